@@ -0,0 +1,526 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: BackupEngine.h
+// 对应需求: 增量备份引擎：清单记录每个源文件已备份的偏移与内容指纹，每次只复制新增尾部；
+//           复制走内核 (reflink / copy_file_range / sendfile)，可选按内容分块 (CDC) 跨备份去重
+// =================================================================================
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 备份方式
+enum class BackupMode {
+    Full,         // 每次把整个文件复制为 backup_<时间戳>_<文件名> (原行为)
+    Incremental   // 追加到每个源文件的镜像文件，只复制上次备份之后的新增部分
+};
+
+// 实际使用的复制方式 (按优先级，前面的失败或不支持时自动退到后面)
+enum class CopyMethod {
+    None,          // 没有复制任何字节
+    Reflink,       // 共享数据块 (btrfs / XFS 的 FICLONE)，不产生 IO
+    CopyFileRange, // 内核内复制 (copy_file_range)
+    Sendfile,      // 内核内复制 (sendfile)
+    SystemCopy,    // 非 Linux 平台的整文件复制 (std::filesystem::copy_file，Windows 上由 CopyFile 完成)
+    Buffered,      // 用户态缓冲读写
+    Chunked        // 分块去重 (需要读取内容计算分块)
+};
+
+inline const char* CopyMethodName(CopyMethod method) {
+    switch (method) {
+    case CopyMethod::Reflink:       return "reflink";
+    case CopyMethod::CopyFileRange: return "copy_file_range";
+    case CopyMethod::Sendfile:      return "sendfile";
+    case CopyMethod::SystemCopy:    return "copy_file";
+    case CopyMethod::Buffered:      return "buffered";
+    case CopyMethod::Chunked:       return "chunked";
+    default:                        return "none";
+    }
+}
+
+struct BackupOptions {
+    BackupMode mode = BackupMode::Incremental;
+    bool dedupe = false;             // 增量模式下按内容分块存入 chunks/，相同的块在所有源文件、所有备份之间只存一份
+    size_t minChunk = 2 * 1024;      // 分块下限
+    size_t avgChunk = 8 * 1024;      // 期望平均块大小 (必须是 2 的幂)
+    size_t maxChunk = 64 * 1024;     // 分块上限
+    size_t fingerprintWindow = 4096; // 用已备份部分末尾这么多字节的哈希判断文件是否被截断 / 重写
+};
+
+// 单个源文件的备份结果
+struct BackupFileResult {
+    std::filesystem::path source;
+    std::filesystem::path target;    // 镜像文件 / 分块清单 / 全量副本
+    uint64_t sourceBytes = 0;        // 本次备份时源文件大小
+    uint64_t bytesCopied = 0;        // 实际写入备份目录的字节数
+    uint64_t bytesDeduped = 0;       // 因为块已存在而省下的字节数
+    uint64_t chunksNew = 0;
+    uint64_t chunksReused = 0;
+    bool restarted = false;          // 源文件被截断 / 重写，从头开始了新一代镜像
+    CopyMethod method = CopyMethod::None;
+};
+
+struct BackupReport {
+    std::vector<BackupFileResult> files;
+    uint64_t bytesCopied = 0;
+    uint64_t bytesDeduped = 0;
+    double seconds = 0.0;
+};
+
+namespace BackupDetail {
+
+// FNV-1a 64 位：清单中的内容指纹与块编号
+inline uint64_t Hash(const char* data, size_t size, uint64_t seed = 14695981039346656037ull) {
+    uint64_t h = seed;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+inline std::string Hex(uint64_t value) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+
+// 读取 [offset, offset + size) 的内容；文件不够长时返回较短的结果
+inline std::string ReadRange(const std::filesystem::path& path, uint64_t offset, size_t size) {
+    std::ifstream in(path, std::ios::binary);
+    std::string data(size, '\0');
+    if (!in) return std::string();
+    in.seekg(static_cast<std::streamoff>(offset));
+    in.read(&data[0], static_cast<std::streamsize>(size));
+    data.resize(static_cast<size_t>(in.gcount()));
+    return data;
+}
+
+// 原子地替换小文件 (先写临时文件再改名)
+inline void WriteFileAtomic(const std::filesystem::path& path, const std::string& content) {
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("无法写入 " + temp.string());
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+        if (!out) throw std::runtime_error("写入失败 " + temp.string());
+    }
+    std::filesystem::rename(temp, path);
+}
+
+// 把 src 的 [offset, offset + length) 追加到 dst 末尾 (dst 不存在时创建)，返回实际使用的方式
+// 源文件在备份过程中可能继续增长，只复制调用时确定的长度
+inline CopyMethod AppendRange(const std::filesystem::path& src, uint64_t offset, uint64_t length,
+                              const std::filesystem::path& dst) {
+    if (length == 0) return CopyMethod::None;
+#if defined(__linux__)
+    struct Fd {
+        int fd;
+        ~Fd() { if (fd >= 0) ::close(fd); }
+    };
+    Fd in{ ::open(src.c_str(), O_RDONLY | O_CLOEXEC) };
+    if (in.fd < 0) throw std::runtime_error("无法打开 " + src.string());
+    Fd out{ ::open(dst.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644) };
+    if (out.fd < 0) throw std::runtime_error("无法打开 " + dst.string());
+    struct stat st;
+    if (::fstat(out.fd, &st) != 0) throw std::runtime_error("无法读取 " + dst.string());
+
+    off_t inOffset = static_cast<off_t>(offset);
+    off_t outOffset = st.st_size;
+    uint64_t remaining = length;
+
+    // 整个文件从头复制到空文件时先尝试 reflink：只共享数据块，不复制任何数据
+    if (offset == 0 && outOffset == 0) {
+        struct stat srcStat;
+        if (::fstat(in.fd, &srcStat) == 0 && static_cast<uint64_t>(srcStat.st_size) == length &&
+            ::ioctl(out.fd, FICLONE, in.fd) == 0) {
+            return CopyMethod::Reflink;
+        }
+    }
+
+    CopyMethod method = CopyMethod::CopyFileRange;
+    while (remaining > 0 && method == CopyMethod::CopyFileRange) {
+        ssize_t n = ::copy_file_range(in.fd, &inOffset, out.fd, &outOffset, static_cast<size_t>(remaining), 0);
+        if (n > 0) remaining -= static_cast<uint64_t>(n);
+        else if (n == 0) throw std::runtime_error("源文件被截断 " + src.string());
+        else if (errno == EINTR) continue;
+        else if (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP || errno == EBADF) method = CopyMethod::Sendfile;
+        else throw std::runtime_error("copy_file_range 失败 " + dst.string());
+    }
+    if (remaining == 0) return method;
+
+    if (::lseek(out.fd, outOffset, SEEK_SET) < 0) throw std::runtime_error("无法定位 " + dst.string());
+    while (remaining > 0 && method == CopyMethod::Sendfile) {
+        ssize_t n = ::sendfile(out.fd, in.fd, &inOffset, static_cast<size_t>(remaining));
+        if (n > 0) remaining -= static_cast<uint64_t>(n);
+        else if (n == 0) throw std::runtime_error("源文件被截断 " + src.string());
+        else if (errno == EINTR) continue;
+        else if (errno == ENOSYS || errno == EINVAL) method = CopyMethod::Buffered;
+        else throw std::runtime_error("sendfile 失败 " + dst.string());
+    }
+    if (remaining == 0) return method;
+
+    std::vector<char> buffer(1 << 20);
+    while (remaining > 0) {
+        size_t want = static_cast<size_t>((std::min)(remaining, static_cast<uint64_t>(buffer.size())));
+        ssize_t n = ::pread(in.fd, buffer.data(), want, inOffset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) throw std::runtime_error("读取失败 " + src.string());
+        for (ssize_t written = 0; written < n;) {
+            ssize_t w = ::pwrite(out.fd, buffer.data() + written, static_cast<size_t>(n - written), outOffset);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) throw std::runtime_error("写入失败 " + dst.string());
+            written += w;
+            outOffset += w;
+        }
+        inOffset += n;
+        remaining -= static_cast<uint64_t>(n);
+    }
+    return CopyMethod::Buffered;
+#else
+    // 其他平台：整文件用 copy_file (Windows 上为 CopyFile，由系统完成复制)，尾部追加用缓冲读写
+    std::error_code ec;
+    if (offset == 0 && !std::filesystem::exists(dst, ec) && std::filesystem::file_size(src, ec) == length && !ec) {
+        std::filesystem::copy_file(src, dst, std::filesystem::copy_options::overwrite_existing);
+        return CopyMethod::SystemCopy;
+    }
+    std::ifstream in(src, std::ios::binary);
+    std::ofstream out(dst, std::ios::binary | std::ios::app);
+    if (!in || !out) throw std::runtime_error("无法打开 " + src.string() + " / " + dst.string());
+    in.seekg(static_cast<std::streamoff>(offset));
+    std::vector<char> buffer(1 << 20);
+    uint64_t remaining = length;
+    while (remaining > 0) {
+        size_t want = static_cast<size_t>((std::min)(remaining, static_cast<uint64_t>(buffer.size())));
+        in.read(buffer.data(), static_cast<std::streamsize>(want));
+        size_t got = static_cast<size_t>(in.gcount());
+        if (got == 0) throw std::runtime_error("源文件被截断 " + src.string());
+        out.write(buffer.data(), static_cast<std::streamsize>(got));
+        remaining -= got;
+    }
+    if (!out) throw std::runtime_error("写入失败 " + dst.string());
+    return CopyMethod::Buffered;
+#endif
+}
+
+// Gear 滚动哈希的随机表 (固定种子，保证每次运行分块边界相同)
+inline const uint64_t* GearTable() {
+    static const std::vector<uint64_t> table = [] {
+        std::vector<uint64_t> t(256);
+        uint64_t z = 0x243F6A8885A308D3ull;
+        for (uint64_t& v : t) {
+            z += 0x9E3779B97F4A7C15ull;
+            uint64_t x = z;
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            v = x ^ (x >> 31);
+        }
+        return t;
+    }();
+    return table.data();
+}
+
+// 内容定义分块 (Gear 哈希)：边界只由附近的内容决定，数据插入 / 平移后未改动的块仍能对齐去重
+class Chunker {
+public:
+    Chunker(size_t minChunk, size_t avgChunk, size_t maxChunk)
+        : m_min(minChunk), m_max((std::max)(maxChunk, minChunk + 1)), m_mask(avgChunk > 1 ? avgChunk - 1 : 0) {}
+
+    // 喂入数据，每切出一个完整块调用一次 emit(data, size)；剩余不足一块的留到下次
+    template <typename Emit>
+    void Feed(const char* data, size_t size, Emit&& emit) {
+        const uint64_t* gear = GearTable();
+        for (size_t i = 0; i < size; ++i) {
+            m_pending.push_back(data[i]);
+            m_hash = (m_hash << 1) + gear[static_cast<unsigned char>(data[i])];
+            if ((m_pending.size() >= m_min && (m_hash & m_mask) == 0) || m_pending.size() >= m_max) {
+                emit(m_pending.data(), m_pending.size());
+                m_pending.clear();
+                m_hash = 0;
+            }
+        }
+    }
+
+    template <typename Emit>
+    void Finish(Emit&& emit) {
+        if (!m_pending.empty()) emit(m_pending.data(), m_pending.size());
+        m_pending.clear();
+        m_hash = 0;
+    }
+
+private:
+    size_t m_min;
+    size_t m_max;
+    uint64_t m_mask;
+    uint64_t m_hash = 0;
+    std::vector<char> m_pending;
+};
+
+} // namespace BackupDetail
+
+// 备份引擎：一个备份目录对应一份清单 (manifest.txt)
+// - 增量模式为每个源文件维护镜像 <文件名>-<路径哈希>.g<代>.mirror，恢复时直接使用镜像即可
+// - 源文件变短或已备份部分末尾的指纹对不上 (日志轮转、被重写) 时开始新的一代，旧镜像保留
+// - 去重模式把新增部分切块存入 chunks/<块哈希>-<长度>，镜像换成按顺序列出块名的 .recipe
+// 同一个备份目录不要同时被两个引擎使用 (CBackupTask 内部串行执行)
+class BackupEngine {
+public:
+    explicit BackupEngine(std::filesystem::path backupDir) : m_dir(std::move(backupDir)) {}
+
+    const std::filesystem::path& Directory() const { return m_dir; }
+
+    BackupReport Run(const std::vector<std::filesystem::path>& sources, const BackupOptions& options = BackupOptions()) {
+        auto start = std::chrono::steady_clock::now();
+        std::filesystem::create_directories(m_dir);
+        LoadManifest();
+
+        BackupReport report;
+        const std::string timestamp = std::to_string(std::time(nullptr));
+        for (const auto& source : sources) {
+            BackupFileResult result = (options.mode == BackupMode::Full)
+                ? BackupFull(source, timestamp) : BackupIncremental(source, options);
+            report.bytesCopied += result.bytesCopied;
+            report.bytesDeduped += result.bytesDeduped;
+            report.files.push_back(std::move(result));
+            // 每个文件完成后立即保存清单：中途中断时，已完成的文件下次不会再追加一遍
+            if (options.mode == BackupMode::Incremental) SaveManifest();
+        }
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return report;
+    }
+
+    // 把源文件最新一代备份还原到 target；没有增量备份记录时返回 false
+    bool Restore(const std::filesystem::path& source, const std::filesystem::path& target) {
+        LoadManifest();
+        auto it = m_manifest.find(Key(source));
+        if (it == m_manifest.end()) return false;
+        const Entry& entry = it->second;
+        std::filesystem::path stored = m_dir / entry.file;
+        if (!entry.chunked) {
+            std::filesystem::copy_file(stored, target, std::filesystem::copy_options::overwrite_existing);
+            return true;
+        }
+        std::ifstream recipe(stored);
+        std::ofstream out(target, std::ios::binary | std::ios::trunc);
+        std::string chunk;
+        while (std::getline(recipe, chunk)) {
+            if (chunk.empty()) continue;
+            std::ifstream in(ChunkPath(chunk), std::ios::binary);
+            if (!in) throw std::runtime_error("缺少数据块 " + chunk);
+            out << in.rdbuf();
+        }
+        return static_cast<bool>(out);
+    }
+
+private:
+    struct Entry {
+        uint64_t generation = 0;
+        uint64_t offset = 0;          // 已备份的字节数
+        uint64_t fingerprint = 0;     // 已备份部分末尾窗口的哈希
+        bool chunked = false;
+        std::string file;             // 备份目录下的镜像 / 分块清单文件名
+    };
+
+    // 清单每行: <代> <偏移> <指纹> <mirror|chunks> <备份文件名> <源路径>，源路径放最后以允许空格
+    void LoadManifest() {
+        m_manifest.clear();
+        std::ifstream in(m_dir / "manifest.txt");
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream fields(line);
+            Entry entry;
+            std::string fingerprint, kind, path;
+            fields >> entry.generation >> entry.offset >> fingerprint >> kind >> entry.file;
+            std::getline(fields >> std::ws, path);
+            if (path.empty() || fingerprint.empty()) continue;
+            entry.fingerprint = std::stoull(fingerprint, nullptr, 16);
+            entry.chunked = (kind == "chunks");
+            m_manifest[path] = entry;
+        }
+    }
+
+    void SaveManifest() {
+        std::ostringstream out;
+        out << "# MyTaskScheduler backup manifest v1\n";
+        for (const auto& item : m_manifest) {
+            const Entry& e = item.second;
+            out << e.generation << ' ' << e.offset << ' ' << BackupDetail::Hex(e.fingerprint) << ' '
+                << (e.chunked ? "chunks" : "mirror") << ' ' << e.file << ' ' << item.first << '\n';
+        }
+        BackupDetail::WriteFileAtomic(m_dir / "manifest.txt", out.str());
+    }
+
+    static std::string Key(const std::filesystem::path& source) {
+        return std::filesystem::absolute(source).lexically_normal().string();
+    }
+
+    std::filesystem::path ChunkPath(const std::string& name) const {
+        return m_dir / "chunks" / name.substr(0, 2) / name;
+    }
+
+    // 把备份文件截回清单记录的偏移 (上次运行在追加之后、保存清单之前中断时，末尾多出一段未登记的数据)
+    // 镜像按字节截断；分块清单按块名中的长度累加，保留恰好覆盖 offset 的那些行
+    // 备份文件比清单记录的短或无法解析时返回 false，由调用方重新开始一代
+    bool TrimToManifest(const Entry& entry) const {
+        const std::filesystem::path path = m_dir / entry.file;
+        std::error_code ec;
+        if (!entry.chunked) {
+            const uint64_t size = std::filesystem::file_size(path, ec);
+            if (ec || size < entry.offset) return false;
+            if (size > entry.offset) std::filesystem::resize_file(path, entry.offset);
+            return true;
+        }
+        std::ifstream in(path);
+        if (!in) return false;
+        std::string kept, line;
+        uint64_t covered = 0;
+        while (covered < entry.offset && std::getline(in, line)) {
+            if (line.empty()) continue;
+            const size_t dash = line.rfind('-');
+            if (dash == std::string::npos) return false;
+            char* end = nullptr;
+            const unsigned long long size = std::strtoull(line.c_str() + dash + 1, &end, 10);
+            if (end == line.c_str() + dash + 1 || *end != '\0') return false;
+            covered += size;
+            kept += line;
+            kept += '\n';
+        }
+        if (covered != entry.offset) return false;
+        if (std::getline(in, line)) {
+            in.close();
+            BackupDetail::WriteFileAtomic(path, kept);
+        }
+        return true;
+    }
+
+    uint64_t Fingerprint(const std::filesystem::path& source, uint64_t end, size_t window) const {
+        uint64_t begin = end > window ? end - window : 0;
+        std::string tail = BackupDetail::ReadRange(source, begin, static_cast<size_t>(end - begin));
+        if (tail.size() != end - begin) return 0;
+        return BackupDetail::Hash(tail.data(), tail.size(), end);
+    }
+
+    BackupFileResult BackupFull(const std::filesystem::path& source, const std::string& timestamp) {
+        BackupFileResult result;
+        result.source = source;
+        result.sourceBytes = std::filesystem::file_size(source);
+        // 同一秒内多次备份时加序号，不覆盖之前的副本
+        const std::string base = "backup_" + timestamp + "_" + source.filename().string();
+        result.target = m_dir / base;
+        for (int seq = 1; std::filesystem::exists(result.target); ++seq) {
+            result.target = m_dir / (base + "." + std::to_string(seq));
+        }
+        result.method = BackupDetail::AppendRange(source, 0, result.sourceBytes, result.target);
+        if (result.method == CopyMethod::None) std::ofstream(result.target, std::ios::binary);
+        result.bytesCopied = result.sourceBytes;
+        return result;
+    }
+
+    BackupFileResult BackupIncremental(const std::filesystem::path& source, const BackupOptions& options) {
+        BackupFileResult result;
+        result.source = source;
+        result.sourceBytes = std::filesystem::file_size(source);
+
+        const std::string key = Key(source);
+        Entry& entry = m_manifest[key];
+        const std::string kind = options.dedupe ? ".recipe" : ".mirror";
+
+        // 判断能否接着上次的位置继续：同一种存储方式、备份文件还在、源文件没有变短、已备份部分末尾没变
+        bool resume = !entry.file.empty() && entry.chunked == options.dedupe &&
+            entry.offset <= result.sourceBytes && std::filesystem::exists(m_dir / entry.file) &&
+            (entry.offset == 0 || Fingerprint(source, entry.offset, options.fingerprintWindow) == entry.fingerprint);
+        // 从 entry.offset 读源文件、追加到备份文件末尾：两者必须对齐，否则重复或错位
+        if (resume) resume = TrimToManifest(entry);
+        if (!resume) {
+            result.restarted = !entry.file.empty();
+            entry.generation = entry.file.empty() ? 1 : entry.generation + 1;
+            entry.offset = 0;
+            entry.chunked = options.dedupe;
+            entry.file = source.filename().string() + "-" +
+                BackupDetail::Hex(BackupDetail::Hash(key.data(), key.size())).substr(0, 8) +
+                ".g" + std::to_string(entry.generation) + kind;
+            std::error_code ec;
+            std::filesystem::remove(m_dir / entry.file, ec);
+        }
+        result.target = m_dir / entry.file;
+
+        const uint64_t length = result.sourceBytes - entry.offset;
+        if (options.dedupe) {
+            StoreChunks(source, entry.offset, length, result.target, options, result);
+        }
+        else {
+            result.method = BackupDetail::AppendRange(source, entry.offset, length, result.target);
+            result.bytesCopied = length;
+            if (!std::filesystem::exists(result.target)) std::ofstream(result.target, std::ios::binary);
+        }
+        entry.offset = result.sourceBytes;
+        entry.fingerprint = Fingerprint(source, entry.offset, options.fingerprintWindow);
+        return result;
+    }
+
+    // 新增部分切块，只写入备份目录中还没有的块，块名按顺序追加到 recipe
+    // 末尾不足一块的部分也作为一个块保存 (下次不会与它重新拼接，边界从上次的偏移处重新开始)
+    void StoreChunks(const std::filesystem::path& source, uint64_t offset, uint64_t length,
+                     const std::filesystem::path& recipePath, const BackupOptions& options, BackupFileResult& result) {
+        std::ofstream recipe(recipePath, std::ios::app);
+        if (!recipe) throw std::runtime_error("无法写入 " + recipePath.string());
+        std::ifstream in(source, std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(offset));
+
+        BackupDetail::Chunker chunker(options.minChunk, options.avgChunk, options.maxChunk);
+        auto store = [&](const char* data, size_t size) {
+            std::string name = BackupDetail::Hex(BackupDetail::Hash(data, size)) + "-" + std::to_string(size);
+            std::filesystem::path path = ChunkPath(name);
+            if (std::filesystem::exists(path)) {
+                ++result.chunksReused;
+                result.bytesDeduped += size;
+            }
+            else {
+                std::filesystem::create_directories(path.parent_path());
+                BackupDetail::WriteFileAtomic(path, std::string(data, size));
+                ++result.chunksNew;
+                result.bytesCopied += size;
+            }
+            recipe << name << '\n';
+        };
+
+        std::vector<char> buffer(1 << 20);
+        uint64_t remaining = length;
+        while (remaining > 0) {
+            size_t want = static_cast<size_t>((std::min)(remaining, static_cast<uint64_t>(buffer.size())));
+            in.read(buffer.data(), static_cast<std::streamsize>(want));
+            size_t got = static_cast<size_t>(in.gcount());
+            if (got == 0) throw std::runtime_error("源文件被截断 " + source.string());
+            chunker.Feed(buffer.data(), got, store);
+            remaining -= got;
+        }
+        chunker.Finish(store);
+        if (!recipe) throw std::runtime_error("写入失败 " + recipePath.string());
+        result.method = (length > 0) ? CopyMethod::Chunked : CopyMethod::None;
+    }
+
+    std::filesystem::path m_dir;
+    std::map<std::string, Entry> m_manifest;
+};
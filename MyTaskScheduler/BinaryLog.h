@@ -0,0 +1,434 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: BinaryLog.h
+// 对应需求: 紧凑二进制日志 + 稀疏时间索引 + 内存映射 (mmap) 读取器
+// =================================================================================
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <chrono>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// === 1. 文件格式 ===
+// xxx.blog     : [文件头 64B] [记录] [记录] ...
+//   记录       : [记录头 24B] [负载 payloadLen 字节，补齐到 8 字节对齐]
+// xxx.blog.idx : [索引头 16B] [索引项 64B] ...  (每 N 条记录一个索引项，顺序追加)
+// 时间戳为单调时钟纳秒 (steady_clock)，文件头保存一对 墙上时间/单调时间 锚点用于换算
+// 写入端保证时间戳单调不减，读取端可以直接对索引二分查找
+
+// 事件类型
+enum class LogEventType : uint16_t {
+    Message = 0,     // LogWriter::Write 的普通文本
+    TaskSubmitted,
+    TaskStarted,
+    TaskFinished,
+    TaskCancelled,
+    TaskFailed,
+    TaskDeadlineMissed,  // 执行完成时已超过截止时间
+    TaskRejected,        // 调度器满载，提交被拒绝 (AdmissionOptions)
+    TaskCoalesced        // 与同一合并键的已有任务合并 (TaskOptions::coalesceKey)
+};
+
+inline const char* LogEventTypeName(LogEventType type) {
+    switch (type) {
+    case LogEventType::Message:       return "Message";
+    case LogEventType::TaskSubmitted: return "Scheduled";
+    case LogEventType::TaskStarted:   return "Executing";
+    case LogEventType::TaskFinished:  return "Finished";
+    case LogEventType::TaskCancelled: return "Cancelled";
+    case LogEventType::TaskFailed:    return "Failed";
+    case LogEventType::TaskDeadlineMissed: return "DeadlineMissed";
+    case LogEventType::TaskRejected:  return "Rejected";
+    case LogEventType::TaskCoalesced: return "Coalesced";
+    default:                          return "Unknown";
+    }
+}
+
+#pragma pack(push, 1)
+struct BinaryLogFileHeader {
+    char magic[8];            // "MTSBLOG1"
+    uint32_t version;
+    uint32_t headerSize;
+    int64_t wallAnchorNs;     // 打开文件时的 system_clock (自 1970 起纳秒)
+    int64_t steadyAnchorNs;   // 同一时刻的 steady_clock 纳秒
+    uint32_t indexEvery;
+    uint8_t reserved[28];
+};
+
+struct BinaryLogRecordHeader {
+    uint64_t timestampNs;     // steady_clock 纳秒
+    uint64_t taskId;
+    uint16_t eventType;
+    uint16_t flags;
+    uint32_t payloadLen;
+};
+
+struct BinaryLogIndexHeader {
+    char magic[8];            // "MTSBIDX1"
+    uint32_t version;
+    uint32_t entrySize;
+};
+
+// 稀疏索引项：一个块 (N 条记录) 的时间范围、起始偏移与任务编号布隆过滤器
+struct BinaryLogIndexEntry {
+    uint64_t firstTs;
+    uint64_t lastTs;
+    uint64_t offset;          // 块内第一条记录在 .blog 中的偏移
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t taskBloom[4];    // 256 位，按任务查询时跳过不可能包含该任务的块
+};
+#pragma pack(pop)
+
+static_assert(sizeof(BinaryLogFileHeader) == 64, "BinaryLogFileHeader must be 64 bytes");
+static_assert(sizeof(BinaryLogRecordHeader) == 24, "BinaryLogRecordHeader must be 24 bytes");
+static_assert(sizeof(BinaryLogIndexEntry) == 64, "BinaryLogIndexEntry must be 64 bytes");
+
+namespace binlog_detail {
+    inline uint64_t MixTaskId(uint64_t x) {
+        x ^= x >> 33; x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33; x *= 0xc4ceb33fe64e51a3ULL;
+        x ^= x >> 33;
+        return x;
+    }
+    inline void BloomAdd(uint64_t* bloom, uint64_t taskId) {
+        uint64_t h = MixTaskId(taskId);
+        uint32_t a = static_cast<uint32_t>(h & 255), b = static_cast<uint32_t>((h >> 8) & 255);
+        bloom[a >> 6] |= 1ULL << (a & 63);
+        bloom[b >> 6] |= 1ULL << (b & 63);
+    }
+    inline bool BloomMayContain(const uint64_t* bloom, uint64_t taskId) {
+        uint64_t h = MixTaskId(taskId);
+        uint32_t a = static_cast<uint32_t>(h & 255), b = static_cast<uint32_t>((h >> 8) & 255);
+        return (bloom[a >> 6] & (1ULL << (a & 63))) && (bloom[b >> 6] & (1ULL << (b & 63)));
+    }
+    inline size_t PaddedSize(uint32_t payloadLen) {
+        return sizeof(BinaryLogRecordHeader) + ((static_cast<size_t>(payloadLen) + 7) & ~size_t(7));
+    }
+    inline int64_t SteadyNowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    // 与文本日志一致的时间前缀 "[YYYY-mm-dd HH:MM:SS] "
+    inline void FormatTimePrefix(int64_t wallNs, char* out, size_t size) {
+        std::time_t sec = static_cast<std::time_t>(wallNs / 1000000000);
+        std::tm tm;
+#if defined(_WIN32)
+        localtime_s(&tm, &sec);
+#else
+        localtime_r(&sec, &tm);
+#endif
+        std::strftime(out, size, "[%Y-%m-%d %H:%M:%S] ", &tm);
+    }
+}
+
+// === 2. 写入端 (非线程安全，由 LogWriter 在其锁内或刷盘线程中调用) ===
+class BinaryLogWriter {
+public:
+    bool Open(const std::string& path, uint32_t indexEvery = 1024) {
+        m_indexEvery = indexEvery ? indexEvery : 1;
+        m_data.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        m_index.open(path + ".idx", std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!m_data.is_open() || !m_index.is_open()) return false;
+
+        BinaryLogFileHeader header{};
+        std::memcpy(header.magic, "MTSBLOG1", 8);
+        header.version = 1;
+        header.headerSize = sizeof(header);
+        header.steadyAnchorNs = binlog_detail::SteadyNowNs();
+        header.wallAnchorNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        header.indexEvery = m_indexEvery;
+        m_data.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        m_offset = sizeof(header);
+
+        BinaryLogIndexHeader indexHeader{};
+        std::memcpy(indexHeader.magic, "MTSBIDX1", 8);
+        indexHeader.version = 1;
+        indexHeader.entrySize = sizeof(BinaryLogIndexEntry);
+        m_index.write(reinterpret_cast<const char*>(&indexHeader), sizeof(indexHeader));
+        ResetBlock();
+        return true;
+    }
+
+    bool IsOpen() const { return m_data.is_open(); }
+
+    void Append(uint64_t timestampNs, uint64_t taskId, LogEventType type, const char* payload, uint32_t payloadLen) {
+        // 保证时间戳单调：多生产者入队顺序与取时间的顺序可能有微小差异
+        if (timestampNs < m_lastTs) timestampNs = m_lastTs;
+        m_lastTs = timestampNs;
+
+        if (m_block.count == 0) {
+            m_block.firstTs = timestampNs;
+            m_block.offset = m_offset;
+        }
+        m_block.lastTs = timestampNs;
+        ++m_block.count;
+        binlog_detail::BloomAdd(m_block.taskBloom, taskId);
+
+        BinaryLogRecordHeader rec{ timestampNs, taskId, static_cast<uint16_t>(type), 0, payloadLen };
+        static const char kZeros[8] = {};
+        size_t padded = binlog_detail::PaddedSize(payloadLen);
+        m_data.write(reinterpret_cast<const char*>(&rec), sizeof(rec));
+        m_data.write(payload, payloadLen);
+        m_data.write(kZeros, static_cast<std::streamsize>(padded - sizeof(rec) - payloadLen));
+        m_offset += padded;
+
+        if (m_block.count >= m_indexEvery) {
+            m_index.write(reinterpret_cast<const char*>(&m_block), sizeof(m_block));
+            ResetBlock();
+        }
+    }
+
+    void Flush() {
+        m_data.flush();
+        m_index.flush();
+    }
+
+    // 关闭时补写最后一个不满 N 条的块
+    void Close() {
+        if (!m_data.is_open()) return;
+        if (m_block.count > 0) {
+            m_index.write(reinterpret_cast<const char*>(&m_block), sizeof(m_block));
+            ResetBlock();
+        }
+        m_data.close();
+        m_index.close();
+    }
+
+    ~BinaryLogWriter() { Close(); }
+
+private:
+    void ResetBlock() {
+        m_block = BinaryLogIndexEntry{};
+    }
+
+    std::ofstream m_data;
+    std::ofstream m_index;
+    uint32_t m_indexEvery = 1024;
+    uint64_t m_offset = 0;
+    uint64_t m_lastTs = 0;
+    BinaryLogIndexEntry m_block{};
+};
+
+// === 3. 只读内存映射文件 ===
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    bool Open(const std::string& path) {
+        Close();
+#if defined(_WIN32)
+        m_file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m_file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!::GetFileSizeEx(m_file, &size) || size.QuadPart == 0) { Close(); return false; }
+        m_size = static_cast<size_t>(size.QuadPart);
+        m_mapping = ::CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!m_mapping) { Close(); return false; }
+        m_data = static_cast<const uint8_t*>(::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_data) { Close(); return false; }
+#else
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        if (m_fd < 0) return false;
+        struct stat st;
+        if (::fstat(m_fd, &st) != 0 || st.st_size == 0) { Close(); return false; }
+        m_size = static_cast<size_t>(st.st_size);
+        void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+        if (p == MAP_FAILED) { Close(); return false; }
+        m_data = static_cast<const uint8_t*>(p);
+#endif
+        return true;
+    }
+
+    void Close() {
+#if defined(_WIN32)
+        if (m_data) ::UnmapViewOfFile(m_data);
+        if (m_mapping) ::CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE) ::CloseHandle(m_file);
+        m_mapping = NULL;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data) ::munmap(const_cast<uint8_t*>(m_data), m_size);
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    const uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+#if defined(_WIN32)
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = NULL;
+#else
+    int m_fd = -1;
+#endif
+};
+
+// === 4. 读取端 ===
+// 时间范围查询: 对索引二分查找定位起始块，只扫描范围内的记录
+// 按任务查询:   用每块的布隆过滤器跳过不含该任务的块
+// 最后一个未写入索引的块 (进程崩溃或仍在写) 从已索引部分的末尾顺序扫描
+struct BinaryLogRecordView {
+    uint64_t timestampNs;
+    uint64_t taskId;
+    LogEventType type;
+    std::string_view payload;
+};
+
+class BinaryLogReader {
+public:
+    bool Open(const std::string& path) {
+        if (!m_data.Open(path) || m_data.Size() < sizeof(BinaryLogFileHeader)) return false;
+        std::memcpy(&m_header, m_data.Data(), sizeof(m_header));
+        if (std::memcmp(m_header.magic, "MTSBLOG1", 8) != 0) return false;
+
+        m_entries = nullptr;
+        m_entryCount = 0;
+        if (m_index.Open(path + ".idx") && m_index.Size() >= sizeof(BinaryLogIndexHeader)
+            && std::memcmp(m_index.Data(), "MTSBIDX1", 8) == 0) {
+            m_entries = reinterpret_cast<const BinaryLogIndexEntry*>(m_index.Data() + sizeof(BinaryLogIndexHeader));
+            m_entryCount = (m_index.Size() - sizeof(BinaryLogIndexHeader)) / sizeof(BinaryLogIndexEntry);
+        }
+        return true;
+    }
+
+    const BinaryLogFileHeader& Header() const { return m_header; }
+
+    // 单调时间戳 <-> 墙上时间 (纳秒)
+    int64_t ToWallNs(uint64_t timestampNs) const {
+        return m_header.wallAnchorNs + (static_cast<int64_t>(timestampNs) - m_header.steadyAnchorNs);
+    }
+    uint64_t FromWallNs(int64_t wallNs) const {
+        int64_t ts = wallNs - m_header.wallAnchorNs + m_header.steadyAnchorNs;
+        return ts < 0 ? 0 : static_cast<uint64_t>(ts);
+    }
+    // 相对文件打开时刻的偏移 (毫秒) -> 时间戳，命令行工具使用
+    uint64_t FromOffsetMs(int64_t offsetMs) const {
+        int64_t ts = m_header.steadyAnchorNs + offsetMs * 1000000;
+        return ts < 0 ? 0 : static_cast<uint64_t>(ts);
+    }
+
+    // 遍历 [fromNs, toNs] 内的记录；fn 返回 false 时提前结束
+    template <typename Fn>
+    void ForEachInRange(uint64_t fromNs, uint64_t toNs, Fn&& fn) const {
+        // 找到最后一个 firstTs < fromNs 的块作为起点 (该块可能包含 >= fromNs 的记录)
+        size_t lo = 0, hi = m_entryCount;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (m_entries[mid].firstTs < fromNs) lo = mid + 1; else hi = mid;
+        }
+        size_t startBlock = lo > 0 ? lo - 1 : 0;
+        size_t offset = (m_entryCount > 0) ? static_cast<size_t>(m_entries[startBlock].offset) : m_header.headerSize;
+
+        ScanFrom(offset, [&](const BinaryLogRecordView& rec) {
+            if (rec.timestampNs > toNs) return false;
+            if (rec.timestampNs >= fromNs) return fn(rec);
+            return true;
+        });
+    }
+
+    // 遍历某个任务的全部记录
+    template <typename Fn>
+    void ForEachForTask(uint64_t taskId, Fn&& fn) const {
+        bool stop = false;
+        for (size_t i = 0; i < m_entryCount && !stop; ++i) {
+            const BinaryLogIndexEntry& e = m_entries[i];
+            if (!binlog_detail::BloomMayContain(e.taskBloom, taskId)) continue;
+            uint32_t seen = 0;
+            ScanFrom(static_cast<size_t>(e.offset), [&](const BinaryLogRecordView& rec) {
+                if (++seen > e.count) return false;
+                if (rec.taskId == taskId && !fn(rec)) { stop = true; return false; }
+                return true;
+            });
+        }
+        if (stop) return;
+        ScanFrom(IndexedEnd(), [&](const BinaryLogRecordView& rec) {
+            return rec.taskId != taskId || fn(rec);
+        });
+    }
+
+    // 把时间范围内的记录还原为文本日志格式
+    void WriteText(uint64_t fromNs, uint64_t toNs, std::ostream& os) const {
+        ForEachInRange(fromNs, toNs, [&](const BinaryLogRecordView& rec) {
+            os << FormatText(rec) << '\n';
+            return true;
+        });
+    }
+
+    std::string FormatText(const BinaryLogRecordView& rec) const {
+        char prefix[32];
+        binlog_detail::FormatTimePrefix(ToWallNs(rec.timestampNs), prefix, sizeof(prefix));
+        std::string line(prefix);
+        if (rec.type == LogEventType::Message) {
+            line.append(rec.payload.data(), rec.payload.size());
+        }
+        else {
+            line.append(LogEventTypeName(rec.type)).append(": ");
+            line.append(rec.payload.data(), rec.payload.size());
+            line.append(" (task #").append(std::to_string(rec.taskId)).append(")");
+        }
+        return line;
+    }
+
+private:
+    // 已被索引覆盖的数据末尾
+    size_t IndexedEnd() const {
+        if (m_entryCount == 0) return m_header.headerSize;
+        const BinaryLogIndexEntry& last = m_entries[m_entryCount - 1];
+        size_t offset = static_cast<size_t>(last.offset);
+        for (uint32_t i = 0; i < last.count && offset + sizeof(BinaryLogRecordHeader) <= m_data.Size(); ++i) {
+            BinaryLogRecordHeader rec;
+            std::memcpy(&rec, m_data.Data() + offset, sizeof(rec));
+            offset += binlog_detail::PaddedSize(rec.payloadLen);
+        }
+        return offset;
+    }
+
+    template <typename Fn>
+    void ScanFrom(size_t offset, Fn&& fn) const {
+        const uint8_t* base = m_data.Data();
+        const size_t size = m_data.Size();
+        while (offset + sizeof(BinaryLogRecordHeader) <= size) {
+            BinaryLogRecordHeader rec;
+            std::memcpy(&rec, base + offset, sizeof(rec));
+            size_t padded = binlog_detail::PaddedSize(rec.payloadLen);
+            if (offset + padded > size) break; // 尾部不完整的记录
+            BinaryLogRecordView view{ rec.timestampNs, rec.taskId, static_cast<LogEventType>(rec.eventType),
+                std::string_view(reinterpret_cast<const char*>(base + offset + sizeof(rec)), rec.payloadLen) };
+            if (!fn(view)) break;
+            offset += padded;
+        }
+    }
+
+    MappedFile m_data;
+    MappedFile m_index;
+    BinaryLogFileHeader m_header{};
+    const BinaryLogIndexEntry* m_entries = nullptr;
+    size_t m_entryCount = 0;
+};
@@ -0,0 +1,156 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: CoTask.h
+// 对应需求: C++20 协程任务：co_await 延时 / 其他任务结束 / IO 就绪事件时挂起，不占用工作线程
+// =================================================================================
+#pragma once
+#include "SchedulerEngine.h"
+
+// 需要编译器支持 C++20 协程 (MSVC: /std:c++20)，否则本文件为空
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#include <utility>
+
+// 协程任务的返回类型
+// 用法:
+//   CoTask Poll(TaskScheduler& s) {
+//       for (int i = 0; i < 10; ++i) {
+//           co_await s.Delay(100);          // 挂到时间轮上，不占线程
+//       }
+//   }
+//   TaskScheduler::Instance().Spawn("Poll", Poll(TaskScheduler::Instance()));
+// - 协程创建后先挂起，由 Spawn 交给调度器后才开始运行
+// - 每次恢复可能在不同的工作线程上，协程内不要依赖线程局部变量
+// - 未捕获的异常按任务失败处理 (与 ITask::Execute 抛异常相同)
+class CoTask {
+public:
+    struct promise_type {
+        ScheduledTask* node = nullptr;   // 承载本协程的调度节点 (Spawn 时写入)
+
+        CoTask get_return_object() {
+            return CoTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        // 结束后保持挂起，协程帧随节点回收一起销毁
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { throw; } // 交给工作线程的 catch 记为失败
+    };
+    using Handle = std::coroutine_handle<promise_type>;
+
+    CoTask(CoTask&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    CoTask& operator=(CoTask&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+
+    // 没有交给调度器的协程在这里销毁
+    ~CoTask() {
+        if (m_handle) m_handle.destroy();
+    }
+
+    // 交出协程帧的所有权
+    Handle Release() {
+        return std::exchange(m_handle, {});
+    }
+
+private:
+    explicit CoTask(Handle handle) : m_handle(handle) {}
+
+    Handle m_handle;
+};
+
+// co_await scheduler.Delay(ms)
+struct CoDelayAwaiter {
+    int delayMs = 0;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(CoTask::Handle handle) const noexcept {
+        ScheduledTask* node = handle.promise().node;
+        node->park = CoPark::Delay;
+        node->parkDelayMs = delayMs;
+    }
+    void await_resume() const noexcept {}
+};
+
+// co_await handle / co_await scheduler.WaitFor(handle)
+// 结果: 等待的任务是否成功结束 (已经结束或句柄无效时为 true)
+struct CoTaskAwaiter {
+    TaskId id = 0;
+    ScheduledTask* node = nullptr;
+
+    bool await_ready() const noexcept { return id == 0; }
+    void await_suspend(CoTask::Handle handle) noexcept {
+        node = handle.promise().node;
+        node->park = CoPark::Task;
+        node->parkTask = id;
+    }
+    bool await_resume() const noexcept { return node ? node->resumeOk : true; }
+};
+
+// 可被协程等待的事件，用于 IO 就绪等由外部线程触发的条件
+// 例如弹性线程池中的阻塞任务下载完成后 Set()，等待它的协程随即在工作线程上恢复
+// 事件必须比等待它的协程活得久；Set 之后直到 Reset 之前 co_await 不挂起
+class AsyncEvent {
+public:
+    explicit AsyncEvent(TaskScheduler& scheduler = TaskScheduler::Instance()) : m_scheduler(&scheduler) {}
+    AsyncEvent(const AsyncEvent&) = delete;
+    AsyncEvent& operator=(const AsyncEvent&) = delete;
+
+    // 置位并恢复所有等待者 (可在任意线程调用)
+    void Set() { m_scheduler->SignalEvent(m_state); }
+    void Reset() { m_scheduler->ResetEvent(m_state); }
+    bool IsSet() const { return m_scheduler->IsEventSignaled(m_state); }
+
+    struct Awaiter {
+        AsyncEvent* event;
+
+        bool await_ready() const { return event->IsSet(); }
+        void await_suspend(CoTask::Handle handle) const noexcept {
+            ScheduledTask* node = handle.promise().node;
+            node->park = CoPark::Event;
+            node->parkEvent = &event->m_state;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    Awaiter operator co_await() { return Awaiter{ this }; }
+
+private:
+    TaskScheduler* m_scheduler;
+    CoEventState m_state;
+};
+
+// === TaskScheduler 协程接口实现 ===
+inline TaskHandle TaskScheduler::Spawn(const char* name, CoTask task, const TaskOptions& options) {
+    CoTask::Handle handle = task.Release();
+    if (!handle) return TaskHandle();
+
+    const char* interned = NameInterner::Instance().Intern(name);
+    ScheduledTask* sTask = m_pool.Acquire();
+    handle.promise().node = sTask;
+    sTask->coFrame = handle.address();
+    sTask->coDestroy = [](void* frame) { CoTask::Handle::from_address(frame).destroy(); };
+    sTask->fn = [handle]() { handle.resume(); };
+    return SubmitNode(sTask, interned, 0, 0, options);
+}
+
+inline CoDelayAwaiter TaskScheduler::Delay(int delayMs) {
+    return CoDelayAwaiter{ delayMs };
+}
+
+inline CoTaskAwaiter TaskScheduler::WaitFor(const TaskHandle& handle) {
+    return CoTaskAwaiter{ handle.GetId() };
+}
+
+// co_await handle：等同于 co_await scheduler.WaitFor(handle)
+inline CoTaskAwaiter operator co_await(const TaskHandle& handle) {
+    return CoTaskAwaiter{ handle.GetId() };
+}
+
+#endif // __cpp_impl_coroutine
@@ -0,0 +1,71 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: CpuFeatures.h
+// 对应需求: 运行时检测 CPU 指令集 (AVX2 / AVX-512)，供矩阵、统计等向量化内核分派
+// =================================================================================
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MTS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC / Clang 需要为使用指令集的函数单独开启目标特性；MSVC 可以直接使用内建函数
+#if defined(MTS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MTS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define MTS_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define MTS_TARGET_AVX2
+#define MTS_TARGET_AVX512
+#endif
+
+// 向量化内核可用的指令集
+enum class SimdLevel : int {
+    Scalar,   // 可移植的标量实现 (编译器可能自动向量化)
+    Avx2,     // AVX2 + FMA，4 个 double / 寄存器
+    Avx512    // AVX-512F，8 个 double / 寄存器
+};
+
+inline const char* SimdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Scalar: return "Scalar";
+    case SimdLevel::Avx2:   return "AVX2";
+    case SimdLevel::Avx512: return "AVX-512";
+    default:                return "Unknown";
+    }
+}
+
+// 检测 CPU 与操作系统都支持的最高指令集 (只检测一次)
+inline SimdLevel DetectSimdLevel() {
+    static const SimdLevel level = [] {
+#if defined(MTS_X86) && defined(_MSC_VER)
+        int info[4] = {};
+        __cpuid(info, 0);
+        if (info[0] < 7) return SimdLevel::Scalar;
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        if (!osxsave) return SimdLevel::Scalar;
+        const unsigned long long xcr0 = _xgetbv(0);
+        const bool ymmState = (xcr0 & 0x6) == 0x6;
+        const bool zmmState = (xcr0 & 0xE6) == 0xE6;
+        __cpuidex(info, 7, 0);
+        const bool avx2 = (info[1] & (1 << 5)) != 0;
+        const bool avx512f = (info[1] & (1 << 16)) != 0;
+        if (avx512f && zmmState) return SimdLevel::Avx512;
+        if (avx2 && fma && ymmState) return SimdLevel::Avx2;
+        return SimdLevel::Scalar;
+#elif defined(MTS_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return SimdLevel::Avx512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::Avx2;
+        return SimdLevel::Scalar;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }();
+    return level;
+}
@@ -0,0 +1,323 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: CpuTopology.h
+// 对应需求: CPU 拓扑 (逻辑 CPU -> 物理核 / 插槽 / NUMA 节点) 与线程绑核；
+//           Linux 读取 /sys/devices/system，Windows 使用 GetLogicalProcessorInformation
+// =================================================================================
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+struct CpuInfo {
+    int cpu = 0;       // 逻辑 CPU 编号 (操作系统的编号)
+    int core = 0;      // 物理核 (全局唯一：不同插槽的 core_id 会重复，这里重新编号)
+    int package = 0;   // 插槽
+    int node = 0;      // NUMA 节点 (0 .. NodeCount()-1，按系统编号的顺序重新编号)
+    int smt = 0;       // 在所属物理核中的序号 (0 为第一个超线程)
+};
+
+class CpuTopology {
+public:
+    // 本机拓扑 (只检测一次)
+    static const CpuTopology& System() {
+        static const CpuTopology topology = Detect();
+        return topology;
+    }
+
+    // sysRoot 可以指向一份拷贝出来的 /sys/devices/system (用于在其他机器上复现拓扑)
+    static CpuTopology Detect(const std::string& sysRoot = "/sys/devices/system") {
+        CpuTopology topology;
+#if defined(__linux__)
+        topology.DetectLinux(sysRoot);
+#elif defined(_WIN32)
+        (void)sysRoot;
+        topology.DetectWindows();
+#else
+        (void)sysRoot;
+#endif
+        if (topology.m_cpus.empty()) topology.DetectFlat();
+        topology.Finish();
+        return topology;
+    }
+
+    const std::vector<CpuInfo>& Cpus() const { return m_cpus; }
+    size_t CpuCount() const { return m_cpus.size(); }
+    size_t CoreCount() const { return m_coreCount; }
+    size_t NodeCount() const { return m_nodeCount; }
+    size_t L2Bytes() const { return m_l2Bytes; }   // 单个 CPU 的 L2 容量 (未知时为 0)
+    size_t L3Bytes() const { return m_l3Bytes; }
+
+    int NodeOfCpu(int cpu) const {
+        for (const auto& info : m_cpus) {
+            if (info.cpu == cpu) return info.node;
+        }
+        return 0;
+    }
+
+    std::vector<int> CpusOfNode(int node) const {
+        std::vector<int> cpus;
+        for (const auto& info : m_cpus) {
+            if (info.node == node) cpus.push_back(info.cpu);
+        }
+        return cpus;
+    }
+
+    // 工作线程的分配顺序：先把每个物理核的第一个超线程按节点轮流排开，再排超线程兄弟
+    // 线程数不超过物理核数时每个线程独占一个物理核 (不与兄弟超线程争抢 L1/L2)，且均匀分布在各节点
+    std::vector<int> PlacementOrder() const {
+        std::vector<CpuInfo> sorted = m_cpus;
+        std::vector<int> rankInNode(m_nodeCount, 0);
+        std::map<int, int> rank; // cpu -> 在所属节点、同一 smt 层中的序号
+        std::stable_sort(sorted.begin(), sorted.end(), [](const CpuInfo& a, const CpuInfo& b) {
+            if (a.smt != b.smt) return a.smt < b.smt;
+            if (a.node != b.node) return a.node < b.node;
+            return a.core < b.core;
+        });
+        int lastSmt = -1;
+        for (const auto& info : sorted) {
+            if (info.smt != lastSmt) {
+                std::fill(rankInNode.begin(), rankInNode.end(), 0);
+                lastSmt = info.smt;
+            }
+            rank[info.cpu] = rankInNode[static_cast<size_t>(info.node)]++;
+        }
+        std::stable_sort(sorted.begin(), sorted.end(), [&](const CpuInfo& a, const CpuInfo& b) {
+            if (a.smt != b.smt) return a.smt < b.smt;
+            if (rank[a.cpu] != rank[b.cpu]) return rank[a.cpu] < rank[b.cpu];
+            return a.node < b.node;
+        });
+        std::vector<int> order;
+        for (const auto& info : sorted) order.push_back(info.cpu);
+        return order;
+    }
+
+    // 例如 "16 CPUs, 8 cores, 2 nodes [node0: 0-3,8-11] [node1: 4-7,12-15], L2 1024KB, L3 32768KB"
+    std::string Describe() const {
+        std::string text = std::to_string(m_cpus.size()) + " CPUs, " + std::to_string(m_coreCount) + " cores, "
+            + std::to_string(m_nodeCount) + (m_nodeCount == 1 ? " node" : " nodes");
+        for (size_t node = 0; node < m_nodeCount; ++node) {
+            text += " [node" + std::to_string(node) + ": " + FormatCpuList(CpusOfNode(static_cast<int>(node))) + "]";
+        }
+        if (m_l2Bytes) text += ", L2 " + std::to_string(m_l2Bytes / 1024) + "KB";
+        if (m_l3Bytes) text += ", L3 " + std::to_string(m_l3Bytes / 1024) + "KB";
+        return text;
+    }
+
+    // "0-3,8,10-11" 格式 (sysfs 的 cpulist)
+    static std::vector<int> ParseCpuList(const std::string& text) {
+        std::vector<int> cpus;
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t end = text.find(',', pos);
+            if (end == std::string::npos) end = text.size();
+            const std::string item = text.substr(pos, end - pos);
+            pos = end + 1;
+            if (item.empty() || item[0] < '0' || item[0] > '9') continue;
+            const size_t dash = item.find('-');
+            const int first = std::atoi(item.c_str());
+            const int last = (dash == std::string::npos) ? first : std::atoi(item.c_str() + dash + 1);
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+
+    static std::string FormatCpuList(const std::vector<int>& cpus) {
+        std::string text;
+        for (size_t i = 0; i < cpus.size();) {
+            size_t j = i;
+            while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+            if (!text.empty()) text += ',';
+            text += std::to_string(cpus[i]);
+            if (j > i) text += '-' + std::to_string(cpus[j]);
+            i = j + 1;
+        }
+        return text;
+    }
+
+private:
+    static std::string ReadLine(const std::string& path) {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    static int ReadInt(const std::string& path, int fallback) {
+        const std::string line = ReadLine(path);
+        return line.empty() ? fallback : std::atoi(line.c_str());
+    }
+
+    // "1024K" / "32M"
+    static size_t ParseSize(const std::string& text) {
+        size_t value = static_cast<size_t>(std::strtoull(text.c_str(), nullptr, 10));
+        if (text.find('K') != std::string::npos) value *= 1024;
+        else if (text.find('M') != std::string::npos) value *= 1024 * 1024;
+        return value;
+    }
+
+#if defined(__linux__)
+    void DetectLinux(const std::string& root) {
+        std::vector<int> online = ParseCpuList(ReadLine(root + "/cpu/online"));
+        if (online.empty()) return;
+
+        // 只使用本进程允许运行的 CPU (容器、taskset 限制)
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        const bool haveMask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0 && root == "/sys/devices/system";
+
+        std::map<int, int> nodeOfCpu;
+        for (int node = 0; node < 4096; ++node) {
+            const std::string list = root + "/node/node" + std::to_string(node) + "/cpulist";
+            std::ifstream probe(list);
+            if (!probe) {
+                if (node > 0 && nodeOfCpu.size() >= online.size()) break;
+                if (node > 64 && nodeOfCpu.empty()) break;
+                continue; // 节点编号可能不连续
+            }
+            for (int cpu : ParseCpuList(ReadLine(list))) nodeOfCpu[cpu] = node;
+        }
+
+        std::map<std::pair<int, int>, int> coreIds; // (package, core_id) -> 全局编号
+        for (int cpu : online) {
+            if (haveMask && (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed))) continue;
+            const std::string dir = root + "/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            CpuInfo info;
+            info.cpu = cpu;
+            info.package = ReadInt(dir + "physical_package_id", 0);
+            const int coreId = ReadInt(dir + "core_id", cpu);
+            auto key = std::make_pair(info.package, coreId);
+            auto it = coreIds.find(key);
+            if (it == coreIds.end()) it = coreIds.emplace(key, static_cast<int>(coreIds.size())).first;
+            info.core = it->second;
+            auto node = nodeOfCpu.find(cpu);
+            info.node = (node != nodeOfCpu.end()) ? node->second : 0;
+            m_cpus.push_back(info);
+        }
+
+        const std::string cache = root + "/cpu/cpu" + std::to_string(m_cpus.empty() ? 0 : m_cpus[0].cpu) + "/cache/index";
+        for (int index = 0; index < 8; ++index) {
+            const int level = ReadInt(cache + std::to_string(index) + "/level", -1);
+            if (level < 0) break;
+            const size_t size = ParseSize(ReadLine(cache + std::to_string(index) + "/size"));
+            if (level == 2) m_l2Bytes = size;
+            if (level == 3) m_l3Bytes = size;
+        }
+    }
+#endif
+
+#if defined(_WIN32)
+    void DetectWindows() {
+        DWORD bytes = 0;
+        GetLogicalProcessorInformation(nullptr, &bytes);
+        std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> infos(bytes / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION) + 1);
+        if (!GetLogicalProcessorInformation(infos.data(), &bytes)) return;
+        infos.resize(bytes / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+
+        std::map<int, CpuInfo> cpus;
+        int core = 0, package = 0;
+        for (const auto& info : infos) {
+            for (int cpu = 0; cpu < 64; ++cpu) {
+                if (!(info.ProcessorMask & (ULONG_PTR(1) << cpu))) continue;
+                CpuInfo& c = cpus[cpu];
+                c.cpu = cpu;
+                if (info.Relationship == RelationProcessorCore) c.core = core;
+                else if (info.Relationship == RelationProcessorPackage) c.package = package;
+                else if (info.Relationship == RelationNumaNode) c.node = static_cast<int>(info.NumaNode.NodeNumber);
+                else if (info.Relationship == RelationCache && info.Cache.Level == 2 && cpu == 0) m_l2Bytes = info.Cache.Size;
+                else if (info.Relationship == RelationCache && info.Cache.Level == 3 && cpu == 0) m_l3Bytes = info.Cache.Size;
+            }
+            if (info.Relationship == RelationProcessorCore) ++core;
+            if (info.Relationship == RelationProcessorPackage) ++package;
+        }
+        DWORD_PTR processMask = 0, systemMask = 0;
+        GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask);
+        for (const auto& item : cpus) {
+            if (processMask && !(processMask & (DWORD_PTR(1) << item.first))) continue;
+            m_cpus.push_back(item.second);
+        }
+    }
+#endif
+
+    // 拿不到拓扑时：每个逻辑 CPU 视为一个物理核，单节点
+    void DetectFlat() {
+        unsigned count = std::thread::hardware_concurrency();
+        if (count == 0) count = 1;
+        for (unsigned cpu = 0; cpu < count; ++cpu) {
+            CpuInfo info;
+            info.cpu = static_cast<int>(cpu);
+            info.core = static_cast<int>(cpu);
+            m_cpus.push_back(info);
+        }
+    }
+
+    // 节点重新编号为 0 .. n-1，计算每个逻辑 CPU 在物理核中的序号
+    void Finish() {
+        std::sort(m_cpus.begin(), m_cpus.end(), [](const CpuInfo& a, const CpuInfo& b) { return a.cpu < b.cpu; });
+        std::map<int, int> nodes;
+        for (const auto& info : m_cpus) nodes.emplace(info.node, 0);
+        int next = 0;
+        for (auto& item : nodes) item.second = next++;
+        std::map<int, int> perCore;
+        std::set<int> cores;
+        for (auto& info : m_cpus) {
+            info.node = nodes[info.node];
+            info.smt = perCore[info.core]++;
+            cores.insert(info.core);
+        }
+        m_nodeCount = (std::max)(nodes.size(), size_t(1));
+        m_coreCount = cores.size();
+    }
+
+    std::vector<CpuInfo> m_cpus;
+    size_t m_coreCount = 0;
+    size_t m_nodeCount = 1;
+    size_t m_l2Bytes = 0;
+    size_t m_l3Bytes = 0;
+};
+
+// 把当前线程限制在给定的逻辑 CPU 上 (一个表示绑核，多个表示绑到一组，例如一个 NUMA 节点)
+// 不支持的平台或失败时返回 false，线程保持原来的亲和性
+inline bool PinCurrentThread(const std::vector<int>& cpus) {
+    if (cpus.empty()) return false;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < 64) mask |= DWORD_PTR(1) << cpu;
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    return false;
+#endif
+}
+
+// 当前线程正在哪个逻辑 CPU 上运行 (不支持时返回 -1)
+inline int CurrentCpu() {
+#if defined(__linux__)
+    return sched_getcpu();
+#elif defined(_WIN32)
+    return static_cast<int>(GetCurrentProcessorNumber());
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,166 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: ElasticPool.h
+// 对应需求: 阻塞 / IO 任务的弹性线程池 (按需扩容、空闲收缩)，不占用 CPU 工作线程
+// =================================================================================
+#pragma once
+#include "WorkStealingQueue.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <thread>
+
+// 弹性线程池参数
+struct ElasticPoolOptions {
+    unsigned minThreads = 0;    // 常驻线程数 (空闲时不收缩到这个数以下)
+    unsigned maxThreads = 16;   // 线程上限；0 表示关闭弹性池，阻塞任务留在 CPU 工作线程上执行
+    std::chrono::milliseconds keepAlive{ 5000 }; // 空闲多久后退出 (超过 minThreads 的部分)
+};
+
+// 各类执行器的排队等待统计 (就绪 -> 开始执行)
+struct ExecutorStats {
+    unsigned long long cpuTasks = 0;            // CPU 工作线程执行的非阻塞任务
+    unsigned long long cpuWaitTotalUs = 0;
+    long long cpuWaitMaxUs = 0;
+    unsigned long long blockingTasks = 0;       // 阻塞任务 (不论在哪个执行器上执行)
+    unsigned long long blockingWaitTotalUs = 0;
+    long long blockingWaitMaxUs = 0;
+    unsigned long long blockingOnWorkers = 0;   // 其中占用了 CPU 工作线程的次数 (弹性池关闭时)
+    size_t elasticThreads = 0;                  // 弹性池当前线程数
+    size_t elasticPeak = 0;                     // 弹性池线程数峰值
+};
+
+// 所有线程共享一个就绪队列 (沿用 WorkStealingQueue 的优先级 + EDF 出队规则)
+// - 提交时没有空闲线程且未达上限就新建一个线程，阻塞任务之间也不互相排队
+// - 线程空闲超过 keepAlive 后退出，退出的线程在下次提交或 Stop 时回收 (join)
+// 节点的执行逻辑由 handler 提供；Stop 只停止线程，队列中剩余的节点由调用方用 TryPop 取出处理
+template <typename Node>
+class ElasticPool {
+public:
+    using Handler = std::function<void(Node*)>;
+
+    ~ElasticPool() {
+        Stop();
+    }
+
+    void Start(const ElasticPoolOptions& options, Handler handler) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_running) return;
+        m_options = options;
+        m_handler = std::move(handler);
+        m_running = true;
+        for (unsigned i = 0; i < m_options.minThreads && i < m_options.maxThreads; ++i) SpawnLocked();
+    }
+
+    // 通知所有线程退出并等待 (正在执行的任务会先执行完)
+    void Stop() {
+        std::list<Worker> threads;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+            threads.swap(m_threads);
+        }
+        m_cv.notify_all();
+        for (auto& worker : threads) {
+            if (worker.thread.joinable()) worker.thread.join();
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending = 0;
+    }
+
+    void Submit(Node* node) {
+        m_queue.Push(node);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_pending;
+            ReapLocked();
+            if (m_running && m_idle < m_pending && m_live < m_options.maxThreads) SpawnLocked();
+        }
+        m_cv.notify_one();
+    }
+
+    // 取出一个未执行的节点 (Stop 之后清空队列用)
+    bool TryPop(Node*& out) {
+        return m_queue.TryPop(out);
+    }
+
+    void SetAgingStep(std::chrono::steady_clock::duration step) {
+        m_queue.SetAgingStep(step);
+    }
+
+    size_t ThreadCount() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_live;
+    }
+
+    size_t PeakThreads() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_peak;
+    }
+
+private:
+    struct Worker {
+        std::thread thread;
+        bool exited = false;
+    };
+    using WorkerIt = typename std::list<Worker>::iterator;
+
+    // 新线程先阻塞在 m_mutex 上，直到调用方释放锁
+    void SpawnLocked() {
+        m_threads.emplace_back();
+        WorkerIt self = std::prev(m_threads.end());
+        self->thread = std::thread(&ElasticPool::Loop, this, self);
+        ++m_live;
+        if (m_live > m_peak) m_peak = m_live;
+    }
+
+    // 回收已经退出的线程 (线程退出前最后一步是持锁设置 exited，之后不再加锁，join 不会死锁)
+    void ReapLocked() {
+        for (auto it = m_threads.begin(); it != m_threads.end();) {
+            if (it->exited) {
+                it->thread.join();
+                it = m_threads.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    void Loop(WorkerIt self) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_running) {
+            if (m_pending > 0) {
+                --m_pending;
+                lock.unlock();
+                Node* node = nullptr;
+                bool aged = false;
+                if (m_queue.TryPop(node, std::chrono::steady_clock::now(), aged)) m_handler(node);
+                lock.lock();
+                continue;
+            }
+            ++m_idle;
+            bool woken = m_cv.wait_for(lock, m_options.keepAlive,
+                [this] { return m_pending > 0 || !m_running; });
+            --m_idle;
+            if (!woken && m_live > m_options.minThreads) break; // 空闲超时，收缩
+        }
+        --m_live;
+        self->exited = true;
+    }
+
+    WorkStealingQueue<Node> m_queue;
+    ElasticPoolOptions m_options;
+    Handler m_handler;
+    std::list<Worker> m_threads;
+    size_t m_pending = 0;   // 已入队、尚未被线程领取的节点数
+    size_t m_idle = 0;      // 正在等待的线程数
+    size_t m_live = 0;      // 存活线程数
+    size_t m_peak = 0;
+    bool m_running = false;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+};
@@ -0,0 +1,245 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: EventChannel.h
+// 对应需求: 批量、非阻塞的 UI/事件通知通道 (Observer Pattern 异步版)
+// =================================================================================
+#pragma once
+#include "MpscRingBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 调度事件类型
+enum class SchedulerEventType : uint8_t {
+    Scheduled,
+    Executing,
+    Finished,
+    Cancelled,
+    Failed,
+    BatchScheduled,  // AddTasks 一次提交多个任务，只发一条汇总事件 (count 为任务数)
+    Rejected,        // 调度器满载，提交被拒绝
+    Coalesced        // 与同一合并键的已有任务合并，新提交不再单独执行
+};
+
+// 定长事件：发布时不做堆分配，名字超长时截断
+struct SchedulerEvent {
+    static constexpr size_t kMaxName = 47;
+
+    SchedulerEventType type = SchedulerEventType::Scheduled;
+    uint64_t taskId = 0;
+    int delayMs = 0;               // 仅 Scheduled 使用
+    uint32_t count = 1;            // 被合并的相同事件数量
+    std::chrono::steady_clock::time_point time;
+    char name[kMaxName + 1] = {};
+
+    void SetName(const std::string& value) {
+        SetName(value.data(), value.size());
+    }
+
+    void SetName(const char* value, size_t length) {
+        size_t len = length < kMaxName ? length : kMaxName;
+        std::memcpy(name, value, len);
+        name[len] = '\0';
+    }
+
+    // 与旧版 UI 回调一致的文本格式，合并过的事件追加 " xN"
+    std::string ToString() const {
+        std::string text;
+        switch (type) {
+        case SchedulerEventType::Scheduled:
+            text = std::string("Scheduled: ") + name + " (Delay: " + std::to_string(delayMs) + "ms)";
+            break;
+        case SchedulerEventType::Executing: text = std::string("Executing: ") + name; break;
+        case SchedulerEventType::Finished:  text = std::string("Finished: ") + name; break;
+        case SchedulerEventType::Cancelled: text = std::string("Cancelled: ") + name; break;
+        case SchedulerEventType::Failed:    text = std::string("Failed: ") + name; break;
+        case SchedulerEventType::Rejected:  text = std::string("Rejected: ") + name; break;
+        case SchedulerEventType::Coalesced: text = std::string("Coalesced: ") + name; break;
+        case SchedulerEventType::BatchScheduled:
+            return "Scheduled: " + std::to_string(count) + " tasks (Batch, first: " + name + ")";
+        }
+        if (count > 1) text += " x" + std::to_string(count);
+        return text;
+    }
+
+    // 合并判定：类型、名字、延迟都相同即视为“相同事件”
+    bool SameAs(const SchedulerEvent& other) const {
+        return type == other.type && delayMs == other.delayMs && std::strcmp(name, other.name) == 0;
+    }
+};
+
+// 无界面 (Headless) 订阅者接口：引擎可以脱离 MFC 运行与测试
+// OnEvents 在通道的分发线程上调用，同一订阅者不会被并发调用
+// 不要在 OnEvents 中同步等待其他线程 (例如 SendMessage 到 UI 线程)：UI 线程调用 Stop 时会等待分发线程退出，
+// 双方互相等待即死锁。需要更新界面时复制数据后 PostMessage
+class IEventSubscriber {
+public:
+    virtual ~IEventSubscriber() {}
+    virtual void OnEvents(const SchedulerEvent* events, size_t count) = 0;
+};
+
+// 用 lambda 实现的订阅者
+class CallbackEventSubscriber : public IEventSubscriber {
+public:
+    using Callback = std::function<void(const SchedulerEvent*, size_t)>;
+    explicit CallbackEventSubscriber(Callback cb) : m_cb(std::move(cb)) {}
+    void OnEvents(const SchedulerEvent* events, size_t count) override {
+        if (m_cb) m_cb(events, count);
+    }
+private:
+    Callback m_cb;
+};
+
+// 通道配置
+struct EventChannelOptions {
+    size_t capacity = 8192;                           // 队列容量，满了丢弃 (UI 事件不影响调度正确性)
+    std::chrono::milliseconds batchInterval{ 50 };    // 批量分发间隔 (即 UI 刷新频率)
+    size_t maxBatch = 512;                            // 单批最多分发的事件数
+    bool coalesce = true;                             // 合并同一批内的相同事件
+};
+
+// 事件通道：生产者 (调度线程) 无锁入队，独立分发线程按固定频率批量推送给订阅者
+class EventChannel {
+public:
+    EventChannel() : m_queue(std::make_unique<MpscRingBuffer<SchedulerEvent>>(m_options.capacity)) {}
+    EventChannel(const EventChannel&) = delete;
+    EventChannel& operator=(const EventChannel&) = delete;
+    ~EventChannel() { Stop(); }
+
+    // 只能在开始发布事件之前调用 (修改容量会重建队列)
+    void SetOptions(const EventChannelOptions& options) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_running) return;
+        if (options.capacity != m_options.capacity) {
+            m_queue = std::make_unique<MpscRingBuffer<SchedulerEvent>>(options.capacity);
+        }
+        m_options = options;
+        if (m_options.maxBatch == 0) m_options.maxBatch = 1;
+    }
+
+    // Start 之前发布的事件会暂存在队列中，启动后发出
+    void Start() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_running) return;
+        m_running = true;
+        m_thread = std::thread(&EventChannel::DispatchLoop, this);
+    }
+
+    // 停止分发线程，剩余事件会在退出前发出 (返回后不会再有回调)
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_running) return;
+            m_running = false;
+        }
+        m_cv.notify_one();
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    void Subscribe(std::shared_ptr<IEventSubscriber> subscriber) {
+        std::lock_guard<std::mutex> lock(m_subscriberMutex);
+        m_subscribers.push_back(std::move(subscriber));
+        m_hasSubscribers = true;
+    }
+
+    // 不等待正在进行的分发：返回时这个订阅者可能还在处理最后一批事件，
+    // 需要确认回调全部结束时在 Unsubscribe 之后调用 Stop
+    void Unsubscribe(const std::shared_ptr<IEventSubscriber>& subscriber) {
+        std::lock_guard<std::mutex> lock(m_subscriberMutex);
+        for (auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it) {
+            if (*it == subscriber) { m_subscribers.erase(it); break; }
+        }
+        m_hasSubscribers = !m_subscribers.empty();
+    }
+
+    // 没有订阅者时发布方可以跳过构造事件
+    bool HasSubscribers() const { return m_hasSubscribers.load(std::memory_order_relaxed); }
+
+    // 发布事件 (无锁，永不阻塞；队列满时丢弃并计数)
+    template <typename Fill>
+    void Publish(Fill&& fill) {
+        if (!m_queue->TryPushWith([&](SchedulerEvent& ev) {
+                ev = SchedulerEvent();
+                ev.time = std::chrono::steady_clock::now();
+                fill(ev);
+            })) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t GetDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    void DispatchLoop() {
+        std::vector<SchedulerEvent> batch;
+        batch.reserve(m_options.maxBatch);
+        for (;;) {
+            bool running;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_cv.wait_for(lock, m_options.batchInterval, [this] { return !m_running; });
+                running = m_running;
+            }
+
+            // 一轮可能分多批发出，保证每批不超过 maxBatch
+            SchedulerEvent ev;
+            bool more = true;
+            while (more) {
+                batch.clear();
+                while (batch.size() < m_options.maxBatch && (more = m_queue->TryPop(ev))) {
+                    if (m_options.coalesce && Coalesce(batch, ev)) continue;
+                    batch.push_back(ev);
+                }
+                if (!batch.empty()) Deliver(batch);
+            }
+            if (!running) break;
+        }
+    }
+
+    // 只与本批最后一个事件比较，相同则只累加计数
+    // 不能跨过中间的其他事件合并：否则后一次 Executing 会被并到前一次里，显示在两者之间的 Finished 之前
+    static bool Coalesce(std::vector<SchedulerEvent>& batch, const SchedulerEvent& ev) {
+        if (batch.empty() || !batch.back().SameAs(ev)) return false;
+        batch.back().count += ev.count;
+        return true;
+    }
+
+    // 在锁内复制订阅者列表，锁外回调：回调再慢也不会挡住 Subscribe / Unsubscribe
+    // 复制到分发线程自己的 m_delivering 中 (容量复用，订阅者不变时不分配内存)，回调后清空，不延长已退订者的生命期
+    void Deliver(const std::vector<SchedulerEvent>& batch) {
+        {
+            std::lock_guard<std::mutex> lock(m_subscriberMutex);
+            m_delivering.assign(m_subscribers.begin(), m_subscribers.end());
+        }
+        for (auto& subscriber : m_delivering) {
+            try {
+                subscriber->OnEvents(batch.data(), batch.size());
+            }
+            catch (...) {
+                // 订阅者异常不能影响分发线程
+            }
+        }
+        m_delivering.clear();
+    }
+
+    EventChannelOptions m_options;
+    std::unique_ptr<MpscRingBuffer<SchedulerEvent>> m_queue;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_running = false;
+
+    std::vector<std::shared_ptr<IEventSubscriber>> m_subscribers;
+    std::vector<std::shared_ptr<IEventSubscriber>> m_delivering;   // 只由分发线程使用
+    std::mutex m_subscriberMutex;
+    std::atomic<bool> m_hasSubscribers{ false };
+    std::atomic<uint64_t> m_dropped{ 0 };
+};
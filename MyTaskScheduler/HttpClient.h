@@ -0,0 +1,719 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: HttpClient.h
+// 对应需求: HTTP GET 与带缓存的获取：结果进入 ResultCache，过期后用 ETag / Last-Modified 条件请求
+//           重新验证 (304 时不重新传输内容)，同一 URL 的并发请求只发出一个
+// =================================================================================
+#pragma once
+#include "ResultCache.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <winhttp.h>
+#pragma comment(lib, "winhttp.lib")
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+using HttpHeaders = std::vector<std::pair<std::string, std::string>>;
+
+struct HttpResponse {
+    int status = 0;             // 0 表示没有收到响应 (error 说明原因)
+    HttpHeaders headers;
+    std::string body;
+    std::string error;
+
+    // 按名字取响应头 (不区分大小写，没有时返回空串)
+    std::string Header(const char* name) const {
+        for (const auto& header : headers) {
+            if (header.first.size() == std::strlen(name)
+                && std::equal(header.first.begin(), header.first.end(), name,
+                    [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); })) {
+                return header.second;
+            }
+        }
+        return std::string();
+    }
+};
+
+// 异步请求的完成回调
+using HttpCallback = std::function<void(HttpResponse&& response)>;
+
+// http(s)://host[:port]/path?query
+struct HttpUrl {
+    bool https = false;
+    std::string host;
+    int port = 80;
+    std::string target = "/";   // 路径 + 查询串
+
+    static bool Parse(const std::string& url, HttpUrl& out) {
+        size_t pos = 0;
+        if (url.compare(0, 7, "http://") == 0) { out.https = false; out.port = 80; pos = 7; }
+        else if (url.compare(0, 8, "https://") == 0) { out.https = true; out.port = 443; pos = 8; }
+        else return false;
+        const size_t slash = url.find('/', pos);
+        std::string authority = url.substr(pos, (slash == std::string::npos) ? std::string::npos : slash - pos);
+        out.target = (slash == std::string::npos) ? "/" : url.substr(slash);
+        const size_t colon = authority.rfind(':');
+        if (colon != std::string::npos && authority.find(']') == std::string::npos) {
+            out.port = std::atoi(authority.c_str() + colon + 1);
+            authority.resize(colon);
+        }
+        out.host = authority;
+        return !out.host.empty() && out.port > 0 && out.port < 65536;
+    }
+
+    // Host 头：非默认端口时带上端口
+    std::string HostHeader() const {
+        return (port == (https ? 443 : 80)) ? host : host + ":" + std::to_string(port);
+    }
+};
+
+// 增量解析 HTTP/1.1 响应：收到多少喂多少，支持 Content-Length、chunked 与以关闭连接结束的响应
+class HttpResponseParser {
+public:
+    enum class Result { NeedMore, Done, Error };
+
+    // headRequest: 对应请求是 HEAD (响应没有正文)
+    void Reset(bool headRequest = false) {
+        m_response = HttpResponse();
+        m_buffer.clear();
+        m_offset = 0;
+        m_state = State::Head;
+        m_remaining = 0;
+        m_keepAlive = true;
+        m_headRequest = headRequest;
+    }
+
+    Result Feed(const char* data, size_t size) {
+        m_buffer.append(data, size);
+        return Parse();
+    }
+
+    // 连接被对方关闭：只有 "读到关闭为止" 的正文以此结束，其余情况是不完整的响应
+    Result FinishOnClose() {
+        if (m_state == State::UntilClose) {
+            m_response.body.append(m_buffer, m_offset, std::string::npos);
+            m_state = State::Done;
+            m_keepAlive = false;
+            return Result::Done;
+        }
+        return (m_state == State::Done) ? Result::Done : Result::Error;
+    }
+
+    HttpResponse& Response() { return m_response; }
+    // 响应结束后连接能否复用 (HTTP/1.1 默认复用，Connection: close 或以关闭结束的正文除外)
+    bool KeepAlive() const { return m_keepAlive && m_state == State::Done; }
+    // 本次解析之后多收到的字节 (不应出现：客户端一次只发一个请求)
+    size_t Leftover() const { return m_buffer.size() - m_offset; }
+
+private:
+    enum class State { Head, Body, ChunkSize, ChunkData, ChunkEnd, Trailer, UntilClose, Done };
+
+    Result Parse() {
+        for (;;) {
+            switch (m_state) {
+            case State::Head: {
+                const size_t end = m_buffer.find("\r\n\r\n", m_offset);
+                if (end == std::string::npos) return NeedMoreOr(64 * 1024);
+                if (!ParseHead(m_buffer.substr(m_offset, end - m_offset))) return Result::Error;
+                m_offset = end + 4;
+                break;
+            }
+            case State::Body: {
+                const size_t take = (std::min)(m_remaining, m_buffer.size() - m_offset);
+                m_response.body.append(m_buffer, m_offset, take);
+                m_offset += take;
+                m_remaining -= take;
+                if (m_remaining > 0) return Compact();
+                m_state = State::Done;
+                break;
+            }
+            case State::ChunkSize: {
+                const size_t end = m_buffer.find("\r\n", m_offset);
+                if (end == std::string::npos) return NeedMoreOr(1024);
+                char* stop = nullptr;
+                const std::string line = m_buffer.substr(m_offset, end - m_offset);
+                m_remaining = std::strtoul(line.c_str(), &stop, 16);
+                if (stop == line.c_str()) return Result::Error;
+                m_offset = end + 2;
+                m_state = (m_remaining == 0) ? State::Trailer : State::ChunkData;
+                break;
+            }
+            case State::ChunkData: {
+                const size_t take = (std::min)(m_remaining, m_buffer.size() - m_offset);
+                m_response.body.append(m_buffer, m_offset, take);
+                m_offset += take;
+                m_remaining -= take;
+                if (m_remaining > 0) return Compact();
+                m_state = State::ChunkEnd;
+                break;
+            }
+            case State::ChunkEnd:
+                if (m_buffer.size() - m_offset < 2) return Compact();
+                if (m_buffer.compare(m_offset, 2, "\r\n") != 0) return Result::Error;
+                m_offset += 2;
+                m_state = State::ChunkSize;
+                break;
+            case State::Trailer: {
+                // 结尾的空行 (忽略 trailer 头)
+                const size_t end = m_buffer.find("\r\n", m_offset);
+                if (end == std::string::npos) return NeedMoreOr(8 * 1024);
+                const bool last = (end == m_offset);
+                m_offset = end + 2;
+                if (last) m_state = State::Done;
+                break;
+            }
+            case State::UntilClose:
+                return Compact(); // 正文留在缓冲区，关闭时一次取出
+            case State::Done:
+                return Result::Done;
+            }
+        }
+    }
+
+    bool ParseHead(const std::string& head) {
+        // 状态行: HTTP/1.1 200 OK
+        size_t lineEnd = head.find("\r\n");
+        const std::string statusLine = head.substr(0, lineEnd);
+        if (statusLine.compare(0, 5, "HTTP/") != 0) return false;
+        const size_t space = statusLine.find(' ');
+        if (space == std::string::npos) return false;
+        m_response.status = std::atoi(statusLine.c_str() + space + 1);
+        if (m_response.status < 100) return false;
+        const bool http10 = statusLine.compare(0, 8, "HTTP/1.0") == 0;
+        m_keepAlive = !http10;
+
+        while (lineEnd != std::string::npos) {
+            const size_t start = lineEnd + 2;
+            lineEnd = head.find("\r\n", start);
+            const std::string line = head.substr(start, (lineEnd == std::string::npos) ? std::string::npos : lineEnd - start);
+            const size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            size_t valueStart = colon + 1;
+            while (valueStart < line.size() && (line[valueStart] == ' ' || line[valueStart] == '\t')) ++valueStart;
+            m_response.headers.emplace_back(line.substr(0, colon), line.substr(valueStart));
+        }
+
+        const std::string connection = Lower(m_response.Header("Connection"));
+        if (connection.find("close") != std::string::npos) m_keepAlive = false;
+        if (connection.find("keep-alive") != std::string::npos) m_keepAlive = true;
+
+        const int status = m_response.status;
+        if (m_headRequest || status == 204 || status == 304 || (status >= 100 && status < 200)) {
+            m_state = State::Done; // 没有正文
+        }
+        else if (Lower(m_response.Header("Transfer-Encoding")).find("chunked") != std::string::npos) {
+            m_state = State::ChunkSize;
+        }
+        else if (!m_response.Header("Content-Length").empty()) {
+            m_remaining = std::strtoull(m_response.Header("Content-Length").c_str(), nullptr, 10);
+            m_response.body.reserve(m_remaining);
+            m_state = State::Body;
+        }
+        else {
+            m_state = State::UntilClose;
+            m_keepAlive = false;
+        }
+        return true;
+    }
+
+    // 丢弃已解析的部分，避免大正文在缓冲区里反复搬移
+    Result Compact() {
+        if (m_offset > 0 && m_state != State::UntilClose) {
+            m_buffer.erase(0, m_offset);
+            m_offset = 0;
+        }
+        return Result::NeedMore;
+    }
+
+    // 在找分隔符：缓冲区超过 limit 仍没有找到时视为格式错误
+    Result NeedMoreOr(size_t limit) {
+        return (m_buffer.size() - m_offset > limit) ? Result::Error : Compact();
+    }
+
+    static std::string Lower(std::string text) {
+        for (char& c : text) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return text;
+    }
+
+    HttpResponse m_response;
+    std::string m_buffer;
+    size_t m_offset = 0;
+    State m_state = State::Head;
+    size_t m_remaining = 0;
+    bool m_keepAlive = true;
+    bool m_headRequest = false;
+};
+
+namespace HttpDetail {
+
+// 请求报文 (只有 GET，没有正文)
+inline std::string BuildGet(const HttpUrl& url, const HttpHeaders& headers, bool keepAlive) {
+    std::string request;
+    request.reserve(128 + url.target.size());
+    request += "GET ";
+    request += url.target;
+    request += " HTTP/1.1\r\nHost: ";
+    request += url.HostHeader();
+    request += keepAlive ? "\r\nConnection: keep-alive\r\n" : "\r\nConnection: close\r\n";
+    request += "Accept-Encoding: identity\r\nUser-Agent: MyTaskScheduler/1.0\r\n";
+    for (const auto& header : headers) {
+        request += header.first;
+        request += ": ";
+        request += header.second;
+        request += "\r\n";
+    }
+    request += "\r\n";
+    return request;
+}
+
+#if defined(_WIN32)
+
+inline std::wstring Widen(const std::string& text) {
+    if (text.empty()) return std::wstring();
+    const int size = ::MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0);
+    std::wstring wide(static_cast<size_t>(size), L'\0');
+    ::MultiByteToWideChar(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), &wide[0], size);
+    return wide;
+}
+
+inline std::string Narrow(const std::wstring& text) {
+    if (text.empty()) return std::string();
+    const int size = ::WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), nullptr, 0, nullptr, nullptr);
+    std::string narrow(static_cast<size_t>(size), '\0');
+    ::WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()), &narrow[0], size, nullptr, nullptr);
+    return narrow;
+}
+
+struct WinHttpHandle {
+    HINTERNET handle = nullptr;
+    explicit WinHttpHandle(HINTERNET h) : handle(h) {}
+    ~WinHttpHandle() { if (handle) ::WinHttpCloseHandle(handle); }
+    WinHttpHandle(const WinHttpHandle&) = delete;
+    WinHttpHandle& operator=(const WinHttpHandle&) = delete;
+};
+
+// Windows：WinHTTP (支持 https，使用系统代理设置)
+inline HttpResponse Get(const HttpUrl& url, const HttpHeaders& headers, std::chrono::milliseconds timeout) {
+    HttpResponse response;
+    WinHttpHandle session(::WinHttpOpen(L"MyTaskScheduler/1.0", WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+        WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0));
+    if (!session.handle) { response.error = "WinHttpOpen failed"; return response; }
+    const int ms = static_cast<int>(timeout.count());
+    ::WinHttpSetTimeouts(session.handle, ms, ms, ms, ms);
+
+    WinHttpHandle connect(::WinHttpConnect(session.handle, Widen(url.host).c_str(), static_cast<INTERNET_PORT>(url.port), 0));
+    if (!connect.handle) { response.error = "WinHttpConnect failed"; return response; }
+    WinHttpHandle request(::WinHttpOpenRequest(connect.handle, L"GET", Widen(url.target).c_str(), nullptr,
+        WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, url.https ? WINHTTP_FLAG_SECURE : 0));
+    if (!request.handle) { response.error = "WinHttpOpenRequest failed"; return response; }
+
+    std::wstring extra;
+    for (const auto& header : headers) extra += Widen(header.first + ": " + header.second + "\r\n");
+    if (!::WinHttpSendRequest(request.handle, extra.empty() ? WINHTTP_NO_ADDITIONAL_HEADERS : extra.c_str(),
+            static_cast<DWORD>(-1L), WINHTTP_NO_REQUEST_DATA, 0, 0, 0)
+        || !::WinHttpReceiveResponse(request.handle, nullptr)) {
+        response.error = "request failed (error " + std::to_string(::GetLastError()) + ")";
+        return response;
+    }
+
+    DWORD status = 0;
+    DWORD size = sizeof(status);
+    ::WinHttpQueryHeaders(request.handle, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+        WINHTTP_HEADER_NAME_BY_INDEX, &status, &size, WINHTTP_NO_HEADER_INDEX);
+    response.status = static_cast<int>(status);
+
+    // 原始响应头 "Name: value\r\n..." (第一行是状态行)
+    size = 0;
+    ::WinHttpQueryHeaders(request.handle, WINHTTP_QUERY_RAW_HEADERS_CRLF, WINHTTP_HEADER_NAME_BY_INDEX,
+        WINHTTP_NO_OUTPUT_BUFFER, &size, WINHTTP_NO_HEADER_INDEX);
+    if (size > 0) {
+        std::wstring raw(size / sizeof(wchar_t), L'\0');
+        if (::WinHttpQueryHeaders(request.handle, WINHTTP_QUERY_RAW_HEADERS_CRLF, WINHTTP_HEADER_NAME_BY_INDEX,
+                &raw[0], &size, WINHTTP_NO_HEADER_INDEX)) {
+            const std::string text = Narrow(raw.substr(0, size / sizeof(wchar_t)));
+            size_t start = text.find("\r\n");
+            while (start != std::string::npos) {
+                start += 2;
+                const size_t end = text.find("\r\n", start);
+                const std::string line = text.substr(start, (end == std::string::npos) ? std::string::npos : end - start);
+                const size_t colon = line.find(':');
+                if (colon != std::string::npos) {
+                    size_t valueStart = colon + 1;
+                    while (valueStart < line.size() && line[valueStart] == ' ') ++valueStart;
+                    response.headers.emplace_back(line.substr(0, colon), line.substr(valueStart));
+                }
+                start = end;
+            }
+        }
+    }
+
+    for (;;) {
+        DWORD available = 0;
+        if (!::WinHttpQueryDataAvailable(request.handle, &available) || available == 0) break;
+        const size_t offset = response.body.size();
+        response.body.resize(offset + available);
+        DWORD read = 0;
+        if (!::WinHttpReadData(request.handle, &response.body[offset], available, &read)) {
+            response.body.resize(offset);
+            break;
+        }
+        response.body.resize(offset + read);
+    }
+    return response;
+}
+
+#else
+
+// 关闭时自动 close 的套接字
+struct Socket {
+    int fd = -1;
+    Socket() = default;
+    explicit Socket(int f) : fd(f) {}
+    ~Socket() { if (fd >= 0) ::close(fd); }
+    Socket(Socket&& other) noexcept : fd(other.fd) { other.fd = -1; }
+    Socket& operator=(Socket&& other) noexcept {
+        if (this != &other) {
+            if (fd >= 0) ::close(fd);
+            fd = other.fd;
+            other.fd = -1;
+        }
+        return *this;
+    }
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+};
+
+// 阻塞连接 (收发超时同样作用于 connect)，失败时 error 说明原因
+inline Socket Connect(const HttpUrl& url, std::chrono::milliseconds timeout, std::string& error) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* list = nullptr;
+    const int rc = ::getaddrinfo(url.host.c_str(), std::to_string(url.port).c_str(), &hints, &list);
+    if (rc != 0) {
+        error = std::string("resolve failed: ") + ::gai_strerror(rc);
+        return Socket();
+    }
+    timeval tv{};
+    tv.tv_sec = static_cast<long>(timeout.count() / 1000);
+    tv.tv_usec = static_cast<long>((timeout.count() % 1000) * 1000);
+    Socket socket;
+    for (addrinfo* ai = list; ai; ai = ai->ai_next) {
+        Socket candidate(::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol));
+        if (candidate.fd < 0) continue;
+        ::setsockopt(candidate.fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        ::setsockopt(candidate.fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        const int one = 1;
+        ::setsockopt(candidate.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (::connect(candidate.fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            socket = std::move(candidate);
+            break;
+        }
+    }
+    ::freeaddrinfo(list);
+    if (socket.fd < 0) error = "connect failed: " + url.host + ":" + std::to_string(url.port);
+    return socket;
+}
+
+inline bool SendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// POSIX：一个请求一个连接 (Connection: close)；没有 TLS，只支持 http
+inline HttpResponse Get(const HttpUrl& url, const HttpHeaders& headers, std::chrono::milliseconds timeout) {
+    HttpResponse response;
+    if (url.https) {
+        response.error = "https is not supported on this platform (no TLS)";
+        return response;
+    }
+    Socket socket = Connect(url, timeout, response.error);
+    if (socket.fd < 0) return response;
+    if (!SendAll(socket.fd, BuildGet(url, headers, false))) {
+        response.error = "send failed";
+        return response;
+    }
+
+    HttpResponseParser parser;
+    parser.Reset();
+    char buffer[16 * 1024];
+    HttpResponseParser::Result result = HttpResponseParser::Result::NeedMore;
+    while (result == HttpResponseParser::Result::NeedMore) {
+        const ssize_t n = ::recv(socket.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) result = parser.Feed(buffer, static_cast<size_t>(n));
+        else if (n == 0) result = parser.FinishOnClose();
+        else {
+            response.error = "receive failed or timed out";
+            return response;
+        }
+    }
+    if (result == HttpResponseParser::Result::Error) {
+        response.error = "malformed or truncated response";
+        return response;
+    }
+    return std::move(parser.Response());
+}
+
+#endif
+
+} // namespace HttpDetail
+
+// 同步 GET，返回状态码、响应头与正文；网络错误时 status 为 0
+inline HttpResponse HttpGet(const std::string& url, const HttpHeaders& headers = HttpHeaders(),
+    std::chrono::milliseconds timeout = std::chrono::milliseconds(10000)) {
+    HttpUrl parsed;
+    if (!HttpUrl::Parse(url, parsed)) {
+        HttpResponse response;
+        response.error = "invalid url: " + url;
+        return response;
+    }
+    return HttpDetail::Get(parsed, headers, timeout);
+}
+
+// 一次带缓存的获取结果
+struct HttpFetchResult {
+    bool ok = false;            // 拿到了内容 (新下载、缓存命中或过期内容兜底)
+    int status = 0;             // 源站的状态码 (没有访问源站时为 0)
+    CachedResultPtr result;     // 内容在 result->value
+    bool fromCache = false;     // 没有访问源站 (新鲜命中，或者等待了同一 URL 进行中的请求)
+    bool revalidated = false;   // 条件请求返回 304，沿用缓存内容
+    bool stale = false;         // 源站不可用，返回了过期的缓存内容
+    std::string error;
+
+    const std::string& Body() const {
+        static const std::string empty;
+        return result ? result->value : empty;
+    }
+};
+
+struct HttpCacheStats {
+    unsigned long long fetches = 0;        // Fetch 调用次数
+    unsigned long long requests = 0;       // 实际发到源站的请求
+    unsigned long long downloaded = 0;     // 200：下载了新内容
+    unsigned long long notModified = 0;    // 304：内容未变化
+    unsigned long long failures = 0;       // 网络错误或其他状态码
+    unsigned long long staleServed = 0;    // 失败时返回了过期内容
+    unsigned long long bytesDownloaded = 0;
+};
+
+// 带缓存的 HTTP 获取 (只用于幂等的 GET)
+// 新鲜内容直接返回；过期内容带 If-None-Match / If-Modified-Since 重新验证；同一 URL 的并发获取只发一个请求
+// 有效期取响应的 Cache-Control: max-age，没有时使用构造时的 ttl；no-cache / no-store 的内容每次都重新验证
+class CachedHttpClient {
+public:
+    // 发出请求的函数 (默认 HttpGet)，可替换为连接池或测试桩
+    using Transport = std::function<HttpResponse(const std::string& url, const HttpHeaders& headers)>;
+    // 异步发出请求，完成时调用 done (例如 HttpEngine::AsyncTransport)
+    using AsyncTransport = std::function<void(const std::string& url, const HttpHeaders& headers, HttpCallback done)>;
+    using FetchCallback = std::function<void(HttpFetchResult&& result)>;
+
+    // asyncTransport 只用于 FetchAsync (为空时 FetchAsync 退化为同步 Fetch)
+    explicit CachedHttpClient(ResultCache& cache = ResultCache::Instance(),
+        std::chrono::milliseconds ttl = std::chrono::milliseconds(60000), Transport transport = nullptr,
+        AsyncTransport asyncTransport = nullptr)
+        : m_cache(cache), m_ttl(ttl), m_transport(std::move(transport)), m_asyncTransport(std::move(asyncTransport)) {
+        if (!m_transport) {
+            m_transport = [](const std::string& url, const HttpHeaders& headers) { return HttpGet(url, headers); };
+        }
+    }
+
+    HttpFetchResult Fetch(const std::string& url) {
+        m_stats.fetches.fetch_add(1, std::memory_order_relaxed);
+        const std::string key = ResultCache::MakeKey("HTTP GET", url);
+        HttpFetchResult fetch;
+        bool loaded = false;
+        fetch.result = m_cache.GetOrLoad(key, [&](const CachedResultPtr& stale) -> std::shared_ptr<CachedResult> {
+            loaded = true;
+            return Load(url, stale, fetch);
+        }, m_ttl);
+        fetch.fromCache = !loaded;
+        Finish(key, fetch);
+        return fetch;
+    }
+
+    // 异步获取：新鲜命中时在调用线程上直接回调；否则由异步传输发出 (条件) 请求，在它的回调线程上完成
+    // 调用方不等待网络；回调执行时本对象必须仍然存在
+    // 同一 URL 的并发异步获取只发一个请求：后来者的 done 排在进行中的请求上，响应到达后依次回调 (fromCache 为 true)
+    void FetchAsync(const std::string& url, FetchCallback done) {
+        if (!m_asyncTransport) {
+            done(Fetch(url));
+            return;
+        }
+        m_stats.fetches.fetch_add(1, std::memory_order_relaxed);
+        std::string key = ResultCache::MakeKey("HTTP GET", url);
+        HttpFetchResult fetch;
+        fetch.result = m_cache.Get(key);
+        if (fetch.result) {
+            fetch.fromCache = true;
+            fetch.ok = true;
+            done(std::move(fetch));
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_flightMutex);
+            auto it = m_flights.find(key);
+            if (it != m_flights.end()) {
+                it->second.push_back(std::move(done));
+                return;
+            }
+            m_flights.emplace(key, std::vector<FetchCallback>());
+        }
+        CachedResultPtr stale = m_cache.Peek(key);
+        m_stats.requests.fetch_add(1, std::memory_order_relaxed);
+        m_asyncTransport(url, RevalidateHeaders(stale),
+            [this, key = std::move(key), stale, done = std::move(done)](HttpResponse&& response) {
+                HttpFetchResult fetch;
+                std::shared_ptr<CachedResult> entry = Accept(response, stale, fetch);
+                if (entry) fetch.result = m_cache.Put(key, std::move(entry), m_ttl);
+                const CachedResultPtr fresh = fetch.result;
+                const std::string error = fetch.error;
+                Finish(key, fetch);
+
+                // 先摘下等待者再回调：回调中再次获取同一 URL 时会发起新的请求，而不是排到已经完成的这一个上
+                std::vector<FetchCallback> waiters;
+                {
+                    std::lock_guard<std::mutex> lock(m_flightMutex);
+                    auto it = m_flights.find(key);
+                    waiters.swap(it->second);
+                    m_flights.erase(it);
+                }
+                done(std::move(fetch));
+                for (FetchCallback& waiter : waiters) {
+                    HttpFetchResult shared;
+                    shared.result = fresh;
+                    shared.fromCache = true;
+                    shared.error = error;
+                    Finish(key, shared);
+                    waiter(std::move(shared));
+                }
+            });
+    }
+
+    HttpCacheStats GetStats() const {
+        HttpCacheStats stats;
+        stats.fetches = m_stats.fetches.load();
+        stats.requests = m_stats.requests.load();
+        stats.downloaded = m_stats.downloaded.load();
+        stats.notModified = m_stats.notModified.load();
+        stats.failures = m_stats.failures.load();
+        stats.staleServed = m_stats.staleServed.load();
+        stats.bytesDownloaded = m_stats.bytesDownloaded.load();
+        return stats;
+    }
+
+private:
+    std::shared_ptr<CachedResult> Load(const std::string& url, const CachedResultPtr& stale, HttpFetchResult& fetch) {
+        m_stats.requests.fetch_add(1, std::memory_order_relaxed);
+        HttpResponse response = m_transport(url, RevalidateHeaders(stale));
+        return Accept(response, stale, fetch);
+    }
+
+    static HttpHeaders RevalidateHeaders(const CachedResultPtr& stale) {
+        HttpHeaders headers;
+        if (stale && !stale->etag.empty()) headers.emplace_back("If-None-Match", stale->etag);
+        if (stale && !stale->lastModified.empty()) headers.emplace_back("If-Modified-Since", stale->lastModified);
+        return headers;
+    }
+
+    // 由源站的响应生成新条目 (304 沿用 stale 的内容)；失败时返回空
+    std::shared_ptr<CachedResult> Accept(HttpResponse& response, const CachedResultPtr& stale, HttpFetchResult& fetch) {
+        fetch.status = response.status;
+
+        std::shared_ptr<CachedResult> entry;
+        if (response.status == 304 && stale) {
+            m_stats.notModified.fetch_add(1, std::memory_order_relaxed);
+            fetch.revalidated = true;
+            entry = std::make_shared<CachedResult>(*stale);
+            entry->expiresAt = std::chrono::steady_clock::time_point();
+            const std::string etag = response.Header("ETag");
+            if (!etag.empty()) entry->etag = etag;
+            const std::string lastModified = response.Header("Last-Modified");
+            if (!lastModified.empty()) entry->lastModified = lastModified;
+        }
+        else if (response.status == 200) {
+            m_stats.downloaded.fetch_add(1, std::memory_order_relaxed);
+            m_stats.bytesDownloaded.fetch_add(response.body.size(), std::memory_order_relaxed);
+            entry = std::make_shared<CachedResult>();
+            entry->value = std::move(response.body);
+            entry->etag = response.Header("ETag");
+            entry->lastModified = response.Header("Last-Modified");
+        }
+        else {
+            m_stats.failures.fetch_add(1, std::memory_order_relaxed);
+            fetch.error = !response.error.empty() ? response.error : "HTTP status " + std::to_string(response.status);
+            return nullptr;
+        }
+        ApplyCacheControl(response.Header("Cache-Control"), *entry);
+        return entry;
+    }
+
+    // 没有拿到新内容：源站不可用时用过期内容兜底
+    void Finish(const std::string& key, HttpFetchResult& fetch) {
+        if (!fetch.result) {
+            fetch.result = m_cache.Peek(key);
+            fetch.stale = (fetch.result != nullptr);
+            if (fetch.stale) m_stats.staleServed.fetch_add(1, std::memory_order_relaxed);
+            else if (fetch.error.empty()) fetch.error = "request failed";
+        }
+        fetch.ok = (fetch.result != nullptr);
+    }
+
+    // max-age=N 覆盖默认有效期；no-cache / no-store 立即过期 (保留校验信息，下次重新验证)
+    static void ApplyCacheControl(const std::string& value, CachedResult& entry) {
+        if (value.empty()) return;
+        const auto now = std::chrono::steady_clock::now();
+        if (value.find("no-cache") != std::string::npos || value.find("no-store") != std::string::npos) {
+            entry.expiresAt = now;
+            return;
+        }
+        const size_t pos = value.find("max-age=");
+        if (pos != std::string::npos) {
+            entry.expiresAt = now + std::chrono::seconds(std::strtol(value.c_str() + pos + 8, nullptr, 10));
+        }
+    }
+
+    struct Counters {
+        std::atomic<unsigned long long> fetches{ 0 };
+        std::atomic<unsigned long long> requests{ 0 };
+        std::atomic<unsigned long long> downloaded{ 0 };
+        std::atomic<unsigned long long> notModified{ 0 };
+        std::atomic<unsigned long long> failures{ 0 };
+        std::atomic<unsigned long long> staleServed{ 0 };
+        std::atomic<unsigned long long> bytesDownloaded{ 0 };
+    };
+
+    ResultCache& m_cache;
+    std::chrono::milliseconds m_ttl;
+    Transport m_transport;
+    AsyncTransport m_asyncTransport;
+    Counters m_stats;
+
+    std::mutex m_flightMutex;                                            // 保护 m_flights
+    std::unordered_map<std::string, std::vector<FetchCallback>> m_flights; // 进行中的异步请求 -> 排队的后来者
+};
@@ -0,0 +1,971 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: HttpEngine.h
+// 对应需求: 非阻塞 HTTP/1.1 获取引擎：一个 IO 线程 (Linux 用 epoll，其他平台用 poll / WSAPoll)
+//           同时推进大量在途请求，按主机复用 keep-alive 连接，响应流式解析到内存，每个请求单独超时
+// =================================================================================
+#pragma once
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#include "HttpClient.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+#endif
+
+// 一个异步请求 (只有 GET)
+struct HttpRequest {
+    std::string url;
+    HttpHeaders headers;
+    std::chrono::milliseconds timeout{ 10000 };  // 从提交到收完响应的总时限
+};
+
+struct HttpEngineOptions {
+    size_t maxConnectionsPerHost = 8;            // 每个主机同时打开的连接上限，超出的请求在该主机上排队
+    size_t maxIdlePerHost = 8;                   // 每个主机保留的空闲 keep-alive 连接上限
+    std::chrono::milliseconds idleTimeout{ 30000 }; // 空闲连接保留多久
+};
+
+struct HttpEngineStats {
+    unsigned long long requests = 0;             // Fetch 调用次数
+    unsigned long long completed = 0;            // 收到完整响应 (任意状态码)
+    unsigned long long failed = 0;               // 解析、连接、网络错误 (不含超时)
+    unsigned long long timedOut = 0;
+    unsigned long long retried = 0;              // 复用的连接已被对方关闭，换新连接重发
+    unsigned long long connectionsOpened = 0;
+    unsigned long long connectionsReused = 0;    // 在空闲连接上发出的请求
+    size_t inFlight = 0;                         // 已提交、尚未回调的请求
+    size_t openConnections = 0;
+    size_t idleConnections = 0;
+    size_t peakInFlight = 0;
+};
+
+namespace HttpEngineDetail {
+
+#if defined(_WIN32)
+using NativeSocket = SOCKET;
+constexpr NativeSocket kInvalidSocket = INVALID_SOCKET;
+inline void CloseSocket(NativeSocket fd) { ::closesocket(fd); }
+inline bool SetNonBlocking(NativeSocket fd) { u_long on = 1; return ::ioctlsocket(fd, FIONBIO, &on) == 0; }
+inline int LastError() { return ::WSAGetLastError(); }
+inline bool WouldBlock(int error) { return error == WSAEWOULDBLOCK; }
+inline bool ConnectPending(int error) { return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS; }
+inline int SendSome(NativeSocket fd, const char* data, size_t size) { return ::send(fd, data, static_cast<int>(size), 0); }
+inline int RecvSome(NativeSocket fd, char* data, size_t size) { return ::recv(fd, data, static_cast<int>(size), 0); }
+#else
+using NativeSocket = int;
+constexpr NativeSocket kInvalidSocket = -1;
+inline void CloseSocket(NativeSocket fd) { ::close(fd); }
+inline bool SetNonBlocking(NativeSocket fd) {
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+inline int LastError() { return errno; }
+inline bool WouldBlock(int error) { return error == EAGAIN || error == EWOULDBLOCK; }
+inline bool ConnectPending(int error) { return error == EINPROGRESS; }
+inline int SendSome(NativeSocket fd, const char* data, size_t size) {
+    return static_cast<int>(::send(fd, data, size, MSG_NOSIGNAL));
+}
+inline int RecvSome(NativeSocket fd, char* data, size_t size) { return static_cast<int>(::recv(fd, data, size, 0)); }
+#endif
+
+// 就绪通知：Linux 用 epoll (水平触发)，其他平台用 poll / WSAPoll
+// 每个套接字只关心 "可读" 和/或 "可写"；错误与挂断总是报告
+class Poller {
+public:
+    struct Event {
+        NativeSocket fd;
+        bool readable;
+        bool writable;
+        bool error;
+    };
+
+    ~Poller() { Close(); }
+
+    bool Open() {
+#if defined(__linux__)
+        m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+        return m_epoll >= 0;
+#else
+        return true;
+#endif
+    }
+
+    void Close() {
+#if defined(__linux__)
+        if (m_epoll >= 0) ::close(m_epoll);
+        m_epoll = -1;
+        m_registered.clear();
+#else
+        m_fds.clear();
+        m_index.clear();
+#endif
+    }
+
+    // 登记或修改关心的事件
+    void Set(NativeSocket fd, bool wantRead, bool wantWrite) {
+#if defined(__linux__)
+        const uint32_t events = (wantRead ? EPOLLIN : 0u) | (wantWrite ? EPOLLOUT : 0u);
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        auto it = m_registered.find(fd);
+        if (it == m_registered.end()) {
+            ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev);
+            m_registered.emplace(fd, events);
+        }
+        else if (it->second != events) {
+            ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &ev);
+            it->second = events;
+        }
+#else
+        const short events = static_cast<short>((wantRead ? POLLIN : 0) | (wantWrite ? POLLOUT : 0));
+        auto it = m_index.find(fd);
+        if (it == m_index.end()) {
+            m_index.emplace(fd, m_fds.size());
+            pollfd p{};
+            p.fd = fd;
+            p.events = events;
+            m_fds.push_back(p);
+        }
+        else {
+            m_fds[it->second].events = events;
+        }
+#endif
+    }
+
+    // 关闭套接字之前调用
+    void Remove(NativeSocket fd) {
+#if defined(__linux__)
+        if (m_registered.erase(fd) > 0) ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+#else
+        auto it = m_index.find(fd);
+        if (it == m_index.end()) return;
+        const size_t slot = it->second;
+        m_index.erase(it);
+        if (slot + 1 != m_fds.size()) {
+            m_fds[slot] = m_fds.back();
+            m_index[m_fds[slot].fd] = slot;
+        }
+        m_fds.pop_back();
+#endif
+    }
+
+    // 等待至多 timeoutMs 毫秒 (-1 表示一直等)，就绪的套接字放入 events
+    void Wait(std::vector<Event>& events, int timeoutMs) {
+        events.clear();
+#if defined(__linux__)
+        epoll_event ready[256];
+        const int n = ::epoll_wait(m_epoll, ready, 256, timeoutMs);
+        for (int i = 0; i < n; ++i) {
+            const uint32_t e = ready[i].events;
+            events.push_back(Event{ ready[i].data.fd, (e & EPOLLIN) != 0, (e & EPOLLOUT) != 0,
+                (e & (EPOLLERR | EPOLLHUP)) != 0 });
+        }
+#else
+#if defined(_WIN32)
+        const int n = ::WSAPoll(m_fds.data(), static_cast<ULONG>(m_fds.size()), timeoutMs);
+#else
+        const int n = ::poll(m_fds.data(), static_cast<nfds_t>(m_fds.size()), timeoutMs);
+#endif
+        if (n <= 0) return;
+        for (const pollfd& p : m_fds) {
+            if (p.revents == 0) continue;
+            events.push_back(Event{ p.fd, (p.revents & POLLIN) != 0, (p.revents & POLLOUT) != 0,
+                (p.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0 });
+        }
+#endif
+    }
+
+private:
+#if defined(__linux__)
+    int m_epoll = -1;
+    std::unordered_map<int, uint32_t> m_registered;
+#else
+    std::vector<pollfd> m_fds;
+    std::unordered_map<NativeSocket, size_t> m_index;
+#endif
+};
+
+// 唤醒 IO 线程：Linux 用 eventfd，其他平台向自己发一个 UDP 包 (WSAPoll 只能等套接字)
+class Wakeup {
+public:
+    ~Wakeup() { Close(); }
+
+    bool Open() {
+#if defined(__linux__)
+        m_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        return m_fd >= 0;
+#else
+        m_fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (m_fd == kInvalidSocket) return false;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (::bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+            || ::getsockname(m_fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0
+            || ::connect(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+            || !SetNonBlocking(m_fd)) {
+            Close();
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    void Close() {
+        if (m_fd != kInvalidSocket) CloseSocket(m_fd);
+        m_fd = kInvalidSocket;
+    }
+
+    NativeSocket Fd() const { return m_fd; }
+
+    void Notify() {
+#if defined(__linux__)
+        const uint64_t one = 1;
+        (void)!::write(m_fd, &one, sizeof(one));
+#else
+        const char byte = 0;
+        ::send(m_fd, &byte, 1, 0);
+#endif
+    }
+
+    void Drain() {
+#if defined(__linux__)
+        uint64_t count = 0;
+        (void)!::read(m_fd, &count, sizeof(count));
+#else
+        char buffer[64];
+        while (::recv(m_fd, buffer, sizeof(buffer), 0) > 0) {}
+#endif
+    }
+
+private:
+    NativeSocket m_fd = kInvalidSocket;
+};
+
+} // namespace HttpEngineDetail
+
+// 非阻塞 HTTP 获取引擎
+// - Fetch 只把请求放入提交队列并唤醒 IO 线程，立即返回；响应在 IO 线程上回调
+// - 每个主机一个连接池：空闲连接优先复用 (后进先出)，连接数到上限时请求在该主机上排队，连接空出后接着发
+// - 复用的空闲连接可能已被服务器关闭：没收到任何字节就断开的请求换新连接重发一次 (GET 是幂等的)
+// - 超时按提交时刻计算，包括排队、连接、发送与接收；超时的请求所在连接直接关闭
+// - 域名解析 (getaddrinfo) 在 IO 线程上同步完成，结果按主机缓存到引擎停止
+// - https 需要 TLS，不经过事件循环：交给一个后备线程用 HttpClient.h 的同步实现 (Windows 上是 WinHTTP)
+class HttpEngine {
+public:
+    // 进程内共享的引擎，第一次 Fetch 时启动 IO 线程 (与 ResultCache / LogWriter 相同)
+    static HttpEngine& Instance() {
+        static HttpEngine instance;
+        return instance;
+    }
+
+    explicit HttpEngine(const HttpEngineOptions& options = HttpEngineOptions()) : m_options(options) {}
+    HttpEngine(const HttpEngine&) = delete;
+    HttpEngine& operator=(const HttpEngine&) = delete;
+
+    ~HttpEngine() {
+        Stop();
+    }
+
+    // 修改连接池参数；IO 线程在下一轮循环时采用
+    void SetOptions(const HttpEngineOptions& options) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_options = options;
+    }
+
+    HttpEngineOptions GetOptions() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_options;
+    }
+
+    // 启动 IO 线程 (已启动时直接返回 true)；Fetch 会自动调用
+    bool Start() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return StartLocked();
+    }
+
+    // 停止：在途与排队的请求以 "engine stopped" 失败回调，关闭所有连接；之后的 Fetch 会重新启动
+    void Stop() {
+        std::thread io;
+        std::thread blocking;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_started) return;
+            m_started = false;
+            m_stopping = true;
+            io.swap(m_ioThread);
+            blocking.swap(m_blockingThread);
+        }
+        m_wakeup.Notify();
+        m_blockingCv.notify_all();
+        if (io.joinable()) io.join();
+        if (blocking.joinable()) blocking.join();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = false;
+        m_wakeup.Close();
+#if defined(_WIN32)
+        ::WSACleanup();
+#endif
+    }
+
+    // 异步 GET：返回请求编号；callback 恰好调用一次，网络错误与超时时 response.status 为 0
+    // callback 在 IO 线程上执行 (参数错误时在调用线程上)，应尽快返回，不要在其中同步等待其他请求
+    uint64_t Fetch(HttpRequest request, HttpCallback callback) {
+        const uint64_t id = m_nextId.fetch_add(1, std::memory_order_relaxed);
+        m_requests.fetch_add(1, std::memory_order_relaxed);
+        const size_t inFlight = m_inFlight.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t peak = m_peakInFlight.load(std::memory_order_relaxed);
+        while (inFlight > peak && !m_peakInFlight.compare_exchange_weak(peak, inFlight, std::memory_order_relaxed)) {}
+
+        auto pending = std::make_unique<Pending>();
+        pending->id = id;
+        pending->callback = std::move(callback);
+        pending->deadline = std::chrono::steady_clock::now() + request.timeout;
+        if (!HttpUrl::Parse(request.url, pending->url)) {
+            Fail(*pending, "invalid url: " + request.url, false);
+            return id;
+        }
+        pending->timeout = request.timeout;
+        pending->headers = std::move(request.headers);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (StartLocked()) {
+                if (pending->url.https) {
+                    m_blockingQueue.push_back(std::move(pending));
+                    m_blockingCv.notify_one();
+                }
+                else {
+                    // 队列原本为空时才需要唤醒：非空说明 IO 线程还没来得及取走上一批
+                    if (m_submitted.empty()) m_wakeup.Notify();
+                    m_submitted.push_back(std::move(pending));
+                }
+                return id;
+            }
+        }
+        Fail(*pending, "cannot start the HTTP engine", false);
+        return id;
+    }
+
+    // 同步 GET：在调用线程上等待 (可以从任意线程调用，IO 线程上的回调除外)
+    HttpResponse Get(const std::string& url, const HttpHeaders& headers = HttpHeaders(),
+        std::chrono::milliseconds timeout = std::chrono::milliseconds(10000)) {
+        std::promise<HttpResponse> promise;
+        std::future<HttpResponse> future = promise.get_future();
+        Fetch(HttpRequest{ url, headers, timeout }, [&promise](HttpResponse&& response) {
+            promise.set_value(std::move(response));
+        });
+        return future.get();
+    }
+
+    // 供 CachedHttpClient 使用的同步 / 异步传输
+    CachedHttpClient::Transport Transport() {
+        return [this](const std::string& url, const HttpHeaders& headers) { return Get(url, headers); };
+    }
+
+    CachedHttpClient::AsyncTransport AsyncTransport() {
+        return [this](const std::string& url, const HttpHeaders& headers, HttpCallback done) {
+            Fetch(HttpRequest{ url, headers }, std::move(done));
+        };
+    }
+
+    HttpEngineStats GetStats() const {
+        HttpEngineStats stats;
+        stats.requests = m_requests.load();
+        stats.completed = m_completed.load();
+        stats.failed = m_failed.load();
+        stats.timedOut = m_timedOut.load();
+        stats.retried = m_retried.load();
+        stats.connectionsOpened = m_connectionsOpened.load();
+        stats.connectionsReused = m_connectionsReused.load();
+        stats.inFlight = m_inFlight.load();
+        stats.openConnections = m_openConnections.load();
+        stats.idleConnections = m_idleConnections.load();
+        stats.peakInFlight = m_peakInFlight.load();
+        return stats;
+    }
+
+    void ResetStats() {
+        m_requests = 0;
+        m_completed = 0;
+        m_failed = 0;
+        m_timedOut = 0;
+        m_retried = 0;
+        m_connectionsOpened = 0;
+        m_connectionsReused = 0;
+        m_peakInFlight = m_inFlight.load();
+    }
+
+private:
+    using NativeSocket = HttpEngineDetail::NativeSocket;
+    using Clock = std::chrono::steady_clock;
+    struct Connection;
+    struct HostPool;
+
+    // 一个请求 (提交后只由 IO 线程或后备线程访问)
+    struct Pending {
+        uint64_t id = 0;
+        HttpUrl url;
+        HttpHeaders headers;
+        std::chrono::milliseconds timeout{ 0 };
+        Clock::time_point deadline;
+        HttpCallback callback;
+        std::string wire;            // 请求报文
+        bool retried = false;
+        HostPool* pool = nullptr;    // 所在主机 (排队或已发出时)
+        Connection* conn = nullptr;  // 所在连接 (为空表示在主机队列中排队)
+    };
+    using PendingPtr = std::unique_ptr<Pending>;
+
+    struct Connection {
+        enum class State { Connecting, Sending, Receiving, Idle };
+        NativeSocket fd = HttpEngineDetail::kInvalidSocket;
+        HostPool* pool = nullptr;
+        State state = State::Connecting;
+        PendingPtr request;
+        size_t sent = 0;
+        bool reused = false;         // 当前请求在复用的连接上发出
+        bool received = false;       // 当前请求已经收到字节
+        HttpResponseParser parser;
+        Clock::time_point idleSince;
+    };
+
+    struct HostPool {
+        std::string key;             // host:port
+        std::vector<char> address;   // 解析得到的 sockaddr
+        int family = AF_INET;
+        std::vector<Connection*> idle;
+        std::deque<Pending*> waiting;
+        std::deque<PendingPtr> queue; // waiting 中请求的所有权 (与 waiting 一一对应)
+        size_t open = 0;
+    };
+
+    bool StartLocked() {
+        if (m_started) return true;
+        if (m_stopping) return false;
+#if defined(_WIN32)
+        WSADATA data;
+        if (::WSAStartup(MAKEWORD(2, 2), &data) != 0) return false;
+#endif
+        if (!m_wakeup.Open()) {
+#if defined(_WIN32)
+            ::WSACleanup();
+#endif
+            return false;
+        }
+        m_started = true;
+        m_ioThread = std::thread(&HttpEngine::IoLoop, this);
+        m_blockingThread = std::thread(&HttpEngine::BlockingLoop, this);
+        return true;
+    }
+
+    // 以错误结束请求 (回调在调用线程上执行)
+    void Fail(Pending& pending, const std::string& error, bool timedOut) {
+        (timedOut ? m_timedOut : m_failed).fetch_add(1, std::memory_order_relaxed);
+        HttpResponse response;
+        response.error = error;
+        Deliver(pending, std::move(response));
+    }
+
+    void Deliver(Pending& pending, HttpResponse&& response) {
+        HttpCallback callback = std::move(pending.callback);
+        m_inFlight.fetch_sub(1, std::memory_order_relaxed);
+        if (!callback) return;
+        try {
+            callback(std::move(response));
+        }
+        catch (...) {
+            // 回调的异常不能打断 IO 循环
+        }
+    }
+
+    // === IO 线程 ===
+
+    void IoLoop() {
+        HttpEngineDetail::Poller poller;
+        if (!poller.Open()) {
+            FailAll("cannot create poller");
+            return;
+        }
+        m_poller = &poller;
+        poller.Set(m_wakeup.Fd(), true, false);
+        std::vector<HttpEngineDetail::Poller::Event> events;
+        std::vector<char> buffer(64 * 1024);
+
+        for (;;) {
+            poller.Wait(events, NextTimeoutMs());
+            for (const auto& ev : events) {
+                if (ev.fd == m_wakeup.Fd()) {
+                    m_wakeup.Drain();
+                    continue;
+                }
+                auto it = m_conns.find(ev.fd);
+                if (it != m_conns.end()) OnEvent(it->second.get(), ev, buffer);
+            }
+
+            std::deque<PendingPtr> submitted;
+            bool stopping;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                submitted.swap(m_submitted);
+                m_loopOptions = m_options;
+                stopping = m_stopping;
+            }
+            if (stopping) {
+                for (PendingPtr& pending : submitted) Fail(*pending, "engine stopped", false);
+                break;
+            }
+            for (PendingPtr& pending : submitted) Dispatch(std::move(pending));
+            const Clock::time_point now = Clock::now();
+            ExpireTimeouts(now);
+            SweepIdle(now);
+        }
+
+        // 停止：在途与排队的请求失败，关闭所有连接
+        std::vector<Connection*> conns;
+        for (auto& entry : m_conns) conns.push_back(entry.second.get());
+        for (Connection* conn : conns) {
+            if (conn->request) {
+                PendingPtr pending = std::move(conn->request);
+                Fail(*pending, "engine stopped", false);
+            }
+            CloseConnection(conn, false);
+        }
+        for (auto& entry : m_pools) {
+            for (PendingPtr& pending : entry.second->queue) Fail(*pending, "engine stopped", false);
+        }
+        m_pools.clear();
+        m_timeouts = TimeoutHeap();
+        m_active.clear();
+        m_poller = nullptr;
+    }
+
+    // 在最近的超时时刻醒来；有空闲连接时至少每秒检查一次
+    int NextTimeoutMs() {
+        const Clock::time_point now = Clock::now();
+        long long wait = -1;
+        while (!m_timeouts.empty() && m_active.find(m_timeouts.top().second) == m_active.end()) m_timeouts.pop();
+        if (!m_timeouts.empty()) {
+            wait = std::chrono::duration_cast<std::chrono::milliseconds>(m_timeouts.top().first - now).count() + 1;
+            if (wait < 0) wait = 0;
+        }
+        if (m_idleConnections.load(std::memory_order_relaxed) > 0 && (wait < 0 || wait > 1000)) wait = 1000;
+        return static_cast<int>(wait);
+    }
+
+    void Dispatch(PendingPtr pending) {
+        HostPool* pool = FindPool(pending->url);
+        if (!pool) {
+            Fail(*pending, "resolve failed: " + pending->url.host, false);
+            return;
+        }
+        pending->wire = HttpDetail::BuildGet(pending->url, pending->headers, true);
+        pending->pool = pool;
+        m_active.emplace(pending->id, pending.get());
+        m_timeouts.emplace(pending->deadline, pending->id);
+        Route(pool, std::move(pending));
+    }
+
+    // 空闲连接 -> 新连接 -> 主机队列
+    void Route(HostPool* pool, PendingPtr pending) {
+        if (!pool->idle.empty()) {
+            Connection* conn = pool->idle.back();
+            pool->idle.pop_back();
+            m_idleConnections.fetch_sub(1, std::memory_order_relaxed);
+            m_connectionsReused.fetch_add(1, std::memory_order_relaxed);
+            Assign(conn, std::move(pending), true);
+        }
+        else if (pool->open < (std::max)(m_loopOptions.maxConnectionsPerHost, size_t(1))) {
+            OpenConnection(pool, std::move(pending));
+        }
+        else {
+            pending->conn = nullptr;
+            pool->waiting.push_back(pending.get());
+            pool->queue.push_back(std::move(pending));
+        }
+    }
+
+    HostPool* FindPool(const HttpUrl& url) {
+        const std::string key = url.host + ":" + std::to_string(url.port);
+        auto it = m_pools.find(key);
+        if (it != m_pools.end()) return it->second.get();
+
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* list = nullptr;
+        if (::getaddrinfo(url.host.c_str(), std::to_string(url.port).c_str(), &hints, &list) != 0 || !list) return nullptr;
+        auto pool = std::make_unique<HostPool>();
+        pool->key = key;
+        pool->family = list->ai_family;
+        const char* address = reinterpret_cast<const char*>(list->ai_addr);
+        pool->address.assign(address, address + list->ai_addrlen);
+        ::freeaddrinfo(list);
+        HostPool* raw = pool.get();
+        m_pools.emplace(key, std::move(pool));
+        return raw;
+    }
+
+    void OpenConnection(HostPool* pool, PendingPtr pending) {
+        NativeSocket fd = ::socket(pool->family, SOCK_STREAM, 0);
+        if (fd == HttpEngineDetail::kInvalidSocket || !HttpEngineDetail::SetNonBlocking(fd)) {
+            if (fd != HttpEngineDetail::kInvalidSocket) HttpEngineDetail::CloseSocket(fd);
+            Finish(*pending, "socket failed");
+            return;
+        }
+        const int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+#if defined(__APPLE__)
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        auto conn = std::make_unique<Connection>();
+        conn->fd = fd;
+        conn->pool = pool;
+        Connection* raw = conn.get();
+        m_conns.emplace(fd, std::move(conn));
+        ++pool->open;
+        m_openConnections.fetch_add(1, std::memory_order_relaxed);
+        m_connectionsOpened.fetch_add(1, std::memory_order_relaxed);
+
+        const int rc = ::connect(fd, reinterpret_cast<const sockaddr*>(pool->address.data()),
+            static_cast<socklen_t>(pool->address.size()));
+        if (rc == 0) {
+            Assign(raw, std::move(pending), false);
+        }
+        else if (HttpEngineDetail::ConnectPending(HttpEngineDetail::LastError())) {
+            raw->state = Connection::State::Connecting;
+            Attach(raw, std::move(pending), false);
+            m_poller->Set(fd, false, true);
+        }
+        else {
+            // 立即失败 (例如本机端口没有监听)：不在这里接着开排队请求的连接，由调用方的循环继续
+            CloseConnection(raw, false);
+            Finish(*pending, "connect failed: " + pool->key);
+        }
+    }
+
+    void Attach(Connection* conn, PendingPtr pending, bool reused) {
+        pending->conn = conn;
+        conn->request = std::move(pending);
+        conn->sent = 0;
+        conn->reused = reused;
+        conn->received = false;
+        conn->parser.Reset();
+    }
+
+    // 在已连接的连接上发出请求：先直接写，写不完再等可写
+    void Assign(Connection* conn, PendingPtr pending, bool reused) {
+        Attach(conn, std::move(pending), reused);
+        conn->state = Connection::State::Sending;
+        Send(conn);
+    }
+
+    void Send(Connection* conn) {
+        const std::string& wire = conn->request->wire;
+        while (conn->sent < wire.size()) {
+            const int n = HttpEngineDetail::SendSome(conn->fd, wire.data() + conn->sent, wire.size() - conn->sent);
+            if (n > 0) {
+                conn->sent += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && HttpEngineDetail::WouldBlock(HttpEngineDetail::LastError())) {
+                m_poller->Set(conn->fd, true, true);
+                return;
+            }
+            Abort(conn, "send failed");
+            return;
+        }
+        conn->state = Connection::State::Receiving;
+        m_poller->Set(conn->fd, true, false);
+    }
+
+    void OnEvent(Connection* conn, const HttpEngineDetail::Poller::Event& ev, std::vector<char>& buffer) {
+        switch (conn->state) {
+        case Connection::State::Connecting: {
+            int error = 0;
+            socklen_t len = sizeof(error);
+            ::getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &len);
+            if (error != 0) {
+                Abort(conn, "connect failed: " + conn->pool->key);
+                return;
+            }
+            if (!ev.writable) return; // 同一轮里关闭的旧套接字留下的事件 (编号被新连接复用)
+            conn->state = Connection::State::Sending;
+            Send(conn);
+            return;
+        }
+        case Connection::State::Sending:
+            if (ev.writable) Send(conn);
+            else if (ev.error) Abort(conn, "connection reset");
+            return;
+        case Connection::State::Receiving:
+            if (ev.readable || ev.error) Receive(conn, buffer);
+            return;
+        case Connection::State::Idle:
+            // 空闲连接可读：对方关闭 (或发来了不该有的数据)，不再复用
+            CloseConnection(conn, true);
+            return;
+        }
+    }
+
+    // 读到没有数据为止，响应完整后立即结束请求
+    void Receive(Connection* conn, std::vector<char>& buffer) {
+        for (;;) {
+            const int n = HttpEngineDetail::RecvSome(conn->fd, buffer.data(), buffer.size());
+            if (n > 0) {
+                conn->received = true;
+                const HttpResponseParser::Result result = conn->parser.Feed(buffer.data(), static_cast<size_t>(n));
+                if (result == HttpResponseParser::Result::Done) {
+                    Complete(conn);
+                    return;
+                }
+                if (result == HttpResponseParser::Result::Error) {
+                    Abort(conn, "malformed response");
+                    return;
+                }
+                continue;
+            }
+            if (n < 0 && HttpEngineDetail::WouldBlock(HttpEngineDetail::LastError())) return;
+            // 对方关闭或连接出错
+            if (n == 0 && conn->parser.FinishOnClose() == HttpResponseParser::Result::Done) {
+                Complete(conn);
+                return;
+            }
+            Abort(conn, conn->received ? "truncated response" : "connection closed");
+            return;
+        }
+    }
+
+    void Complete(Connection* conn) {
+        PendingPtr pending = std::move(conn->request);
+        const bool keepAlive = conn->parser.KeepAlive() && conn->parser.Leftover() == 0;
+        HttpResponse response = std::move(conn->parser.Response());
+        m_active.erase(pending->id);
+        m_completed.fetch_add(1, std::memory_order_relaxed);
+        if (keepAlive) Release(conn);
+        else CloseConnection(conn, true);
+        Deliver(*pending, std::move(response));
+    }
+
+    // 当前请求失败：复用的连接上还没收到字节时换新连接重发一次，否则以错误结束
+    void Abort(Connection* conn, const std::string& error) {
+        PendingPtr pending = std::move(conn->request);
+        HostPool* pool = conn->pool;
+        const bool retry = conn->reused && !conn->received && pending && !pending->retried;
+        CloseConnection(conn, false);
+        if (pending) {
+            if (retry) {
+                pending->retried = true;
+                m_retried.fetch_add(1, std::memory_order_relaxed);
+                Route(pool, std::move(pending));
+            }
+            else {
+                Finish(*pending, error);
+            }
+        }
+        ServeWaiting(pool);
+    }
+
+    // 请求以错误结束 (不含超时)
+    void Finish(Pending& pending, const std::string& error) {
+        m_active.erase(pending.id);
+        Fail(pending, error, false);
+    }
+
+    // 响应结束后连接可复用：先给本主机排队的请求，没有时放回空闲列表
+    void Release(Connection* conn) {
+        HostPool* pool = conn->pool;
+        if (!pool->queue.empty()) {
+            PendingPtr pending = PopWaiting(pool);
+            m_connectionsReused.fetch_add(1, std::memory_order_relaxed);
+            Assign(conn, std::move(pending), true);
+            return;
+        }
+        if (pool->idle.size() >= m_loopOptions.maxIdlePerHost) {
+            CloseConnection(conn, true);
+            return;
+        }
+        conn->state = Connection::State::Idle;
+        conn->idleSince = Clock::now();
+        pool->idle.push_back(conn);
+        m_idleConnections.fetch_add(1, std::memory_order_relaxed);
+        m_poller->Set(conn->fd, true, false);
+    }
+
+    PendingPtr PopWaiting(HostPool* pool) {
+        PendingPtr pending = std::move(pool->queue.front());
+        pool->queue.pop_front();
+        pool->waiting.pop_front();
+        return pending;
+    }
+
+    // 关闭连接 (当前请求已由调用方取走)；serveWaiting: 空出的名额交给本主机排队的请求
+    void CloseConnection(Connection* conn, bool serveWaiting) {
+        HostPool* pool = conn->pool;
+        if (conn->state == Connection::State::Idle) {
+            auto it = std::find(pool->idle.begin(), pool->idle.end(), conn);
+            if (it != pool->idle.end()) {
+                pool->idle.erase(it);
+                m_idleConnections.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        m_poller->Remove(conn->fd);
+        HttpEngineDetail::CloseSocket(conn->fd);
+        --pool->open;
+        m_openConnections.fetch_sub(1, std::memory_order_relaxed);
+        m_conns.erase(conn->fd); // conn 在此之后失效
+        if (serveWaiting) ServeWaiting(pool);
+    }
+
+    // 连接数低于上限时为排队的请求开新连接
+    void ServeWaiting(HostPool* pool) {
+        while (!pool->queue.empty() && pool->open < (std::max)(m_loopOptions.maxConnectionsPerHost, size_t(1))) {
+            OpenConnection(pool, PopWaiting(pool));
+        }
+    }
+
+    void ExpireTimeouts(Clock::time_point now) {
+        while (!m_timeouts.empty() && m_timeouts.top().first <= now) {
+            const uint64_t id = m_timeouts.top().second;
+            m_timeouts.pop();
+            auto it = m_active.find(id);
+            if (it == m_active.end()) continue; // 已经结束
+            Pending* raw = it->second;
+            m_active.erase(it);
+            PendingPtr pending;
+            if (raw->conn) {
+                // 响应只收了一部分的连接不能再用
+                Connection* conn = raw->conn;
+                pending = std::move(conn->request);
+                CloseConnection(conn, true);
+            }
+            else {
+                HostPool* pool = raw->pool;
+                auto pos = std::find(pool->waiting.begin(), pool->waiting.end(), raw);
+                const size_t index = static_cast<size_t>(pos - pool->waiting.begin());
+                pending = std::move(pool->queue[index]);
+                pool->queue.erase(pool->queue.begin() + static_cast<std::ptrdiff_t>(index));
+                pool->waiting.erase(pos);
+            }
+            Fail(*pending, "timed out after " + std::to_string(pending->timeout.count()) + " ms", true);
+        }
+    }
+
+    void SweepIdle(Clock::time_point now) {
+        if (m_idleConnections.load(std::memory_order_relaxed) == 0) return;
+        std::vector<Connection*> expired;
+        for (auto& entry : m_pools) {
+            for (Connection* conn : entry.second->idle) {
+                if (now - conn->idleSince >= m_loopOptions.idleTimeout) expired.push_back(conn);
+            }
+        }
+        for (Connection* conn : expired) CloseConnection(conn, false);
+    }
+
+    // 后备线程：事件循环处理不了的请求 (https) 用同步实现逐个执行
+    void BlockingLoop() {
+        for (;;) {
+            PendingPtr pending;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_blockingCv.wait(lock, [this] { return m_stopping || !m_blockingQueue.empty(); });
+                if (m_stopping) break;
+                pending = std::move(m_blockingQueue.front());
+                m_blockingQueue.pop_front();
+            }
+            // 排队期间已经超过期限：不再发出，按超时结束
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(pending->deadline - Clock::now());
+            if (left.count() <= 0) {
+                Fail(*pending, "timed out after " + std::to_string(pending->timeout.count()) + " ms", true);
+                continue;
+            }
+            HttpResponse response = HttpDetail::Get(pending->url, pending->headers, left);
+            if (response.status == 0) Fail(*pending, response.error, false);
+            else {
+                m_completed.fetch_add(1, std::memory_order_relaxed);
+                Deliver(*pending, std::move(response));
+            }
+        }
+        std::deque<PendingPtr> rest;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            rest.swap(m_blockingQueue);
+        }
+        for (PendingPtr& pending : rest) Fail(*pending, "engine stopped", false);
+    }
+
+    // IO 线程启动失败
+    void FailAll(const char* error) {
+        std::deque<PendingPtr> submitted;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            submitted.swap(m_submitted);
+        }
+        for (PendingPtr& pending : submitted) Fail(*pending, error, false);
+    }
+
+    using TimeoutEntry = std::pair<Clock::time_point, uint64_t>;
+    using TimeoutHeap = std::priority_queue<TimeoutEntry, std::vector<TimeoutEntry>, std::greater<TimeoutEntry>>;
+
+    // 提交端 (m_mutex 保护)
+    std::mutex m_mutex;
+    HttpEngineOptions m_options;
+    bool m_started = false;
+    bool m_stopping = false;
+    std::thread m_ioThread;
+    std::thread m_blockingThread;
+    std::deque<PendingPtr> m_submitted;
+    std::deque<PendingPtr> m_blockingQueue;
+    std::condition_variable m_blockingCv;
+    HttpEngineDetail::Wakeup m_wakeup;
+
+    // IO 线程独占
+    HttpEngineOptions m_loopOptions;
+    HttpEngineDetail::Poller* m_poller = nullptr;
+    std::unordered_map<std::string, std::unique_ptr<HostPool>> m_pools;
+    std::unordered_map<NativeSocket, std::unique_ptr<Connection>> m_conns;
+    std::unordered_map<uint64_t, Pending*> m_active;   // 已分派、尚未结束的请求
+    TimeoutHeap m_timeouts;
+
+    // 统计
+    std::atomic<uint64_t> m_nextId{ 1 };
+    std::atomic<unsigned long long> m_requests{ 0 };
+    std::atomic<unsigned long long> m_completed{ 0 };
+    std::atomic<unsigned long long> m_failed{ 0 };
+    std::atomic<unsigned long long> m_timedOut{ 0 };
+    std::atomic<unsigned long long> m_retried{ 0 };
+    std::atomic<unsigned long long> m_connectionsOpened{ 0 };
+    std::atomic<unsigned long long> m_connectionsReused{ 0 };
+    std::atomic<size_t> m_inFlight{ 0 };
+    std::atomic<size_t> m_openConnections{ 0 };
+    std::atomic<size_t> m_idleConnections{ 0 };
+    std::atomic<size_t> m_peakInFlight{ 0 };
+};
@@ -0,0 +1,35 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: ITask.h
+// 对应需求: 抽象任务接口，从 TaskEngine.h 拆出：调度引擎只依赖本文件，不再需要 windows.h
+// =================================================================================
+#pragma once
+#include "NameInterner.h"
+#include <atomic>
+#include <string>
+
+class ITask {
+public:
+    ITask() = default;
+    ITask(const ITask&) {}                              // 驻留名缓存不随副本复制
+    ITask& operator=(const ITask&) { return *this; }
+    virtual ~ITask() {}
+    virtual void Execute() = 0;
+    virtual std::string GetName() const = 0;
+    // 是否会长时间阻塞 (网络 / 磁盘 IO、等待用户操作)：阻塞任务由弹性线程池执行，不占用 CPU 工作线程
+    virtual bool IsBlocking() const { return false; }
+
+    // 驻留后的任务名：每个实例只在第一次提交时调用 GetName() 并驻留，之后的提交不再构造 std::string
+    // (要求同一实例的 GetName() 不变)
+    const char* InternedName() const {
+        const char* name = m_internedName.load(std::memory_order_acquire);
+        if (!name) {
+            name = NameInterner::Instance().Intern(GetName());
+            m_internedName.store(name, std::memory_order_release);
+        }
+        return name;
+    }
+
+private:
+    mutable std::atomic<const char*> m_internedName{ nullptr };
+};
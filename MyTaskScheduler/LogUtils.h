@@ -2,6 +2,8 @@
 // 项目名称: MyTaskScheduler (Project 3)
 // 文件名称: LogUtils.h
 // 修复方案: 强制 UTF-8 + BOM (彻底解决记事本乱码)
+// 性能优化: 可选异步模式 (无锁环形队列 + 后台批量刷盘线程)
+// 扩展功能: 可选二进制日志 (BinaryLog.h)，带时间索引，可按时间/任务快速查询
 // =================================================================================
 #pragma once
 #include <fstream>
@@ -10,6 +12,28 @@
 #include <ctime>
 #include <iomanip>
 #include <filesystem>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include "MpscRingBuffer.h"
+#include "BinaryLog.h"
+
+// 异步模式下队列满时的处理策略
+enum class LogOverflowPolicy {
+    Block,  // 生产者让出 CPU 等待刷盘线程腾出空间 (不丢日志)
+    Drop    // 直接丢弃并计数 (生产者永不等待)
+};
+
+// 异步日志配置
+struct AsyncLogOptions {
+    size_t capacity = 4096;                                  // 队列容量 (条)，内存上限约为 容量 x 512 字节
+    std::chrono::milliseconds flushInterval{ 50 };           // 最长刷盘间隔
+    size_t flushBatch = 256;                                 // 积压达到该条数时提前唤醒刷盘线程
+    LogOverflowPolicy overflowPolicy = LogOverflowPolicy::Block;
+};
 
 class LogWriter {
 public:
@@ -19,11 +43,25 @@ public:
     }
 
     void Write(const std::string& message) {
+        // m_inflight 让 DisableAsync 能等到所有正在入队的生产者离开后再释放队列
+        m_inflight.fetch_add(1);
+        if (m_async.load()) {
+            WriteAsync(0, LogEventType::Message, message.data(), message.size(), true);
+            m_inflight.fetch_sub(1);
+            return;
+        }
+        m_inflight.fetch_sub(1);
+
         std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_binary) {
+            m_binary->Append(static_cast<uint64_t>(binlog_detail::SteadyNowNs()), 0, LogEventType::Message,
+                message.data(), static_cast<uint32_t>(message.size()));
+            m_binary->Flush();
+        }
         if (m_ofs.is_open()) {
             std::time_t t = std::time(nullptr);
             std::tm tm;
-            localtime_s(&tm, &t);
+            ToLocalTime(t, tm);
 
             // 写入时间 + 消息
             m_ofs << "[" << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << "] "
@@ -31,7 +69,133 @@ public:
         }
     }
 
+    // 记录一条结构化任务事件 (只写入二进制日志；未开启二进制日志时为空操作)
+    void WriteEvent(uint64_t taskId, LogEventType type, const std::string& payload) {
+        WriteEvent(taskId, type, payload.data(), payload.size());
+    }
+
+    // 同上，直接传入字节区间 (调度器传驻留的任务名，不构造 std::string)
+    void WriteEvent(uint64_t taskId, LogEventType type, const char* payload, size_t length) {
+        if (!m_binaryEnabled.load(std::memory_order_relaxed)) return;
+
+        m_inflight.fetch_add(1);
+        if (m_async.load()) {
+            WriteAsync(taskId, type, payload, length, false);
+            m_inflight.fetch_sub(1);
+            return;
+        }
+        m_inflight.fetch_sub(1);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_binary) {
+            m_binary->Append(static_cast<uint64_t>(binlog_detail::SteadyNowNs()), taskId, type,
+                payload, static_cast<uint32_t>(length));
+            m_binary->Flush();
+        }
+    }
+
+    // 开启二进制日志 (与文本日志并存)
+    // indexEvery: 每多少条记录写一个稀疏时间索引项
+    bool EnableBinarySink(const std::string& path = "scheduler.blog", uint32_t indexEvery = 1024) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto writer = std::make_unique<BinaryLogWriter>();
+        if (!writer->Open(path, indexEvery)) return false;
+        m_binary = std::move(writer);
+        m_binaryEnabled = true;
+        return true;
+    }
+
+    void DisableBinarySink() {
+        Flush();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_binaryEnabled = false;
+        m_binary.reset(); // 析构时补写最后一个索引块
+    }
+
+    bool IsBinaryEnabled() const {
+        return m_binaryEnabled.load(std::memory_order_relaxed);
+    }
+
+    // 开启异步模式：Write 只把记录放入无锁队列，格式化与磁盘 IO 全部由后台线程完成
+    void EnableAsync(const AsyncLogOptions& options = AsyncLogOptions()) {
+        std::lock_guard<std::mutex> lock(m_asyncMutex);
+        if (m_async) return;
+
+        m_options = options;
+        if (m_options.flushBatch == 0) m_options.flushBatch = 1;
+        m_queue = std::make_unique<MpscRingBuffer<LogRecord>>(m_options.capacity);
+        m_written = 0; // 与新队列的领取位置对应
+        m_stopFlusher = false;
+        m_flusher = std::thread(&LogWriter::FlusherLoop, this);
+        m_async.store(true);
+    }
+
+    // 关闭异步模式：保证队列中已有的日志全部落盘后返回
+    void DisableAsync() {
+        {
+            std::lock_guard<std::mutex> lock(m_asyncMutex);
+            if (!m_async) return;
+            m_async.store(false);
+        }
+        // 新的 Write 已切回同步路径，等待仍在入队的生产者结束
+        while (m_inflight.load() != 0) std::this_thread::yield();
+        {
+            std::lock_guard<std::mutex> lock(m_asyncMutex);
+            m_stopFlusher = true;
+        }
+        m_flushCv.notify_one();
+        if (m_flusher.joinable()) m_flusher.join();
+        m_queue.reset();
+    }
+
+    // 阻塞直到调用前提交的所有日志都已写入磁盘
+    void Flush() {
+        std::unique_lock<std::mutex> lock(m_asyncMutex);
+        if (!m_async || m_stopFlusher) {
+            lock.unlock();
+            std::lock_guard<std::mutex> fileLock(m_mutex);
+            m_ofs.flush();
+            if (m_binary) m_binary->Flush();
+            return;
+        }
+        // 以队列的领取位置为目标，而不是入队成功后才加一的计数：另一个线程可能已领取更早的位置、
+        // 但还没来得及计数，只按计数等待会在本线程自己的记录落盘前返回
+        // 领取了位置但仍在填写的记录会让刷盘线程停在它前面，所以每轮都重新请求刷盘
+        const uint64_t target = m_queue->ClaimedCount();
+        while (m_written.load() < target && m_async) {
+            m_flushRequested = true;
+            m_flushCv.notify_one();
+            m_flushedCv.wait(lock);
+        }
+    }
+
+    // 异步模式下因队列满 (Drop 策略) 被丢弃的日志条数
+    uint64_t GetDroppedCount() const {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
 private:
+    // 固定大小的日志记录：队列内存在启用时一次性分配，Write 不做任何堆分配
+    struct LogRecord {
+        static constexpr size_t kMaxText = 472;
+        std::chrono::system_clock::time_point time;
+        uint64_t steadyNs = 0;      // 二进制日志使用的单调时间戳
+        uint64_t taskId = 0;
+        LogEventType eventType = LogEventType::Message;
+        bool toText = true;         // 是否写入文本日志 (任务事件只进二进制日志)
+        uint32_t length = 0;
+        char text[kMaxText];
+    };
+
+    // 线程安全的本地时间转换 (Windows 为 localtime_s，其他平台为 localtime_r)
+    static void ToLocalTime(std::time_t t, std::tm& tm) {
+#if defined(_WIN32)
+        localtime_s(&tm, &t);
+#else
+        localtime_r(&t, &tm);
+#endif
+    }
+
     LogWriter() {
         // 1. 以【覆盖模式】打开，每次运行清空旧日志
         m_ofs.open("scheduler.log", std::ios::out | std::ios::trunc);
@@ -44,6 +208,9 @@ private:
     }
 
     ~LogWriter() {
+        // 退出前排空异步队列 (保证不丢日志)
+        DisableAsync();
+        m_binary.reset();
         if (m_ofs.is_open()) {
             m_ofs.close();
         }
@@ -52,6 +219,122 @@ private:
     LogWriter(const LogWriter&) = delete;
     LogWriter& operator=(const LogWriter&) = delete;
 
+    void WriteAsync(uint64_t taskId, LogEventType type, const char* message, size_t length, bool toText) {
+        auto now = std::chrono::system_clock::now();
+        auto steadyNs = static_cast<uint64_t>(binlog_detail::SteadyNowNs());
+        auto fill = [&](LogRecord& rec) {
+            rec.time = now;
+            rec.steadyNs = steadyNs;
+            rec.taskId = taskId;
+            rec.eventType = type;
+            rec.toText = toText;
+            size_t len = length;
+            if (len > LogRecord::kMaxText) len = LogRecord::kMaxText; // 超长消息截断
+            std::memcpy(rec.text, message, len);
+            rec.length = static_cast<uint32_t>(len);
+        };
+
+        while (!m_queue->TryPushWith(fill)) {
+            if (m_options.overflowPolicy == LogOverflowPolicy::Drop) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            m_flushCv.notify_one();
+            std::this_thread::yield();
+        }
+
+        // 只在积压达到批量阈值时唤醒刷盘线程，其余情况靠定时刷盘，避免每条日志一次系统调用
+        uint64_t count = m_enqueued.fetch_add(1) + 1;
+        if (count % m_options.flushBatch == 0) m_flushCv.notify_one();
+    }
+
+    // 后台刷盘线程：批量取出记录，格式化进缓冲区后一次写入并 flush
+    void FlusherLoop() {
+        std::string buffer;
+        buffer.reserve(m_options.flushBatch * 128);
+        std::time_t cachedSecond = 0;
+        char timePrefix[32] = {};
+
+        LogRecord rec;
+        for (;;) {
+            bool stopping;
+            {
+                std::unique_lock<std::mutex> lock(m_asyncMutex);
+                m_flushCv.wait_for(lock, m_options.flushInterval, [this] {
+                    return m_stopFlusher || m_flushRequested
+                        || m_queue->SizeApprox() >= m_options.flushBatch;
+                });
+                m_flushRequested = false;
+                stopping = m_stopFlusher;
+            }
+
+            uint64_t drained = 0;
+            {
+                // 一个批次只加一次文件锁
+                std::lock_guard<std::mutex> fileLock(m_mutex);
+                while (m_queue->TryPop(rec)) {
+                    ++drained;
+                    if (m_binary) {
+                        m_binary->Append(rec.steadyNs, rec.taskId, rec.eventType, rec.text, rec.length);
+                    }
+                    if (!rec.toText) continue;
+
+                    // 同一秒内的时间前缀只格式化一次
+                    std::time_t sec = std::chrono::system_clock::to_time_t(rec.time);
+                    if (sec != cachedSecond) {
+                        std::tm tm;
+                        ToLocalTime(sec, tm);
+                        std::strftime(timePrefix, sizeof(timePrefix), "[%Y-%m-%d %H:%M:%S] ", &tm);
+                        cachedSecond = sec;
+                    }
+                    buffer.append(timePrefix);
+                    buffer.append(rec.text, rec.length);
+                    buffer.push_back('\n');
+
+                    if (buffer.size() >= 64 * 1024) WriteBufferLocked(buffer);
+                }
+                WriteBufferLocked(buffer);
+                if (m_binary && drained > 0) m_binary->Flush();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_asyncMutex);
+                m_written.fetch_add(drained);
+            }
+            m_flushedCv.notify_all();
+
+            // 停止时所有生产者都已离开，上面的循环已把队列完整排空
+            if (stopping) break;
+        }
+    }
+
+    // 调用方持有 m_mutex
+    void WriteBufferLocked(std::string& buffer) {
+        if (buffer.empty()) return;
+        if (m_ofs.is_open()) {
+            m_ofs.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            m_ofs.flush();
+        }
+        buffer.clear();
+    }
+
     std::ofstream m_ofs;
     std::mutex m_mutex;
-};
\ No newline at end of file
+    std::unique_ptr<BinaryLogWriter> m_binary;    // 由 m_mutex 保护
+    std::atomic<bool> m_binaryEnabled{ false };
+
+    // === 异步模式 ===
+    std::atomic<bool> m_async{ false };
+    std::atomic<int> m_inflight{ 0 };
+    AsyncLogOptions m_options;
+    std::unique_ptr<MpscRingBuffer<LogRecord>> m_queue;
+    std::thread m_flusher;
+    std::mutex m_asyncMutex;
+    std::condition_variable m_flushCv;     // 唤醒刷盘线程
+    std::condition_variable m_flushedCv;   // 通知 Flush() 调用者
+    bool m_stopFlusher = false;
+    bool m_flushRequested = false;
+    std::atomic<uint64_t> m_enqueued{ 0 };   // 成功入队的条数 (只用于按批量阈值唤醒刷盘线程)
+    std::atomic<uint64_t> m_written{ 0 };    // 从当前队列取出并写入磁盘的条数 (由 m_asyncMutex 保护更新)
+    std::atomic<uint64_t> m_dropped{ 0 };
+};
@@ -0,0 +1,276 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: MatrixKernel.h
+// 对应需求: 连续存储矩阵 + 分块打包 (Cache Blocking / Packing) 的 GEMM，
+//           运行时按 CPU 选择 AVX2 / AVX-512 微内核，可按行带拆给调度器的工作线程并行
+// =================================================================================
+#pragma once
+#include "CpuFeatures.h"
+#include "TaskOptions.h"
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+// 行主序 (Row-Major) 连续存储的双精度矩阵：一次分配，行与行首尾相接
+class Matrix {
+public:
+    Matrix() = default;
+    Matrix(size_t rows, size_t cols, double value = 0.0)
+        : m_rows(rows), m_cols(cols), m_data(rows * cols, value) {}
+
+    size_t Rows() const { return m_rows; }
+    size_t Cols() const { return m_cols; }
+
+    double& operator()(size_t row, size_t col) { return m_data[row * m_cols + col]; }
+    double operator()(size_t row, size_t col) const { return m_data[row * m_cols + col]; }
+
+    double* Data() { return m_data.data(); }
+    const double* Data() const { return m_data.data(); }
+
+    void Fill(double value) { std::fill(m_data.begin(), m_data.end(), value); }
+
+private:
+    size_t m_rows = 0;
+    size_t m_cols = 0;
+    std::vector<double> m_data;
+};
+
+struct GemmOptions {
+    SimdLevel simd = DetectSimdLevel();   // 高于 CPU 支持的级别时自动降级
+    ParallelForFn parallelFor;            // 为空时在调用线程上单线程计算
+    size_t parallelThreshold = 256;       // M、N、K 都不小于该值时才拆分
+};
+
+namespace GemmDetail {
+
+// 分块参数 (double)：
+// - 一个 KC x NR 的 B 微面板 (16KB~32KB) 留在 L1
+// - 一个 MC x KC 的 A 块 (约 192KB) 留在 L2
+// - 一个 KC x NC 的 B 块 (约 4MB) 留在 L3
+constexpr size_t kMR = 6;
+constexpr size_t kMC = 96;    // kMR 的整数倍
+constexpr size_t kKC = 256;
+constexpr size_t kNC = 2048;  // 所有 NR 的整数倍
+constexpr size_t kMaxNR = 16;
+
+// 微内核: C[MR x NR] += A 面板 (每个 k 连续 MR 个) x B 面板 (每个 k 连续 NR 个)
+using MicroKernel = void (*)(size_t kc, const double* a, const double* b, double* c, size_t ldc);
+
+inline void KernelScalar(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+    constexpr size_t NR = 4;
+    double acc[kMR][NR] = {};
+    for (size_t k = 0; k < kc; ++k, a += kMR, b += NR) {
+        for (size_t r = 0; r < kMR; ++r) {
+            for (size_t j = 0; j < NR; ++j) acc[r][j] += a[r] * b[j];
+        }
+    }
+    for (size_t r = 0; r < kMR; ++r) {
+        for (size_t j = 0; j < NR; ++j) c[r * ldc + j] += acc[r][j];
+    }
+}
+
+#if defined(MTS_X86)
+// 6 x 8：12 个 ymm 累加器，每个 k 两次 B 加载 + 6 次 A 广播 + 12 次 FMA
+MTS_TARGET_AVX2 inline void KernelAvx2(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+    __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+    for (size_t k = 0; k < kc; ++k, a += kMR, b += 8) {
+        const __m256d b0 = _mm256_loadu_pd(b);
+        const __m256d b1 = _mm256_loadu_pd(b + 4);
+        __m256d ai = _mm256_broadcast_sd(a + 0);
+        c00 = _mm256_fmadd_pd(ai, b0, c00); c01 = _mm256_fmadd_pd(ai, b1, c01);
+        ai = _mm256_broadcast_sd(a + 1);
+        c10 = _mm256_fmadd_pd(ai, b0, c10); c11 = _mm256_fmadd_pd(ai, b1, c11);
+        ai = _mm256_broadcast_sd(a + 2);
+        c20 = _mm256_fmadd_pd(ai, b0, c20); c21 = _mm256_fmadd_pd(ai, b1, c21);
+        ai = _mm256_broadcast_sd(a + 3);
+        c30 = _mm256_fmadd_pd(ai, b0, c30); c31 = _mm256_fmadd_pd(ai, b1, c31);
+        ai = _mm256_broadcast_sd(a + 4);
+        c40 = _mm256_fmadd_pd(ai, b0, c40); c41 = _mm256_fmadd_pd(ai, b1, c41);
+        ai = _mm256_broadcast_sd(a + 5);
+        c50 = _mm256_fmadd_pd(ai, b0, c50); c51 = _mm256_fmadd_pd(ai, b1, c51);
+    }
+    const __m256d rows[kMR][2] = { { c00, c01 }, { c10, c11 }, { c20, c21 },
+                                   { c30, c31 }, { c40, c41 }, { c50, c51 } };
+    for (size_t r = 0; r < kMR; ++r) {
+        double* row = c + r * ldc;
+        _mm256_storeu_pd(row, _mm256_add_pd(_mm256_loadu_pd(row), rows[r][0]));
+        _mm256_storeu_pd(row + 4, _mm256_add_pd(_mm256_loadu_pd(row + 4), rows[r][1]));
+    }
+}
+
+// 6 x 16：12 个 zmm 累加器
+MTS_TARGET_AVX512 inline void KernelAvx512(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+    __m512d c00 = _mm512_setzero_pd(), c01 = _mm512_setzero_pd();
+    __m512d c10 = _mm512_setzero_pd(), c11 = _mm512_setzero_pd();
+    __m512d c20 = _mm512_setzero_pd(), c21 = _mm512_setzero_pd();
+    __m512d c30 = _mm512_setzero_pd(), c31 = _mm512_setzero_pd();
+    __m512d c40 = _mm512_setzero_pd(), c41 = _mm512_setzero_pd();
+    __m512d c50 = _mm512_setzero_pd(), c51 = _mm512_setzero_pd();
+    for (size_t k = 0; k < kc; ++k, a += kMR, b += 16) {
+        const __m512d b0 = _mm512_loadu_pd(b);
+        const __m512d b1 = _mm512_loadu_pd(b + 8);
+        __m512d ai = _mm512_set1_pd(a[0]);
+        c00 = _mm512_fmadd_pd(ai, b0, c00); c01 = _mm512_fmadd_pd(ai, b1, c01);
+        ai = _mm512_set1_pd(a[1]);
+        c10 = _mm512_fmadd_pd(ai, b0, c10); c11 = _mm512_fmadd_pd(ai, b1, c11);
+        ai = _mm512_set1_pd(a[2]);
+        c20 = _mm512_fmadd_pd(ai, b0, c20); c21 = _mm512_fmadd_pd(ai, b1, c21);
+        ai = _mm512_set1_pd(a[3]);
+        c30 = _mm512_fmadd_pd(ai, b0, c30); c31 = _mm512_fmadd_pd(ai, b1, c31);
+        ai = _mm512_set1_pd(a[4]);
+        c40 = _mm512_fmadd_pd(ai, b0, c40); c41 = _mm512_fmadd_pd(ai, b1, c41);
+        ai = _mm512_set1_pd(a[5]);
+        c50 = _mm512_fmadd_pd(ai, b0, c50); c51 = _mm512_fmadd_pd(ai, b1, c51);
+    }
+    const __m512d rows[kMR][2] = { { c00, c01 }, { c10, c11 }, { c20, c21 },
+                                   { c30, c31 }, { c40, c41 }, { c50, c51 } };
+    for (size_t r = 0; r < kMR; ++r) {
+        double* row = c + r * ldc;
+        _mm512_storeu_pd(row, _mm512_add_pd(_mm512_loadu_pd(row), rows[r][0]));
+        _mm512_storeu_pd(row + 8, _mm512_add_pd(_mm512_loadu_pd(row + 8), rows[r][1]));
+    }
+}
+#endif
+
+struct KernelInfo {
+    MicroKernel kernel;
+    size_t nr;
+    SimdLevel level;
+};
+
+// 请求的级别高于 CPU 支持时降级
+inline KernelInfo SelectKernel(SimdLevel requested) {
+    SimdLevel level = (std::min)(requested, DetectSimdLevel());
+#if defined(MTS_X86)
+    if (level == SimdLevel::Avx512) return { &KernelAvx512, 16, level };
+    if (level == SimdLevel::Avx2) return { &KernelAvx2, 8, level };
+#endif
+    return { &KernelScalar, 4, SimdLevel::Scalar };
+}
+
+// 打包 A 的 mc x kc 子块：每 MR 行一个面板，面板内按 k 连续存放 MR 个元素，不足 MR 行补 0
+inline void PackA(const Matrix& a, size_t row0, size_t mc, size_t col0, size_t kc, double* out) {
+    const size_t lda = a.Cols();
+    for (size_t ir = 0; ir < mc; ir += kMR) {
+        const size_t rows = (std::min)(kMR, mc - ir);
+        const double* src = a.Data() + (row0 + ir) * lda + col0;
+        for (size_t k = 0; k < kc; ++k) {
+            size_t r = 0;
+            for (; r < rows; ++r) *out++ = src[r * lda + k];
+            for (; r < kMR; ++r) *out++ = 0.0;
+        }
+    }
+}
+
+// 打包 B 的 kc x nc 子块：每 NR 列一个面板，面板内按 k 连续存放 NR 个元素，不足 NR 列补 0
+inline void PackB(const Matrix& b, size_t row0, size_t kc, size_t col0, size_t nc, size_t nr, double* out) {
+    const size_t ldb = b.Cols();
+    for (size_t jr = 0; jr < nc; jr += nr) {
+        const size_t cols = (std::min)(nr, nc - jr);
+        const double* src = b.Data() + row0 * ldb + col0 + jr;
+        for (size_t k = 0; k < kc; ++k, src += ldb) {
+            size_t j = 0;
+            for (; j < cols; ++j) *out++ = src[j];
+            for (; j < nr; ++j) *out++ = 0.0;
+        }
+    }
+}
+
+// 计算 C 的行带 [rowBegin, rowEnd)：C 需预先清零
+// 打包缓冲区为线程局部变量，同一线程反复调用不再分配
+inline void MultiplyRows(const Matrix& a, const Matrix& b, Matrix& c, size_t rowBegin, size_t rowEnd,
+    const KernelInfo& info) {
+    thread_local std::vector<double> packedA;
+    thread_local std::vector<double> packedB;
+    packedA.resize(kMC * kKC);
+    packedB.resize(kKC * (kNC + kMaxNR));
+
+    const size_t n = b.Cols();
+    const size_t depth = a.Cols();
+    const size_t ldc = c.Cols();
+    const size_t nr = info.nr;
+    double edge[kMR * kMaxNR];
+
+    for (size_t jc = 0; jc < n; jc += kNC) {
+        const size_t nc = (std::min)(kNC, n - jc);
+        for (size_t pc = 0; pc < depth; pc += kKC) {
+            const size_t kc = (std::min)(kKC, depth - pc);
+            PackB(b, pc, kc, jc, nc, nr, packedB.data());
+            for (size_t ic = rowBegin; ic < rowEnd; ic += kMC) {
+                const size_t mc = (std::min)(kMC, rowEnd - ic);
+                PackA(a, ic, mc, pc, kc, packedA.data());
+                // 宏内核：遍历 MR x NR 的 C 小块
+                for (size_t jr = 0; jr < nc; jr += nr) {
+                    const size_t cols = (std::min)(nr, nc - jr);
+                    const double* bPanel = packedB.data() + jr * kc;
+                    for (size_t ir = 0; ir < mc; ir += kMR) {
+                        const size_t rows = (std::min)(kMR, mc - ir);
+                        const double* aPanel = packedA.data() + ir * kc;
+                        double* cTile = c.Data() + (ic + ir) * ldc + jc + jr;
+                        if (rows == kMR && cols == nr) {
+                            info.kernel(kc, aPanel, bPanel, cTile, ldc);
+                            continue;
+                        }
+                        // 边缘小块：先算到临时缓冲区，再加回有效部分
+                        std::fill(edge, edge + kMR * nr, 0.0);
+                        info.kernel(kc, aPanel, bPanel, edge, nr);
+                        for (size_t r = 0; r < rows; ++r) {
+                            for (size_t j = 0; j < cols; ++j) cTile[r * ldc + j] += edge[r * nr + j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace GemmDetail
+
+// C = A x B (C 的尺寸不符时重新分配)
+// 设置了 parallelFor 且规模足够大时，按行带拆成若干互不重叠的子任务并行计算
+inline void MatrixMultiply(const Matrix& a, const Matrix& b, Matrix& c, const GemmOptions& options = GemmOptions()) {
+    if (a.Cols() != b.Rows()) throw std::invalid_argument("MatrixMultiply: dimension mismatch");
+    if (c.Rows() != a.Rows() || c.Cols() != b.Cols()) c = Matrix(a.Rows(), b.Cols());
+    else c.Fill(0.0);
+
+    const size_t m = a.Rows();
+    const size_t n = b.Cols();
+    const size_t k = a.Cols();
+    if (m == 0 || n == 0 || k == 0) return;
+
+    const GemmDetail::KernelInfo info = GemmDetail::SelectKernel(options.simd);
+    const size_t threshold = options.parallelThreshold;
+    if (!options.parallelFor || m < threshold || n < threshold || k < threshold) {
+        GemmDetail::MultiplyRows(a, b, c, 0, m, info);
+        return;
+    }
+
+    // 行带高度取 MC 的整数倍，最多约 16 个行带 (每个行带各自打包 B，行带过多时重复打包的开销变大)
+    const size_t mc = GemmDetail::kMC;
+    size_t bandRows = (m + 15) / 16;
+    bandRows = (std::max)(mc, (bandRows + mc - 1) / mc * mc);
+    const size_t bands = (m + bandRows - 1) / bandRows;
+    options.parallelFor(bands, [&](size_t band) {
+        const size_t begin = band * bandRows;
+        GemmDetail::MultiplyRows(a, b, c, begin, (std::min)(m, begin + bandRows), info);
+    });
+}
+
+// 朴素 i-j-k 三重循环 (结果校验的参照)
+inline void MatrixMultiplyNaive(const Matrix& a, const Matrix& b, Matrix& c) {
+    if (a.Cols() != b.Rows()) throw std::invalid_argument("MatrixMultiplyNaive: dimension mismatch");
+    c = Matrix(a.Rows(), b.Cols());
+    for (size_t i = 0; i < a.Rows(); ++i) {
+        for (size_t j = 0; j < b.Cols(); ++j) {
+            double sum = 0.0;
+            for (size_t p = 0; p < a.Cols(); ++p) sum += a(i, p) * b(p, j);
+            c(i, j) = sum;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: MpscRingBuffer.h
+// 对应需求: 有界无锁环形队列 (多生产者 / 单消费者)
+// =================================================================================
+#pragma once
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+// 基于序号的有界队列 (Dmitry Vyukov bounded queue)
+// - 生产者之间只竞争一个 CAS，不加锁、不分配内存
+// - 单消费者出队无需 CAS
+// - 容量固定 (向上取整为 2 的幂)，内存占用在构造时确定
+template <typename T>
+class MpscRingBuffer {
+public:
+    explicit MpscRingBuffer(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        m_mask = cap - 1;
+        m_cells.reset(new Cell[cap]);
+        for (size_t i = 0; i < cap; ++i) m_cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    MpscRingBuffer(const MpscRingBuffer&) = delete;
+    MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+    size_t Capacity() const { return m_mask + 1; }
+
+    // 原地填充一个槽位 (避免大对象先构造再拷贝)；队列满时返回 false
+    template <typename Fill>
+    bool TryPushWith(Fill&& fill) {
+        Cell* cell;
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                return false; // 已满
+            }
+            else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        fill(cell->data);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPush(T value) {
+        return TryPushWith([&](T& slot) { slot = std::move(value); });
+    }
+
+    // 仅允许一个消费者线程调用
+    bool TryPop(T& out) {
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell = &m_cells[pos & m_mask];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0) return false; // 为空
+        out = std::move(cell->data);
+        cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+        m_dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 生产者已领取的位置总数 (包括仍在填写中的槽位)：一次 TryPush 返回 true 之后读取，结果一定包含它的记录
+    // 消费者出队数达到该值时，读取之前完成的入队都已被取出
+    size_t ClaimedCount() const {
+        return m_enqueuePos.load(std::memory_order_acquire);
+    }
+
+    // 近似长度 (并发下仅供参考)
+    size_t SizeApprox() const {
+        size_t enq = m_enqueuePos.load(std::memory_order_relaxed);
+        size_t deq = m_dequeuePos.load(std::memory_order_relaxed);
+        return enq > deq ? enq - deq : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq{ 0 };
+        T data{};
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask = 0;
+    alignas(64) std::atomic<size_t> m_enqueuePos{ 0 };
+    alignas(64) std::atomic<size_t> m_dequeuePos{ 0 };
+};
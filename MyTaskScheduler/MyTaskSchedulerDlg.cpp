@@ -64,6 +64,7 @@ BEGIN_MESSAGE_MAP(CMyTaskSchedulerDlg, CDialogEx)
 	ON_WM_SYSCOMMAND()
 	ON_WM_PAINT()
 	ON_WM_QUERYDRAGICON()
+	ON_MESSAGE(WM_SCHEDULER_EVENTS, &CMyTaskSchedulerDlg::OnSchedulerEvents)
 	// === 按钮点击事件映射 ===
 	ON_BN_CLICKED(IDC_BTN_TASK_A, &CMyTaskSchedulerDlg::OnBnClickedBtnTaskA)
 	ON_BN_CLICKED(IDC_BTN_TASK_B, &CMyTaskSchedulerDlg::OnBnClickedBtnTaskB)
@@ -108,23 +109,39 @@ BOOL CMyTaskSchedulerDlg::OnInitDialog()
 	// === 项目3 核心逻辑：初始化调度器 ===
 	// =========================================================
 
-	// 1. 设置 UI 回调：当后台线程有日志时，调用此 Lambda 更新界面
-	TaskScheduler::Instance().SetUICallback([this](std::string msg) {
-		// 注意：这个回调是在后台工作线程运行的
-		// 必须使用 SendMessage 跨线程通知主窗口更新，直接操作控件(AddString)是不安全的
-		if (this->m_hWnd)
-		{
-			CString strMsg(msg.c_str());
-			// 发送 LB_ADDSTRING 消息给列表框
-			::SendMessage(::GetDlgItem(this->m_hWnd, IDC_LIST_LOG), LB_ADDSTRING, 0, (LPARAM)(LPCTSTR)strMsg);
-
-			// 自动滚动到最后一行
-			int count = (int)::SendMessage(::GetDlgItem(this->m_hWnd, IDC_LIST_LOG), LB_GETCOUNT, 0, 0);
-			::SendMessage(::GetDlgItem(this->m_hWnd, IDC_LIST_LOG), LB_SETTOPINDEX, count - 1, 0);
-		}
-		});
-
-	// 2. 启动后台工作线程
+	// 1. 订阅调度事件：事件通道每 50ms 批量推送一次，相同事件已合并 (显示为 "xN")
+	HWND hWnd = m_hWnd;
+	m_eventSubscriber = std::make_shared<CallbackEventSubscriber>(
+		[hWnd](const SchedulerEvent* events, size_t count) {
+		// 注意：这个回调在事件通道的分发线程运行 (不是工作线程，UI 再慢也不会拖住调度)
+		// 只复制文本后 PostMessage 给主窗口，由 UI 线程添加到列表框：
+		// 不能用 SendMessage 等待 UI 线程，关闭窗口时 UI 线程在 Stop() 里等待本线程退出，会互相等待死锁
+		std::vector<std::string>* lines = new std::vector<std::string>();
+		lines->reserve(count);
+		for (size_t i = 0; i < count; ++i)
+			lines->push_back(events[i].ToString());
+		if (!::PostMessage(hWnd, WM_SCHEDULER_EVENTS, 0, (LPARAM)lines))
+			delete lines; // 窗口已销毁或消息队列已满
+	});
+	TaskScheduler::Instance().SubscribeEvents(m_eventSubscriber);
+
+	// 2. 日志切换为异步模式：任务线程只入队，由后台线程批量落盘
+	LogWriter::Instance().EnableAsync();
+
+	// 3. 持久模式：周期任务写入 scheduler_state\ 下的日志，重启后自动恢复 (不用再手动登记)
+	DurableTaskRegistry registry;
+	TaskFactory::RegisterDurableTypes(registry);
+	TaskScheduler::Instance().EnableDurability(JournalOptions(), std::move(registry));
+
+	// 4. 按任务类型限流：备份同一时间只跑一个，HTTP 请求每秒最多 2 次 (多点几下按钮也不会堆在一起执行)
+	RateLimit backupLimit;
+	backupLimit.maxConcurrent = 1;
+	TaskScheduler::Instance().SetRateLimit("File Backup Task", backupLimit);
+	RateLimit httpLimit;
+	httpLimit.ratePerSecond = 2;
+	TaskScheduler::Instance().SetRateLimit("HTTP Request Task", httpLimit);
+
+	// 5. 启动后台工作线程
 	TaskScheduler::Instance().Start();
 
 	return TRUE;
@@ -136,37 +153,54 @@ BOOL CMyTaskSchedulerDlg::OnInitDialog()
 
 void CMyTaskSchedulerDlg::OnBnClickedBtnTaskA()
 {
-	// Task A: 备份 (延迟 2秒, 一次性)
-	auto task = TaskFactory::CreateTask(TaskType::Backup);
-	TaskScheduler::Instance().AddTask(task, 2000, 0);
+	// Task A: 备份 (延迟 2秒, 一次性, 后台低优先级)
+	auto task = TaskFactory::GetSharedTask(TaskType::Backup);
+	TaskOptions options;
+	options.priority = TaskPriority::Low;
+	TaskScheduler::Instance().AddTask(task, 2000, 0, options);
 }
 
 void CMyTaskSchedulerDlg::OnBnClickedBtnTaskB()
 {
-	// Task B: 计算 (立即开始, 周期 5秒)
-	auto task = TaskFactory::CreateTask(TaskType::Matrix);
-	TaskScheduler::Instance().AddTask(task, 0, 5000);
+	// Task B: 计算 (立即开始, 周期 5秒; 持久任务，程序重启后继续按周期运行)
+	// 同一合并键只保留一个周期任务：重复点击不会叠加出多个每 5 秒一次的矩阵乘法
+	TaskOptions options;
+	options.coalesceKey = "Task B Matrix";
+	options.coalesce = CoalescePolicy::KeepEarliest;
+	TaskHandle handle = TaskScheduler::Instance().AddDurableTask(TaskFactory::DurableTypeName(TaskType::Matrix), "", 0, 5000, options);
+	if (!handle.IsValid()) {
+		// 持久模式未开启 (目录不可写等)：退回普通周期任务
+		TaskScheduler::Instance().AddTask(TaskFactory::GetSharedTask(TaskType::Matrix), 0, 5000, options);
+	}
 }
 
 void CMyTaskSchedulerDlg::OnBnClickedBtnTaskC()
 {
 	// Task C: HTTP (立即, 一次性)
-	auto task = TaskFactory::CreateTask(TaskType::Http);
-	TaskScheduler::Instance().AddTask(task, 0, 0);
+	// 异步获取：请求由 HttpEngine 的 IO 线程发出，等待网络期间不占用任何工作线程，结果到达后再执行任务
+	auto task = std::make_shared<CHttpTask>(true);
+	TaskScheduler::Instance().AddAsyncTask(TaskBody(task), [task](TaskScheduler::AsyncDone done) {
+		CHttpTask::Prefetch(task, std::move(done));
+	});
 }
 
 void CMyTaskSchedulerDlg::OnBnClickedBtnTaskD()
 {
-	// Task D: 提醒 (立即, 周期 3秒 - 演示用)
-	auto task = TaskFactory::CreateTask(TaskType::Reminder);
-	TaskScheduler::Instance().AddTask(task, 0, 3000);
+	// Task D: 提醒 (立即, 周期 3秒 - 演示用; 最高优先级, 到期后尽快弹出)
+	// 不设截止时间：弹出的是模态对话框，任务要等用户点掉才结束，截止时间按完成时刻判定，每次都会记为超时
+	auto task = TaskFactory::GetSharedTask(TaskType::Reminder);
+	TaskOptions options;
+	options.priority = TaskPriority::Critical;
+	TaskScheduler::Instance().AddTask(task, 0, 3000, options);
 }
 
 void CMyTaskSchedulerDlg::OnBnClickedBtnTaskE()
 {
-	// Task E: 统计 (延迟 10秒, 一次性)
-	auto task = TaskFactory::CreateTask(TaskType::Stats);
-	TaskScheduler::Instance().AddTask(task, 10000, 0);
+	// Task E: 统计 (延迟 10秒, 一次性, 后台低优先级)
+	auto task = TaskFactory::GetSharedTask(TaskType::Stats);
+	TaskOptions options;
+	options.priority = TaskPriority::Low;
+	TaskScheduler::Instance().AddTask(task, 10000, 0, options);
 }
 
 // ===========================================================================
@@ -192,12 +226,36 @@ void CMyTaskSchedulerDlg::AppendLog(std::string msg)
 	}
 }
 
+// 事件通道投递的一批日志 (UI 线程)：整批添加期间关闭重绘，最后只滚动、重绘一次
+LRESULT CMyTaskSchedulerDlg::OnSchedulerEvents(WPARAM wParam, LPARAM lParam)
+{
+	std::unique_ptr<std::vector<std::string>> lines(reinterpret_cast<std::vector<std::string>*>(lParam));
+	CListBox* pList = (CListBox*)GetDlgItem(IDC_LIST_LOG);
+	if (!pList || lines->empty()) return 0;
+
+	pList->SetRedraw(FALSE);
+	for (const std::string& line : *lines)
+		pList->AddString(CString(line.c_str()));
+	pList->SetTopIndex(pList->GetCount() - 1);
+	pList->SetRedraw(TRUE);
+	pList->Invalidate();
+	return 0;
+}
+
 // 窗口关闭/销毁时
 void CMyTaskSchedulerDlg::OnCancel()
 {
-	// 停止调度器线程，防止关闭窗口时后台线程还在跑导致崩溃
+	// 先退订事件，再停止调度器线程 (Stop 会等待事件分发线程退出，返回后不会再有回调)
+	// 防止关闭窗口时后台线程还在跑导致崩溃
+	TaskScheduler::Instance().UnsubscribeEvents(m_eventSubscriber);
+	m_eventSubscriber.reset();
 	TaskScheduler::Instance().Stop();
 
+	// 释放已投递但还没处理的日志批次
+	MSG msg;
+	while (::PeekMessage(&msg, m_hWnd, WM_SCHEDULER_EVENTS, WM_SCHEDULER_EVENTS, PM_REMOVE))
+		delete reinterpret_cast<std::vector<std::string>*>(msg.lParam);
+
 	CDialogEx::OnCancel();
 }
 
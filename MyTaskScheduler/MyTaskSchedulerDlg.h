@@ -2,7 +2,14 @@
 //
 
 #pragma once
+#include <memory>
 #include <string>
+#include <vector>
+
+class IEventSubscriber;
+
+// 事件通道分发线程投递给主窗口的一批日志文本 (LPARAM 为 new 出的 std::vector<std::string>*，由处理函数释放)
+#define WM_SCHEDULER_EVENTS (WM_APP + 1)
 
 // CMyTaskSchedulerDlg 对话框
 class CMyTaskSchedulerDlg : public CDialogEx
@@ -22,12 +29,14 @@ protected:
 	// 实现
 protected:
 	HICON m_hIcon;
+	std::shared_ptr<IEventSubscriber> m_eventSubscriber; // 关闭窗口时先退订再停止调度器
 
 	// 生成的消息映射函数
 	virtual BOOL OnInitDialog();
 	afx_msg void OnSysCommand(UINT nID, LPARAM lParam);
 	afx_msg void OnPaint();
 	afx_msg HCURSOR OnQueryDragIcon();
+	afx_msg LRESULT OnSchedulerEvents(WPARAM wParam, LPARAM lParam);
 	DECLARE_MESSAGE_MAP()
 
 public:
@@ -0,0 +1,95 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: NameInterner.h
+// 对应需求: 任务名驻留 (String Interning)，事件与日志只传递指针，不再构造 std::string；
+//           合并键 / 限流键这类动态键使用带引用计数的驻留表，不再被引用后释放
+// =================================================================================
+#pragma once
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+// 名字驻留表：相同内容的名字只保存一份，返回的指针在进程生命周期内有效
+// 查找使用 string_view，已驻留的名字再次查询不分配内存
+class NameInterner {
+public:
+    static NameInterner& Instance() {
+        static NameInterner instance;
+        return instance;
+    }
+
+    const char* Intern(std::string_view name) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_names.find(name);
+        if (it != m_names.end()) return it->second.get();
+
+        std::unique_ptr<char[]> text(new char[name.size() + 1]);
+        std::memcpy(text.get(), name.data(), name.size());
+        text[name.size()] = '\0';
+        const char* result = text.get();
+        // 键指向自己持有的副本，而不是调用方的内存
+        m_names.emplace(std::string_view(result, name.size()), std::move(text));
+        return result;
+    }
+
+    size_t Size() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_names.size();
+    }
+
+private:
+    NameInterner() = default;
+    NameInterner(const NameInterner&) = delete;
+    NameInterner& operator=(const NameInterner&) = delete;
+
+    std::unordered_map<std::string_view, std::unique_ptr<char[]>> m_names;
+    std::mutex m_mutex;
+};
+
+// 带引用计数的键驻留表 (调度器持有)：合并键、限流键可能按 URL / 用户 / 请求动态生成，
+// 放进进程级的 NameInterner 会永远不释放。每个持有者 Acquire 一次、用完 Release 一次，计数归零时删除；
+// 键被引用期间相同内容返回同一个指针，所以持有者之间可以按指针比较
+class KeyInterner {
+public:
+    KeyInterner() = default;
+    KeyInterner(const KeyInterner&) = delete;
+    KeyInterner& operator=(const KeyInterner&) = delete;
+
+    const char* Acquire(std::string_view key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_keys.find(key);
+        if (it != m_keys.end()) {
+            ++it->second.refs;
+            return it->second.text.get();
+        }
+        std::unique_ptr<char[]> text(new char[key.size() + 1]);
+        std::memcpy(text.get(), key.data(), key.size());
+        text[key.size()] = '\0';
+        const char* result = text.get();
+        m_keys.emplace(std::string_view(result, key.size()), Entry{ std::move(text), 1 });
+        return result;
+    }
+
+    // key 必须是 Acquire 返回的指针
+    void Release(const char* key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_keys.find(std::string_view(key));
+        if (it != m_keys.end() && --it->second.refs == 0) m_keys.erase(it);
+    }
+
+    size_t Size() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_keys.size();
+    }
+
+private:
+    struct Entry {
+        std::unique_ptr<char[]> text;
+        size_t refs;
+    };
+
+    std::unordered_map<std::string_view, Entry> m_keys;   // 键指向 Entry 自己持有的副本
+    std::mutex m_mutex;
+};
@@ -0,0 +1,93 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: ObjectPool.h
+// 对应需求: 任务对象池 (Slab 分配，对象回收复用，稳态下零堆分配)
+// =================================================================================
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// 按 Slab 成批分配的对象池
+// - 每个 Slab 一次性分配 SlabSize 个对象，对象地址终身不变，池析构时统一释放
+// - 每个对象有一个固定的槽位号 (poolSlot)，可用 At(slot) 以 O(1) 找回，
+//   调度器用它把任务编号直接映射到节点，不再需要哈希表
+// - 回收的对象不析构，保持上次的状态，由调用方在复用前重置
+// T 需要有一个 uint32_t poolSlot 成员，由池在创建时写入
+template <typename T, size_t SlabSize = 1024, size_t MaxSlabs = 4096>
+class ObjectPool {
+public:
+    ObjectPool() {
+        for (auto& slab : m_slabs) slab.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~ObjectPool() {
+        for (auto& slab : m_slabs) delete[] slab.load(std::memory_order_relaxed);
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    // 取一个空闲对象；池空时追加一个 Slab (只有这时才分配内存)
+    T* Acquire() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_free.empty()) GrowLocked();
+        T* obj = m_free.back();
+        m_free.pop_back();
+        return obj;
+    }
+
+    // 归还对象 (不析构)
+    void Release(T* obj) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(obj); // 容量在 GrowLocked 中已预留，不会重新分配
+    }
+
+    // 预热：保证至少有 count 个对象可用，之后的 Acquire 不再分配内存
+    void Reserve(size_t count) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        while (m_free.size() < count) GrowLocked();
+    }
+
+    // 按槽位号取对象 (无锁)；槽位不存在时返回 nullptr
+    T* At(uint32_t slot) const {
+        size_t slabIndex = slot / SlabSize;
+        if (slabIndex >= MaxSlabs) return nullptr;
+        T* slab = m_slabs[slabIndex].load(std::memory_order_acquire);
+        return slab ? &slab[slot % SlabSize] : nullptr;
+    }
+
+    // 已分配的对象总数
+    size_t Capacity() const { return m_slabCount.load(std::memory_order_relaxed) * SlabSize; }
+
+    // 当前被取走、尚未归还的对象数
+    size_t InUse() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return Capacity() - m_free.size();
+    }
+
+private:
+    void GrowLocked() {
+        size_t index = m_slabCount.load(std::memory_order_relaxed);
+        if (index >= MaxSlabs) throw std::bad_alloc();
+
+        T* slab = new T[SlabSize];
+        for (size_t i = 0; i < SlabSize; ++i) {
+            slab[i].poolSlot = static_cast<uint32_t>(index * SlabSize + i);
+        }
+        m_free.reserve((index + 1) * SlabSize);
+        // 倒序压入，使 Acquire 先取到低槽位
+        for (size_t i = SlabSize; i > 0; --i) m_free.push_back(&slab[i - 1]);
+
+        m_slabs[index].store(slab, std::memory_order_release);
+        m_slabCount.store(index + 1, std::memory_order_relaxed);
+    }
+
+    std::atomic<T*> m_slabs[MaxSlabs];
+    std::atomic<size_t> m_slabCount{ 0 };
+    std::vector<T*> m_free;
+    std::mutex m_mutex;
+};
@@ -0,0 +1,170 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: RateLimiter.h
+// 对应需求: 按任务类型 / 标签限流：并发上限 + 令牌桶速率限制，可在运行中修改
+// =================================================================================
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// 一个限流键的限制 (两项都为 0 表示不限制)
+struct RateLimit {
+    int maxConcurrent = 0;      // 同时执行的上限 (0 表示不限)
+    double ratePerSecond = 0;   // 令牌桶：每秒开始执行的次数 (0 表示不限)
+    double burst = 0;           // 桶容量，允许的突发次数 (0 表示取 max(1, ratePerSecond))
+};
+
+// 一个限流键的统计快照
+struct RateLimitStats {
+    RateLimit limit;
+    int running = 0;                          // 正在执行
+    size_t waitingForSlot = 0;                // 等待并发空位
+    double tokens = 0;                        // 桶中剩余令牌
+    unsigned long long started = 0;           // 通过限流开始执行的次数
+    unsigned long long deferredForSlot = 0;   // 因并发已满被挂起的次数
+    unsigned long long deferredForToken = 0;  // 因没有令牌被推迟到时间轮的次数
+};
+
+// 限流键 -> 限流状态
+// 按键的内容查找 (任务名来自 NameInterner，limitKey 来自调度器的 KeyInterner，指针不同)，键由状态对象自己保存；
+// 状态对象创建后不再销毁 (删除限制只是改为不限)，调度节点可以一直持有指针。查找由本类的锁保护，计数与令牌由调度器在持有 m_mutex 时修改
+class RateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TaskId = uint64_t;
+
+    struct State {
+        std::string key;
+        RateLimit limit;
+        std::atomic<bool> limited{ false };   // 无锁读取：不限制的键在领取任务时直接放行
+        int running = 0;
+        double tokens = 0;
+        Clock::time_point refilled;
+        std::deque<TaskId> waiters;           // 等待并发空位的任务编号 (任务可能先被取消，所以不存指针)
+        unsigned long long started = 0;
+        unsigned long long deferredForSlot = 0;
+        unsigned long long deferredForToken = 0;
+    };
+
+    enum class Decision { Run, WaitSlot, WaitToken };
+
+    // 是否设置过任何限制 (没有时领取任务只多一次原子读)
+    bool Active() const {
+        return m_active.load(std::memory_order_relaxed);
+    }
+
+    // 每登记一个新键加一：节点缓存的查找结果在版本变化后重新查找
+    uint64_t Version() const {
+        return m_version.load(std::memory_order_acquire);
+    }
+
+    // 查找键对应的状态 (没有登记过返回 nullptr)
+    State* Find(std::string_view key) {
+        std::lock_guard<std::mutex> lock(m_mapMutex);
+        auto it = m_states.find(key);
+        return (it != m_states.end()) ? it->second.get() : nullptr;
+    }
+
+    // 登记或修改限制，调用方持有调度锁；返回状态对象
+    State* SetLocked(const std::string& key, const RateLimit& limit, Clock::time_point now) {
+        State* state = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(m_mapMutex);
+            auto it = m_states.find(key);
+            if (it == m_states.end()) {
+                auto created = std::make_unique<State>();
+                created->key = key;
+                created->refilled = now;
+                const std::string_view view(created->key); // 映射的键指向状态自己保存的副本
+                it = m_states.emplace(view, std::move(created)).first;
+                m_version.fetch_add(1, std::memory_order_release);
+            }
+            state = it->second.get();
+        }
+        Refill(*state, now);
+        const bool hadRate = state->limit.ratePerSecond > 0;
+        state->limit = limit;
+        state->limit.maxConcurrent = (std::max)(limit.maxConcurrent, 0);
+        state->limit.ratePerSecond = (std::max)(limit.ratePerSecond, 0.0);
+        // 新开启速率限制时桶是满的；修改速率时保留剩余令牌 (不超过新的桶容量)
+        state->tokens = hadRate ? (std::min)(state->tokens, Burst(state->limit)) : Burst(state->limit);
+        state->limited = state->limit.maxConcurrent > 0 || state->limit.ratePerSecond > 0;
+        m_active = true;
+        return state;
+    }
+
+    // 任务开始执行前申请，调用方持有调度锁
+    // WaitSlot: 并发已满，调用方把任务挂起并登记到 waiters；WaitToken: retryAfter 后再试
+    Decision AcquireLocked(State& state, Clock::time_point now, Clock::duration& retryAfter) {
+        const RateLimit& limit = state.limit;
+        if (limit.maxConcurrent > 0 && state.running >= limit.maxConcurrent) {
+            ++state.deferredForSlot;
+            return Decision::WaitSlot;
+        }
+        if (limit.ratePerSecond > 0) {
+            Refill(state, now);
+            if (state.tokens < 1.0) {
+                ++state.deferredForToken;
+                retryAfter = std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>((1.0 - state.tokens) / limit.ratePerSecond));
+                return Decision::WaitToken;
+            }
+            state.tokens -= 1.0;
+        }
+        ++state.running;
+        ++state.started;
+        return Decision::Run;
+    }
+
+    // 一次执行结束，归还并发名额，调用方持有调度锁
+    // 返回 true 表示有等待者可以放行 (由调用方从 waiters 中取出)
+    bool ReleaseLocked(State& state) {
+        if (state.running > 0) --state.running;
+        return HasFreeSlot(state) && !state.waiters.empty();
+    }
+
+    static bool HasFreeSlot(const State& state) {
+        return state.limit.maxConcurrent <= 0 || state.running < state.limit.maxConcurrent;
+    }
+
+    RateLimitStats StatsLocked(std::string_view key, Clock::time_point now) {
+        RateLimitStats stats;
+        State* state = Find(key);
+        if (!state) return stats;
+        Refill(*state, now);
+        stats.limit = state->limit;
+        stats.running = state->running;
+        stats.waitingForSlot = state->waiters.size();
+        stats.tokens = state->tokens;
+        stats.started = state->started;
+        stats.deferredForSlot = state->deferredForSlot;
+        stats.deferredForToken = state->deferredForToken;
+        return stats;
+    }
+
+private:
+    static double Burst(const RateLimit& limit) {
+        return (limit.burst > 0) ? limit.burst : (std::max)(1.0, limit.ratePerSecond);
+    }
+
+    static void Refill(State& state, Clock::time_point now) {
+        if (now <= state.refilled) return;
+        const double elapsed = std::chrono::duration<double>(now - state.refilled).count();
+        state.refilled = now;
+        if (state.limit.ratePerSecond <= 0) return;
+        state.tokens = (std::min)(Burst(state.limit), state.tokens + elapsed * state.limit.ratePerSecond);
+    }
+
+    std::atomic<bool> m_active{ false };
+    std::atomic<uint64_t> m_version{ 0 };
+    std::mutex m_mapMutex;
+    std::unordered_map<std::string_view, std::unique_ptr<State>> m_states;
+};
@@ -0,0 +1,260 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: ResultCache.h
+// 对应需求: 幂等任务的结果缓存：按 "任务 + 参数" 缓存在内存中，TTL 过期、容量上限与 LRU 淘汰，
+//           同键并发加载只执行一次 (Single-flight)，过期条目保留校验信息供条件请求重新验证
+// =================================================================================
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// 一条缓存结果 (发布后只读，多个调用方共享)
+struct CachedResult {
+    std::string value;          // 结果内容 (由使用方自行编码)
+    std::string etag;           // 校验信息：HTTP ETag (为空表示没有)
+    std::string lastModified;   // 校验信息：HTTP Last-Modified
+    std::chrono::steady_clock::time_point storedAt;
+    std::chrono::steady_clock::time_point expiresAt; // 加载函数不设置时为存入时刻 + TTL
+
+    bool IsFresh(std::chrono::steady_clock::time_point now) const {
+        return now < expiresAt;
+    }
+};
+
+using CachedResultPtr = std::shared_ptr<const CachedResult>;
+
+struct ResultCacheOptions {
+    size_t maxEntries = 1024;                  // 条目数上限 (0 表示不限)
+    size_t maxBytes = 16 * 1024 * 1024;        // 键与内容的总字节数上限 (0 表示不限)
+    std::chrono::milliseconds ttl{ 60000 };    // 默认有效期
+};
+
+struct ResultCacheStats {
+    size_t entries = 0;
+    size_t bytes = 0;
+    unsigned long long hits = 0;          // 命中新鲜条目
+    unsigned long long misses = 0;        // 没有条目或已过期
+    unsigned long long loads = 0;         // 执行加载函数的次数
+    unsigned long long loadFailures = 0;  // 加载函数返回空或抛出异常
+    unsigned long long joined = 0;        // 同键加载进行中，等待其结果而没有重复加载
+    unsigned long long evictions = 0;     // 超出容量被 LRU 淘汰
+};
+
+// 结果缓存：一把锁保护 LRU 链表 + 哈希索引；加载函数在锁外执行
+// 过期条目不会立即删除：它的 etag / lastModified 交给下一次加载做条件请求，
+// 未变化时只刷新有效期，不重新传输内容
+class ResultCache {
+public:
+    // 加载函数：stale 为过期的旧条目 (没有时为空)；返回新条目，返回空表示失败 (不缓存，旧条目保留)
+    using Loader = std::function<std::shared_ptr<CachedResult>(const CachedResultPtr& stale)>;
+
+    // 进程内共享的缓存，任务体可以直接使用而不依赖调度器 (与 LogWriter 相同)
+    static ResultCache& Instance() {
+        static ResultCache instance;
+        return instance;
+    }
+
+    explicit ResultCache(const ResultCacheOptions& options = ResultCacheOptions()) : m_options(options) {}
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    // 缓存键：任务名 + 参数 (以 0x1F 分隔，避免 "a"+"bc" 与 "ab"+"c" 相同)
+    static std::string MakeKey(const std::string& task, const std::string& params) {
+        std::string key;
+        key.reserve(task.size() + 1 + params.size());
+        key += task;
+        key += '\x1f';
+        key += params;
+        return key;
+    }
+
+    void SetOptions(const ResultCacheOptions& options) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_options = options;
+        TrimLocked();
+    }
+
+    ResultCacheOptions GetOptions() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_options;
+    }
+
+    // 取新鲜条目 (过期或没有时返回空)，命中时移到 LRU 头部
+    CachedResultPtr Get(const std::string& key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        CachedResultPtr entry = FindLocked(key, true);
+        if (entry && entry->IsFresh(std::chrono::steady_clock::now())) {
+            ++m_stats.hits;
+            return entry;
+        }
+        ++m_stats.misses;
+        return nullptr;
+    }
+
+    // 取条目 (包括已过期的)，不计入命中统计，不调整 LRU 顺序
+    CachedResultPtr Peek(const std::string& key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return FindLocked(key, false);
+    }
+
+    // 存入条目；expiresAt 未设置时按 ttl (< 0 表示使用默认有效期)
+    CachedResultPtr Put(const std::string& key, std::shared_ptr<CachedResult> entry,
+        std::chrono::milliseconds ttl = std::chrono::milliseconds(-1)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return StoreLocked(key, std::move(entry), ttl);
+    }
+
+    // 有新鲜条目时直接返回；否则同键只有一个调用方执行 load，并发的其他调用方等待它的结果
+    // 加载失败时返回空 (等待者同样得到空)；load 抛出的异常只在执行它的调用方重新抛出
+    CachedResultPtr GetOrLoad(const std::string& key, const Loader& load,
+        std::chrono::milliseconds ttl = std::chrono::milliseconds(-1)) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        CachedResultPtr stale = FindLocked(key, true);
+        if (stale && stale->IsFresh(std::chrono::steady_clock::now())) {
+            ++m_stats.hits;
+            return stale;
+        }
+        ++m_stats.misses;
+
+        auto inflight = m_inflight.find(key);
+        if (inflight != m_inflight.end()) {
+            std::shared_ptr<Flight> flight = inflight->second;
+            ++m_stats.joined;
+            m_flightCv.wait(lock, [&flight] { return flight->done; });
+            return flight->result;
+        }
+
+        auto flight = std::make_shared<Flight>();
+        m_inflight.emplace(key, flight);
+        ++m_stats.loads;
+        lock.unlock();
+
+        std::shared_ptr<CachedResult> loaded;
+        try {
+            loaded = load(stale);
+        }
+        catch (...) {
+            Finish(key, flight, nullptr, ttl);
+            throw;
+        }
+        return Finish(key, flight, std::move(loaded), ttl);
+    }
+
+    void Erase(const std::string& key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(key);
+        if (it != m_index.end()) RemoveLocked(it->second);
+    }
+
+    void Clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lru.clear();
+        m_index.clear();
+        m_bytes = 0;
+    }
+
+    ResultCacheStats GetStats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ResultCacheStats stats = m_stats;
+        stats.entries = m_lru.size();
+        stats.bytes = m_bytes;
+        return stats;
+    }
+
+    void ResetStats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats = ResultCacheStats();
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        CachedResultPtr result;
+        size_t bytes = 0;
+    };
+
+    // 进行中的加载 (Single-flight)
+    struct Flight {
+        bool done = false;
+        CachedResultPtr result;
+    };
+
+    using LruList = std::list<Entry>;
+
+    CachedResultPtr FindLocked(const std::string& key, bool touch) {
+        auto it = m_index.find(key);
+        if (it == m_index.end()) return nullptr;
+        if (touch) m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return it->second->result;
+    }
+
+    CachedResultPtr StoreLocked(const std::string& key, std::shared_ptr<CachedResult> entry, std::chrono::milliseconds ttl) {
+        const auto now = std::chrono::steady_clock::now();
+        entry->storedAt = now;
+        if (entry->expiresAt == std::chrono::steady_clock::time_point()) {
+            entry->expiresAt = now + ((ttl.count() >= 0) ? ttl : m_options.ttl);
+        }
+        const size_t bytes = key.size() + entry->value.size() + entry->etag.size() + entry->lastModified.size();
+        CachedResultPtr result = std::move(entry);
+
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            m_bytes -= it->second->bytes;
+            it->second->result = result;
+            it->second->bytes = bytes;
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+        }
+        else {
+            m_lru.push_front(Entry{ key, result, bytes });
+            m_index.emplace(key, m_lru.begin());
+        }
+        m_bytes += bytes;
+        TrimLocked();
+        return result; // 超过容量上限的单个条目会被立即淘汰，但调用方仍然得到结果
+    }
+
+    void RemoveLocked(LruList::iterator it) {
+        m_bytes -= it->bytes;
+        m_index.erase(it->key);
+        m_lru.erase(it);
+    }
+
+    // 从 LRU 尾部淘汰，直到满足条目数与字节数上限
+    void TrimLocked() {
+        while (!m_lru.empty()
+            && ((m_options.maxEntries > 0 && m_lru.size() > m_options.maxEntries)
+                || (m_options.maxBytes > 0 && m_bytes > m_options.maxBytes))) {
+            RemoveLocked(std::prev(m_lru.end()));
+            ++m_stats.evictions;
+        }
+    }
+
+    CachedResultPtr Finish(const std::string& key, const std::shared_ptr<Flight>& flight,
+        std::shared_ptr<CachedResult> loaded, std::chrono::milliseconds ttl) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        CachedResultPtr result;
+        if (loaded) result = StoreLocked(key, std::move(loaded), ttl);
+        else ++m_stats.loadFailures;
+        flight->result = result;
+        flight->done = true;
+        m_inflight.erase(key);
+        m_flightCv.notify_all();
+        return result;
+    }
+
+    ResultCacheOptions m_options;
+    ResultCacheStats m_stats;
+    LruList m_lru;                                            // 头部最近使用
+    std::unordered_map<std::string, LruList::iterator> m_index;
+    size_t m_bytes = 0;
+    std::unordered_map<std::string, std::shared_ptr<Flight>> m_inflight;
+    std::condition_variable m_flightCv;
+    std::mutex m_mutex;
+};
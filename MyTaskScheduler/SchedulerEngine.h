@@ -1,33 +1,184 @@
-// =================================================================================
-// Ŀ: MyTaskScheduler (Project 3)
-// ļ: SchedulerEngine.h
-// Ӧ: ȡȶС̰߳ȫ
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: SchedulerEngine.h
+// 对应需求: 任务调度、优先队列、线程安全
 // =================================================================================
 #pragma once
-#include "TaskEngine.h"
-#include <queue>
+#include "ITask.h"
+#include "LogUtils.h"
+#include "WorkStealingQueue.h"
+#include "TimingWheel.h"
+#include "EventChannel.h"
+#include "ObjectPool.h"
+#include "SmallFunction.h"
+#include "NameInterner.h"
+#include "TaskGraph.h"
+#include "TaskOptions.h"
+#include "ElasticPool.h"
+#include "SchedulerMetrics.h"
+#include "TraceRecorder.h"
+#include "TaskJournal.h"
+#include "CpuTopology.h"
+#include "RateLimiter.h"
+#include "HttpEngine.h"
 #include <mutex>
 #include <condition_variable>
 #include <functional>
 #include <chrono>
+#include <atomic>
+#include <vector>
+#include <cstring>
+#include <type_traits>
+#include <algorithm>
+#include <exception>
+#include <climits>
+#include <unordered_map>
 
-//  UI ص (Observer Pattern ļ򻯰)
+// 定义 UI 回调函数类型 (Observer Pattern 的简化版)
+// 兼容旧接口：回调改为在事件通道的分发线程上调用，不再阻塞调度与工作线程
 using UINotifyCallback = std::function<void(std::string)>;
 
-// װ (Decorator/Wrapper)
-struct ScheduledTask {
-    std::shared_ptr<ITask> task;
-    std::chrono::system_clock::time_point runTime; // ִʱ
-    bool isPeriodic;          // Ƿ
-    int intervalMs;           // ʱ()
+// 任务编号 (0 表示无效)
+// 低 32 位为对象池槽位，高 32 位为槽位的复用代数 (Generation)：节点回收复用后旧编号自动失效
+using TaskId = uint64_t;
+
+// 任务生命周期状态
+enum class TaskState : int {
+    Waiting,    // 挂在时间轮上等待到期
+    Ready,      // 已到期，位于某个工作线程的就绪队列
+    Running,    // 正在执行
+    Rearm,      // 在就绪队列中被 Reschedule：工作线程取到后不执行，按 runTime 重新挂回时间轮
+    Cancelled,  // 在就绪队列中被取消 (墓碑 Tombstone，等待工作线程回收)
+    Blocked,    // 等待前驱任务结束 (不在时间轮或队列中)
+    LimitWait   // 依赖早已满足，正在等待限流键的并发名额 (登记在 RateLimiter::State::waiters 中)
+};
+
+// 协程任务 (CoTask.h) 本次恢复执行后挂起在哪里，由等待体 (Awaiter) 在挂起时写入
+// 工作线程在协程让出控制权之后才按此停放节点，协程不会在挂起完成前被另一个线程恢复
+enum class CoPark : int {
+    None,   // 没有挂起 (协程已结束)
+    Delay,  // co_await scheduler.Delay(ms)：挂到时间轮上
+    Task,   // co_await handle：等待另一个任务最终结束
+    Event   // co_await event：等待 AsyncEvent 被置位
+};
+
+// 协程可等待的事件状态 (CoTask.h 的 AsyncEvent)，由调度器在 m_mutex 下维护
+struct CoEventState {
+    bool signaled = false;
+    std::vector<TaskId> waiters;   // 挂起在该事件上的协程任务编号
+};
+
+// 调度任务封装类 (Decorator/Wrapper)
+// 作为侵入式节点挂在时间轮与就绪队列上，由调度器的对象池统一分配、回收复用
+// registered 与 state 之外的字段只在持有 m_mutex 时修改 (提交时在登记之前初始化)
+struct ScheduledTask : TimerNode {
+    TaskId id = 0;
+    uint32_t poolSlot = 0;        // 对象池槽位 (由 ObjectPool 写入，终身不变)
+    uint32_t generation = 0;      // 槽位复用代数
+    bool registered = false;      // 能否按编号找到 (任务结束或取消后置为 false)
+    std::shared_ptr<ITask> task;  // 任务对象，与 fn 二选一
+    SmallFunction fn;             // 可调用对象 (小对象内联存储)
+    const char* name = "";        // 驻留的任务名 (NameInterner)，事件与日志直接引用
+    std::chrono::steady_clock::time_point runTime; // 执行时间点 (单调时钟，不受系统改时影响)
+    bool isPeriodic = false;  // 是否周期性
+    int intervalMs = 0;       // 周期时间(毫秒)
+    bool cancelRequested = false; // 运行中被取消：本次执行完后不再重挂
+    int rearmDelayMs = -1;        // 运行中被 Reschedule：本次执行完后按此延迟重挂一次
+    std::atomic<TaskState> state{ TaskState::Waiting };
+
+    // === 优先级与截止时间 ===
+    TaskPriority priority = TaskPriority::Normal;
+    int deadlineMs = 0;       // 每次到期后的截止时间 (0 表示没有)
+    std::chrono::steady_clock::time_point deadlineAt; // 本次运行的截止时刻 (同级 EDF 排序键)
+    std::chrono::steady_clock::time_point readyTime;  // 进入就绪队列的时刻 (老化依据)
+    bool blocking = false;    // 阻塞 / IO 任务，交给弹性线程池
+    TaskPlacement placement = TaskPlacement::Default;
+    int homeWorker = -1;      // SameCore / NodeLocal 的归属工作线程 (-1 表示在分发时确定)
+    bool periodicRun = false; // 本次就绪时是否为周期任务 (就绪时在锁内记下，供运行统计读取)
+    uint64_t durableKey = 0;  // 持久编号 (TaskJournal)，0 表示不持久
+
+    // === 准入控制 (AdmissionOptions)，只在持有 m_mutex 时访问 ===
+    bool admitted = false;            // 占用容量 (注销时归还)
+    uint64_t admitSeq = 0;            // 接纳顺序 (DropOldest 依据)
+    ScheduledTask* admitPrev = nullptr; // 同优先级已接纳任务的链表 (按接纳顺序)
+    ScheduledTask* admitNext = nullptr;
+
+    // === 限流 (RateLimiter.h) ===
+    const char* limitKey = nullptr;              // 限流键：任务名，或 m_keys 中的键 (节点持有引用)
+    RateLimiter::State* limitState = nullptr;    // 按 limitKey 查到的限流状态 (limitVersion 变化后重新查找)
+    uint64_t limitVersion = 0;
+    bool holdsLimit = false;                     // 本次执行占用了一个并发名额
+
+    // === 合并键 (TaskOptions::coalesceKey) ===
+    const char* coalesceKey = nullptr;           // m_keys 中的合并键 (节点持有引用)，只由 AddTask / AddTasks 等提交入口设置
+
+    // === 依赖图 (Then / WhenAll / WhenAny / TaskGraph) ===
+    std::vector<TaskId> successors;   // 后继任务编号 (后继可能先被取消，所以不存指针)
+    std::atomic<int> pendingDeps{ 0 }; // 尚未结束的前驱数量，减到 0 时立即变为可运行
+    bool joinAny = false;             // WhenAny：任一前驱成功即可运行
+    bool depFailed = false;           // 有前驱失败或被取消
+    int startDelayMs = 0;             // 依赖满足后再延迟多久执行
+
+    // === 协程 (CoTask.h) ===
+    void* coFrame = nullptr;              // 协程帧 (coroutine_handle::address)，普通任务为空
+    void (*coDestroy)(void*) = nullptr;   // 销毁协程帧 (节点回收时调用)
+    CoPark park = CoPark::None;
+    int parkDelayMs = 0;
+    TaskId parkTask = 0;
+    CoEventState* parkEvent = nullptr;
+    bool resumeOk = true;                 // co_await 等待的任务是否成功结束
 
-    // ȼȽϣʱԽȼԽ (С)
-    bool operator>(const ScheduledTask& other) const {
-        return runTime > other.runTime;
+    void Execute() {
+        if (task) task->Execute();
+        else fn();
     }
 };
 
-//  (Singleton + Producer-Consumer Pattern)
+// 批量提交的一项 (AddTasks 使用)
+struct TaskSubmission {
+    std::shared_ptr<ITask> task;
+    int delayMs = 0;      // 延迟多少毫秒执行 (0表示立即)
+    int intervalMs = 0;   // 周期执行间隔 (0表示一次性)
+    TaskOptions options;  // 优先级与截止时间
+};
+
+class TaskScheduler;
+class CoTask;
+class AsyncEvent;
+struct CoDelayAwaiter;
+struct CoTaskAwaiter;
+
+// 任务句柄：AddTask 的返回值，只保存调度器指针与任务编号 (可随意拷贝)
+// 任务结束后句柄自动失效，所有操作返回 false
+class TaskHandle {
+public:
+    TaskHandle() = default;
+    TaskHandle(TaskScheduler* scheduler, TaskId id) : m_scheduler(scheduler), m_id(id) {}
+
+    TaskId GetId() const { return m_id; }
+    bool IsValid() const { return m_scheduler != nullptr && m_id != 0; }
+
+    // 取消任务：等待中的任务立即移除；运行中的任务执行完本次后不再重挂
+    bool Cancel();
+    // 重新设定下一次执行时间 (从现在起 delayMs 毫秒后)
+    bool Reschedule(int delayMs);
+    // 修改周期 (<= 0 表示改为一次性)，从下一次重挂开始生效
+    bool ChangeInterval(int intervalMs);
+    // 任务是否仍由调度器持有 (等待、就绪、运行中或等待前驱)
+    bool IsPending() const;
+    // 添加后继：本任务最终结束 (周期任务为不再重挂) 且成功后运行 next
+    // 本任务已经结束时 next 立即可运行；句柄无效时返回无效句柄
+    TaskHandle Then(TaskBody next, int delayMs = 0) const;
+
+private:
+    TaskScheduler* m_scheduler = nullptr;
+    TaskId m_id = 0;
+};
+
+// 任务调度器 (Singleton + Producer-Consumer Pattern)
+// 线程模型:
+// - 定时线程 (Timer Thread): 独占分层时间轮，按到期顺序把到期任务分发给工作线程
+// - 工作线程池 (Worker Pool): 每个线程一个本地队列，空闲时从其他线程窃取 (Work-Stealing)
 class TaskScheduler {
 public:
     static TaskScheduler& Instance() {
@@ -35,123 +186,2018 @@ public:
         return instance;
     }
 
-    // 
-    void Start() {
+    // 启动调度器
+    // workerCount: 工作线程数量 (0 表示使用 CPU 核心数)
+    void Start(unsigned workerCount = 0) {
         if (m_running) return;
+
+        if (workerCount == 0) workerCount = std::thread::hardware_concurrency();
+        if (workerCount == 0) workerCount = 1;
+
+        m_queues.clear();
+        for (unsigned i = 0; i < workerCount; ++i) {
+            m_queues.push_back(std::make_unique<WorkStealingQueue<ScheduledTask>>());
+            m_queues.back()->SetAgingStep(m_priorityOptions.agingStep);
+        }
+        BuildPlacement(workerCount);
+        m_readyCount = 0;
+        m_blockingEnabled = (m_blockingOptions.maxThreads > 0);
+        if (m_blockingEnabled) {
+            m_blockingPool.SetAgingStep(m_priorityOptions.agingStep);
+            m_blockingPool.Start(m_blockingOptions, [this](ScheduledTask* sTask) {
+                TraceRecorder::SetThreadLabel("Blocking");
+                if (ClaimTask(sTask, false)) RunTask(sTask);
+            });
+        }
         m_running = true;
-        // ߳
-        m_workerThread = std::thread(&TaskScheduler::WorkerLoop, this);
-        LogWriter::Instance().Write("Scheduler Started.");
+
+        // 启动定时线程与工作线程
+        m_timerThread = std::thread(&TaskScheduler::TimerLoop, this);
+        for (unsigned i = 0; i < workerCount; ++i) {
+            m_workers.emplace_back(&TaskScheduler::WorkerLoop, this, i);
+        }
+        m_events.Start();
+        LogWriter::Instance().Write("Scheduler Started. Workers: " + std::to_string(workerCount));
     }
 
-    // ֹͣ
+    // 停止调度器
     void Stop() {
-        m_running = false;
-        m_cv.notify_all(); // ߳Ա˳
-        if (m_workerThread.joinable()) {
-            m_workerThread.join();
+        {
+            // 持锁修改标志，避免与等待中的线程错过唤醒
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::lock_guard<std::mutex> idleLock(m_idleMutex);
+            if (!m_running) return;
+            m_running = false;
+        }
+        m_cv.notify_all(); // 唤醒定时线程以便退出
+        m_workCv.notify_all(); // 唤醒所有空闲工作线程
+        m_admitCv.notify_all(); // 等待空位的提交线程改为拒绝
+
+        if (m_timerThread.joinable()) {
+            m_timerThread.join();
+        }
+        for (auto& worker : m_workers) {
+            if (worker.joinable()) worker.join();
+        }
+        m_workers.clear();
+        m_blockingPool.Stop(); // 等待正在执行的阻塞任务结束
+
+        const TraceOptions trace = m_trace.GetOptions();
+        if (trace.enabled && !trace.dumpOnStopPath.empty()) m_trace.DumpToFile(trace.dumpOnStopPath);
+
+        // 丢弃尚未执行的就绪任务 (时间轮上的任务保留，再次 Start 后继续)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ScheduledTask* pending = nullptr;
+            std::vector<ScheduledTask*> discardedReady; // 失败传递不会放行后继，始终为空
+            std::vector<ScheduledTask*> discarded;      // 被级联取消的后继
+            auto discard = [&](ScheduledTask* sTask) {
+                TaskState state = sTask->state.load();
+                if (state == TaskState::Rearm) {
+                    ArmLocked(sTask); // 已改期的任务属于等待中的任务，同样保留
+                    return;
+                }
+                if (state != TaskState::Cancelled) {
+                    UnregisterLocked(sTask);
+                    ResolveSuccessorsLocked(sTask, false, discardedReady, discarded);
+                }
+                ReleaseNode(sTask);
+            };
+            for (auto& queue : m_queues) {
+                while (queue->TryPop(pending)) discard(pending);
+            }
+            for (auto& slot : m_workerSlots) {
+                while (slot->pinned.TryPop(pending)) discard(pending);
+                slot->pinnedCount = 0;
+            }
+            for (auto& node : m_nodeSlots) {
+                while (node->queue.TryPop(pending)) discard(pending);
+                node->count = 0;
+            }
+            while (m_blockingPool.TryPop(pending)) discard(pending);
+            for (ScheduledTask* sTask : discarded) ReleaseNode(sTask);
         }
+        m_events.Stop(); // 把剩余事件发给订阅者后退出
+        if (m_journal) m_journal->Flush();
         LogWriter::Instance().Write("Scheduler Stopped.");
     }
 
-    //  UI ֪ͨص
+    // 设置 UI 通知回调 (逐条文本，合并过的事件带 " xN" 后缀)
     void SetUICallback(UINotifyCallback cb) {
-        m_uiCallback = cb;
+        if (m_uiSubscriber) m_events.Unsubscribe(m_uiSubscriber);
+        m_uiSubscriber.reset();
+        if (!cb) return;
+        m_uiSubscriber = std::make_shared<CallbackEventSubscriber>(
+            [cb](const SchedulerEvent* events, size_t count) {
+                for (size_t i = 0; i < count; ++i) cb(events[i].ToString());
+            });
+        m_events.Subscribe(m_uiSubscriber);
+    }
+
+    // 订阅批量事件 (无界面订阅者同样适用)
+    void SubscribeEvents(std::shared_ptr<IEventSubscriber> subscriber) {
+        m_events.Subscribe(std::move(subscriber));
+    }
+
+    void UnsubscribeEvents(const std::shared_ptr<IEventSubscriber>& subscriber) {
+        m_events.Unsubscribe(subscriber);
+    }
+
+    // 分发频率、批量大小、是否合并，需在 Start 与提交任务之前设置
+    void SetEventOptions(const EventChannelOptions& options) {
+        m_events.SetOptions(options);
+    }
+
+    // 设置时间轮刻度 (默认 1ms)，只能在没有挂起的定时任务时修改
+    bool SetTimerTick(std::chrono::microseconds tick) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_timerWheel.SetTick(tick);
+    }
+
+    // 预热任务对象池：之后同时存在的任务不超过 count 个时，提交不再分配节点内存
+    void ReserveTasks(size_t count) {
+        m_pool.Reserve(count);
+    }
+
+    // 设置优先级策略 (老化步长、无截止时间任务的隐含期限)
+    void SetPriorityOptions(const PriorityOptions& options) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_priorityOptions = options;
+        for (auto& queue : m_queues) queue->SetAgingStep(options.agingStep);
+        for (auto& slot : m_workerSlots) slot->pinned.SetAgingStep(options.agingStep);
+        for (auto& node : m_nodeSlots) node->queue.SetAgingStep(options.agingStep);
+        m_blockingPool.SetAgingStep(options.agingStep);
+    }
+
+    // 某个优先级的执行与截止时间统计
+    PriorityClassStats GetPriorityStats(TaskPriority priority) const {
+        const PriorityCounters& c = m_priorityStats[static_cast<size_t>(priority)];
+        PriorityClassStats stats;
+        stats.executed = c.executed.load();
+        stats.withDeadline = c.withDeadline.load();
+        stats.deadlineMisses = c.deadlineMisses.load();
+        stats.agedPromotions = c.agedPromotions.load();
+        stats.maxLatenessUs = c.maxLatenessUs.load();
+        return stats;
+    }
+
+    void ResetPriorityStats() {
+        for (auto& c : m_priorityStats) {
+            c.executed = 0;
+            c.withDeadline = 0;
+            c.deadlineMisses = 0;
+            c.agedPromotions = 0;
+            c.maxLatenessUs = 0;
+        }
+    }
+
+    // 设置阻塞任务弹性线程池的参数，在 Start 之前调用生效
+    // maxThreads 为 0 时关闭弹性池，阻塞任务和普通任务一样在 CPU 工作线程上执行 (旧行为)
+    void SetBlockingPoolOptions(const ElasticPoolOptions& options) {
+        m_blockingOptions = options;
+    }
+
+    // 设置工作线程与定时线程的绑核方式 (CpuTopology.h)，在 Start 之前调用生效
+    // 默认不绑核；绑核后窃取先在同一 NUMA 节点内进行，NodeLocal 任务只在父任务的节点上执行
+    void SetAffinityOptions(const AffinityOptions& options) {
+        m_affinity = options;
+    }
+
+    // 各工作线程分配到的逻辑 CPU 与节点 (Start 之后有效)
+    std::vector<CpuInfo> GetWorkerPlacement() const {
+        std::vector<CpuInfo> placement;
+        for (const auto& slot : m_workerSlots) {
+            CpuInfo info;
+            info.cpu = slot->cpu;
+            info.node = slot->node;
+            placement.push_back(info);
+        }
+        return placement;
+    }
+
+    // 排队等待统计：用于对比阻塞任务是否拖慢了 CPU 任务
+    ExecutorStats GetExecutorStats() {
+        ExecutorStats stats;
+        stats.cpuTasks = m_cpuWait.tasks.load();
+        stats.cpuWaitTotalUs = m_cpuWait.totalUs.load();
+        stats.cpuWaitMaxUs = m_cpuWait.maxUs.load();
+        stats.blockingTasks = m_blockingWait.tasks.load();
+        stats.blockingWaitTotalUs = m_blockingWait.totalUs.load();
+        stats.blockingWaitMaxUs = m_blockingWait.maxUs.load();
+        stats.blockingOnWorkers = m_blockingOnWorkers.load();
+        stats.elasticThreads = m_blockingPool.ThreadCount();
+        stats.elasticPeak = m_blockingPool.PeakThreads();
+        return stats;
+    }
+
+    void ResetExecutorStats() {
+        for (WaitCounters* c : { &m_cpuWait, &m_blockingWait }) {
+            c->tasks = 0;
+            c->totalUs = 0;
+            c->maxUs = 0;
+        }
+        m_blockingOnWorkers = 0;
+    }
+
+    // === 准入控制 ===
+
+    // 设置容量上限与满载策略，可随时调用 (调小容量不会取消已接纳的任务)
+    void SetAdmissionOptions(const AdmissionOptions& options) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_admission = options;
+        }
+        m_admitCv.notify_all(); // 容量可能变大
+    }
+
+    AdmissionOptions GetAdmissionOptions() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_admission;
+    }
+
+    AdmissionStats GetAdmissionStats() {
+        AdmissionStats stats;
+        long ready = m_readyCount.load();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            stats = m_admissionStats;
+            stats.capacity = m_admission.capacity;
+            for (const auto& slot : m_workerSlots) ready += slot->pinnedCount.load();
+            for (const auto& node : m_nodeSlots) ready += node->count.load();
+        }
+        stats.readyDepth = static_cast<size_t>((std::max)(ready, 0L));
+        return stats;
+    }
+
+    // 清零累计计数 (当前持有数保留，峰值从当前值重新开始)
+    void ResetAdmissionStats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const size_t held = m_admissionStats.held;
+        m_admissionStats = AdmissionStats();
+        m_admissionStats.held = held;
+        m_admissionStats.peakHeld = held;
+    }
+
+    // === 限流 (RateLimiter.h) ===
+
+    // 设置某个限流键的并发上限与令牌桶速率，可在运行中修改；键默认是任务名 (也可用 TaskOptions::limitKey 指定标签)
+    // 被限流的任务不占用线程：等待并发空位的任务挂起，空位释放时放行；等待令牌的任务推迟到时间轮上
+    void SetRateLimit(const std::string& key, const RateLimit& limit) {
+        std::vector<ScheduledTask*> ready;
+        bool earlier = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            RateLimiter::State* state = m_limiter.SetLocked(key, limit, std::chrono::steady_clock::now());
+            earlier = WakeLimitWaitersLocked(*state, ready); // 上限调大或取消时放行等待者
+        }
+        if (earlier) m_cv.notify_one();
+        DispatchBulk(ready);
+    }
+
+    // 取消某个键的限制 (等待中的任务全部放行)
+    void RemoveRateLimit(const std::string& key) {
+        SetRateLimit(key, RateLimit());
+    }
+
+    RateLimitStats GetRateLimitStats(const std::string& key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_limiter.StatsLocked(key, std::chrono::steady_clock::now());
+    }
+
+    // === 合并键 (TaskOptions::coalesceKey) ===
+
+    CoalesceStats GetCoalesceStats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        CoalesceStats stats = m_coalesceStats;
+        stats.keys = m_coalesceIndex.size();
+        stats.internedKeys = m_keys.Size();
+        return stats;
+    }
+
+    void ResetCoalesceStats() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_coalesceStats = CoalesceStats();
+    }
+
+    // === 运行统计 (SchedulerMetrics.h) ===
+
+    // 开启 / 关闭按任务名的排队等待、执行耗时、周期迟到与异常统计 (默认关闭，可随时切换)
+    // 关闭时每次执行只多一次原子读；开启时每次执行多两次读时钟，写本线程的分片，不获取调度锁
+    void EnableMetrics(bool enable) {
+        m_metrics.SetEnabled(enable);
+    }
+
+    bool IsMetricsEnabled() const {
+        return m_metrics.IsEnabled();
+    }
+
+    // 合并各线程分片得到的快照 (snapshot.ToText() 输出文本格式)
+    MetricsSnapshot GetMetricsSnapshot() const {
+        return m_metrics.Snapshot();
+    }
+
+    void ResetMetrics() {
+        m_metrics.Reset();
+    }
+
+    // === 时间线追踪 (TraceRecorder.h) ===
+
+    // 开启 / 关闭提交、就绪、出队、开始、结束事件的记录 (默认关闭，可随时切换)
+    // 关闭时每个事件点只多一次原子读；开启时写本线程的事件块，不获取调度锁
+    // 取样 (sampleEvery) 与缓冲上限 (bufferEvents) 决定长期开启的开销与内存
+    void SetTraceOptions(const TraceOptions& options) {
+        m_trace.SetOptions(options);
+    }
+
+    TraceOptions GetTraceOptions() const {
+        return m_trace.GetOptions();
+    }
+
+    // Chrome trace-event JSON (chrome://tracing、ui.perfetto.dev 可直接打开)
+    std::string GetTraceJson() const {
+        return m_trace.ToJson();
+    }
+
+    bool DumpTrace(const std::string& path) const {
+        return m_trace.DumpToFile(path);
+    }
+
+    void ClearTrace() {
+        m_trace.Clear();
+    }
+
+    // 工作线程数量 (未启动时为 0)
+    size_t GetWorkerCount() const {
+        return m_workers.size();
+    }
+
+    // 添加任务
+    // delayMs: 延迟多少毫秒执行 (0表示立即)
+    // intervalMs: 周期执行间隔 (0表示一次性)
+    // options: 优先级与截止时间 (默认 Normal、无截止时间)
+    // 返回值: 任务句柄，可用于取消 / 改期 / 修改周期
+    TaskHandle AddTask(std::shared_ptr<ITask> task, int delayMs = 0, int intervalMs = 0,
+        const TaskOptions& options = TaskOptions()) {
+        const char* name = task->InternedName();
+        ScheduledTask* sTask = m_pool.Acquire();
+        sTask->task = std::move(task);
+        return SubmitNode(sTask, name, delayMs, intervalMs, options);
+    }
+
+    // 添加可调用对象任务 (lambda / 函数对象)
+    // 捕获不超过 SmallFunction::kInlineSize 字节时，对象池预热后整个提交-执行过程没有堆分配
+    // name: 任务名，用于 UI 事件与日志 (内部驻留，相同名字只保存一份)
+    template <typename F,
+        typename = typename std::enable_if<std::is_invocable<typename std::decay<F>::type&>::value>::type>
+    TaskHandle AddTask(const char* name, F&& fn, int delayMs = 0, int intervalMs = 0,
+        const TaskOptions& options = TaskOptions()) {
+        SmallFunction callable(std::forward<F>(fn));
+        const char* interned = NameInterner::Instance().Intern(name);
+        ScheduledTask* sTask = m_pool.Acquire();
+        sTask->fn = std::move(callable);
+        return SubmitNode(sTask, interned, delayMs, intervalMs, options);
+    }
+
+    // 批量添加任务：整批只加一次调度锁，立即任务按队列分块入队，
+    // 按任务数唤醒对应数量的空闲工作线程，只发一条汇总 UI 事件
+    // 返回值: 与输入顺序一一对应的任务句柄
+    std::vector<TaskHandle> AddTasks(const TaskSubmission* submissions, size_t count) {
+        return SubmitBatch(submissions, count, nullptr);
+    }
+
+    std::vector<TaskHandle> AddTasks(const std::vector<TaskSubmission>& submissions) {
+        return AddTasks(submissions.data(), submissions.size());
+    }
+
+    // === 持久化 (TaskJournal.h) ===
+
+    // 开启持久模式并恢复上次退出时仍登记中的持久任务 (快照 + 日志尾部)
+    // registry: 任务类型名 -> 由 payload 重建任务对象的工厂；日志中类型未登记的任务被丢弃
+    // 错过的周期按 options.missedRuns 处理；恢复出的任务整批提交 (一次加锁)
+    // 应在 Start 之前调用且只能调用一次；目录不可用或快照损坏时返回 false
+    bool EnableDurability(const JournalOptions& options, DurableTaskRegistry registry) {
+        if (m_journal) return false;
+        auto journal = std::make_unique<TaskJournal>();
+        std::vector<DurableTaskRecord> records;
+        if (!journal->Open(options, records)) return false;
+        m_durableTypes = std::move(registry);
+        m_journal = std::move(journal);
+
+        const int64_t nowMs = WallMs(std::chrono::steady_clock::now());
+        std::vector<TaskSubmission> submissions;
+        std::vector<uint64_t> keys;
+        std::vector<std::pair<size_t, TaskGraph>> catchUps; // 补跑链与对应的 submissions 下标
+        submissions.reserve(records.size());
+        keys.reserve(records.size());
+        size_t dropped = 0;
+        for (const DurableTaskRecord& rec : records) {
+            TaskSubmission sub;
+            sub.task = m_durableTypes.Create(rec.type, rec.payload);
+            if (!sub.task) {
+                m_journal->LogRemove(rec.key);
+                ++dropped;
+                continue;
+            }
+            sub.intervalMs = rec.intervalMs;
+            sub.options.priority = static_cast<TaskPriority>((std::min)(rec.priority, uint8_t(kTaskPriorityCount - 1)));
+            sub.options.deadlineMs = rec.deadlineMs;
+            sub.options.blocking = rec.blocking;
+            const int64_t lateMs = nowMs - rec.nextRunMs;
+            sub.delayMs = (lateMs < 0) ? static_cast<int>((std::min)(-lateMs, int64_t(INT_MAX))) : 0;
+            if (lateMs > 0 && rec.intervalMs > 0 && options.missedRuns != MissedRunPolicy::RunOnce) {
+                // 两种策略的周期任务都按原相位 (日志中的下次执行时刻) 等下一个周期
+                // CatchUp 另外把错过的次数依次补跑 (不写日志)
+                if (options.missedRuns == MissedRunPolicy::CatchUp) {
+                    const int64_t missed = (std::min)(lateMs / rec.intervalMs + 1,
+                        static_cast<int64_t>((std::max)(options.maxCatchUpRuns, uint32_t(1))));
+                    TaskGraph chain;
+                    TaskGraph::NodeId prev = 0;
+                    for (int64_t i = 0; i < missed; ++i) {
+                        TaskBody body(sub.task);
+                        body.options = sub.options;
+                        prev = (i == 0) ? chain.Add(std::move(body)) : chain.Then(prev, std::move(body));
+                    }
+                    catchUps.emplace_back(submissions.size(), std::move(chain));
+                }
+                sub.delayMs = static_cast<int>(rec.intervalMs - lateMs % rec.intervalMs);
+                m_journal->LogRearm(rec.key, nowMs + sub.delayMs);
+            }
+            if (!rec.coalesceKey.empty()) {
+                // 补跑的链不带合并键；日志不记录合并策略，同键的多个任务只保留先登记的一个
+                sub.options.coalesceKey = rec.coalesceKey.c_str();
+                sub.options.coalesce = CoalescePolicy::KeepEarliest;
+            }
+            submissions.push_back(std::move(sub));
+            keys.push_back(rec.key);
+        }
+        std::vector<TaskHandle> handles = SubmitBatch(submissions.data(), submissions.size(), keys.data());
+        for (auto& item : catchUps) {
+            if (handles[item.first].IsValid()) Submit(std::move(item.second)); // 被合并掉的任务不补跑
+        }
+
+        const JournalStats stats = m_journal->GetStats();
+        LogWriter::Instance().Write("Journal recovered " + std::to_string(submissions.size()) + " tasks in "
+            + std::to_string(stats.recoverSeconds * 1000.0) + " ms (dropped " + std::to_string(dropped)
+            + ", truncated " + std::to_string(stats.truncatedBytes) + " bytes)");
+        return true;
+    }
+
+    bool IsDurabilityEnabled() const {
+        return m_journal != nullptr;
+    }
+
+    // 添加持久任务：由注册表按 type + payload 创建任务对象，登记写入日志后提交
+    // 结束 (一次性任务执行完、周期任务失败)、取消、改期、修改周期都会写日志；Stop 时仍未执行的持久任务在下次启动时恢复
+    // 没有开启持久模式或类型未登记时返回无效句柄
+    TaskHandle AddDurableTask(const std::string& type, const std::string& payload, int delayMs = 0,
+        int intervalMs = 0, const TaskOptions& options = TaskOptions()) {
+        if (!m_journal) return TaskHandle();
+        std::shared_ptr<ITask> task = m_durableTypes.Create(type, payload);
+        if (!task) return TaskHandle();
+
+        DurableTaskRecord rec;
+        rec.key = m_journal->NextKey();
+        rec.type = type;
+        rec.payload = payload;
+        rec.nextRunMs = WallMs(std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs));
+        rec.intervalMs = (std::max)(intervalMs, 0);
+        rec.deadlineMs = (std::max)(options.deadlineMs, 0);
+        rec.priority = static_cast<uint8_t>(options.priority);
+        rec.blocking = options.blocking;
+        if (options.coalesceKey) rec.coalesceKey = options.coalesceKey;
+        m_journal->LogAdd(rec); // 先于任何结束记录写入
+
+        const char* name = task->InternedName();
+        ScheduledTask* sTask = m_pool.Acquire();
+        sTask->task = std::move(task);
+        return SubmitNode(sTask, name, delayMs, intervalMs, options, rec.key);
+    }
+
+    // 等待此前的日志记录全部落盘
+    void FlushJournal() {
+        if (m_journal) m_journal->Flush();
+    }
+
+    // 立即把登记中的持久任务压缩为快照
+    void CompactJournal() {
+        if (m_journal) m_journal->Compact();
+    }
+
+    JournalStats GetJournalStats() const {
+        return m_journal ? m_journal->GetStats() : JournalStats();
+    }
+
+    // === 依赖与后继 ===
+    // 后继与依赖图节点的 TaskOptions::coalesceKey 被忽略 (不参与合并)
+
+    // 所有前驱都成功结束后运行 body (已经结束的前驱视为已满足)
+    TaskHandle WhenAll(const std::vector<TaskHandle>& preds, TaskBody body, int delayMs = 0) {
+        return AddContinuation(preds.data(), preds.size(), false, std::move(body), delayMs);
+    }
+
+    // 任一前驱成功结束后运行 body (只运行一次)
+    TaskHandle WhenAny(const std::vector<TaskHandle>& preds, TaskBody body, int delayMs = 0) {
+        return AddContinuation(preds.data(), preds.size(), true, std::move(body), delayMs);
     }
 
-    // 
-    // delayMs: ӳٶٺִ (0ʾ)
-    // intervalMs: ִм (0ʾһ)
-    void AddTask(std::shared_ptr<ITask> task, int delayMs = 0, int intervalMs = 0) {
-        ScheduledTask sTask;
-        sTask.task = task;
-        sTask.runTime = std::chrono::system_clock::now() + std::chrono::milliseconds(delayMs);
-        sTask.isPeriodic = (intervalMs > 0);
-        sTask.intervalMs = intervalMs;
+    // 提交整张依赖图：一次加锁登记所有节点，入度为 0 的节点立即可运行
+    // 返回值: 与 TaskGraph 节点编号一一对应的句柄；图中有环时不提交并返回空
+    std::vector<TaskHandle> Submit(TaskGraph graph) {
+        std::vector<TaskHandle> handles;
+        auto& nodes = graph.m_nodes;
+        if (nodes.empty() || !graph.IsAcyclic()) return handles;
+        handles.reserve(nodes.size());
+
+        // 1. 锁外取节点并初始化
+        std::vector<ScheduledTask*> tasks(nodes.size());
+        const auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            ScheduledTask* sTask = AcquireNode(nodes[i].body);
+            PrepareNode(sTask, sTask->name, 0, 0, nodes[i].body.options, now);
+            sTask->startDelayMs = (std::max)(nodes[i].delayMs, 0);
+            sTask->joinAny = nodes[i].joinAny;
+            sTask->pendingDeps = nodes[i].inDegree;
+            if (nodes[i].inDegree > 0) sTask->homeWorker = -1;
+            tasks[i] = sTask;
+            handles.emplace_back(this, sTask->id);
+            LogEvent(sTask, LogEventType::TaskSubmitted);
+            TraceTask(TraceEventType::Submit, sTask, sTask->startDelayMs);
+        }
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            for (TaskGraph::NodeId next : nodes[i].successors) tasks[i]->successors.push_back(tasks[next]->id);
+        }
+        const TaskId firstId = tasks[0]->id;
+        const char* firstName = tasks[0]->name;
 
+        // 2. 一次加锁完成登记；根节点直接放行
+        std::vector<ScheduledTask*> ready;
+        bool earlier = false;
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            m_taskQueue.push(sTask);
+            for (ScheduledTask* sTask : tasks) {
+                sTask->registered = true;
+                if (sTask->pendingDeps.load() == 0) earlier |= ReleaseBlockedLocked(sTask, ready);
+                else sTask->state = TaskState::Blocked;
+            }
         }
-        m_cv.notify_one(); // ѹ̣߳»ˣ
+        if (earlier) m_cv.notify_one();
 
-        // ֪ͨUI
-        std::stringstream ss;
-        ss << "Scheduled: " << task->GetName() << " (Delay: " << delayMs << "ms)";
-        if (m_uiCallback) m_uiCallback(ss.str());
+        PublishEvent(SchedulerEventType::BatchScheduled, firstId, firstName, 0, tasks.size());
+        DispatchBulk(ready);
+        return handles;
+    }
+
+    // 把 count 个互不相关的子任务分给工作线程并等待全部完成，调用线程也参与执行
+    // 子任务编号由所有参与者原子领取：在工作线程内调用时，调用方会自己做完还没人领取的部分，
+    // 不会因为等待排在自己队列里的帮手任务而死锁
+    // 第一个抛出的异常在全部完成后重新抛给调用方
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body,
+        const TaskOptions& options = TaskOptions()) {
+        if (count == 0) return;
+        if (count == 1 || !m_running) {
+            for (size_t i = 0; i < count; ++i) body(i);
+            return;
+        }
+
+        struct Shared {
+            const std::function<void(size_t)>* body;
+            size_t count;
+            std::atomic<size_t> next{ 0 };
+            std::atomic<size_t> done{ 0 };
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::exception_ptr error;
+        };
+        auto shared = std::make_shared<Shared>();
+        shared->body = &body;
+        shared->count = count;
+        auto work = [shared]() {
+            for (size_t i; (i = shared->next.fetch_add(1)) < shared->count;) {
+                try {
+                    (*shared->body)(i);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(shared->mutex);
+                    if (!shared->error) shared->error = std::current_exception();
+                }
+                if (shared->done.fetch_add(1) + 1 == shared->count) {
+                    std::lock_guard<std::mutex> lock(shared->mutex);
+                    shared->cv.notify_all();
+                }
+            }
+        };
+
+        // 帮手任务领不到编号就直接结束 (只访问共享状态，不再访问 body)
+        const size_t helpers = (std::min)(count - 1, m_workers.size());
+        const char* name = NameInterner::Instance().Intern("Parallel For");
+        for (size_t i = 0; i < helpers; ++i) {
+            ScheduledTask* sTask = m_pool.Acquire();
+            sTask->fn = SmallFunction(work);
+            SubmitNode(sTask, name, 0, 0, options, 0, false); // 帮手任务不占容量
+        }
+        work();
+
+        std::unique_lock<std::mutex> lock(shared->mutex);
+        shared->cv.wait(lock, [&] { return shared->done.load() == count; });
+        if (shared->error) std::rethrow_exception(shared->error);
+    }
+
+    // === 协程任务 (定义见 CoTask.h，需要 C++20) ===
+
+    // 启动一个协程任务：在任意工作线程上运行，co_await 挂起期间不占用任何线程
+    // 返回的句柄与普通任务相同，可以取消、Then，也可以被其他协程 co_await
+    TaskHandle Spawn(const char* name, CoTask task, const TaskOptions& options = TaskOptions());
+
+    // co_await scheduler.Delay(ms)：协程挂到时间轮上，到期后在任意工作线程恢复 (0 表示让出一次)
+    CoDelayAwaiter Delay(int delayMs);
+
+    // co_await scheduler.WaitFor(handle)：等待另一个任务最终结束，结果为是否成功
+    CoTaskAwaiter WaitFor(const TaskHandle& handle);
+
+    // === 异步任务 (等待外部完成通知，等待期间不占用任何线程) ===
+
+    // 完成通知：可以在任意线程上调用，只有第一次调用有效
+    using AsyncDone = std::function<void()>;
+
+    // 提交一个先等待外部操作的任务：登记后立即调用 start(done) 发起操作 (在调用线程上)，
+    // 操作完成时调用 done()，body 随后在工作线程上执行 (延迟、优先级、限流等选项照常生效)
+    // 等待期间任务处于阻塞状态，可以取消；取消后的 done() 被忽略。被准入拒绝时不调用 start，返回无效句柄
+    // 合并键与普通任务相同：被合并掉的提交不调用 start，返回保留下来的同键任务的句柄；
+    // Replace 取消还在等待的旧任务 (它的 done() 被忽略)，Merge 对等待中的任务相当于 KeepEarliest
+    TaskHandle AddAsyncTask(TaskBody body, std::function<void(AsyncDone done)> start) {
+        ScheduledTask* sTask = AcquireNode(body);
+        PrepareNode(sTask, sTask->name, 0, 0, body.options, std::chrono::steady_clock::now());
+        if (body.options.coalesceKey) sTask->coalesceKey = m_keys.Acquire(body.options.coalesceKey);
+        sTask->homeWorker = -1; // 由调用 done 的线程放行，分发时再确定
+        const TaskId id = sTask->id;
+        const char* name = sTask->name;
+        LogEvent(sTask, LogEventType::TaskSubmitted);
+        TraceTask(TraceEventType::Submit, sTask, 0);
+
+        std::vector<ScheduledTask*> evicted;
+        bool earlier = false;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            const TaskId keptId = sTask->coalesceKey ? CoalesceLocked(sTask, body.options.coalesce, evicted, earlier) : 0;
+            if (keptId || !AdmitLocked(lock, sTask, evicted)) {
+                lock.unlock();
+                ReleaseNode(sTask);
+                for (ScheduledTask* victim : evicted) ReleaseNode(victim);
+                if (earlier) m_cv.notify_one();
+                return keptId ? TaskHandle(this, keptId) : TaskHandle();
+            }
+            sTask->registered = true;
+            if (sTask->coalesceKey) m_coalesceIndex[sTask->coalesceKey] = id;
+            sTask->pendingDeps = 1;
+            sTask->state = TaskState::Blocked;
+        }
+        for (ScheduledTask* victim : evicted) ReleaseNode(victim);
+        if (earlier) m_cv.notify_one();
+        PublishEvent(SchedulerEventType::Scheduled, id, name);
+
+        auto fired = std::make_shared<std::atomic<bool>>(false);
+        try {
+            start([this, id, fired] {
+                if (!fired->exchange(true)) ReleaseAsync(id);
+            });
+        }
+        catch (...) {
+            CancelTask(id);
+            throw;
+        }
+        return TaskHandle(this, id);
+    }
+
+    // 异步 HTTP 获取任务：请求交给 HttpEngine (IO 线程上的事件循环)，等待网络期间不占用工作线程，
+    // 响应到达后 onResponse 在工作线程上执行。网络错误与超时时 response.status 为 0
+    TaskHandle AddFetchTask(const char* name, HttpRequest request, std::function<void(HttpResponse&)> onResponse,
+        const TaskOptions& options = TaskOptions()) {
+        auto slot = std::make_shared<HttpResponse>();
+        TaskBody body(name, [slot, onResponse = std::move(onResponse)] { onResponse(*slot); });
+        body.options = options;
+        return AddAsyncTask(std::move(body), [slot, request = std::move(request)](AsyncDone done) mutable {
+            HttpEngine::Instance().Fetch(std::move(request), [slot, done = std::move(done)](HttpResponse&& response) {
+                *slot = std::move(response); // done 放行时加锁，工作线程读取 slot 之前一定能看到这次写入
+                done();
+            });
+        });
+    }
+
+    // === 句柄操作 (编号直接定位对象池槽位，O(1)，不扫描队列) ===
+
+    bool CancelTask(TaskId id) {
+        std::vector<ScheduledTask*> released;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ScheduledTask* sTask = FindLocked(id);
+            if (!sTask) return false;
+            CancelLocked(sTask, released);
+        }
+        for (ScheduledTask* sTask : released) ReleaseNode(sTask);
+        return true;
+    }
+
+    bool RescheduleTask(TaskId id, int delayMs) {
+        bool earlier = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ScheduledTask* sTask = FindLocked(id);
+            if (!sTask) return false;
+            if (sTask->cancelRequested) return false;
+            auto runTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+            if (sTask->durableKey) m_journal->LogRearm(sTask->durableKey, WallMs(runTime));
+
+            TaskState state = sTask->state.load();
+            switch (state) {
+            case TaskState::Waiting:
+                m_timerWheel.Remove(sTask);
+                sTask->runTime = runTime;
+                earlier = ArmLocked(sTask);
+                break;
+            case TaskState::Rearm:
+                sTask->runTime = runTime;
+                break;
+            case TaskState::Blocked:
+                // 还在等待前驱：改为依赖满足后延迟 delayMs 执行
+                sTask->startDelayMs = (std::max)(delayMs, 0);
+                break;
+            case TaskState::LimitWait:
+                // 等待并发名额：改为按新时间挂轮，到期后重新申请 (等待者列表中的旧编号放行时跳过)
+                sTask->runTime = runTime;
+                earlier = ArmLocked(sTask);
+                break;
+            case TaskState::Ready:
+                // 节点留在就绪队列中，取到它的工作线程按新的 runTime 重新挂轮
+                if (sTask->state.compare_exchange_strong(state, TaskState::Rearm)) {
+                    sTask->runTime = runTime;
+                    break;
+                }
+                sTask->rearmDelayMs = (std::max)(delayMs, 0);
+                break;
+            default:
+                sTask->rearmDelayMs = (std::max)(delayMs, 0);
+                break;
+            }
+        }
+        if (earlier) m_cv.notify_one();
+        return true;
+    }
+
+    bool ChangeTaskInterval(TaskId id, int intervalMs) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ScheduledTask* sTask = FindLocked(id);
+        if (!sTask) return false;
+        sTask->isPeriodic = (intervalMs > 0);
+        sTask->intervalMs = (std::max)(intervalMs, 0);
+        if (sTask->durableKey) m_journal->LogInterval(sTask->durableKey, sTask->intervalMs);
+        return true;
+    }
+
+    bool IsTaskPending(TaskId id) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return FindLocked(id) != nullptr;
     }
 
 private:
+    friend class AsyncEvent;
+
     TaskScheduler() : m_running(false) {}
-    ~TaskScheduler() { Stop(); }
+    ~TaskScheduler() {
+        Stop();
+        m_timerWheel.Clear([this](TimerNode* node) { ReleaseNode(static_cast<ScheduledTask*>(node)); });
+    }
 
-    // ߳ѭ
-    void WorkerLoop() {
-        while (m_running) {
-            ScheduledTask currentTask;
-            bool haveTask = false;
+    // 当前线程所属的工作线程编号 (非工作线程为 -1)
+    static int& CurrentWorkerIndex() {
+        thread_local int index = -1;
+        return index;
+    }
+
+    // 结构化事件写入二进制日志 (未开启时只有一次原子读)
+    static void LogEvent(const ScheduledTask* sTask, LogEventType type) {
+        LogWriter& log = LogWriter::Instance();
+        if (log.IsBinaryEnabled()) log.WriteEvent(sTask->id, type, sTask->name, std::strlen(sTask->name));
+    }
+
+    // 发布 UI 事件 (没有订阅者时只有一次原子读)
+    void PublishEvent(SchedulerEventType type, TaskId id, const char* name, int delayMs = 0, size_t count = 1) {
+        if (!m_events.HasSubscribers()) return;
+        m_events.Publish([&](SchedulerEvent& ev) {
+            ev.type = type;
+            ev.taskId = id;
+            ev.delayMs = delayMs;
+            ev.count = static_cast<uint32_t>(count);
+            ev.SetName(name, std::strlen(name));
+        });
+    }
+
+    // 单调时钟时刻 -> 墙上时间 (毫秒)，用于持久化 (单调时钟跨重启没有意义)
+    static int64_t WallMs(std::chrono::steady_clock::time_point t) {
+        const auto wall = std::chrono::system_clock::now() + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            t - std::chrono::steady_clock::now());
+        return std::chrono::duration_cast<std::chrono::milliseconds>(wall.time_since_epoch()).count();
+    }
+
+    // 记录时间线事件 (未开启时只有一次原子读)
+    void TraceTask(TraceEventType type, const ScheduledTask* sTask, int32_t arg = 0, uint8_t flags = 0) {
+        if (m_trace.IsEnabled() && m_trace.Sampled(sTask->id)) m_trace.Record(type, sTask->id, sTask->name, arg, flags);
+    }
+
+    // 初始化刚从池中取出的节点并分配新编号 (不需要持有 m_mutex：
+    // 按编号查找时先检查 registered，而 registered 只在持锁时置位)
+    // 指定了 limitKey 时为节点取得一个键引用，由 ReleaseNode 归还
+    void PrepareNode(ScheduledTask* sTask, const char* name, int delayMs, int intervalMs,
+        const TaskOptions& options, std::chrono::steady_clock::time_point now) {
+        if (++sTask->generation == 0) sTask->generation = 1;
+        sTask->id = (static_cast<TaskId>(sTask->generation) << 32) | sTask->poolSlot;
+        sTask->name = name;
+        sTask->runTime = now + std::chrono::milliseconds(delayMs);
+        sTask->isPeriodic = (intervalMs > 0);
+        sTask->intervalMs = intervalMs;
+        sTask->cancelRequested = false;
+        sTask->rearmDelayMs = -1;
+        sTask->state = TaskState::Waiting;
+        sTask->priority = options.priority;
+        sTask->deadlineMs = (std::max)(options.deadlineMs, 0);
+        sTask->blocking = options.blocking || (sTask->task && sTask->task->IsBlocking());
+        sTask->placement = options.placement;
+        sTask->homeWorker = CurrentWorkerIndex(); // SameCore / NodeLocal 的 "父任务" 是提交它的工作线程
+        sTask->successors.clear(); // 保留容量，复用时不再分配
+        sTask->pendingDeps = 0;
+        sTask->joinAny = false;
+        sTask->depFailed = false;
+        sTask->startDelayMs = 0;
+        sTask->park = CoPark::None;
+        sTask->resumeOk = true;
+        sTask->durableKey = 0;
+        sTask->admitted = false;
+        sTask->limitKey = options.limitKey ? m_keys.Acquire(options.limitKey) : name;
+        sTask->limitState = nullptr;
+        sTask->limitVersion = 0;
+        sTask->holdsLimit = false;
+        sTask->coalesceKey = nullptr;
+    }
+
+    // 从池中取节点并装入任务体，节点的 name 为驻留后的名字
+    ScheduledTask* AcquireNode(TaskBody& body) {
+        const char* name = body.InternName();
+        ScheduledTask* sTask = m_pool.Acquire();
+        sTask->task = std::move(body.task);
+        sTask->fn = std::move(body.fn);
+        sTask->name = name;
+        return sTask;
+    }
+
+    // 提交一个依赖若干已有任务的后继
+    TaskHandle AddContinuation(const TaskHandle* preds, size_t count, bool joinAny, TaskBody body, int delayMs) {
+        ScheduledTask* sTask = AcquireNode(body);
+        PrepareNode(sTask, sTask->name, 0, 0, body.options, std::chrono::steady_clock::now());
+        sTask->startDelayMs = (std::max)(delayMs, 0);
+        sTask->joinAny = joinAny;
+        sTask->homeWorker = -1; // 后继的父任务是放行它的前驱，分发时再确定
+        const TaskId id = sTask->id;
+        const char* name = sTask->name;
+        LogEvent(sTask, LogEventType::TaskSubmitted);
+        TraceTask(TraceEventType::Submit, sTask, sTask->startDelayMs);
+
+        std::vector<ScheduledTask*> ready;
+        bool earlier = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            sTask->registered = true;
+            int pending = 0;
+            bool finishedPred = false;
+            for (size_t i = 0; i < count; ++i) {
+                ScheduledTask* pred = FindLocked(preds[i].GetId());
+                if (pred) {
+                    pred->successors.push_back(id);
+                    ++pending;
+                }
+                else {
+                    finishedPred = true; // 已经结束 (无法区分成功与否，视为已满足)
+                }
+            }
+            sTask->pendingDeps = pending;
+            if (pending == 0 || (joinAny && finishedPred)) {
+                earlier = ReleaseBlockedLocked(sTask, ready);
+            }
+            else {
+                sTask->state = TaskState::Blocked;
+            }
+        }
+        if (earlier) m_cv.notify_one();
+        PublishEvent(SchedulerEventType::Scheduled, id, name, delayMs);
+        DispatchBulk(ready);
+        return TaskHandle(this, id);
+    }
+
+    // 依赖已满足：按 startDelayMs 挂轮，或放入 ready 由调用方在锁外分发，调用方持有 m_mutex
+    // 返回 true 表示需要唤醒定时线程
+    bool ReleaseBlockedLocked(ScheduledTask* sTask, std::vector<ScheduledTask*>& ready) {
+        if (sTask->startDelayMs > 0 || !m_running) {
+            sTask->runTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(sTask->startDelayMs);
+            return ArmLocked(sTask);
+        }
+        MarkReadyLocked(sTask, std::chrono::steady_clock::now());
+        ready.push_back(sTask);
+        return false;
+    }
+
+    // 到期 -> 就绪：记录就绪时刻并计算本次运行的截止时刻，调用方持有 m_mutex
+    // 没有截止时间的任务使用所在优先级的隐含期限，使同级任务统一按 EDF 排序
+    void MarkReadyLocked(ScheduledTask* sTask, std::chrono::steady_clock::time_point now) {
+        sTask->state = TaskState::Ready;
+        sTask->readyTime = now;
+        sTask->periodicRun = sTask->isPeriodic;
+        sTask->deadlineAt = sTask->runTime + ((sTask->deadlineMs > 0)
+            ? std::chrono::milliseconds(sTask->deadlineMs)
+            : m_priorityOptions.implicitDeadline[static_cast<size_t>(sTask->priority)]);
+    }
+
+    // 一次执行结束：按优先级累计执行次数与截止时间命中情况
+    void RecordExecution(const ScheduledTask* sTask) {
+        PriorityCounters& c = m_priorityStats[static_cast<size_t>(sTask->priority)];
+        c.executed.fetch_add(1, std::memory_order_relaxed);
+        if (sTask->deadlineMs <= 0) return;
+
+        c.withDeadline.fetch_add(1, std::memory_order_relaxed);
+        long long latenessUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - sTask->deadlineAt).count();
+        if (latenessUs <= 0) return;
+
+        c.deadlineMisses.fetch_add(1, std::memory_order_relaxed);
+        long long prev = c.maxLatenessUs.load(std::memory_order_relaxed);
+        while (prev < latenessUs && !c.maxLatenessUs.compare_exchange_weak(prev, latenessUs)) {}
+        LogEvent(sTask, LogEventType::TaskDeadlineMissed);
+    }
+
+    // 任务最终结束 (不再重挂)：按结果推进后继的依赖计数，调用方持有 m_mutex
+    // succeeded: 本次执行成功；失败或取消时后继被级联取消
+    // ready: 依赖已满足、需要在锁外分发的后继；released: 被级联取消、需要在锁外回收的后继
+    // 返回 true 表示需要唤醒定时线程
+    bool ResolveSuccessorsLocked(ScheduledTask* finished, bool succeeded,
+        std::vector<ScheduledTask*>& ready, std::vector<ScheduledTask*>& released) {
+        if (finished->successors.empty()) return false; // 普通任务只有这一次判断
+        bool earlier = false;
+        std::vector<std::pair<ScheduledTask*, bool>> work{ { finished, succeeded } };
+        while (!work.empty()) {
+            ScheduledTask* node = work.back().first;
+            bool ok = work.back().second;
+            work.pop_back();
+            for (TaskId nextId : node->successors) {
+                ScheduledTask* next = FindLocked(nextId);
+                if (!next || next->state.load() != TaskState::Blocked) continue; // 已取消或 WhenAny 已放行
+
+                int remaining = next->pendingDeps.fetch_sub(1) - 1;
+                if (!ok) next->depFailed = true;
+                if (next->coFrame) {
+                    // 挂起等待的协程：不论成败都恢复，结果由 co_await 返回
+                    next->resumeOk = ok;
+                    earlier |= ReleaseBlockedLocked(next, ready);
+                    continue;
+                }
+                bool run = next->joinAny ? ok : (remaining == 0 && !next->depFailed);
+                bool cancel = !run && remaining == 0;
+                if (run) {
+                    earlier |= ReleaseBlockedLocked(next, ready);
+                }
+                else if (cancel) {
+                    LogEvent(next, LogEventType::TaskCancelled);
+                    PublishEvent(SchedulerEventType::Cancelled, next->id, next->name);
+                    UnregisterLocked(next);
+                    released.push_back(next);
+                    work.emplace_back(next, false);
+                }
+            }
+            node->successors.clear();
+        }
+        return earlier;
+    }
+
+    // 批量提交的公共路径；durableKeys 非空时与 submissions 一一对应 (0 表示不持久)
+    // 恢复的持久任务被合并时从日志中删除并返回无效句柄 (调用方据此不再补跑)
+    std::vector<TaskHandle> SubmitBatch(const TaskSubmission* submissions, size_t count, const uint64_t* durableKeys) {
+        std::vector<TaskHandle> handles;
+        if (count == 0) return handles;
+        handles.reserve(count);
+
+        // 1. 锁外取节点并初始化
+        std::vector<ScheduledTask*> nodes(count);
+        std::vector<ScheduledTask*> immediate;
+        const auto now = std::chrono::steady_clock::now();
+        const bool running = m_running;
+        for (size_t i = 0; i < count; ++i) {
+            const TaskSubmission& sub = submissions[i];
+            const char* name = sub.task->InternedName();
+            ScheduledTask* sTask = m_pool.Acquire();
+            sTask->task = sub.task;
+            PrepareNode(sTask, name, sub.delayMs, sub.intervalMs, sub.options, now);
+            if (sub.options.coalesceKey) sTask->coalesceKey = m_keys.Acquire(sub.options.coalesceKey);
+            if (durableKeys) sTask->durableKey = durableKeys[i];
+            nodes[i] = sTask;
+            handles.emplace_back(this, sTask->id);
+            LogEvent(sTask, LogEventType::TaskSubmitted);
+            TraceTask(TraceEventType::Submit, sTask, sub.delayMs);
+        }
+        const TaskId firstId = nodes[0]->id;
+        const char* firstName = nodes[0]->name;
+
+        // 2. 一次加锁完成合并、准入、登记与挂轮
+        //    恢复的持久任务同样按合并键去重 (重启后同一个键不会出现重复的周期任务)；它们此前已被接纳，不再做准入检查
+        bool earlier = false;
+        std::vector<ScheduledTask*> rejected;
+        std::vector<ScheduledTask*> evicted;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            for (size_t i = 0; i < count; ++i) {
+                ScheduledTask* sTask = nodes[i];
+                if (sTask->coalesceKey) {
+                    const TaskId keptId = CoalesceLocked(sTask, submissions[i].options.coalesce, evicted, earlier);
+                    if (keptId) {
+                        rejected.push_back(sTask);
+                        if (sTask->durableKey) m_journal->LogRemove(sTask->durableKey);
+                        handles[i] = sTask->durableKey ? TaskHandle() : TaskHandle(this, keptId);
+                        continue;
+                    }
+                }
+                if (!durableKeys && !AdmitLocked(lock, sTask, evicted, &immediate)) {
+                    rejected.push_back(sTask);
+                    handles[i] = TaskHandle();
+                    continue;
+                }
+                sTask->registered = true;
+                if (sTask->coalesceKey) m_coalesceIndex[sTask->coalesceKey] = sTask->id;
+                if (submissions[i].delayMs <= 0 && running) {
+                    MarkReadyLocked(sTask, now);
+                    immediate.push_back(sTask);
+                }
+                else if (ArmLocked(sTask)) {
+                    earlier = true;
+                }
+            }
+        }
+        if (earlier) m_cv.notify_one();
+        for (ScheduledTask* sTask : evicted) ReleaseNode(sTask);
+        for (ScheduledTask* sTask : rejected) ReleaseNode(sTask); // 被拒绝或被合并掉的提交
+
+        // 3. 汇总事件在分发前发布 (分发后节点可能已被执行并回收)，再批量分发
+        if (rejected.size() < count) {
+            PublishEvent(SchedulerEventType::BatchScheduled, firstId, firstName, 0, count - rejected.size());
+        }
+        DispatchBulk(immediate);
+        return handles;
+    }
+
+    // 单个任务提交的公共路径
+    // admit: 是否做准入检查 (调度器内部派生的任务不占容量)；被拒绝时回收节点并返回无效句柄
+    TaskHandle SubmitNode(ScheduledTask* sTask, const char* name, int delayMs, int intervalMs,
+        const TaskOptions& options, uint64_t durableKey = 0, bool admit = true) {
+        const auto now = std::chrono::steady_clock::now();
+        PrepareNode(sTask, name, delayMs, intervalMs, options, now);
+        sTask->durableKey = durableKey;
+        if (options.coalesceKey) sTask->coalesceKey = m_keys.Acquire(options.coalesceKey);
+        const TaskId id = sTask->id; // Dispatch 之后节点可能已被执行并回收
+        LogEvent(sTask, LogEventType::TaskSubmitted);
+        TraceTask(TraceEventType::Submit, sTask, delayMs);
+
+        // 立即任务绕过定时线程，直接进入工作线程队列
+        bool immediate = false;
+        bool earlier = false;
+        std::vector<ScheduledTask*> evicted;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            // 先合并再准入：被合并掉的重复提交不占容量，也不会挤掉其他任务
+            const TaskId keptId = sTask->coalesceKey ? CoalesceLocked(sTask, options.coalesce, evicted, earlier) : 0;
+            if (keptId || (admit && !AdmitLocked(lock, sTask, evicted))) {
+                lock.unlock();
+                if (durableKey) m_journal->LogRemove(durableKey);
+                ReleaseNode(sTask);
+                for (ScheduledTask* victim : evicted) ReleaseNode(victim);
+                if (earlier) m_cv.notify_one();
+                return keptId ? TaskHandle(this, keptId) : TaskHandle();
+            }
+            sTask->registered = true;
+            if (sTask->coalesceKey) m_coalesceIndex[sTask->coalesceKey] = id;
+            immediate = (delayMs <= 0 && m_running);
+            if (immediate) {
+                MarkReadyLocked(sTask, now);
+            }
+            else {
+                earlier |= ArmLocked(sTask);
+            }
+        }
+        for (ScheduledTask* victim : evicted) ReleaseNode(victim);
+        if (immediate) Dispatch(sTask);
+        else if (earlier) m_cv.notify_one();
+
+        // 通知UI (进入事件通道，由分发线程批量推送)
+        PublishEvent(SchedulerEventType::Scheduled, id, name, delayMs);
+        return TaskHandle(this, id);
+    }
+
+    // 取消登记中的任务，调用方持有 m_mutex；需要在锁外回收的节点放入 released
+    void CancelLocked(ScheduledTask* sTask, std::vector<ScheduledTask*>& released) {
+        LogEvent(sTask, LogEventType::TaskCancelled);
+        if (sTask->durableKey) m_journal->LogRemove(sTask->durableKey);
+        PublishEvent(SchedulerEventType::Cancelled, sTask->id, sTask->name);
+
+        TaskState state = sTask->state.load();
+        if (state == TaskState::Waiting || state == TaskState::Blocked || state == TaskState::LimitWait) {
+            // LimitWait 的编号留在限流等待者中，放行时按编号找不到而跳过
+            if (state == TaskState::Waiting) m_timerWheel.Remove(sTask);
+            UnregisterLocked(sTask);
+            released.push_back(sTask);
+        }
+        else if ((state == TaskState::Ready || state == TaskState::Rearm)
+            && sTask->state.compare_exchange_strong(state, TaskState::Cancelled)) {
+            // 就绪队列中的节点无法 O(1) 摘除：标记为墓碑，由取到它的工作线程回收
+            UnregisterLocked(sTask);
+        }
+        else {
+            // 运行中 (或刚被工作线程抢先取走)：执行完本次后再按结果通知后继
+            sTask->cancelRequested = true;
+            return;
+        }
+        // 被取消的任务不会再运行，依赖它的后继随之取消
+        std::vector<ScheduledTask*> ready;
+        ResolveSuccessorsLocked(sTask, false, ready, released);
+    }
+
+    // 注销节点 (之后不能再按编号找到)，已接纳的任务归还容量，调用方持有 m_mutex
+    void UnregisterLocked(ScheduledTask* sTask) {
+        sTask->registered = false;
+        if (sTask->coalesceKey) {
+            // 索引可能已指向接替它的新任务 (Replace，或执行中时又提交了一个)
+            auto it = m_coalesceIndex.find(sTask->coalesceKey);
+            if (it != m_coalesceIndex.end() && it->second == sTask->id) m_coalesceIndex.erase(it);
+        }
+        if (!sTask->admitted) return;
+        sTask->admitted = false;
+        ScheduledTask*& head = m_admitHead[static_cast<size_t>(sTask->priority)];
+        ScheduledTask*& tail = m_admitTail[static_cast<size_t>(sTask->priority)];
+        if (sTask->admitPrev) sTask->admitPrev->admitNext = sTask->admitNext;
+        else head = sTask->admitNext;
+        if (sTask->admitNext) sTask->admitNext->admitPrev = sTask->admitPrev;
+        else tail = sTask->admitPrev;
+        sTask->admitPrev = sTask->admitNext = nullptr;
+        --m_admissionStats.held;
+        if (m_admitWaiters > 0) m_admitCv.notify_one();
+    }
+
+    // 准入检查：有空位 (或按策略腾出空位) 时占用容量并返回 true，调用方持有 lock
+    // Block 策略会在 lock 上等待；等待前先把 dispatchFirst 中已登记的立即任务分发出去，
+    // 否则它们占着容量却没有线程执行。被挤掉的任务放入 released，由调用方在锁外回收
+    bool AdmitLocked(std::unique_lock<std::mutex>& lock, ScheduledTask* sTask,
+        std::vector<ScheduledTask*>& released, std::vector<ScheduledTask*>* dispatchFirst = nullptr) {
+        auto full = [this] { return m_admission.capacity > 0 && m_admissionStats.held >= m_admission.capacity; };
+        if (full()) {
+            switch (m_admission.policy) {
+            case OverloadPolicy::Block: {
+                if (CurrentWorkerIndex() >= 0) return RejectLocked(sTask); // 工作线程等待会死锁
+                const auto deadline = std::chrono::steady_clock::now() + m_admission.blockTimeout;
+                const bool forever = (m_admission.blockTimeout.count() <= 0);
+                ++m_admissionStats.blockedWaits;
+                while (full() && m_running) {
+                    if (dispatchFirst && !dispatchFirst->empty()) {
+                        std::vector<ScheduledTask*> ready;
+                        ready.swap(*dispatchFirst);
+                        lock.unlock();
+                        DispatchBulk(ready);
+                        lock.lock();
+                        continue;
+                    }
+                    m_cv.notify_one(); // 本批挂轮的任务可能早于定时线程的唤醒时刻
+                    ++m_admitWaiters;
+                    bool timedOut = false;
+                    if (forever) m_admitCv.wait(lock);
+                    else timedOut = (m_admitCv.wait_until(lock, deadline) == std::cv_status::timeout);
+                    --m_admitWaiters;
+                    if (timedOut && full()) break;
+                }
+                if (full() || !m_running) return RejectLocked(sTask);
+                break;
+            }
+            case OverloadPolicy::DropOldest:
+            case OverloadPolicy::ShedByPriority: {
+                ScheduledTask* victim = (m_admission.policy == OverloadPolicy::DropOldest)
+                    ? OldestVictimLocked() : ShedVictimLocked(sTask->priority);
+                if (!victim) return RejectLocked(sTask);
+                CancelLocked(victim, released);
+                ++m_admissionStats.dropped;
+                break;
+            }
+            default:
+                return RejectLocked(sTask);
+            }
+        }
+        const size_t level = static_cast<size_t>(sTask->priority);
+        sTask->admitted = true;
+        sTask->admitSeq = ++m_admitSeq;
+        sTask->admitPrev = m_admitTail[level];
+        sTask->admitNext = nullptr;
+        if (m_admitTail[level]) m_admitTail[level]->admitNext = sTask;
+        else m_admitHead[level] = sTask;
+        m_admitTail[level] = sTask;
+        ++m_admissionStats.admitted;
+        m_admissionStats.peakHeld = (std::max)(m_admissionStats.peakHeld, ++m_admissionStats.held);
+        return true;
+    }
+
+    // 按合并键去重，调用方持有 m_mutex，在准入检查之前调用
+    // 返回 0 表示新任务照常登记 (由调用方在登记后写入索引)；否则返回保留下来的同键任务编号，新任务由调用方回收
+    // 被 Replace 取消的旧任务放入 released；Merge 提前了时间轮上的任务时 earlier 置为 true
+    TaskId CoalesceLocked(ScheduledTask* sTask, CoalescePolicy policy,
+        std::vector<ScheduledTask*>& released, bool& earlier) {
+        ++m_coalesceStats.submitted;
+        auto it = m_coalesceIndex.find(sTask->coalesceKey);
+        ScheduledTask* existing = (it != m_coalesceIndex.end()) ? FindLocked(it->second) : nullptr;
+        if (!existing || existing->cancelRequested) return 0; // 已取消的任务不会再执行
+
+        // 执行中：已经开始、之后不会再执行的一次性任务 (它可能读不到新提交对应的状态)
+        const bool running = existing->state.load() == TaskState::Running
+            && !existing->isPeriodic && existing->rearmDelayMs < 0;
+        switch (policy) {
+        case CoalescePolicy::Replace:
+            if (running) return 0;
+            CancelLocked(existing, released);
+            ++m_coalesceStats.replaced;
+            return 0;
+        case CoalescePolicy::KeepEarliest:
+        case CoalescePolicy::IgnoreWhileRunning:
+            if (running && policy == CoalescePolicy::KeepEarliest) return 0;
+            ++m_coalesceStats.kept;
+            break;
+        case CoalescePolicy::Merge:
+            if (running) return 0;
+            earlier |= MergeLocked(existing, sTask->runTime);
+            ++m_coalesceStats.merged;
+            break;
+        }
+        LogEvent(sTask, LogEventType::TaskCoalesced);
+        PublishEvent(SchedulerEventType::Coalesced, existing->id, sTask->name);
+        return existing->id;
+    }
+
+    // Merge：已有任务的下一次执行提前到 runTime (不晚于原时间时不变)，调用方持有 m_mutex
+    // 就绪或等待前驱 / 并发名额的任务很快就会执行，不需要调整；返回 true 表示需要唤醒定时线程
+    bool MergeLocked(ScheduledTask* existing, std::chrono::steady_clock::time_point runTime) {
+        if (runTime >= existing->runTime || existing->coFrame) return false; // 不缩短协程的 co_await Delay
+        const TaskState state = existing->state.load();
+        if (state != TaskState::Waiting && state != TaskState::Rearm) return false;
+        if (existing->durableKey) m_journal->LogRearm(existing->durableKey, WallMs(runTime));
+        existing->runTime = runTime;
+        if (state == TaskState::Rearm) return false; // 取到它的工作线程按新的 runTime 挂轮
+        m_timerWheel.Remove(existing);
+        return ArmLocked(existing);
+    }
+
+    bool RejectLocked(const ScheduledTask* sTask) {
+        ++m_admissionStats.rejected;
+        LogEvent(sTask, LogEventType::TaskRejected);
+        PublishEvent(SchedulerEventType::Rejected, sTask->id, sTask->name);
+        return false;
+    }
+
+    // 可以被挤掉的任务：尚未开始执行的一次性任务
+    // 周期任务是常驻登记而不是积压；协程可能已经执行过一部分，挂起时也不能丢弃
+    static bool EvictableLocked(const ScheduledTask* sTask) {
+        if (sTask->isPeriodic || sTask->cancelRequested || sTask->coFrame) return false;
+        const TaskState state = sTask->state.load();
+        return state == TaskState::Waiting || state == TaskState::Ready
+            || state == TaskState::Rearm || state == TaskState::Blocked || state == TaskState::LimitWait;
+    }
+
+    // 最早接纳的可挤掉任务 (各优先级链表从头找，跳过运行中与周期任务)
+    ScheduledTask* OldestVictimLocked() const {
+        ScheduledTask* victim = nullptr;
+        for (ScheduledTask* head : m_admitHead) {
+            for (ScheduledTask* node = head; node; node = node->admitNext) {
+                if (!EvictableLocked(node)) continue;
+                if (!victim || node->admitSeq < victim->admitSeq) victim = node;
+                break;
+            }
+        }
+        return victim;
+    }
+
+    // 优先级低于 incoming 的任务中，从最低一级开始找最早接纳的可挤掉任务
+    // 不挤掉最近接纳的：高优先级任务占满处理能力时，留下的最早的低优先级任务只能等老化把它提升到
+    // 高优先级之上 (每级一个 agingStep) 才执行，被接纳任务的排队时延会被拉长到数百毫秒
+    ScheduledTask* ShedVictimLocked(TaskPriority incoming) const {
+        for (size_t level = kTaskPriorityCount; level-- > static_cast<size_t>(incoming) + 1;) {
+            for (ScheduledTask* node = m_admitHead[level]; node; node = node->admitNext) {
+                if (EvictableLocked(node)) return node;
+            }
+        }
+        return nullptr;
+    }
+
+    // 按编号找到仍登记中的节点，调用方持有 m_mutex
+    ScheduledTask* FindLocked(TaskId id) const {
+        if (id == 0) return nullptr;
+        ScheduledTask* sTask = m_pool.At(static_cast<uint32_t>(id));
+        return (sTask && sTask->registered && sTask->id == id) ? sTask : nullptr;
+    }
+
+    // 释放捕获的资源与键引用，并把节点还给对象池 (节点必须已注销，且不在时间轮或队列中)
+    // 合并索引只指向登记中的节点，注销时已移除，所以这里归还合并键不会留下悬空的索引
+    void ReleaseNode(ScheduledTask* sTask) {
+        sTask->task.reset();
+        sTask->fn.Reset();
+        if (sTask->coalesceKey) m_keys.Release(sTask->coalesceKey);
+        if (sTask->limitKey && sTask->limitKey != sTask->name) m_keys.Release(sTask->limitKey);
+        sTask->coalesceKey = nullptr;
+        sTask->limitKey = nullptr;
+        if (sTask->coFrame) {
+            sTask->coDestroy(sTask->coFrame);
+            sTask->coFrame = nullptr;
+            sTask->coDestroy = nullptr;
+        }
+        m_pool.Release(sTask);
+    }
+
+    // 把任务挂上时间轮 (O(1))，调用方持有 m_mutex
+    // 返回 true 表示早于定时线程当前的唤醒时刻，需要唤醒它重新计算
+    bool ArmLocked(ScheduledTask* sTask) {
+        sTask->state = TaskState::Waiting;
+        m_timerWheel.Add(sTask, sTask->runTime);
+        return sTask->expireTick < m_nextWakeTick;
+    }
+
+    // 一次执行结束后：重挂周期任务，或者注销并回收节点
+    // failed: 执行抛出异常 (与旧行为一致，抛异常的周期任务不再重挂)
+    void CompleteTask(ScheduledTask* sTask, bool failed) {
+        bool earlier = false;
+        bool release = false;
+        std::vector<ScheduledTask*> ready;     // 依赖已满足的后继
+        std::vector<ScheduledTask*> cancelled; // 因本任务失败被级联取消的后继
+        const uint64_t durableKey = sTask->durableKey;
+        int64_t durableNextMs = -1;            // 持久任务的下一次执行时间 (-1 表示从日志中移除)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            bool again = (sTask->isPeriodic || sTask->rearmDelayMs >= 0) && !sTask->cancelRequested && !failed;
+            bool rearm = again && m_running;
+            if (again) {
+                int delayMs = (sTask->rearmDelayMs >= 0) ? sTask->rearmDelayMs : sTask->intervalMs;
+                sTask->rearmDelayMs = -1;
+                sTask->runTime = std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+                // 停止过程中结束的持久周期任务不重挂，但保留在日志中，下次启动时恢复
+                if (durableKey) durableNextMs = WallMs(sTask->runTime);
+            }
+            if (rearm) {
+                earlier = ArmLocked(sTask); // 节点复用，不重新分配
+            }
+            else {
+                UnregisterLocked(sTask);
+                release = true;
+                earlier |= ResolveSuccessorsLocked(sTask, !failed, ready, cancelled);
+            }
+        }
+        if (durableKey) {
+            if (durableNextMs >= 0) m_journal->LogRearm(durableKey, durableNextMs);
+            else m_journal->LogRemove(durableKey);
+        }
+        if (release) ReleaseNode(sTask); // 任务对象的析构放在锁外
+        for (ScheduledTask* next : cancelled) ReleaseNode(next);
+        if (earlier) m_cv.notify_one();
+        DispatchBulk(ready); // 工作线程内放行的后继进入本线程队列，其余空闲线程会来窃取
+    }
+
+    // 就绪队列中被改期的节点：按新的 runTime 挂回时间轮
+    void RearmDeferred(ScheduledTask* sTask) {
+        bool earlier = false;
+        bool release = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (sTask->state.load() == TaskState::Rearm) earlier = ArmLocked(sTask);
+            else release = true; // 取出前又被取消
+        }
+        if (release) ReleaseNode(sTask);
+        if (earlier) m_cv.notify_one();
+    }
+
+    // 把到期任务交给工作线程 (阻塞任务交给弹性线程池)
+    // 工作线程内部提交的任务进入本线程队列 (缓存局部性)，外部提交则轮询分配
+    void Dispatch(ScheduledTask* sTask) {
+        TraceTask(TraceEventType::Ready, sTask); // 入队之后节点可能已被执行并回收
+        if (sTask->blocking && m_blockingEnabled) {
+            m_blockingPool.Submit(sTask);
+            return;
+        }
+        if (sTask->placement == TaskPlacement::SameCore || sTask->placement == TaskPlacement::NodeLocal) {
+            DispatchPlaced(sTask);
+            return;
+        }
+        int self = CurrentWorkerIndex();
+        size_t target = (self >= 0 && sTask->placement != TaskPlacement::Any)
+            ? static_cast<size_t>(self)
+            : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+        m_queues[target]->Push(sTask);
+        m_readyCount.fetch_add(1);
+
+        // 只有存在休眠线程时才需要加锁唤醒
+        if (m_sleepingWorkers.load() > 0) {
+            { std::lock_guard<std::mutex> lock(m_idleMutex); }
+            m_workCv.notify_one();
+        }
+    }
+
+    // SameCore 进入归属线程的专属队列，NodeLocal 进入归属线程所在节点的共享队列
+    // 外部线程提交、尚无归属的任务轮询选定归属线程 (周期任务之后一直沿用)
+    void DispatchPlaced(ScheduledTask* sTask) {
+        const size_t workers = m_workerSlots.size();
+        if (sTask->homeWorker < 0 || static_cast<size_t>(sTask->homeWorker) >= workers) {
+            int self = CurrentWorkerIndex();
+            sTask->homeWorker = (self >= 0)
+                ? self
+                : static_cast<int>(m_nextQueue.fetch_add(1, std::memory_order_relaxed) % workers);
+        }
+        WorkerSlot& home = *m_workerSlots[static_cast<size_t>(sTask->homeWorker)];
+        if (sTask->placement == TaskPlacement::SameCore) {
+            home.pinned.Push(sTask);
+            home.pinnedCount.fetch_add(1);
+            // 只有归属线程能执行：它在休眠时才需要唤醒 (共用条件变量，只能全部唤醒)
+            if (home.sleeping.load()) {
+                { std::lock_guard<std::mutex> lock(m_idleMutex); }
+                m_workCv.notify_all();
+            }
+        }
+        else {
+            NodeSlot& node = *m_nodeSlots[static_cast<size_t>(home.node)];
+            node.queue.Push(sTask);
+            node.count.fetch_add(1);
+            if (m_sleepingWorkers.load() > 0) {
+                { std::lock_guard<std::mutex> lock(m_idleMutex); }
+                m_workCv.notify_all();
+            }
+        }
+    }
+
+    // 批量分发：切成连续的块，每个队列只加一次锁；按任务数唤醒休眠线程
+    void DispatchBulk(const std::vector<ScheduledTask*>& tasks) {
+        if (tasks.empty()) return;
+        if (std::any_of(tasks.begin(), tasks.end(), [this](const ScheduledTask* sTask) {
+            return (sTask->blocking && m_blockingEnabled) || sTask->placement != TaskPlacement::Default; })) {
+            // 混有阻塞任务或指定了运行位置的任务时先把它们逐个分出去 (少见路径，允许分配)
+            std::vector<ScheduledTask*> cpuTasks;
+            cpuTasks.reserve(tasks.size());
+            for (ScheduledTask* sTask : tasks) {
+                if ((sTask->blocking && m_blockingEnabled) || sTask->placement != TaskPlacement::Default) {
+                    Dispatch(sTask);
+                }
+                else {
+                    cpuTasks.push_back(sTask);
+                }
+            }
+            DispatchBulk(cpuTasks);
+            return;
+        }
+        if (m_trace.IsEnabled()) {
+            for (ScheduledTask* sTask : tasks) TraceTask(TraceEventType::Ready, sTask);
+        }
+        int self = CurrentWorkerIndex();
+        if (self >= 0) {
+            // 工作线程内部提交：全部放入本线程队列，空闲线程会来窃取
+            m_queues[self]->PushBulk(tasks.begin(), tasks.end());
+        }
+        else {
+            const size_t queues = m_queues.size();
+            const size_t chunk = (tasks.size() + queues - 1) / queues;
+            size_t target = m_nextQueue.fetch_add(1, std::memory_order_relaxed);
+            for (size_t begin = 0; begin < tasks.size(); begin += chunk, ++target) {
+                size_t end = (std::min)(begin + chunk, tasks.size());
+                m_queues[target % queues]->PushBulk(tasks.begin() + begin, tasks.begin() + end);
+            }
+        }
+        m_readyCount.fetch_add(static_cast<long>(tasks.size()));
 
+        int sleeping = m_sleepingWorkers.load();
+        if (sleeping > 0) {
+            { std::lock_guard<std::mutex> lock(m_idleMutex); }
+            if (tasks.size() >= static_cast<size_t>(sleeping)) {
+                m_workCv.notify_all();
+            }
+            else {
+                for (size_t i = 0; i < tasks.size(); ++i) m_workCv.notify_one();
+            }
+        }
+    }
+
+    // 定时线程主循环：只负责“到期 -> 就绪”的搬运，不执行任何任务
+    void TimerLoop() {
+        TraceRecorder::SetThreadLabel("Timer");
+        if (m_affinity.timerCpu >= 0) PinCurrentThread({ m_affinity.timerCpu });
+        std::vector<ScheduledTask*> dueTasks;
+        while (m_running) {
             {
                 std::unique_lock<std::mutex> lock(m_mutex);
 
-                // Ϊգȴֱֹͣ
-                if (m_taskQueue.empty()) {
-                    m_cv.wait(lock, [this] { return !m_taskQueue.empty() || !m_running; });
+                // 如果时间轮为空，等待直到有新任务或停止
+                m_nextWakeTick = TimingWheel::kNoTick;
+                m_cv.wait(lock, [this] { return !m_timerWheel.Empty() || !m_running; });
+                if (!m_running) break;
+
+                // 推进时间轮，一次性取出所有到期任务 (按到期刻度顺序)
+                const auto now = std::chrono::steady_clock::now();
+                uint64_t nowTick = m_timerWheel.TickOf(now);
+                m_timerWheel.Advance(nowTick, [&](TimerNode* node) {
+                    auto* sTask = static_cast<ScheduledTask*>(node);
+                    MarkReadyLocked(sTask, now);
+                    dueTasks.push_back(sTask);
+                });
+
+                if (dueTasks.empty()) {
+                    // 时间还没到，等待直到下一个刻度到达或有更早的任务插入
+                    m_nextWakeTick = m_timerWheel.NextWakeTick();
+                    if (m_nextWakeTick != TimingWheel::kNoTick) {
+                        m_cv.wait_until(lock, m_timerWheel.TimeOfTick(m_nextWakeTick));
+                    }
+                    continue;
                 }
+            } // 锁在这里释放，分发时不持有时间轮锁
 
-                if (!m_running) break;
+            for (ScheduledTask* sTask : dueTasks) {
+                Dispatch(sTask);
+            }
+            dueTasks.clear();
+        }
+    }
+
+    // 取一个就绪任务：专属队列、本节点队列或其他队列有更高优先级的任务时先取它，否则先取本地队列，
+    // 再按拓扑顺序 (同节点优先) 依次窃取其他队列，都没有则休眠
+    // 取到的墓碑节点直接回收，改期节点重新挂轮，都不计为任务
+    bool AcquireTask(size_t index, ScheduledTask*& out) {
+        WorkerSlot& self = *m_workerSlots[index];
+        NodeSlot& node = *m_nodeSlots[static_cast<size_t>(self.node)];
+        while (m_running) {
+            const auto now = std::chrono::steady_clock::now();
+            bool aged = false;
+            bool found = false;
+            std::atomic<long>* counter = &m_readyCount; // 取到的任务来自哪个计数
+
+            size_t victim = index;
+            size_t bestLevel = m_queues[index]->BestLevel();
+            for (size_t other : self.stealOrder) {
+                size_t level = m_queues[other]->BestLevel();
+                if (level < bestLevel) {
+                    bestLevel = level;
+                    victim = other;
+                }
+            }
+            // 专属与本节点任务没有空闲时计数为 0，普通任务的路径只多两次原子读
+            const bool hasPinned = self.pinnedCount.load(std::memory_order_relaxed) > 0;
+            const bool hasNode = node.count.load(std::memory_order_relaxed) > 0;
+            if (hasPinned && self.pinned.BestLevel() <= bestLevel) {
+                found = self.pinned.TryPop(out, now, aged);
+                if (found) counter = &self.pinnedCount;
+            }
+            if (!found && hasNode && node.queue.BestLevel() <= bestLevel) {
+                found = node.queue.TryPop(out, now, aged);
+                if (found) counter = &node.count;
+            }
+            if (!found && victim != index) found = m_queues[victim]->TrySteal(out, now, aged);
+            if (!found) found = m_queues[index]->TryPop(out, now, aged);
+            for (size_t i = 0; i < self.stealOrder.size() && !found; ++i) {
+                found = m_queues[self.stealOrder[i]]->TrySteal(out, now, aged);
+            }
+            if (found) {
+                counter->fetch_sub(1);
+                if (ClaimTask(out, aged)) return true;
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_idleMutex);
+            m_sleepingWorkers.fetch_add(1);
+            self.sleeping = true;
+            m_workCv.wait(lock, [&] {
+                return m_readyCount.load() > 0 || self.pinnedCount.load() > 0 || node.count.load() > 0 || !m_running;
+            });
+            self.sleeping = false;
+            m_sleepingWorkers.fetch_sub(1);
+        }
+        return false;
+    }
+
+    // 为每个工作线程分配逻辑 CPU 与节点，建立专属队列、节点队列与窃取顺序 (Start 时调用)
+    void BuildPlacement(size_t workerCount) {
+        const CpuTopology& topology = CpuTopology::System();
+        std::vector<int> cpus = m_affinity.cpus.empty() ? topology.PlacementOrder() : m_affinity.cpus;
+        if (cpus.empty()) cpus.push_back(0);
+        // 不绑核时线程会在各节点之间迁移，节点划分没有意义，全部视为节点 0
+        const bool pinned = (m_affinity.pinning != WorkerPinning::None);
+        const size_t nodeCount = pinned ? topology.NodeCount() : 1;
+
+        m_workerSlots.clear();
+        for (size_t i = 0; i < workerCount; ++i) {
+            auto slot = std::make_unique<WorkerSlot>();
+            slot->cpu = cpus[i % cpus.size()];
+            slot->node = pinned ? topology.NodeOfCpu(slot->cpu) : 0;
+            slot->pinned.SetAgingStep(m_priorityOptions.agingStep);
+            m_workerSlots.push_back(std::move(slot));
+        }
+        // 窃取顺序：同节点的线程在前 (共享 L3 与本地内存)，其余在后；各自从下一个编号开始轮转
+        for (size_t i = 0; i < workerCount; ++i) {
+            WorkerSlot& slot = *m_workerSlots[i];
+            for (int pass = 0; pass < 2; ++pass) {
+                for (size_t k = 1; k < workerCount; ++k) {
+                    const size_t other = (i + k) % workerCount;
+                    if ((m_workerSlots[other]->node == slot.node) == (pass == 0)) slot.stealOrder.push_back(other);
+                }
+            }
+        }
+        m_nodeSlots.clear();
+        for (size_t n = 0; n < nodeCount; ++n) {
+            m_nodeSlots.push_back(std::make_unique<NodeSlot>());
+            m_nodeSlots.back()->queue.SetAgingStep(m_priorityOptions.agingStep);
+        }
+    }
+
+    // 按 AffinityOptions 绑定当前工作线程
+    void PinWorker(size_t index) {
+        const WorkerSlot& slot = *m_workerSlots[index];
+        bool ok = true;
+        if (m_affinity.pinning == WorkerPinning::Core) ok = PinCurrentThread({ slot.cpu });
+        else if (m_affinity.pinning == WorkerPinning::Node) ok = PinCurrentThread(CpuTopology::System().CpusOfNode(slot.node));
+        if (!ok) {
+            LogWriter::Instance().Write("Worker " + std::to_string(index) + " cannot be pinned to CPU " + std::to_string(slot.cpu));
+        }
+    }
+
+    // 从就绪队列取出的节点：Ready -> Running 成功才执行
+    // 墓碑节点直接回收，改期节点重新挂轮，返回 false
+    bool ClaimTask(ScheduledTask* sTask, bool aged) {
+        TaskState expected = TaskState::Ready;
+        if (sTask->state.compare_exchange_strong(expected, TaskState::Running)) {
+            if (m_limiter.Active() && !AcquireLimit(sTask)) return false; // 被限流：已挂起或推迟
+            TraceTask(TraceEventType::Dequeue, sTask);
+            if (aged) {
+                m_priorityStats[static_cast<size_t>(sTask->priority)].agedPromotions.fetch_add(
+                    1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+        if (expected == TaskState::Rearm) RearmDeferred(sTask);
+        else ReleaseNode(sTask); // 已被取消 (Tombstone)
+        return false;
+    }
+
+    // 按限流键申请执行 (并发名额 + 令牌)，节点处于 Running，只有本线程访问
+    // 并发已满时挂起 (LimitWait) 并登记到等待者，空位释放时放行；没有令牌时推迟到时间轮，返回 false
+    // 不复用 Blocked：WhenAny 后继被放行后，其余前驱结束时会把 Blocked 的节点当成仍在等待依赖
+    bool AcquireLimit(ScheduledTask* sTask) {
+        const uint64_t version = m_limiter.Version();
+        if (sTask->limitVersion != version) {
+            sTask->limitState = m_limiter.Find(sTask->limitKey);
+            sTask->limitVersion = version;
+        }
+        RateLimiter::State* state = sTask->limitState;
+        if (!state || !state->limited.load(std::memory_order_relaxed)) return true;
 
-                // 
-                if (!m_taskQueue.empty()) {
-                    auto now = std::chrono::system_clock::now();
-                    auto topTask = m_taskQueue.top();
+        bool earlier = false;
+        bool cancelled = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            const auto now = std::chrono::steady_clock::now();
+            std::chrono::steady_clock::duration retryAfter{};
+            cancelled = sTask->cancelRequested;
+            if (!cancelled) {
+                switch (m_limiter.AcquireLocked(*state, now, retryAfter)) {
+                case RateLimiter::Decision::Run:
+                    sTask->holdsLimit = true;
+                    return true;
+                case RateLimiter::Decision::WaitSlot:
+                    state->waiters.push_back(sTask->id);
+                    sTask->startDelayMs = 0;
+                    sTask->state = TaskState::LimitWait;
+                    break;
+                case RateLimiter::Decision::WaitToken:
+                    sTask->runTime = now + retryAfter;
+                    earlier = ArmLocked(sTask);
+                    break;
+                }
+            }
+        }
+        if (cancelled) CompleteTask(sTask, true); // 等待期间被取消：不执行，后继随之取消
+        else if (earlier) m_cv.notify_one();
+        return false;
+    }
+
+    // 一次执行结束：归还并发名额并放行等待者
+    void ReleaseLimit(ScheduledTask* sTask) {
+        sTask->holdsLimit = false;
+        std::vector<ScheduledTask*> ready;
+        bool earlier = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_limiter.ReleaseLocked(*sTask->limitState)) earlier = WakeLimitWaitersLocked(*sTask->limitState, ready);
+        }
+        if (earlier) m_cv.notify_one();
+        DispatchBulk(ready);
+    }
 
-                    if (now >= topTask.runTime) {
-                        // ʱ䵽ˣȡִ
-                        currentTask = topTask;
-                        m_taskQueue.pop();
-                        haveTask = true;
+    // 按空位数放行等待并发名额的任务 (已取消的跳过)，调用方持有 m_mutex
+    // 放行的任务在被领取时重新申请，被其他任务抢先时再次排到队尾
+    bool WakeLimitWaitersLocked(RateLimiter::State& state, std::vector<ScheduledTask*>& ready) {
+        bool earlier = false;
+        size_t slots = (state.limit.maxConcurrent > 0)
+            ? static_cast<size_t>((std::max)(state.limit.maxConcurrent - state.running, 0))
+            : state.waiters.size();
+        while (slots > 0 && !state.waiters.empty()) {
+            ScheduledTask* waiter = FindLocked(state.waiters.front());
+            state.waiters.pop_front();
+            if (!waiter || waiter->state.load() != TaskState::LimitWait) continue; // 已取消或已改期
+            earlier |= ReleaseBlockedLocked(waiter, ready);
+            --slots;
+        }
+        return earlier;
+    }
+
+    // 累计一次排队等待 (就绪 -> 开始执行)
+    void RecordWait(const ScheduledTask* sTask) {
+        long long waitUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - sTask->readyTime).count();
+        if (waitUs < 0) waitUs = 0;
+        WaitCounters& c = sTask->blocking ? m_blockingWait : m_cpuWait;
+        c.tasks.fetch_add(1, std::memory_order_relaxed);
+        c.totalUs.fetch_add(static_cast<unsigned long long>(waitUs), std::memory_order_relaxed);
+        long long prev = c.maxUs.load(std::memory_order_relaxed);
+        while (prev < waitUs && !c.maxUs.compare_exchange_weak(prev, waitUs)) {}
+        if (sTask->blocking && CurrentWorkerIndex() >= 0) {
+            m_blockingOnWorkers.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // 执行一个已领取 (Running) 的任务，CPU 工作线程与弹性线程共用
+    void RunTask(ScheduledTask* sTask) {
+        RecordWait(sTask);
+        const bool metrics = m_metrics.IsEnabled();
+        std::chrono::steady_clock::time_point start;
+        if (metrics) start = std::chrono::steady_clock::now();
+        bool failed = false;
+        try {
+            // === 执行任务 ===
+            // 通知UI开始
+            PublishEvent(SchedulerEventType::Executing, sTask->id, sTask->name);
+            LogEvent(sTask, LogEventType::TaskStarted);
+            TraceTask(TraceEventType::Start, sTask);
+
+            sTask->Execute(); // 多态调用 / 可调用对象 / 恢复协程
+
+            // 协程在 co_await 处挂起：停放节点，本次不算结束
+            if (sTask->park != CoPark::None) {
+                if (sTask->holdsLimit) ReleaseLimit(sTask); // 挂起期间不占并发名额，恢复时重新申请
+                if (metrics) RecordMetrics(sTask, start, false);
+                TraceTask(TraceEventType::End, sTask, 0, kTraceEndParked);
+                ParkCoroutine(sTask);
+                return;
+            }
+
+            // 通知UI完成
+            PublishEvent(SchedulerEventType::Finished, sTask->id, sTask->name);
+            LogEvent(sTask, LogEventType::TaskFinished);
+        }
+        catch (...) {
+            LogWriter::Instance().Write("Exception occurred in task execution!");
+            LogEvent(sTask, LogEventType::TaskFailed);
+            PublishEvent(SchedulerEventType::Failed, sTask->id, sTask->name);
+            failed = true;
+        }
+        if (metrics) RecordMetrics(sTask, start, failed);
+        TraceTask(TraceEventType::End, sTask, 0, failed ? kTraceEndFailed : 0);
+        RecordExecution(sTask);
+        if (sTask->holdsLimit) ReleaseLimit(sTask);
+
+        // 如果是周期任务，重新计算时间并放回
+        CompleteTask(sTask, failed);
+    }
+
+    // 按任务名记录一次执行 (节点处于 Running，只有本线程访问)
+    void RecordMetrics(const ScheduledTask* sTask, std::chrono::steady_clock::time_point start, bool failed) {
+        const auto end = std::chrono::steady_clock::now();
+        const int64_t lateNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start - sTask->runTime).count();
+        m_metrics.Record(sTask->name, lateNs,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+            sTask->periodicRun ? (std::max)(lateNs, int64_t(0)) : -1, failed);
+    }
+
+    // 协程挂起后停放节点：Delay 挂到时间轮，等待任务 / 事件时进入 Blocked，条件已满足则直接重新就绪
+    // 挂起期间被取消的协程不再恢复，按失败结束 (销毁协程帧，后继随之取消)
+    void ParkCoroutine(ScheduledTask* sTask) {
+        const CoPark park = sTask->park;
+        sTask->park = CoPark::None;
+        std::vector<ScheduledTask*> ready;
+        bool earlier = false;
+        bool cancelled = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            cancelled = sTask->cancelRequested;
+            if (!cancelled) {
+                sTask->resumeOk = true;
+                sTask->startDelayMs = 0;
+                bool wait = false;
+                if (park == CoPark::Delay) {
+                    sTask->runTime = std::chrono::steady_clock::now()
+                        + std::chrono::milliseconds((std::max)(sTask->parkDelayMs, 0));
+                    earlier = ArmLocked(sTask);
+                }
+                else if (park == CoPark::Task) {
+                    ScheduledTask* target = FindLocked(sTask->parkTask);
+                    if (target && target != sTask) {
+                        target->successors.push_back(sTask->id);
+                        wait = true;
                     }
                     else {
-                        // ʱ仹ûȴֱʱ䵽
-                        m_cv.wait_until(lock, topTask.runTime);
+                        earlier = ReleaseBlockedLocked(sTask, ready); // 已经结束，视为成功
                     }
                 }
-            } // ͷţִҪ߲ȣ
-
-            if (haveTask && currentTask.task) {
-                try {
-                    // === ִ ===
-                    // ֪ͨUIʼ
-                    if (m_uiCallback) m_uiCallback("Executing: " + currentTask.task->GetName());
-
-                    currentTask.task->Execute(); // ̬
-
-                    // ֪ͨUI
-                    if (m_uiCallback) m_uiCallback("Finished: " + currentTask.task->GetName());
-
-                    // ¼
-                    if (currentTask.isPeriodic && m_running) {
-                        currentTask.runTime = std::chrono::system_clock::now()
-                            + std::chrono::milliseconds(currentTask.intervalMs);
-                        {
-                            std::lock_guard<std::mutex> lock(m_mutex);
-                            m_taskQueue.push(currentTask);
-                        }
-                        // ҪnotifyΪ̻߳ѭ
-                    }
+                else if (!sTask->parkEvent->signaled) {
+                    sTask->parkEvent->waiters.push_back(sTask->id);
+                    wait = true;
                 }
-                catch (...) {
-                    LogWriter::Instance().Write("Exception occurred in task execution!");
+                else {
+                    earlier = ReleaseBlockedLocked(sTask, ready);
+                }
+                if (wait) {
+                    sTask->pendingDeps = 1;
+                    sTask->joinAny = false;
+                    sTask->depFailed = false;
+                    sTask->state = TaskState::Blocked;
                 }
             }
         }
+        if (cancelled) {
+            CompleteTask(sTask, true);
+            return;
+        }
+        if (earlier) m_cv.notify_one();
+        DispatchBulk(ready);
     }
 
-    std::priority_queue<ScheduledTask, std::vector<ScheduledTask>, std::greater<ScheduledTask>> m_taskQueue;
+    // 置位事件并恢复所有等待它的协程
+    void SignalEvent(CoEventState& event) {
+        std::vector<ScheduledTask*> ready;
+        bool earlier = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            event.signaled = true;
+            for (TaskId id : event.waiters) {
+                ScheduledTask* waiter = FindLocked(id);
+                if (!waiter || waiter->state.load() != TaskState::Blocked) continue; // 已被取消
+                waiter->pendingDeps = 0;
+                earlier |= ReleaseBlockedLocked(waiter, ready);
+            }
+            event.waiters.clear();
+        }
+        if (earlier) m_cv.notify_one();
+        DispatchBulk(ready);
+    }
+
+    // 异步任务的外部操作完成：与 SignalEvent 相同地放行 (已取消的任务找不到，直接忽略)
+    void ReleaseAsync(TaskId id) {
+        std::vector<ScheduledTask*> ready;
+        bool earlier = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ScheduledTask* sTask = FindLocked(id);
+            if (!sTask || sTask->state.load() != TaskState::Blocked || sTask->pendingDeps.load() == 0) return;
+            sTask->pendingDeps = 0;
+            earlier = ReleaseBlockedLocked(sTask, ready);
+        }
+        if (earlier) m_cv.notify_one();
+        DispatchBulk(ready);
+    }
+
+    void ResetEvent(CoEventState& event) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        event.signaled = false;
+    }
+
+    bool IsEventSignaled(const CoEventState& event) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return event.signaled;
+    }
+
+    // 工作线程主循环
+    void WorkerLoop(size_t index) {
+        CurrentWorkerIndex() = static_cast<int>(index);
+        TraceRecorder::SetThreadLabel("Worker", static_cast<int>(index));
+        PinWorker(index);
+
+        ScheduledTask* currentTask = nullptr;
+        while (AcquireTask(index, currentTask)) {
+            RunTask(currentTask);
+        }
+        CurrentWorkerIndex() = -1;
+    }
+
+    // 任务节点对象池 (编号 -> 节点的映射也由它提供)
+    ObjectPool<ScheduledTask> m_pool;
+
+    // 延迟任务 (定时线程独占消费)
+    TimingWheel m_timerWheel;
+    uint64_t m_nextWakeTick = TimingWheel::kNoTick; // 定时线程当前等待的刻度
     std::mutex m_mutex;
     std::condition_variable m_cv;
-    std::thread m_workerThread;
-    bool m_running;
-    UINotifyCallback m_uiCallback;
-};
\ No newline at end of file
+    std::thread m_timerThread;
+
+    // 工作线程池
+    std::vector<std::unique_ptr<WorkStealingQueue<ScheduledTask>>> m_queues;
+    std::vector<std::thread> m_workers;
+    std::atomic<size_t> m_nextQueue{ 0 };
+    std::atomic<long> m_readyCount{ 0 };     // 所有本地队列中的就绪任务总数
+    std::atomic<int> m_sleepingWorkers{ 0 };
+    std::mutex m_idleMutex;
+    std::condition_variable m_workCv;
+
+    // CPU 亲和性与按拓扑放置 (Start 时建立，运行期间不变)
+    struct WorkerSlot {
+        int cpu = -1;                    // 分配到的逻辑 CPU (未绑核时只用于确定节点)
+        int node = 0;
+        std::vector<size_t> stealOrder;  // 窃取顺序：同节点优先
+        WorkStealingQueue<ScheduledTask> pinned; // SameCore 任务，只有本线程取
+        std::atomic<long> pinnedCount{ 0 };
+        std::atomic<bool> sleeping{ false };     // 由 m_idleMutex 保护写入
+    };
+    struct NodeSlot {
+        WorkStealingQueue<ScheduledTask> queue;  // NodeLocal 任务，本节点的工作线程共享
+        std::atomic<long> count{ 0 };
+    };
+    AffinityOptions m_affinity;
+    std::vector<std::unique_ptr<WorkerSlot>> m_workerSlots;
+    std::vector<std::unique_ptr<NodeSlot>> m_nodeSlots;
+
+    // 优先级策略与统计
+    struct PriorityCounters {
+        std::atomic<unsigned long long> executed{ 0 };
+        std::atomic<unsigned long long> withDeadline{ 0 };
+        std::atomic<unsigned long long> deadlineMisses{ 0 };
+        std::atomic<unsigned long long> agedPromotions{ 0 };
+        std::atomic<long long> maxLatenessUs{ 0 };
+    };
+    PriorityOptions m_priorityOptions;                     // 由 m_mutex 保护
+    PriorityCounters m_priorityStats[kTaskPriorityCount];
+
+    // 阻塞任务的弹性线程池与排队等待统计
+    struct WaitCounters {
+        std::atomic<unsigned long long> tasks{ 0 };
+        std::atomic<unsigned long long> totalUs{ 0 };
+        std::atomic<long long> maxUs{ 0 };
+    };
+    ElasticPool<ScheduledTask> m_blockingPool;
+    ElasticPoolOptions m_blockingOptions;
+    bool m_blockingEnabled = false;          // Start 时确定，运行期间不变
+    WaitCounters m_cpuWait;
+    WaitCounters m_blockingWait;
+    std::atomic<unsigned long long> m_blockingOnWorkers{ 0 };
+
+    // 准入控制 (由 m_mutex 保护)
+    AdmissionOptions m_admission;
+    AdmissionStats m_admissionStats;            // held / peakHeld 与各计数，capacity 与 readyDepth 读取时填入
+    ScheduledTask* m_admitHead[kTaskPriorityCount] = {}; // 各优先级已接纳任务链表 (按接纳顺序)
+    ScheduledTask* m_admitTail[kTaskPriorityCount] = {};
+    uint64_t m_admitSeq = 0;
+    int m_admitWaiters = 0;
+    std::condition_variable m_admitCv;          // Block 策略下等待空位
+    // 合并键与 TaskOptions::limitKey 的驻留表 (引用计数，由引用它们的节点持有；自带锁)
+    KeyInterner m_keys;
+    // 按任务类型 / 标签限流 (计数与令牌由 m_mutex 保护)
+    RateLimiter m_limiter;
+    // 合并键 -> 登记中的同键任务 (由 m_mutex 保护；键是 m_keys 中的指针，由该任务持有引用)
+    std::unordered_map<const char*, TaskId> m_coalesceIndex;
+    CoalesceStats m_coalesceStats;
+
+    // 按任务名的运行统计 (各线程分片，读取时合并)
+    SchedulerMetrics m_metrics;
+    // 时间线追踪 (各线程事件块，导出时合并)
+    TraceRecorder m_trace;
+    // 持久模式 (EnableDurability 之后不再改变)
+    std::unique_ptr<TaskJournal> m_journal;
+    DurableTaskRegistry m_durableTypes;
+
+    std::atomic<bool> m_running;
+    // UI / 订阅者事件通道
+    EventChannel m_events;
+    std::shared_ptr<IEventSubscriber> m_uiSubscriber; // SetUICallback 注册的兼容订阅者
+};
+
+// === TaskHandle 实现 (需要完整的 TaskScheduler 定义) ===
+inline bool TaskHandle::Cancel() {
+    return IsValid() && m_scheduler->CancelTask(m_id);
+}
+
+inline bool TaskHandle::Reschedule(int delayMs) {
+    return IsValid() && m_scheduler->RescheduleTask(m_id, delayMs);
+}
+
+inline bool TaskHandle::ChangeInterval(int intervalMs) {
+    return IsValid() && m_scheduler->ChangeTaskInterval(m_id, intervalMs);
+}
+
+inline bool TaskHandle::IsPending() const {
+    return IsValid() && m_scheduler->IsTaskPending(m_id);
+}
+
+inline TaskHandle TaskHandle::Then(TaskBody next, int delayMs) const {
+    if (!IsValid()) return TaskHandle();
+    return m_scheduler->WhenAll(std::vector<TaskHandle>{ *this }, std::move(next), delayMs);
+}
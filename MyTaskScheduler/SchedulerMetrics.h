@@ -0,0 +1,339 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: SchedulerMetrics.h
+// 对应需求: 按任务名统计排队等待、执行耗时、周期任务迟到与异常次数 (HDR 风格直方图)；
+//           每个执行线程写自己的分片，读取时合并；关闭时热路径只有一次原子读，从不获取调度锁
+// =================================================================================
+#pragma once
+#include "ThreadLocalShards.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// === 1. 直方图 ===
+
+// 对数-线性分桶 (HDR Histogram 的简化)：每个 2 的幂区间再等分 16 份
+// 单位纳秒，[0, 16) 精确，之后相对误差约 3%，上限约 2^40 ns (18 分钟，更大的值计入最后一个桶)
+namespace MetricsDetail {
+    constexpr int kSubBits = 4;
+    constexpr int kSubBuckets = 1 << kSubBits;
+    constexpr int kMaxExponent = 40;
+    constexpr size_t kBucketCount = kSubBuckets + (kMaxExponent - kSubBits) * kSubBuckets;
+
+    // v > 0
+    inline int Log2(uint64_t v) {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanReverse64(&idx, v);
+        return static_cast<int>(idx);
+#else
+        return 63 - __builtin_clzll(v);
+#endif
+    }
+
+    inline size_t BucketIndex(uint64_t ns) {
+        if (ns < static_cast<uint64_t>(kSubBuckets)) return static_cast<size_t>(ns);
+        int e = Log2(ns);
+        if (e >= kMaxExponent) return kBucketCount - 1;
+        size_t sub = static_cast<size_t>((ns >> (e - kSubBits)) & (kSubBuckets - 1));
+        return kSubBuckets + static_cast<size_t>(e - kSubBits) * kSubBuckets + sub;
+    }
+
+    // 桶的下界与宽度
+    inline uint64_t BucketLow(size_t index) {
+        if (index < static_cast<size_t>(kSubBuckets)) return index;
+        size_t e = (index - kSubBuckets) / kSubBuckets + kSubBits;
+        size_t sub = (index - kSubBuckets) % kSubBuckets;
+        return static_cast<uint64_t>(kSubBuckets + sub) << (e - kSubBits);
+    }
+
+    inline uint64_t BucketWidth(size_t index) {
+        if (index < static_cast<size_t>(kSubBuckets)) return 1;
+        size_t e = (index - kSubBuckets) / kSubBuckets + kSubBits;
+        return uint64_t(1) << (e - kSubBits);
+    }
+}
+
+// 单线程写入的直方图分片：写线程用 load + store 代替原子加 (没有总线锁)，读线程随时可以读取
+struct AtomicHistogram {
+    std::atomic<uint64_t> buckets[MetricsDetail::kBucketCount];
+    std::atomic<uint64_t> count{ 0 };
+    std::atomic<uint64_t> sum{ 0 };
+
+    AtomicHistogram() {
+        for (auto& b : buckets) b.store(0, std::memory_order_relaxed);
+    }
+
+    void Record(uint64_t ns) {
+        std::atomic<uint64_t>& b = buckets[MetricsDetail::BucketIndex(ns)];
+        b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        sum.store(sum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    }
+};
+
+// 合并后的直方图 (快照中使用，普通整数)
+class LatencyHistogram {
+public:
+    LatencyHistogram() : m_buckets(MetricsDetail::kBucketCount, 0) {}
+
+    void Add(const AtomicHistogram& shard) {
+        for (size_t i = 0; i < m_buckets.size(); ++i) m_buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        m_count += shard.count.load(std::memory_order_relaxed);
+        m_sum += shard.sum.load(std::memory_order_relaxed);
+    }
+
+    void Merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < m_buckets.size(); ++i) m_buckets[i] += other.m_buckets[i];
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+    }
+
+    // 扣除基线 (ResetMetrics 时的快照)，计数只增不减，逐桶相减即可
+    void Subtract(const LatencyHistogram& base) {
+        for (size_t i = 0; i < m_buckets.size(); ++i) m_buckets[i] -= (std::min)(m_buckets[i], base.m_buckets[i]);
+        m_count -= (std::min)(m_count, base.m_count);
+        m_sum -= (std::min)(m_sum, base.m_sum);
+    }
+
+    uint64_t Count() const { return m_count; }
+    uint64_t SumNs() const { return m_sum; }
+    double MeanNs() const { return m_count ? static_cast<double>(m_sum) / static_cast<double>(m_count) : 0.0; }
+
+    // 分位数 (q 取 [0, 1])，返回所在桶的中点；没有样本时返回 0
+    uint64_t PercentileNs(double q) const {
+        if (m_count == 0) return 0;
+        q = (std::min)((std::max)(q, 0.0), 1.0);
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(m_count - 1));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < m_buckets.size(); ++i) {
+            seen += m_buckets[i];
+            if (seen > rank) return MetricsDetail::BucketLow(i) + MetricsDetail::BucketWidth(i) / 2;
+        }
+        return MetricsDetail::BucketLow(m_buckets.size() - 1);
+    }
+
+    uint64_t MaxNs() const { return PercentileNs(1.0); }
+
+private:
+    std::vector<uint64_t> m_buckets;
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+};
+
+// === 2. 快照 ===
+
+struct TaskMetrics {
+    std::string name;
+    uint64_t executions = 0;
+    uint64_t exceptions = 0;
+    LatencyHistogram queueWait;         // 计划执行时刻 (runTime) -> 开始执行
+    LatencyHistogram execution;         // 执行耗时 (协程为每次恢复的运行片段)
+    LatencyHistogram periodicLateness;  // 周期任务每次触发相对计划时刻的迟到 (只统计周期执行)
+
+    void Merge(const TaskMetrics& other) {
+        executions += other.executions;
+        exceptions += other.exceptions;
+        queueWait.Merge(other.queueWait);
+        execution.Merge(other.execution);
+        periodicLateness.Merge(other.periodicLateness);
+    }
+};
+
+struct MetricsSnapshot {
+    std::vector<TaskMetrics> tasks;   // 按任务名排序
+
+    const TaskMetrics* Find(const std::string& name) const {
+        for (const auto& t : tasks) {
+            if (t.name == name) return &t;
+        }
+        return nullptr;
+    }
+
+    // 所有任务合计
+    TaskMetrics Total() const {
+        TaskMetrics total;
+        total.name = "(all)";
+        for (const auto& t : tasks) total.Merge(t);
+        return total;
+    }
+
+    // 文本格式 (Prometheus exposition 风格，单位秒)，可直接写文件或日志
+    std::string ToText() const {
+        std::string out;
+        char line[512];
+        auto counter = [&](const char* metric, const char* help, uint64_t TaskMetrics::* field) {
+            std::snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s counter\n", metric, help, metric);
+            out += line;
+            for (const auto& t : tasks) {
+                std::snprintf(line, sizeof(line), "%s{task=\"%s\"} %llu\n", metric, Escape(t.name).c_str(),
+                    static_cast<unsigned long long>(t.*field));
+                out += line;
+            }
+        };
+        auto summary = [&](const char* metric, const char* help, LatencyHistogram TaskMetrics::* field) {
+            std::snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s summary\n", metric, help, metric);
+            out += line;
+            for (const auto& t : tasks) {
+                const LatencyHistogram& h = t.*field;
+                if (h.Count() == 0) continue;
+                const std::string name = Escape(t.name);
+                for (double q : { 0.5, 0.9, 0.99, 0.999 }) {
+                    std::snprintf(line, sizeof(line), "%s{task=\"%s\",quantile=\"%g\"} %.9f\n", metric, name.c_str(), q,
+                        h.PercentileNs(q) / 1e9);
+                    out += line;
+                }
+                std::snprintf(line, sizeof(line), "%s_sum{task=\"%s\"} %.9f\n%s_count{task=\"%s\"} %llu\n",
+                    metric, name.c_str(), h.SumNs() / 1e9, metric, name.c_str(), static_cast<unsigned long long>(h.Count()));
+                out += line;
+            }
+        };
+        counter("mts_task_executions_total", "Task executions (coroutine resumes count separately).", &TaskMetrics::executions);
+        counter("mts_task_exceptions_total", "Executions that ended with an exception.", &TaskMetrics::exceptions);
+        summary("mts_task_queue_wait_seconds", "Scheduled run time to start of execution.", &TaskMetrics::queueWait);
+        summary("mts_task_execution_seconds", "Execution time.", &TaskMetrics::execution);
+        summary("mts_task_periodic_lateness_seconds", "Start of a periodic run after its scheduled time.", &TaskMetrics::periodicLateness);
+        return out;
+    }
+
+private:
+    static std::string Escape(const std::string& text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') out += '\\';
+            if (c == '\n') { out += "\\n"; continue; }
+            out += c;
+        }
+        return out;
+    }
+};
+
+// === 3. 采集器 ===
+
+// 每个执行线程一个分片：按驻留后的任务名指针开放寻址，只有所属线程写入
+// 新任务名的统计单元先创建再以 release 发布键，读线程以 acquire 读到键后即可安全读取
+class MetricsShard {
+public:
+    struct Cell {
+        std::atomic<uint64_t> executions{ 0 };
+        std::atomic<uint64_t> exceptions{ 0 };
+        AtomicHistogram queueWait;
+        AtomicHistogram execution;
+        AtomicHistogram periodicLateness;
+    };
+
+    static constexpr size_t kCapacity = 256;   // 每个分片最多区分的任务名数量 (超出的合并到 "(other)")
+
+    MetricsShard() {
+        for (auto& key : m_keys) key.store(nullptr, std::memory_order_relaxed);
+    }
+
+    Cell& Find(const char* name) {
+        size_t slot = (reinterpret_cast<uintptr_t>(name) >> 3) * 0x9E3779B97F4A7C15ull >> 56;
+        for (size_t probe = 0; probe < kCapacity; ++probe, slot = (slot + 1) & (kCapacity - 1)) {
+            const char* key = m_keys[slot].load(std::memory_order_relaxed);
+            if (key == name) return *m_cells[slot];
+            if (key == nullptr) {
+                m_cells[slot] = std::make_unique<Cell>();
+                m_keys[slot].store(name, std::memory_order_release);
+                return *m_cells[slot];
+            }
+        }
+        return m_overflow;
+    }
+
+    // 读线程：遍历已发布的统计单元 (名字为 nullptr 表示溢出单元)
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        for (size_t i = 0; i < kCapacity; ++i) {
+            const char* key = m_keys[i].load(std::memory_order_acquire);
+            if (key) fn(key, *m_cells[i]);
+        }
+        fn(nullptr, m_overflow);
+    }
+
+private:
+    std::atomic<const char*> m_keys[kCapacity];
+    std::unique_ptr<Cell> m_cells[kCapacity];
+    Cell m_overflow;
+};
+
+class SchedulerMetrics {
+public:
+    void SetEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+    bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // 记录一次执行 (由执行任务的线程调用)；periodicLatenessNs < 0 表示不是周期执行
+    void Record(const char* name, int64_t queueWaitNs, int64_t executionNs, int64_t periodicLatenessNs, bool failed) {
+        MetricsShard::Cell& cell = m_shards.Local(m_registryMutex).Find(name);
+        cell.executions.store(cell.executions.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (failed) cell.exceptions.store(cell.exceptions.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        cell.queueWait.Record(static_cast<uint64_t>((std::max)(queueWaitNs, int64_t(0))));
+        cell.execution.Record(static_cast<uint64_t>((std::max)(executionNs, int64_t(0))));
+        if (periodicLatenessNs >= 0) cell.periodicLateness.Record(static_cast<uint64_t>(periodicLatenessNs));
+    }
+
+    // 合并所有分片 (扣除最近一次 Reset 时的基线)
+    MetricsSnapshot Snapshot() const {
+        std::lock_guard<std::mutex> lock(m_registryMutex);
+        MetricsSnapshot snapshot = CollectLocked();
+        for (auto& t : snapshot.tasks) {
+            auto base = m_baseline.find(t.name);
+            if (base == m_baseline.end()) continue;
+            t.executions -= (std::min)(t.executions, base->second.executions);
+            t.exceptions -= (std::min)(t.exceptions, base->second.exceptions);
+            t.queueWait.Subtract(base->second.queueWait);
+            t.execution.Subtract(base->second.execution);
+            t.periodicLateness.Subtract(base->second.periodicLateness);
+        }
+        snapshot.tasks.erase(std::remove_if(snapshot.tasks.begin(), snapshot.tasks.end(),
+            [](const TaskMetrics& t) { return t.executions == 0; }), snapshot.tasks.end());
+        return snapshot;
+    }
+
+    // 清零：写线程不停，记录当前值作为基线
+    void Reset() {
+        std::lock_guard<std::mutex> lock(m_registryMutex);
+        MetricsSnapshot current = CollectLocked();
+        m_baseline.clear();
+        for (auto& t : current.tasks) m_baseline[t.name] = std::move(t);
+    }
+
+private:
+    MetricsSnapshot CollectLocked() const {
+        std::map<std::string, TaskMetrics> merged;
+        m_shards.ForEachLocked([&](const MetricsShard& shard) {
+            shard.ForEach([&](const char* name, const MetricsShard::Cell& cell) {
+                uint64_t executions = cell.executions.load(std::memory_order_relaxed);
+                if (executions == 0) return;
+                TaskMetrics& t = merged[name ? name : "(other)"];
+                t.executions += executions;
+                t.exceptions += cell.exceptions.load(std::memory_order_relaxed);
+                t.queueWait.Add(cell.queueWait);
+                t.execution.Add(cell.execution);
+                t.periodicLateness.Add(cell.periodicLateness);
+            });
+        });
+        MetricsSnapshot snapshot;
+        for (auto& item : merged) {
+            item.second.name = item.first;
+            snapshot.tasks.push_back(std::move(item.second));
+        }
+        return snapshot;
+    }
+
+    std::atomic<bool> m_enabled{ false };
+    mutable std::mutex m_registryMutex;     // 只保护分片注册表与基线，与调度锁无关
+    ThreadLocalShards<MetricsShard> m_shards;
+    std::map<std::string, TaskMetrics> m_baseline;
+};
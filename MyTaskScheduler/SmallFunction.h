@@ -0,0 +1,128 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: SmallFunction.h
+// 对应需求: 任意可调用对象 (lambda / 函数对象) 作为任务，小对象内联存储不分配堆内存
+// =================================================================================
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 只可移动的 void() 可调用对象包装 (Small Buffer Optimization)
+// - 捕获不超过 kInlineSize 字节且可无异常移动的 lambda 直接放在对象内部
+// - 更大的可调用对象退化为一次堆分配 (与 std::function 相同)
+class SmallFunction {
+public:
+    static constexpr size_t kInlineSize = 48;
+
+    SmallFunction() noexcept = default;
+    SmallFunction(std::nullptr_t) noexcept {}
+
+    template <typename F,
+        typename Fn = typename std::decay<F>::type,
+        typename = typename std::enable_if<!std::is_same<Fn, SmallFunction>::value>::type>
+    SmallFunction(F&& f) {
+        Construct<Fn>(std::forward<F>(f));
+    }
+
+    SmallFunction(SmallFunction&& other) noexcept {
+        MoveFrom(other);
+    }
+
+    SmallFunction& operator=(SmallFunction&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    SmallFunction& operator=(std::nullptr_t) noexcept {
+        Reset();
+        return *this;
+    }
+
+    SmallFunction(const SmallFunction&) = delete;
+    SmallFunction& operator=(const SmallFunction&) = delete;
+
+    ~SmallFunction() { Reset(); }
+
+    // 释放捕获的状态 (任务结束后尽早归还捕获的资源)
+    void Reset() noexcept {
+        if (m_ops) {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+    explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+    void operator()() { m_ops->invoke(m_storage); }
+
+    // 是否使用了内联存储 (调试与测试用)
+    bool IsInline() const noexcept { return m_ops != nullptr && m_ops->isInline; }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* dst, void* src) noexcept;   // 移动到 dst 并销毁 src
+        void (*destroy)(void* storage) noexcept;
+        bool isInline;
+    };
+
+    template <typename Fn>
+    struct InlineOps {
+        static void Invoke(void* s) { (*static_cast<Fn*>(s))(); }
+        static void Move(void* dst, void* src) noexcept {
+            Fn* from = static_cast<Fn*>(src);
+            ::new (dst) Fn(std::move(*from));
+            from->~Fn();
+        }
+        static void Destroy(void* s) noexcept { static_cast<Fn*>(s)->~Fn(); }
+        static constexpr Ops kOps = { &Invoke, &Move, &Destroy, true };
+    };
+
+    // 堆存储：内部只保存一个指针，移动时只搬指针
+    template <typename Fn>
+    struct HeapOps {
+        static Fn*& Ptr(void* s) { return *static_cast<Fn**>(s); }
+        static void Invoke(void* s) { (*Ptr(s))(); }
+        static void Move(void* dst, void* src) noexcept {
+            ::new (dst) Fn*(Ptr(src));
+            Ptr(src) = nullptr;
+        }
+        static void Destroy(void* s) noexcept { delete Ptr(s); }
+        static constexpr Ops kOps = { &Invoke, &Move, &Destroy, false };
+    };
+
+    template <typename Fn>
+    static constexpr bool FitsInline() {
+        return sizeof(Fn) <= kInlineSize
+            && alignof(Fn) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible<Fn>::value;
+    }
+
+    template <typename Fn, typename F>
+    void Construct(F&& f) {
+        if constexpr (FitsInline<Fn>()) {
+            ::new (static_cast<void*>(m_storage)) Fn(std::forward<F>(f));
+            m_ops = &InlineOps<Fn>::kOps;
+        }
+        else {
+            ::new (static_cast<void*>(m_storage)) Fn*(new Fn(std::forward<F>(f)));
+            m_ops = &HeapOps<Fn>::kOps;
+        }
+    }
+
+    void MoveFrom(SmallFunction& other) noexcept {
+        if (other.m_ops) {
+            other.m_ops->move(m_storage, other.m_storage);
+            m_ops = other.m_ops;
+            other.m_ops = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char m_storage[kInlineSize];
+    const Ops* m_ops = nullptr;
+};
@@ -0,0 +1,495 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: StatsEngine.h
+// 对应需求: 流式统计引擎：分块单遍 Welford / Chan 合并 (最小、最大、均值、方差)，
+//           对数分桶近似分位数 (DDSketch 风格)，块内 SIMD，按区间并行归约，样本不落内存
+// =================================================================================
+#pragma once
+#include "CpuFeatures.h"
+#include "TaskOptions.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+// === 1. 矩统计 ===
+
+// 单遍均值 / 方差 (Welford)，两个部分结果可以合并 (Chan et al.)，合并顺序不影响数值稳定性
+struct RunningStats {
+    uint64_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;   // 离差平方和
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void Add(double x) {
+        ++count;
+        double delta = x - mean;
+        mean += delta / static_cast<double>(count);
+        m2 += delta * (x - mean);
+        if (x < min) min = x;
+        if (x > max) max = x;
+    }
+
+    void Merge(const RunningStats& other) {
+        if (other.count == 0) return;
+        if (count == 0) {
+            *this = other;
+            return;
+        }
+        const double n1 = static_cast<double>(count);
+        const double n2 = static_cast<double>(other.count);
+        const double n = n1 + n2;
+        const double delta = other.mean - mean;
+        mean += delta * (n2 / n);
+        m2 += other.m2 + delta * delta * (n1 * n2 / n);
+        count += other.count;
+        min = (std::min)(min, other.min);
+        max = (std::max)(max, other.max);
+    }
+
+    // 总体方差 (除以 n)
+    double Variance() const { return count > 0 ? m2 / static_cast<double>(count) : 0.0; }
+    // 样本方差 (除以 n - 1)
+    double SampleVariance() const { return count > 1 ? m2 / static_cast<double>(count - 1) : 0.0; }
+    double StdDev() const { return std::sqrt(Variance()); }
+};
+
+namespace StatsDetail {
+
+// 一个数据块的矩：块内两遍 (求和与最值 -> 离差平方和)，块在缓存中，第二遍几乎不占内存带宽
+// 各指令集版本结果只在舍入误差范围内不同
+inline RunningStats ChunkScalar(const double* x, size_t n) {
+    RunningStats s;
+    double sum[4] = {};
+    double lo = x[0], hi = x[0];
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        for (size_t j = 0; j < 4; ++j) {
+            sum[j] += x[i + j];
+            lo = (std::min)(lo, x[i + j]);
+            hi = (std::max)(hi, x[i + j]);
+        }
+    }
+    double total = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    for (; i < n; ++i) {
+        total += x[i];
+        lo = (std::min)(lo, x[i]);
+        hi = (std::max)(hi, x[i]);
+    }
+    const double mean = total / static_cast<double>(n);
+    double m2 = 0.0;
+    for (i = 0; i < n; ++i) m2 += (x[i] - mean) * (x[i] - mean);
+    s.count = n;
+    s.mean = mean;
+    s.m2 = m2;
+    s.min = lo;
+    s.max = hi;
+    return s;
+}
+
+#if defined(MTS_X86)
+MTS_TARGET_AVX2 inline RunningStats ChunkAvx2(const double* x, size_t n) {
+    if (n < 8) return ChunkScalar(x, n);
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    __m256d lo = _mm256_loadu_pd(x), hi = lo;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256d a = _mm256_loadu_pd(x + i);
+        const __m256d b = _mm256_loadu_pd(x + i + 4);
+        sum0 = _mm256_add_pd(sum0, a);
+        sum1 = _mm256_add_pd(sum1, b);
+        lo = _mm256_min_pd(lo, _mm256_min_pd(a, b));
+        hi = _mm256_max_pd(hi, _mm256_max_pd(a, b));
+    }
+    alignas(32) double s[4], l[4], h[4];
+    _mm256_store_pd(s, _mm256_add_pd(sum0, sum1));
+    _mm256_store_pd(l, lo);
+    _mm256_store_pd(h, hi);
+    double total = (s[0] + s[1]) + (s[2] + s[3]);
+    double minValue = (std::min)((std::min)(l[0], l[1]), (std::min)(l[2], l[3]));
+    double maxValue = (std::max)((std::max)(h[0], h[1]), (std::max)(h[2], h[3]));
+    for (size_t j = i; j < n; ++j) {
+        total += x[j];
+        minValue = (std::min)(minValue, x[j]);
+        maxValue = (std::max)(maxValue, x[j]);
+    }
+    const double mean = total / static_cast<double>(n);
+
+    const __m256d vmean = _mm256_set1_pd(mean);
+    __m256d m20 = _mm256_setzero_pd(), m21 = _mm256_setzero_pd();
+    for (i = 0; i + 8 <= n; i += 8) {
+        const __m256d a = _mm256_sub_pd(_mm256_loadu_pd(x + i), vmean);
+        const __m256d b = _mm256_sub_pd(_mm256_loadu_pd(x + i + 4), vmean);
+        m20 = _mm256_fmadd_pd(a, a, m20);
+        m21 = _mm256_fmadd_pd(b, b, m21);
+    }
+    _mm256_store_pd(s, _mm256_add_pd(m20, m21));
+    double m2 = (s[0] + s[1]) + (s[2] + s[3]);
+    for (; i < n; ++i) m2 += (x[i] - mean) * (x[i] - mean);
+
+    RunningStats r;
+    r.count = n;
+    r.mean = mean;
+    r.m2 = m2;
+    r.min = minValue;
+    r.max = maxValue;
+    return r;
+}
+
+// GCC 12 的 _mm512_min_pd / _mm512_max_pd 在内联后会误报 -Wmaybe-uninitialized
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+MTS_TARGET_AVX512 inline RunningStats ChunkAvx512(const double* x, size_t n) {
+    if (n < 16) return ChunkScalar(x, n);
+    __m512d sum0 = _mm512_setzero_pd(), sum1 = _mm512_setzero_pd();
+    __m512d lo = _mm512_loadu_pd(x), hi = lo;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m512d a = _mm512_loadu_pd(x + i);
+        const __m512d b = _mm512_loadu_pd(x + i + 8);
+        sum0 = _mm512_add_pd(sum0, a);
+        sum1 = _mm512_add_pd(sum1, b);
+        lo = _mm512_min_pd(lo, _mm512_min_pd(a, b));
+        hi = _mm512_max_pd(hi, _mm512_max_pd(a, b));
+    }
+    double total = _mm512_reduce_add_pd(_mm512_add_pd(sum0, sum1));
+    double minValue = _mm512_reduce_min_pd(lo);
+    double maxValue = _mm512_reduce_max_pd(hi);
+    for (size_t j = i; j < n; ++j) {
+        total += x[j];
+        minValue = (std::min)(minValue, x[j]);
+        maxValue = (std::max)(maxValue, x[j]);
+    }
+    const double mean = total / static_cast<double>(n);
+
+    const __m512d vmean = _mm512_set1_pd(mean);
+    __m512d m20 = _mm512_setzero_pd(), m21 = _mm512_setzero_pd();
+    for (i = 0; i + 16 <= n; i += 16) {
+        const __m512d a = _mm512_sub_pd(_mm512_loadu_pd(x + i), vmean);
+        const __m512d b = _mm512_sub_pd(_mm512_loadu_pd(x + i + 8), vmean);
+        m20 = _mm512_fmadd_pd(a, a, m20);
+        m21 = _mm512_fmadd_pd(b, b, m21);
+    }
+    double m2 = _mm512_reduce_add_pd(_mm512_add_pd(m20, m21));
+    for (; i < n; ++i) m2 += (x[i] - mean) * (x[i] - mean);
+
+    RunningStats r;
+    r.count = n;
+    r.mean = mean;
+    r.m2 = m2;
+    r.min = minValue;
+    r.max = maxValue;
+    return r;
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+inline RunningStats ChunkStats(const double* x, size_t n, SimdLevel level) {
+    if (n == 0) return RunningStats();
+    level = (std::min)(level, DetectSimdLevel());
+#if defined(MTS_X86)
+    if (level == SimdLevel::Avx512) return ChunkAvx512(x, n);
+    if (level == SimdLevel::Avx2) return ChunkAvx2(x, n);
+#endif
+    return ChunkScalar(x, n);
+}
+
+} // namespace StatsDetail
+
+// === 2. 近似分位数 ===
+
+// 对数分桶分位数草图 (DDSketch 风格)：任意分位数的相对误差不超过 relativeAccuracy，可合并
+// - 桶下标由 double 的指数位与尾数线性插值得到 (不调用 log)，桶宽按插值的最坏情况收紧，精度保证不变
+// - 正数、负数各一组连续桶，|x| 小于最小正规数的样本计入零桶
+// - 内存与数据范围的对数成正比 (1% 精度下 1e-3 ~ 1e9 约 1000 个桶)，与样本数无关
+class QuantileSketch {
+public:
+    explicit QuantileSketch(double relativeAccuracy = 0.01)
+        : m_accuracy(relativeAccuracy) {
+        const double gamma = (1.0 + relativeAccuracy) / (1.0 - relativeAccuracy);
+        m_width = std::log(gamma);
+        m_invWidth = 1.0 / m_width;
+    }
+
+    void Add(double x) {
+        ++m_count;
+        if (x > kMinIndexable) m_positive.Add(Index(x), 1);
+        else if (x < -kMinIndexable) m_negative.Add(Index(-x), 1);
+        else ++m_zero;
+    }
+
+    void AddChunk(const double* x, size_t n) {
+        for (size_t i = 0; i < n; ++i) Add(x[i]);
+    }
+
+    // 合并另一个相同精度的草图
+    void Merge(const QuantileSketch& other) {
+        m_positive.Merge(other.m_positive);
+        m_negative.Merge(other.m_negative);
+        m_zero += other.m_zero;
+        m_count += other.m_count;
+    }
+
+    // q 取 [0, 1]；没有样本时返回 NaN
+    double Quantile(double q) const {
+        if (m_count == 0) return std::numeric_limits<double>::quiet_NaN();
+        q = (std::min)((std::max)(q, 0.0), 1.0);
+        const uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(m_count - 1));
+
+        uint64_t seen = 0;
+        // 负数：绝对值从大到小
+        for (size_t i = m_negative.bins.size(); i-- > 0;) {
+            seen += m_negative.bins[i];
+            if (seen > rank) return -Value(m_negative.offset + static_cast<int>(i));
+        }
+        seen += m_zero;
+        if (seen > rank) return 0.0;
+        for (size_t i = 0; i < m_positive.bins.size(); ++i) {
+            seen += m_positive.bins[i];
+            if (seen > rank) return Value(m_positive.offset + static_cast<int>(i));
+        }
+        return Value(m_positive.offset + static_cast<int>(m_positive.bins.size()) - 1);
+    }
+
+    uint64_t Count() const { return m_count; }
+    double RelativeAccuracy() const { return m_accuracy; }
+
+private:
+    static constexpr double kMinIndexable = std::numeric_limits<double>::min();
+
+    // 连续桶数组，下标 offset + i 的计数在 bins[i]；两端按需扩展 (预留余量，扩展很少发生)
+    struct Store {
+        static constexpr int kSlack = 32;
+        std::vector<uint64_t> bins;
+        int offset = 0;
+
+        void Add(int index, uint64_t n) {
+            if (bins.empty()) {
+                offset = index - kSlack;
+                bins.assign(2 * kSlack, 0);
+            }
+            else if (index < offset) {
+                const int grow = offset - index + kSlack;
+                bins.insert(bins.begin(), static_cast<size_t>(grow), 0);
+                offset -= grow;
+            }
+            else if (index - offset >= static_cast<int>(bins.size())) {
+                bins.resize(static_cast<size_t>(index - offset + kSlack), 0);
+            }
+            bins[static_cast<size_t>(index - offset)] += n;
+        }
+
+        void Merge(const Store& other) {
+            for (size_t i = 0; i < other.bins.size(); ++i) {
+                if (other.bins[i] != 0) Add(other.offset + static_cast<int>(i), other.bins[i]);
+            }
+        }
+    };
+
+    // 近似 log2(x) = 指数 + (尾数 - 1)，在 ln x 上的斜率介于 1 与 2 之间，桶宽取 ln(gamma) 即可保证精度
+    int Index(double x) const {
+        uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        const int exponent = static_cast<int>((bits >> 52) & 0x7FF) - 1023;
+        const double mantissa = static_cast<double>(bits & ((uint64_t(1) << 52) - 1)) * (1.0 / 4503599627370496.0);
+        return static_cast<int>(std::floor((exponent + mantissa) * m_invWidth));
+    }
+
+    static double InverseLog(double y) {
+        const double exponent = std::floor(y);
+        return std::ldexp(1.0 + (y - exponent), static_cast<int>(exponent));
+    }
+
+    // 桶 [lo, hi) 的代表值取调和平均，使两端的相对误差相等
+    double Value(int index) const {
+        const double lo = InverseLog(index * m_width);
+        const double hi = InverseLog((index + 1) * m_width);
+        if (hi > (std::numeric_limits<double>::max)()) return lo; // 最高的桶上界溢出
+        return 2.0 * lo / (1.0 + lo / hi);
+    }
+
+    double m_accuracy;
+    double m_width;
+    double m_invWidth;
+    Store m_positive;
+    Store m_negative;
+    uint64_t m_zero = 0;
+    uint64_t m_count = 0;
+};
+
+// === 3. 统计累加器 (矩 + 可选分位数) ===
+class StatsAccumulator {
+public:
+    explicit StatsAccumulator(bool quantiles = true, double quantileAccuracy = 0.01)
+        : m_quantiles(quantiles), m_sketch(quantileAccuracy) {}
+
+    void Add(double x) {
+        m_moments.Add(x);
+        if (m_quantiles) m_sketch.Add(x);
+    }
+
+    void AddChunk(const double* data, size_t count, SimdLevel level = DetectSimdLevel()) {
+        m_moments.Merge(StatsDetail::ChunkStats(data, count, level));
+        if (m_quantiles) m_sketch.AddChunk(data, count);
+    }
+
+    void Merge(const StatsAccumulator& other) {
+        m_moments.Merge(other.m_moments);
+        if (m_quantiles && other.m_quantiles) m_sketch.Merge(other.m_sketch);
+    }
+
+    const RunningStats& Moments() const { return m_moments; }
+    bool HasQuantiles() const { return m_quantiles; }
+
+    // 近似分位数，结果夹在 [min, max] 内；未开启分位数时返回 NaN
+    double Quantile(double q) const {
+        if (!m_quantiles || m_moments.count == 0) return std::numeric_limits<double>::quiet_NaN();
+        return (std::min)((std::max)(m_sketch.Quantile(q), m_moments.min), m_moments.max);
+    }
+
+private:
+    bool m_quantiles;
+    RunningStats m_moments;
+    QuantileSketch m_sketch;
+};
+
+// === 4. 数据源 ===
+
+// 可随机访问的样本源：并行统计时各线程读取互不重叠的下标区间，样本不需要整体放进内存
+class ISampleSource {
+public:
+    virtual ~ISampleSource() {}
+    // 样本总数
+    virtual uint64_t Size() const = 0;
+    // 读取下标 [offset, offset + count) 的样本，返回实际读取数量；必须可以被多个线程同时调用
+    virtual size_t Read(uint64_t offset, double* out, size_t count) const = 0;
+};
+
+// 计数器型伪随机整数，均匀分布在 [lo, hi]
+// 第 i 个样本只由 (seed, i) 决定 (SplitMix64)：任意区间可以独立生成，结果与线程数、分块方式无关
+class UniformIntSource : public ISampleSource {
+public:
+    UniformIntSource(uint64_t count, int lo, int hi, uint64_t seed)
+        : m_count(count), m_lo(lo), m_range(static_cast<uint64_t>(static_cast<int64_t>(hi) - lo + 1)), m_seed(seed) {}
+
+    uint64_t Size() const override { return m_count; }
+
+    size_t Read(uint64_t offset, double* out, size_t count) const override {
+        if (offset >= m_count) return 0;
+        count = static_cast<size_t>((std::min)(static_cast<uint64_t>(count), m_count - offset));
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t z = m_seed + (offset + i) * 0x9E3779B97F4A7C15ull;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            z ^= z >> 31;
+            // 高 32 位乘以区间长度取高位 (Lemire)，避免取模
+            out[i] = static_cast<double>(m_lo + static_cast<int64_t>(((z >> 32) * m_range) >> 32));
+        }
+        return count;
+    }
+
+private:
+    uint64_t m_count;
+    int m_lo;
+    uint64_t m_range;
+    uint64_t m_seed;
+};
+
+// 任意生成函数：fill(offset, out, count) 写入下标 [offset, offset + count) 的样本
+class GeneratorSource : public ISampleSource {
+public:
+    using FillFn = std::function<void(uint64_t offset, double* out, size_t count)>;
+
+    GeneratorSource(uint64_t count, FillFn fill) : m_count(count), m_fill(std::move(fill)) {}
+
+    uint64_t Size() const override { return m_count; }
+
+    size_t Read(uint64_t offset, double* out, size_t count) const override {
+        if (offset >= m_count) return 0;
+        count = static_cast<size_t>((std::min)(static_cast<uint64_t>(count), m_count - offset));
+        m_fill(offset, out, count);
+        return count;
+    }
+
+private:
+    uint64_t m_count;
+    FillFn m_fill;
+};
+
+// 原生字节序的 double 二进制文件；每次读取独立打开文件，多个线程可以同时读不同区间
+class BinaryFileSource : public ISampleSource {
+public:
+    explicit BinaryFileSource(std::string path) : m_path(std::move(path)) {
+        std::ifstream file(m_path, std::ios::binary | std::ios::ate);
+        m_count = file ? static_cast<uint64_t>(file.tellg()) / sizeof(double) : 0;
+    }
+
+    uint64_t Size() const override { return m_count; }
+
+    size_t Read(uint64_t offset, double* out, size_t count) const override {
+        if (offset >= m_count) return 0;
+        count = static_cast<size_t>((std::min)(static_cast<uint64_t>(count), m_count - offset));
+        std::ifstream file(m_path, std::ios::binary);
+        file.seekg(static_cast<std::streamoff>(offset * sizeof(double)));
+        file.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(count * sizeof(double)));
+        return static_cast<size_t>(file.gcount()) / sizeof(double);
+    }
+
+private:
+    std::string m_path;
+    uint64_t m_count = 0;
+};
+
+// === 5. 统计驱动 ===
+
+struct StatsOptions {
+    size_t chunkSize = 16384;             // 每次从数据源读取的样本数 (128KB，留在 L2 中做块内两遍)
+    bool quantiles = true;                // 是否维护分位数草图
+    double quantileAccuracy = 0.01;       // 分位数相对误差
+    SimdLevel simd = DetectSimdLevel();
+    ParallelForFn parallelFor;            // 为空时单线程
+    size_t partitions = 64;               // 并行时下标空间切成的区间数上限
+};
+
+// 流式计算数据源的全部统计量：每个区间一个累加器，按区间顺序合并 (结果与调度顺序无关)
+inline StatsAccumulator ComputeStats(const ISampleSource& source, const StatsOptions& options = StatsOptions()) {
+    const uint64_t size = source.Size();
+    const size_t chunk = (std::max)(options.chunkSize, size_t(1));
+    size_t parts = 1;
+    if (options.parallelFor) {
+        const uint64_t chunks = (size + chunk - 1) / chunk;
+        parts = static_cast<size_t>((std::min)(chunks, static_cast<uint64_t>((std::max)(options.partitions, size_t(1)))));
+        parts = (std::max)(parts, size_t(1));
+    }
+
+    std::vector<StatsAccumulator> partials(parts, StatsAccumulator(options.quantiles, options.quantileAccuracy));
+    auto run = [&](size_t part) {
+        thread_local std::vector<double> buffer;
+        buffer.resize(chunk);
+        const uint64_t begin = size * part / parts;
+        const uint64_t end = size * (part + 1) / parts;
+        for (uint64_t offset = begin; offset < end;) {
+            size_t want = static_cast<size_t>((std::min)(static_cast<uint64_t>(chunk), end - offset));
+            size_t got = source.Read(offset, buffer.data(), want);
+            if (got == 0) break;
+            partials[part].AddChunk(buffer.data(), got, options.simd);
+            offset += got;
+        }
+    };
+    if (parts > 1) options.parallelFor(parts, run);
+    else run(0);
+
+    StatsAccumulator result = partials[0];
+    for (size_t i = 1; i < parts; ++i) result.Merge(partials[i]);
+    return result;
+}
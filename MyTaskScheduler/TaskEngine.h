@@ -8,61 +8,71 @@
 #include <thread>
 #include <memory>
 #include <vector>
-#include <random>
 #include <sstream>
 #include <filesystem> // C++17 文件系统库
 #include <fstream>
 #include <chrono>     
-#include <numeric>    // 用于计算均值
+#include <atomic>
+#include <mutex>
+#include <iomanip>
+#include "ITask.h"
 #include "LogUtils.h"
+#include "BackupEngine.h"
+#include "MatrixKernel.h"
+#include "StatsEngine.h"
+#include "TaskJournal.h"
+#include "HttpEngine.h"
 
 // === Windows 系统 API ===
 #include <windows.h>
-#include <urlmon.h>   
-
-// 自动链接 urlmon.lib
-#pragma comment(lib, "urlmon.lib")
 
 namespace fs = std::filesystem;
 
-// === 1. 抽象任务接口 ===
-class ITask {
-public:
-    virtual ~ITask() {}
-    virtual void Execute() = 0;
-    virtual std::string GetName() const = 0;
-};
+// === 1. 抽象任务接口 (ITask.h) ===
 
 // === 2. 具体任务实现 ===
 
 // Task A: 文件备份 (纯净版，移除防死锁测试以避免循环依赖)
+// 默认增量备份 scheduler.log：只复制上次备份之后追加的部分 (见 BackupEngine.h)
 class CBackupTask : public ITask {
 public:
+    // sources 为空时备份当前目录下的 scheduler.log；backupDir 为空时使用 D:\Backup (没有 D 盘时 C:\Backup)
+    explicit CBackupTask(std::vector<fs::path> sources = {}, fs::path backupDir = {},
+                         BackupOptions options = BackupOptions())
+        : m_sources(std::move(sources)), m_backupDir(std::move(backupDir)), m_options(options) {}
+
     void Execute() override {
         LogWriter::Instance().Write("Task A [Backup]: 开始执行文件备份...");
 
-        fs::path sourceFile = fs::current_path() / "scheduler.log";
-        fs::path backupDir = "D:\\Backup";
-
-        // 简单的盘符检测
-        std::error_code ec;
-        if (!fs::exists("D:\\", ec)) {
-            backupDir = "C:\\Backup";
-        }
-
-        fs::path targetFile = backupDir / ("backup_" + GetTimestamp() + ".txt");
+        std::vector<fs::path> sources = m_sources;
+        if (sources.empty()) sources.push_back(fs::current_path() / "scheduler.log");
+        fs::path backupDir = m_backupDir.empty() ? DefaultBackupDir() : m_backupDir;
 
         try {
-            if (!fs::exists(backupDir)) {
-                fs::create_directories(backupDir);
-            }
-
-            if (fs::exists(sourceFile)) {
-                fs::copy_file(sourceFile, targetFile, fs::copy_options::overwrite_existing);
-                LogWriter::Instance().Write("Task A [Backup]: 备份成功! 保存至 " + targetFile.string());
+            std::vector<fs::path> existing;
+            for (const auto& source : sources) {
+                std::error_code ec;
+                if (fs::exists(source, ec)) existing.push_back(source);
+                else LogWriter::Instance().Write("Task A [Backup]: 源文件尚未生成，跳过备份。" + source.string());
             }
-            else {
-                LogWriter::Instance().Write("Task A [Backup]: 源文件尚未生成，跳过备份。");
+            if (existing.empty()) return;
+
+            // 异步日志模式下先把队列中的日志落盘，备份才是完整的
+            LogWriter::Instance().Flush();
+
+            // 共享实例可能被并发执行，同一份清单必须串行更新
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_engine || m_engine->Directory() != backupDir) m_engine = std::make_unique<BackupEngine>(backupDir);
+            BackupReport report = m_engine->Run(existing, m_options);
+
+            for (const auto& file : report.files) {
+                std::stringstream ss;
+                ss << "Task A [Backup]: 备份成功! 保存至 " << file.target.string()
+                   << " (复制 " << file.bytesCopied << " / " << file.sourceBytes << " 字节";
+                if (file.bytesDeduped > 0) ss << ", 去重 " << file.bytesDeduped << " 字节";
+                if (file.restarted) ss << ", 源文件已重写, 重新开始";
+                ss << ", " << CopyMethodName(file.method) << ")";
+                LogWriter::Instance().Write(ss.str());
             }
         }
         catch (const std::exception& e) {
@@ -70,75 +80,123 @@ public:
         }
     }
     std::string GetName() const override { return "File Backup Task"; }
+    bool IsBlocking() const override { return true; } // 磁盘 IO
 
 private:
-    std::string GetTimestamp() {
-        auto now = std::time(nullptr);
-        std::stringstream ss;
-        ss << now;
-        return ss.str();
+    static fs::path DefaultBackupDir() {
+        // 简单的盘符检测
+        std::error_code ec;
+        return fs::exists("D:\\", ec) ? fs::path("D:\\Backup") : fs::path("C:\\Backup");
     }
+
+    std::vector<fs::path> m_sources;
+    fs::path m_backupDir;
+    BackupOptions m_options;
+    std::mutex m_mutex;
+    std::unique_ptr<BackupEngine> m_engine;
 };
 
 // Task B: 矩阵计算
+// size: 方阵边长；parallelFor: 非空时大矩阵按行带拆给调度器的工作线程 (如 TaskScheduler::ParallelFor)
 class CMatrixTask : public ITask {
 public:
+    explicit CMatrixTask(size_t size = 200, ParallelForFn parallelFor = nullptr)
+        : m_size(size), m_parallelFor(std::move(parallelFor)) {}
+
     void Execute() override {
-        int size = 200;
-        LogWriter::Instance().Write("Task B [Matrix]: 开始 200x200 矩阵乘法...");
+        std::stringstream begin;
+        begin << "Task B [Matrix]: 开始 " << m_size << "x" << m_size << " 矩阵乘法...";
+        LogWriter::Instance().Write(begin.str());
 
-        std::vector<std::vector<double>> matA(size, std::vector<double>(size, 1.0));
-        std::vector<std::vector<double>> matB(size, std::vector<double>(size, 2.0));
-        std::vector<std::vector<double>> matC(size, std::vector<double>(size, 0.0));
+        Matrix matA(m_size, m_size, 1.0);
+        Matrix matB(m_size, m_size, 2.0);
+        Matrix matC;
+        GemmOptions options;
+        options.parallelFor = m_parallelFor;
 
         auto start = std::chrono::high_resolution_clock::now();
 
-        for (int i = 0; i < size; ++i) {
-            for (int j = 0; j < size; ++j) {
-                for (int k = 0; k < size; ++k) {
-                    matC[i][j] += matA[i][k] * matB[k][j];
-                }
-            }
-        }
+        MatrixMultiply(matA, matB, matC, options);
 
         auto end = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double> diff = end - start;
 
+        double gflops = 2.0 * m_size * m_size * m_size / (diff.count() > 0 ? diff.count() : 1e-9) / 1e9;
         std::stringstream ss;
-        ss << "Task B [Matrix]: 运算完成。耗时: " << diff.count() << " 秒";
+        ss << "Task B [Matrix]: 运算完成。耗时: " << diff.count() << " 秒 ("
+           << SimdLevelName(options.simd) << ", " << gflops << " GFLOP/s)";
         LogWriter::Instance().Write(ss.str());
     }
     std::string GetName() const override { return "Matrix Calc Task"; }
+
+private:
+    size_t m_size;
+    ParallelForFn m_parallelFor;
 };
 
 // Task C: HTTP GET Github
+// 结果进入进程内缓存 (ResultCache.h)：30 秒内重复执行直接使用内存中的结果，过期后带 ETag 重新验证，
+// 同步方式下几个 Task C 同时执行时只发一个请求；只有下载到新内容时才写 zen.txt
+// 同步方式 (默认)：Execute 在阻塞执行器上等待网络
+// 异步方式：配合 TaskScheduler::AddAsyncTask，请求由 HttpEngine 的 IO 线程发出，Execute 只处理已到达的结果
 class CHttpTask : public ITask {
 public:
-    void Execute() override {
-        LogWriter::Instance().Write("Task C [HTTP]: GET https://api.github.com/zen ...");
-
-        std::wstring url = L"https://api.github.com/zen";
-        fs::path savePath = fs::current_path() / "zen.txt";
+    explicit CHttpTask(bool async = false) : m_async(async) {}
+
+    // AddAsyncTask 的 start：结果保存到 task 后调用 done (回调持有 task，任务被取消也不会悬空)
+    static void Prefetch(const std::shared_ptr<CHttpTask>& task, std::function<void()> done) {
+        LogWriter::Instance().Write(std::string("Task C [HTTP]: GET ") + kUrl + " (async) ...");
+        Client().FetchAsync(kUrl, [task, done = std::move(done)](HttpFetchResult&& result) {
+            task->m_prefetched = std::make_unique<HttpFetchResult>(std::move(result));
+            done();
+        });
+    }
 
-        if (fs::exists(savePath)) fs::remove(savePath);
+    void Execute() override {
+        if (m_prefetched) {
+            std::unique_ptr<HttpFetchResult> result = std::move(m_prefetched);
+            Report(*result);
+            return;
+        }
+        LogWriter::Instance().Write(std::string("Task C [HTTP]: GET ") + kUrl + " ...");
+        Report(Client().Fetch(kUrl));
+    }
+    std::string GetName() const override { return "HTTP Request Task"; }
+    bool IsBlocking() const override { return !m_async; } // 同步方式访问源站时等待网络
 
-        HRESULT hr = URLDownloadToFile(NULL, url.c_str(), savePath.c_str(), 0, NULL);
+private:
+    static constexpr const char* kUrl = "https://api.github.com/zen";
 
-        if (hr == S_OK) {
-            std::ifstream f(savePath);
-            std::string content;
-            if (std::getline(f, content)) {
-                LogWriter::Instance().Write("Task C [HTTP]: 请求成功! Github Zen 说: " + content);
-            }
-            else {
-                LogWriter::Instance().Write("Task C [HTTP]: 请求成功 (文件已保存)");
-            }
+    void Report(const HttpFetchResult& result) {
+        if (!result.ok) {
+            LogWriter::Instance().Write("Task C [HTTP]: 请求超时 (Github 可能无法访问)，演示结束。(" + result.error + ")");
+            return;
         }
-        else {
-            LogWriter::Instance().Write("Task C [HTTP]: 请求超时 (Github 可能无法访问)，演示结束。");
+
+        std::string content = result.Body().substr(0, result.Body().find('\n'));
+        const char* source = result.stale ? "源站不可用，使用缓存"
+            : result.fromCache ? "缓存命中"
+            : result.revalidated ? "304 未修改"
+            : "已下载";
+        if (!result.fromCache && !result.revalidated && !result.stale) {
+            std::ofstream f(fs::current_path() / "zen.txt", std::ios::binary | std::ios::trunc);
+            f << result.Body();
         }
+        LogWriter::Instance().Write(std::string("Task C [HTTP]: 请求成功 (") + source + ")! Github Zen 说: " + content);
     }
-    std::string GetName() const override { return "HTTP Request Task"; }
+
+    // 异步传输在第一次使用时才取 HttpEngine::Instance()：引擎晚于 client 构造、先于它析构，
+    // 退出时引擎回调未完成请求不会访问已析构的 client
+    static CachedHttpClient& Client() {
+        static CachedHttpClient client(ResultCache::Instance(), std::chrono::seconds(30), nullptr,
+            [](const std::string& url, const HttpHeaders& headers, HttpCallback done) {
+                HttpEngine::Instance().Fetch(HttpRequest{ url, headers }, std::move(done));
+            });
+        return client;
+    }
+
+    bool m_async;
+    std::unique_ptr<HttpFetchResult> m_prefetched;
 };
 
 // Task D: 课堂提醒
@@ -155,42 +213,47 @@ public:
         LogWriter::Instance().Write("Task D [Reminder]: 用户已确认休息。");
     }
     std::string GetName() const override { return "Classroom Reminder"; }
+    bool IsBlocking() const override { return true; } // 模态对话框等待用户确认
 };
 
 // Task E: 随机数统计
 class CStatsTask : public ITask {
 public:
-    void Execute() override {
-        LogWriter::Instance().Write("Task E [Stats]: 生成 1000 个随机数并计算...");
-
-        std::vector<int> numbers;
-        numbers.reserve(1000);
+    // samples 个 [0, 100] 的随机整数边生成边统计，不落内存；可以取到数十亿
+    explicit CStatsTask(uint64_t samples = 1000, ParallelForFn parallelFor = nullptr)
+        : m_samples(samples), m_parallelFor(std::move(parallelFor)),
+          m_seed(static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())) {}
 
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> dis(0, 100);
-
-        long long sum = 0;
-        for (int i = 0; i < 1000; ++i) {
-            int num = dis(gen);
-            numbers.push_back(num);
-            sum += num;
-        }
+    void Execute() override {
+        std::stringstream begin;
+        begin << "Task E [Stats]: 生成 " << m_samples << " 个随机数并计算...";
+        LogWriter::Instance().Write(begin.str());
 
-        double mean = sum / 1000.0;
+        // 每次执行换一个种子 (共享实例被并发执行时也互不干扰)
+        UniformIntSource source(m_samples, 0, 100, m_seed.fetch_add(0x9E3779B97F4A7C15ull, std::memory_order_relaxed));
+        StatsOptions options;
+        options.parallelFor = m_parallelFor;
 
-        double varianceSum = 0.0;
-        for (int num : numbers) {
-            varianceSum += (num - mean) * (num - mean);
-        }
-        double variance = varianceSum / 1000.0;
+        auto start = std::chrono::high_resolution_clock::now();
+        StatsAccumulator stats = ComputeStats(source, options);
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
 
+        const RunningStats& moments = stats.Moments();
+        double rate = static_cast<double>(moments.count) / (diff.count() > 0 ? diff.count() : 1e-9);
         std::stringstream ss;
         ss << std::fixed << std::setprecision(4);
-        ss << "Task E [Stats]: 均值(Mean) = " << mean << ", 方差(Variance) = " << variance;
+        ss << "Task E [Stats]: 均值(Mean) = " << moments.mean << ", 方差(Variance) = " << moments.Variance()
+           << ", 最小/最大 = " << moments.min << "/" << moments.max
+           << ", P50/P90/P99 = " << stats.Quantile(0.5) << "/" << stats.Quantile(0.9) << "/" << stats.Quantile(0.99)
+           << std::setprecision(0) << " (" << SimdLevelName(options.simd) << ", " << rate << " 样本/秒)";
         LogWriter::Instance().Write(ss.str());
     }
     std::string GetName() const override { return "Random Stats Task"; }
+
+private:
+    uint64_t m_samples;
+    ParallelForFn m_parallelFor;
+    std::atomic<uint64_t> m_seed;
 };
 
 // === 3. 任务枚举 ===
@@ -211,4 +274,37 @@ public:
         default: return nullptr;
         }
     }
+
+    // 共享实例：反复提交时不再每次分配。同一个实例可能同时在多个线程上 Execute，必须能安全地并发执行：
+    // - CStatsTask 的随机种子 m_seed 是原子变量，每次执行取一个新种子
+    // - CBackupTask 的 m_engine 由 m_mutex 保护，同时只有一次备份在运行
+    // - CHttpTask 的预取结果 m_prefetched 只写入 AddAsyncTask 时单独创建的实例，共享实例不会用到
+    // - 其余成员 (CMatrixTask 的尺寸等) 构造后只读
+    static std::shared_ptr<ITask> GetSharedTask(TaskType type) {
+        static const std::shared_ptr<ITask> tasks[] = {
+            CreateTask(TaskType::Backup), CreateTask(TaskType::Matrix), CreateTask(TaskType::Http),
+            CreateTask(TaskType::Reminder), CreateTask(TaskType::Stats)
+        };
+        size_t index = static_cast<size_t>(type);
+        return index < sizeof(tasks) / sizeof(tasks[0]) ? tasks[index] : nullptr;
+    }
+
+    // 持久模式的类型名 (写入日志，改名会使旧日志中的任务无法恢复)
+    static const char* DurableTypeName(TaskType type) {
+        switch (type) {
+        case TaskType::Backup:   return "Backup";
+        case TaskType::Matrix:   return "Matrix";
+        case TaskType::Http:     return "Http";
+        case TaskType::Reminder: return "Reminder";
+        case TaskType::Stats:    return "Stats";
+        default: return "";
+        }
+    }
+
+    // 把五个内置任务登记为持久类型 (没有参数，payload 忽略)
+    static void RegisterDurableTypes(DurableTaskRegistry& registry) {
+        for (TaskType type : { TaskType::Backup, TaskType::Matrix, TaskType::Http, TaskType::Reminder, TaskType::Stats }) {
+            registry.Register(DurableTypeName(type), [type](const std::string&) { return GetSharedTask(type); });
+        }
+    }
 };
\ No newline at end of file
@@ -0,0 +1,118 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: TaskGraph.h
+// 对应需求: 任务依赖图 (DAG)：Then 后继、WhenAll / WhenAny 汇合、整图提交
+// =================================================================================
+#pragma once
+#include "ITask.h"
+#include "LogUtils.h"
+#include "SmallFunction.h"
+#include "NameInterner.h"
+#include "TaskOptions.h"
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 一个待提交的任务体：ITask 对象，或带名字的可调用对象
+// 用法: TaskBody(TaskFactory::GetSharedTask(TaskType::Stats)) 或 TaskBody("Notify", [] { ... })
+struct TaskBody {
+    template <typename T,
+        typename = typename std::enable_if<std::is_base_of<ITask, T>::value>::type>
+    TaskBody(std::shared_ptr<T> task) : task(std::move(task)) {}
+
+    template <typename F,
+        typename = typename std::enable_if<std::is_invocable<typename std::decay<F>::type&>::value>::type>
+    TaskBody(const char* name, F&& fn) : fn(std::forward<F>(fn)), name(name) {}
+
+    // 驻留后的任务名
+    const char* InternName() const {
+        if (task) return task->InternedName();
+        return NameInterner::Instance().Intern(name ? name : "");
+    }
+
+    std::shared_ptr<ITask> task;
+    SmallFunction fn;
+    const char* name = nullptr;   // 只用于可调用对象
+    TaskOptions options;          // 优先级与截止时间
+};
+
+// 任务依赖图构建器：先描述节点与依赖边，再用 TaskScheduler::Submit 一次性提交
+// - 一个节点在它的所有前驱 (WhenAny 节点为任一前驱) 成功结束后立即变为可运行
+// - 没有依赖关系的分支由空闲工作线程并行执行
+// - 前驱失败或被取消时，依赖它的节点 (WhenAny 节点为全部前驱都失败时) 被取消，并继续向下传递
+class TaskGraph {
+public:
+    using NodeId = size_t;
+
+    // 添加一个节点；delayMs 为依赖满足后再延迟多久执行
+    NodeId Add(TaskBody body, int delayMs = 0) {
+        m_nodes.push_back(Node{ std::move(body), delayMs, false, 0, {} });
+        return m_nodes.size() - 1;
+    }
+
+    // 添加依赖边：after 在 before 结束后才运行 (无效编号忽略)
+    TaskGraph& Precede(NodeId before, NodeId after) {
+        if (before < m_nodes.size() && after < m_nodes.size() && before != after) {
+            m_nodes[before].successors.push_back(after);
+            ++m_nodes[after].inDegree;
+        }
+        return *this;
+    }
+
+    // 添加 before 的后继节点
+    NodeId Then(NodeId before, TaskBody body, int delayMs = 0) {
+        NodeId node = Add(std::move(body), delayMs);
+        Precede(before, node);
+        return node;
+    }
+
+    // 汇合节点：所有前驱都成功结束后运行
+    NodeId WhenAll(const std::vector<NodeId>& preds, TaskBody body, int delayMs = 0) {
+        NodeId node = Add(std::move(body), delayMs);
+        for (NodeId pred : preds) Precede(pred, node);
+        return node;
+    }
+
+    // 汇合节点：任一前驱成功结束后运行 (只运行一次)
+    NodeId WhenAny(const std::vector<NodeId>& preds, TaskBody body, int delayMs = 0) {
+        NodeId node = WhenAll(preds, std::move(body), delayMs);
+        m_nodes[node].joinAny = true;
+        return node;
+    }
+
+    size_t Size() const { return m_nodes.size(); }
+
+    // 拓扑排序 (Kahn) 检查是否有环；有环的图不能提交
+    bool IsAcyclic() const {
+        std::vector<int> inDegree(m_nodes.size());
+        std::vector<NodeId> ready;
+        for (NodeId i = 0; i < m_nodes.size(); ++i) {
+            inDegree[i] = m_nodes[i].inDegree;
+            if (inDegree[i] == 0) ready.push_back(i);
+        }
+        size_t visited = 0;
+        while (!ready.empty()) {
+            NodeId node = ready.back();
+            ready.pop_back();
+            ++visited;
+            for (NodeId next : m_nodes[node].successors) {
+                if (--inDegree[next] == 0) ready.push_back(next);
+            }
+        }
+        return visited == m_nodes.size();
+    }
+
+private:
+    friend class TaskScheduler;
+
+    struct Node {
+        TaskBody body;
+        int delayMs;
+        bool joinAny;
+        int inDegree;
+        std::vector<NodeId> successors;
+    };
+
+    std::vector<Node> m_nodes;
+};
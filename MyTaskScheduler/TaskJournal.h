@@ -0,0 +1,609 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: TaskJournal.h
+// 对应需求: 调度状态持久化：任务登记、取消、周期重挂写入追加式日志 (Write-Ahead Journal，组提交)，
+//           定期压缩为快照；启动时由 快照 + 日志尾部 重建任务，错过的周期按策略补跑
+// =================================================================================
+#pragma once
+#include "ITask.h"
+#include "TaskOptions.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// === 1. 文件格式 ===
+// <目录>/snapshot.bin : [快照头 40B] [帧: 登记记录] ...   (压缩时整体重写：先写 .tmp，刷盘后改名)
+// <目录>/journal.bin  : [日志头 24B] [帧] [帧] ...        (只追加，组提交后刷盘；压缩时由 journal.bin.next 改名替换)
+//   帧             : [长度 u32] [校验 u32 (FNV-1a)] [正文]，正文第一个字节为记录类型
+// 日志头的代数 (generation) 与快照头相同时，日志是快照之后的增量；小于快照代数的日志已被压缩，直接丢弃
+// 恢复时读到长度越界或校验不符的帧即视为崩溃时写了一半的尾部，截断后继续追加
+// 整数按本机字节序写入 (与 BinaryLog.h 相同)，时间为墙上时间 (system_clock 毫秒)：单调时钟跨重启没有意义
+
+// 重启时错过的周期执行如何处理
+enum class MissedRunPolicy {
+    Skip,       // 跳过，按原来的相位等下一个周期
+    RunOnce,    // 立即补跑一次，之后按周期继续 (默认)
+    CatchUp     // 错过几次就补跑几次 (不超过 maxCatchUpRuns)，之后按周期继续
+};
+
+struct JournalOptions {
+    std::string directory = "scheduler_state";
+    std::chrono::milliseconds commitInterval{ 5 };  // 组提交窗口：同一窗口内的记录一次写入、一次刷盘
+    bool syncOnCommit = true;                       // 每次组提交后 fdatasync / _commit (关闭则只写入系统缓存)
+    size_t compactEvery = 100000;                   // 快照之后累计多少条日志记录触发压缩
+    MissedRunPolicy missedRuns = MissedRunPolicy::RunOnce;
+    uint32_t maxCatchUpRuns = 100;
+};
+
+// 一个持久任务的完整描述 (快照与登记记录的内容)
+struct DurableTaskRecord {
+    uint64_t key = 0;             // 持久编号 (跨重启不变；TaskId 每次启动都不同)
+    std::string type;             // 任务类型名 (DurableTaskRegistry 中登记)
+    std::string payload;          // 交给工厂的参数 (由使用方自行编码)
+    int64_t nextRunMs = 0;        // 下一次执行的墙上时间 (自 1970 起毫秒)
+    int32_t intervalMs = 0;       // 周期 (0 表示一次性)
+    int32_t deadlineMs = 0;
+    uint8_t priority = static_cast<uint8_t>(TaskPriority::Normal);
+    bool blocking = false;
+    std::string coalesceKey;      // 合并键 (为空表示没有)，恢复后同键的新提交照样与它合并
+};
+
+// 任务类型注册表：类型名 -> 由 payload 重建任务对象的工厂
+using DurableTaskFactory = std::function<std::shared_ptr<ITask>(const std::string& payload)>;
+
+class DurableTaskRegistry {
+public:
+    void Register(const std::string& type, DurableTaskFactory factory) {
+        m_factories[type] = std::move(factory);
+    }
+
+    bool Contains(const std::string& type) const {
+        return m_factories.find(type) != m_factories.end();
+    }
+
+    // 未登记的类型或工厂返回空时返回 nullptr
+    std::shared_ptr<ITask> Create(const std::string& type, const std::string& payload) const {
+        auto it = m_factories.find(type);
+        return (it != m_factories.end() && it->second) ? it->second(payload) : nullptr;
+    }
+
+private:
+    std::map<std::string, DurableTaskFactory> m_factories;
+};
+
+struct JournalStats {
+    size_t recoveredTasks = 0;         // 最近一次打开时恢复出的任务数
+    size_t snapshotRecords = 0;        // 其中来自快照的登记记录数
+    size_t replayedRecords = 0;        // 重放的日志记录数
+    uint64_t truncatedBytes = 0;       // 截断的不完整尾部字节数
+    double recoverSeconds = 0.0;       // 读取并重建记录的耗时 (不含重新提交到调度器)
+    uint64_t recordsWritten = 0;       // 本次打开后写入的日志记录数
+    uint64_t commits = 0;              // 组提交次数 (刷盘次数)
+    uint64_t compactions = 0;
+    uint64_t generation = 0;           // 当前日志代数
+    size_t liveTasks = 0;              // 当前登记中的持久任务数
+    bool failed = false;               // 压缩时新快照已写入但日志无法切换到新一代：记录不再落盘，直到下一次压缩成功
+};
+
+namespace JournalDetail {
+    enum RecordType : uint8_t {
+        kAdd = 1,       // 完整的 DurableTaskRecord
+        kRemove = 2,    // 任务结束或取消
+        kRearm = 3,     // 下一次执行时间改变 (周期重挂、改期)
+        kInterval = 4   // 周期改变
+    };
+
+    constexpr char kSnapshotMagic[8] = { 'M', 'T', 'S', 'S', 'N', 'A', 'P', '1' };
+    constexpr char kJournalMagic[8] = { 'M', 'T', 'S', 'J', 'R', 'N', 'L', '1' };
+    constexpr uint32_t kVersion = 1;
+    constexpr size_t kSnapshotHeaderSize = 40;   // magic, version, reserved, generation, nextKey, count
+    constexpr size_t kJournalHeaderSize = 24;    // magic, version, reserved, generation
+    constexpr uint32_t kMaxFrame = 64 * 1024 * 1024;
+
+    inline uint32_t Checksum(const char* data, size_t size) {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < size; ++i) {
+            h ^= static_cast<unsigned char>(data[i]);
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    template <typename T>
+    void Put(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    inline void PutString(std::string& out, const std::string& text) {
+        Put(out, static_cast<uint32_t>(text.size()));
+        out += text;
+    }
+
+    // 顺序读取正文，越界时 ok 置为 false
+    struct Reader {
+        const char* p;
+        const char* end;
+        bool ok = true;
+
+        template <typename T>
+        T Get() {
+            T value{};
+            if (static_cast<size_t>(end - p) < sizeof(T)) { ok = false; return value; }
+            std::memcpy(&value, p, sizeof(T));
+            p += sizeof(T);
+            return value;
+        }
+
+        std::string GetString() {
+            uint32_t size = Get<uint32_t>();
+            if (!ok || static_cast<size_t>(end - p) < size) { ok = false; return std::string(); }
+            std::string text(p, size);
+            p += size;
+            return text;
+        }
+    };
+
+    // 追加一帧：先占位长度与校验，写完正文后回填
+    template <typename Fn>
+    void AppendFrame(std::string& out, Fn&& body) {
+        const size_t head = out.size();
+        Put(out, uint32_t(0));
+        Put(out, uint32_t(0));
+        body(out);
+        const uint32_t size = static_cast<uint32_t>(out.size() - head - 8);
+        const uint32_t sum = Checksum(out.data() + head + 8, size);
+        std::memcpy(&out[head], &size, 4);
+        std::memcpy(&out[head + 4], &sum, 4);
+    }
+
+    inline void EncodeAdd(std::string& out, const DurableTaskRecord& rec) {
+        AppendFrame(out, [&](std::string& o) {
+            Put(o, kAdd);
+            Put(o, rec.key);
+            Put(o, rec.nextRunMs);
+            Put(o, rec.intervalMs);
+            Put(o, rec.deadlineMs);
+            Put(o, rec.priority);
+            Put(o, static_cast<uint8_t>(rec.blocking ? 1 : 0));
+            PutString(o, rec.type);
+            PutString(o, rec.payload);
+            if (!rec.coalesceKey.empty()) PutString(o, rec.coalesceKey); // 可选尾部字段，旧记录没有
+        });
+    }
+
+    inline bool ReadFile(const std::filesystem::path& path, std::string& data) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        in.seekg(0, std::ios::end);
+        data.resize(static_cast<size_t>(in.tellg()));
+        in.seekg(0, std::ios::beg);
+        in.read(&data[0], static_cast<std::streamsize>(data.size()));
+        return static_cast<bool>(in) || data.empty();
+    }
+
+    // 把缓冲区写穿到磁盘
+    inline bool SyncFile(std::FILE* file) {
+        if (std::fflush(file) != 0) return false;
+#if defined(_WIN32)
+        return _commit(_fileno(file)) == 0;
+#elif defined(__APPLE__)
+        return fsync(fileno(file)) == 0;
+#else
+        return fdatasync(fileno(file)) == 0;
+#endif
+    }
+
+    // 改名之后同步目录项 (POSIX 需要，Windows 没有对应操作)
+    inline void SyncDirectory(const std::filesystem::path& dir) {
+#if !defined(_WIN32)
+        int fd = ::open(dir.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+#else
+        (void)dir;
+#endif
+    }
+
+    // 写临时文件、刷盘、改名覆盖：任何时刻磁盘上都是完整的旧文件或完整的新文件
+    inline bool WriteAtomically(const std::filesystem::path& path, const std::string& data) {
+        std::filesystem::path tmp = path;
+        tmp += ".tmp";
+        std::FILE* file = std::fopen(tmp.string().c_str(), "wb");
+        if (!file) return false;
+        bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size() && SyncFile(file);
+        ok = (std::fclose(file) == 0) && ok;
+        std::error_code ec;
+        if (ok) std::filesystem::rename(tmp, path, ec);
+        if (!ok || ec) {
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        SyncDirectory(path.parent_path());
+        return true;
+    }
+}
+
+// === 2. 日志 ===
+// 调用方 (调度器) 在任意线程追加记录：编码后放入内存批次立即返回，由后台提交线程每个窗口写入并刷盘一次
+// 崩溃时最多丢失最近一个提交窗口内的记录；需要确认落盘时调用 Flush
+class TaskJournal {
+public:
+    TaskJournal() = default;
+    TaskJournal(const TaskJournal&) = delete;
+    TaskJournal& operator=(const TaskJournal&) = delete;
+
+    ~TaskJournal() {
+        Close();
+    }
+
+    // 打开 (不存在则创建) 目录并恢复：recovered 为仍登记中的持久任务，按持久编号排序
+    bool Open(const JournalOptions& options, std::vector<DurableTaskRecord>& recovered) {
+        namespace fs = std::filesystem;
+        Close();
+        const auto begin = std::chrono::steady_clock::now();
+        m_options = options;
+        m_dir = options.directory;
+        std::error_code ec;
+        fs::create_directories(m_dir, ec);
+        if (!fs::is_directory(m_dir)) return false;
+
+        m_live.clear();
+        m_pending.clear();
+        m_pendingCount = 0;
+        m_appendedSeq = m_durableSeq = 0;
+        m_flushRequested = m_compactRequested = false;
+        m_stats = JournalStats();
+        m_nextKey = 1;
+        uint64_t generation = 0;
+
+        // 1. 快照
+        std::string data;
+        if (JournalDetail::ReadFile(m_dir / "snapshot.bin", data)) {
+            if (data.size() < JournalDetail::kSnapshotHeaderSize
+                || std::memcmp(data.data(), JournalDetail::kSnapshotMagic, 8) != 0) {
+                return false; // 快照是原子替换的，损坏说明不是本程序写的文件，不冒险覆盖
+            }
+            JournalDetail::Reader header{ data.data() + 8, data.data() + JournalDetail::kSnapshotHeaderSize };
+            header.Get<uint32_t>();
+            header.Get<uint32_t>();
+            generation = header.Get<uint64_t>();
+            m_nextKey = (std::max)(header.Get<uint64_t>(), uint64_t(1));
+            m_live.reserve(static_cast<size_t>(header.Get<uint64_t>()));
+            m_stats.snapshotRecords = ReplayFrames(data, JournalDetail::kSnapshotHeaderSize);
+        }
+
+        // 2. 日志尾部：与快照同代才重放，截断写了一半的帧
+        const fs::path journalPath = m_dir / "journal.bin";
+        bool reuseJournal = false;
+        if (JournalDetail::ReadFile(journalPath, data) && data.size() >= JournalDetail::kJournalHeaderSize
+            && std::memcmp(data.data(), JournalDetail::kJournalMagic, 8) == 0) {
+            uint64_t journalGeneration = 0;
+            std::memcpy(&journalGeneration, data.data() + 16, 8);
+            if (journalGeneration == generation) {
+                size_t valid = JournalDetail::kJournalHeaderSize;
+                m_stats.replayedRecords = ReplayFrames(data, valid, &valid);
+                m_stats.truncatedBytes = data.size() - valid;
+                if (valid < data.size()) fs::resize_file(journalPath, valid, ec);
+                reuseJournal = !ec;
+            }
+        }
+        m_generation = generation;
+        if (!reuseJournal) {
+            if (!JournalDetail::WriteAtomically(journalPath, JournalHeader(generation))) return false;
+            m_compactRequested = (m_stats.replayedRecords > 0); // 重放过的记录只在内存里，尽快写进快照
+        }
+        m_file = std::fopen(journalPath.string().c_str(), "ab");
+        if (!m_file) return false;
+
+        recovered.clear();
+        recovered.reserve(m_live.size());
+        for (const auto& item : m_live) recovered.push_back(item.second);
+        std::sort(recovered.begin(), recovered.end(),
+            [](const DurableTaskRecord& a, const DurableTaskRecord& b) { return a.key < b.key; });
+        m_recordsSinceSnapshot = m_stats.replayedRecords;
+        m_stats.recoveredTasks = recovered.size();
+        m_stats.generation = m_generation;
+        m_stats.recoverSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        m_stop = false;
+        m_writer = std::thread(&TaskJournal::WriterLoop, this);
+        return true;
+    }
+
+    // 写出剩余批次并关闭文件
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_writer.joinable()) return;
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_writer.join();
+        if (m_file) std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+    bool IsOpen() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_file != nullptr;
+    }
+
+    uint64_t NextKey() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_nextKey++;
+    }
+
+    void LogAdd(const DurableTaskRecord& rec) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        JournalDetail::EncodeAdd(m_pending, rec);
+        m_live[rec.key] = rec;
+        if (rec.key >= m_nextKey) m_nextKey = rec.key + 1;
+        Appended();
+    }
+
+    void LogRemove(uint64_t key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_live.erase(key) == 0) return; // 已经移除 (取消与结束可能先后到达)
+        JournalDetail::AppendFrame(m_pending, [&](std::string& o) {
+            JournalDetail::Put(o, JournalDetail::kRemove);
+            JournalDetail::Put(o, key);
+        });
+        Appended();
+    }
+
+    void LogRearm(uint64_t key, int64_t nextRunMs) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_live.find(key);
+        if (it == m_live.end()) return;
+        it->second.nextRunMs = nextRunMs;
+        JournalDetail::AppendFrame(m_pending, [&](std::string& o) {
+            JournalDetail::Put(o, JournalDetail::kRearm);
+            JournalDetail::Put(o, key);
+            JournalDetail::Put(o, nextRunMs);
+        });
+        Appended();
+    }
+
+    void LogInterval(uint64_t key, int32_t intervalMs) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_live.find(key);
+        if (it == m_live.end()) return;
+        it->second.intervalMs = intervalMs;
+        JournalDetail::AppendFrame(m_pending, [&](std::string& o) {
+            JournalDetail::Put(o, JournalDetail::kInterval);
+            JournalDetail::Put(o, key);
+            JournalDetail::Put(o, intervalMs);
+        });
+        Appended();
+    }
+
+    // 等待此前追加的所有记录落盘
+    void Flush() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_writer.joinable()) return;
+        const uint64_t target = m_appendedSeq;
+        m_flushRequested = true;
+        m_cv.notify_all();
+        m_doneCv.wait(lock, [&] { return m_durableSeq >= target || !m_writer.joinable(); });
+    }
+
+    // 立即压缩：把当前登记中的任务写成新快照，日志从空开始
+    void Compact() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_writer.joinable()) return;
+        const uint64_t target = m_stats.compactions + 1;
+        m_compactRequested = true;
+        m_cv.notify_all();
+        m_doneCv.wait(lock, [&] { return m_stats.compactions >= target || m_stop; });
+    }
+
+    JournalStats GetStats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        JournalStats stats = m_stats;
+        stats.liveTasks = m_live.size();
+        return stats;
+    }
+
+private:
+    static std::string JournalHeader(uint64_t generation) {
+        std::string header(JournalDetail::kJournalMagic, 8);
+        JournalDetail::Put(header, JournalDetail::kVersion);
+        JournalDetail::Put(header, uint32_t(0));
+        JournalDetail::Put(header, generation);
+        return header;
+    }
+
+    // 调用方持有 m_mutex
+    void Appended() {
+        ++m_appendedSeq;
+        ++m_recordsSinceSnapshot;
+        ++m_stats.recordsWritten;
+        if (m_pendingCount++ == 0) m_cv.notify_one();
+    }
+
+    // 依次应用 data[offset...] 中的帧，返回应用的帧数；validEnd 返回最后一个完整帧的结尾
+    size_t ReplayFrames(const std::string& data, size_t offset, size_t* validEnd = nullptr) {
+        size_t applied = 0;
+        while (data.size() - offset >= 8) {
+            uint32_t size = 0, sum = 0;
+            std::memcpy(&size, data.data() + offset, 4);
+            std::memcpy(&sum, data.data() + offset + 4, 4);
+            if (size == 0 || size > JournalDetail::kMaxFrame || data.size() - offset - 8 < size) break;
+            const char* body = data.data() + offset + 8;
+            if (JournalDetail::Checksum(body, size) != sum || !Apply(body, size)) break;
+            offset += 8 + size;
+            ++applied;
+        }
+        if (validEnd) *validEnd = offset;
+        return applied;
+    }
+
+    bool Apply(const char* body, size_t size) {
+        JournalDetail::Reader r{ body, body + size };
+        const uint8_t type = r.Get<uint8_t>();
+        const uint64_t key = r.Get<uint64_t>();
+        if (!r.ok) return false;
+        if (key >= m_nextKey) m_nextKey = key + 1;
+        switch (type) {
+        case JournalDetail::kAdd: {
+            DurableTaskRecord rec;
+            rec.key = key;
+            rec.nextRunMs = r.Get<int64_t>();
+            rec.intervalMs = r.Get<int32_t>();
+            rec.deadlineMs = r.Get<int32_t>();
+            rec.priority = r.Get<uint8_t>();
+            rec.blocking = r.Get<uint8_t>() != 0;
+            rec.type = r.GetString();
+            rec.payload = r.GetString();
+            if (r.p < r.end) rec.coalesceKey = r.GetString();
+            if (!r.ok) return false;
+            m_live[key] = std::move(rec);
+            return true;
+        }
+        case JournalDetail::kRemove:
+            m_live.erase(key);
+            return true;
+        case JournalDetail::kRearm: {
+            int64_t nextRunMs = r.Get<int64_t>();
+            auto it = m_live.find(key);
+            if (r.ok && it != m_live.end()) it->second.nextRunMs = nextRunMs;
+            return r.ok;
+        }
+        case JournalDetail::kInterval: {
+            int32_t intervalMs = r.Get<int32_t>();
+            auto it = m_live.find(key);
+            if (r.ok && it != m_live.end()) it->second.intervalMs = intervalMs;
+            return r.ok;
+        }
+        default:
+            return false;
+        }
+    }
+
+    // 后台提交线程：攒一个窗口的记录，一次写入、一次刷盘；需要时在两次提交之间压缩
+    void WriterLoop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_cv.wait(lock, [this] { return m_stop || m_pendingCount > 0 || m_compactRequested; });
+            if (!m_stop && !m_flushRequested && !m_compactRequested && m_options.commitInterval.count() > 0) {
+                m_cv.wait_for(lock, m_options.commitInterval, [this] { return m_stop || m_flushRequested; });
+            }
+
+            // 在锁内切下批次；需要压缩时同时复制登记表，二者是同一时刻的状态
+            std::string batch;
+            batch.swap(m_pending);
+            const uint64_t seq = m_appendedSeq;
+            m_pendingCount = 0;
+            m_flushRequested = false;
+            const bool compact = m_compactRequested
+                || (m_options.compactEvery > 0 && m_recordsSinceSnapshot >= m_options.compactEvery);
+            std::string snapshot;
+            if (compact) {
+                snapshot = EncodeSnapshotLocked(m_generation + 1);
+                m_recordsSinceSnapshot = 0;
+            }
+            const bool stop = m_stop;
+            lock.unlock();
+
+            if (!batch.empty() && m_file) {
+                std::fwrite(batch.data(), 1, batch.size(), m_file);
+                if (m_options.syncOnCommit) JournalDetail::SyncFile(m_file);
+                else std::fflush(m_file);
+            }
+            bool compacted = compact && Rotate(snapshot);
+
+            lock.lock();
+            if (compact) m_stats.failed = (m_file == nullptr);
+            m_durableSeq = seq;
+            if (!batch.empty()) ++m_stats.commits;
+            if (compact) {
+                m_compactRequested = false;
+                ++m_stats.compactions; // 失败时也计数，让 Compact 的等待返回
+                if (compacted) m_stats.generation = ++m_generation;
+            }
+            m_doneCv.notify_all();
+            if (stop && m_pendingCount == 0) break;
+        }
+    }
+
+    std::string EncodeSnapshotLocked(uint64_t generation) const {
+        std::string out(JournalDetail::kSnapshotMagic, 8);
+        JournalDetail::Put(out, JournalDetail::kVersion);
+        JournalDetail::Put(out, uint32_t(0));
+        JournalDetail::Put(out, generation);
+        JournalDetail::Put(out, m_nextKey);
+        JournalDetail::Put(out, static_cast<uint64_t>(m_live.size()));
+        out.reserve(out.size() + m_live.size() * 64);
+        for (const auto& item : m_live) JournalDetail::EncodeAdd(out, item.second);
+        return out;
+    }
+
+    // 压缩：先写好新一代 (代数 +1) 的空日志 journal.bin.next，再替换快照，最后把新日志改名为 journal.bin
+    // - 前两步失败：磁盘上仍是同代的旧快照 + 旧日志，继续追加旧日志，下次再压缩
+    // - 快照已替换但日志改名失败：旧日志代数较小，再追加的记录恢复时会被忽略，只能停止写入 (m_file 置空)，
+    //   下一次压缩按内存中的登记表重写快照与日志后恢复
+    // 中途崩溃时旧日志代数较小，恢复时被忽略；新快照包含压缩时刻的全部登记，不丢记录
+    bool Rotate(const std::string& snapshot) {
+        uint64_t generation = 0;
+        std::memcpy(&generation, snapshot.data() + 16, 8);
+        const std::filesystem::path journalPath = m_dir / "journal.bin";
+        std::filesystem::path nextPath = journalPath;
+        nextPath += ".next";
+        std::error_code ec;
+        if (!JournalDetail::WriteAtomically(nextPath, JournalHeader(generation))) return false;
+        if (!JournalDetail::WriteAtomically(m_dir / "snapshot.bin", snapshot)) {
+            std::filesystem::remove(nextPath, ec);
+            return false;
+        }
+        if (m_file) std::fclose(m_file);
+        m_file = nullptr;
+        std::filesystem::rename(nextPath, journalPath, ec);
+        if (ec) return false;
+        JournalDetail::SyncDirectory(m_dir);
+        m_file = std::fopen(journalPath.string().c_str(), "ab");
+        return m_file != nullptr;
+    }
+
+    JournalOptions m_options;
+    std::filesystem::path m_dir;
+    std::FILE* m_file = nullptr;        // 只有提交线程写入 (Open / Close 时线程不存在)
+    uint64_t m_generation = 0;
+
+    mutable std::mutex m_mutex;         // 保护以下成员，与调度锁无关
+    std::condition_variable m_cv;       // 唤醒提交线程
+    std::condition_variable m_doneCv;   // 通知 Flush / Compact
+    std::unordered_map<uint64_t, DurableTaskRecord> m_live;   // 当前登记中的持久任务 (压缩时写入快照)
+    std::string m_pending;              // 尚未写入的批次
+    size_t m_pendingCount = 0;
+    uint64_t m_appendedSeq = 0;
+    uint64_t m_durableSeq = 0;
+    size_t m_recordsSinceSnapshot = 0;
+    uint64_t m_nextKey = 1;
+    bool m_flushRequested = false;
+    bool m_compactRequested = false;
+    bool m_stop = false;
+    JournalStats m_stats;
+    std::thread m_writer;
+};
@@ -0,0 +1,140 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: TaskOptions.h
+// 对应需求: 任务优先级与截止时间 (同级内按最早截止时间优先 EDF 分发，老化防饿死)
+// =================================================================================
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// 优先级 (数值越小越优先)
+enum class TaskPriority : int {
+    Critical = 0,   // 延迟敏感 (如界面提醒)
+    High,
+    Normal,         // 默认
+    Low             // 后台批处理 (如统计、备份)
+};
+
+constexpr size_t kTaskPriorityCount = 4;
+
+inline const char* TaskPriorityName(TaskPriority priority) {
+    switch (priority) {
+    case TaskPriority::Critical: return "Critical";
+    case TaskPriority::High:     return "High";
+    case TaskPriority::Normal:   return "Normal";
+    case TaskPriority::Low:      return "Low";
+    default:                     return "Unknown";
+    }
+}
+
+// 任务在哪个工作线程上运行 (CpuTopology.h，配合 AffinityOptions 绑核)
+enum class TaskPlacement : int {
+    Default = 0,    // 工作线程内提交的进入本线程队列，外部提交轮询分配，空闲线程可以窃取 (原行为)
+    SameCore,       // 只在提交它的工作线程 (父任务所在的核) 上运行，不被窃取；周期任务每次都回到同一线程
+    NodeLocal,      // 只由与父任务同一 NUMA 节点的工作线程执行
+    Any             // 总是轮询分配到各工作线程，用于把大量子任务立即铺开
+};
+
+// 同一合并键 (TaskOptions::coalesceKey) 已有任务时，新提交如何处理
+// "待执行" 指尚未开始的任务以及常驻的周期任务；已经开始执行的一次性任务视为 "执行中"
+enum class CoalescePolicy : int {
+    Replace = 0,        // 取消待执行的旧任务，由新任务 (新的任务体、延迟与周期) 接替
+    KeepEarliest,       // 已有待执行的任务时丢弃新提交，保留先到的那个
+    Merge,              // 并入待执行的任务：只执行一次，执行时间取两者中较早的
+    IgnoreWhileRunning  // 同键任务待执行或执行中都丢弃新提交 (同一时间最多一个)
+};
+
+// 提交任务时的可选参数
+struct TaskOptions {
+    TaskPriority priority = TaskPriority::Normal;
+    int deadlineMs = 0;   // 每次到期后必须在多少毫秒内执行完 (0 表示没有截止时间)
+    bool blocking = false; // 阻塞 / IO 任务，由弹性线程池执行 (ITask 也可通过 IsBlocking 声明)
+    TaskPlacement placement = TaskPlacement::Default;
+    const char* limitKey = nullptr; // 限流键 (TaskScheduler::SetRateLimit)，为空时使用任务名
+    // 合并键：同键的重复提交在提交时按 coalesce 合并，不会进入工作线程 (为空时不合并)
+    // 对 AddTask / AddTasks / AddDurableTask / Spawn / AddAsyncTask / AddFetchTask 有效，被合并掉的提交返回保留下来的那个任务的句柄；
+    // 依赖图与后继 (Submit(TaskGraph) / WhenAll / WhenAny / Then) 忽略它：这些节点由前驱放行，合并掉会让依赖关系落空
+    const char* coalesceKey = nullptr;
+    CoalescePolicy coalesce = CoalescePolicy::Replace;
+};
+
+// 把 count 个互不相关的子任务分给若干线程执行并等待全部完成 (例如 TaskScheduler::ParallelFor)
+// 计算内核 (矩阵、统计) 通过它使用调度器的工作线程，而不直接依赖调度器
+using ParallelForFn = std::function<void(size_t count, const std::function<void(size_t)>& body)>;
+
+// 调度器的优先级策略
+struct PriorityOptions {
+    // 老化 (Aging)：就绪任务每多等待 agingStep，有效优先级提升一级 (0 表示关闭)
+    std::chrono::milliseconds agingStep{ 200 };
+    // 没有截止时间的任务在同级 EDF 排序中使用的隐含期限 (到期时刻 + 该值)
+    std::chrono::milliseconds implicitDeadline[kTaskPriorityCount] = {
+        std::chrono::milliseconds(10), std::chrono::milliseconds(100),
+        std::chrono::milliseconds(1000), std::chrono::milliseconds(10000)
+    };
+};
+
+// 工作线程绑核方式
+enum class WorkerPinning : int {
+    None = 0,   // 不绑核，由操作系统调度 (默认；此时所有工作线程视为同一个节点)
+    Core,       // 每个工作线程绑定一个逻辑 CPU
+    Node        // 每个工作线程绑定到其 CPU 所在 NUMA 节点的全部 CPU
+};
+
+// 调度器的 CPU 亲和性策略，在 Start 之前设置
+struct AffinityOptions {
+    WorkerPinning pinning = WorkerPinning::None;
+    // 工作线程依次使用的逻辑 CPU (线程数更多时循环使用)；为空时按 CpuTopology::PlacementOrder，
+    // 先占满各物理核再使用超线程兄弟，并在各节点之间交替
+    std::vector<int> cpus;
+    int timerCpu = -1;  // 定时线程绑定的逻辑 CPU (-1 表示不绑)
+};
+
+// 调度器满载 (持有的任务达到 AdmissionOptions::capacity) 时如何处理新提交的任务
+enum class OverloadPolicy : int {
+    Block = 0,      // 提交线程等待空位 (可设超时)；工作线程内提交不能等待 (会死锁)，直接拒绝
+    Reject,         // 拒绝新任务：提交函数返回无效句柄
+    DropOldest,     // 取消最早接纳、尚未开始执行的一次性任务，为新任务腾出位置
+    ShedByPriority  // 取消优先级低于新任务的最早接纳的未执行任务 (从最低一级开始)；没有更低优先级的任务时拒绝新任务
+};
+
+// 准入控制：限制调度器同时持有的任务数，过载时排队时延有上界而不是无限增长
+// 计入容量的是 AddTask / AddTasks / AddDurableTask / Spawn 接纳的任务 (等待、就绪、运行中)；
+// 后继任务、依赖图与 ParallelFor 的帮手任务由已接纳的任务派生，不做准入检查
+struct AdmissionOptions {
+    size_t capacity = 0;                          // 0 表示不限制 (原行为)
+    OverloadPolicy policy = OverloadPolicy::Reject;
+    std::chrono::milliseconds blockTimeout{ 0 };  // Block 最长等待，超时后拒绝 (0 表示一直等待)
+};
+
+// 准入统计快照
+struct AdmissionStats {
+    size_t capacity = 0;
+    size_t held = 0;                    // 当前持有的已接纳任务
+    size_t peakHeld = 0;                // 持有数的峰值
+    size_t readyDepth = 0;              // 就绪队列中等待工作线程的任务
+    unsigned long long admitted = 0;
+    unsigned long long rejected = 0;    // 被拒绝的提交 (包括 Block 超时)
+    unsigned long long dropped = 0;     // 为新任务腾位置而被取消的任务 (DropOldest / ShedByPriority)
+    unsigned long long blockedWaits = 0; // Block 策略下提交线程等待的次数
+};
+
+// 合并键统计快照
+struct CoalesceStats {
+    size_t keys = 0;                    // 当前登记中的合并键
+    size_t internedKeys = 0;            // 调度器键表中的合并键与限流键 (不再被任务或限流设置引用时删除)
+    unsigned long long submitted = 0;   // 带合并键的提交
+    unsigned long long replaced = 0;    // Replace：被新提交取消的旧任务
+    unsigned long long kept = 0;        // KeepEarliest / IgnoreWhileRunning：被丢弃的新提交
+    unsigned long long merged = 0;      // Merge：并入已有任务的新提交
+};
+
+// 单个优先级的统计快照
+struct PriorityClassStats {
+    unsigned long long executed = 0;        // 执行次数
+    unsigned long long withDeadline = 0;    // 其中带截止时间的次数
+    unsigned long long deadlineMisses = 0;  // 执行完成时已超过截止时间的次数
+    unsigned long long agedPromotions = 0;  // 因老化越过更高优先级被先调度的次数
+    long long maxLatenessUs = 0;            // 最大超时 (微秒)
+};
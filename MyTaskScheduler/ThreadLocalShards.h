@@ -0,0 +1,85 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: ThreadLocalShards.h
+// 对应需求: 按线程分片的注册表 (SchedulerMetrics 的统计分片与 TraceRecorder 的事件缓冲共用)：
+//           每个线程第一次写入时领取一个分片并缓存在 thread_local 中，之后的写入不加锁；线程退出后分片留给新线程接手
+// =================================================================================
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Shard 只由领取它的线程写入；读取方在注册锁内遍历全部分片 (包括已退出线程留下的)
+// 注册锁由使用方提供，以便在同一把锁内维护与分片相关的其他状态 (基线、事件块列表等)
+template <typename Shard>
+class ThreadLocalShards {
+public:
+    ThreadLocalShards() : m_instance(NextInstanceId()) {}
+
+    ThreadLocalShards(const ThreadLocalShards&) = delete;
+    ThreadLocalShards& operator=(const ThreadLocalShards&) = delete;
+
+    // 当前线程的分片：第一次调用时在 registryMutex 内领取 (优先复用已退出线程留下的分片)，
+    // 领取后仍在锁内调用 onClaim(shard)；之后的调用只比较一次实例编号
+    template <typename OnClaim>
+    Shard& Local(std::mutex& registryMutex, OnClaim&& onClaim) {
+        Slot& slot = CurrentSlot();
+        if (slot.owner == m_instance) return slot.entry->shard;
+
+        if (slot.entry) slot.entry->inUse.store(false);
+        std::lock_guard<std::mutex> lock(registryMutex);
+        slot.entry.reset();
+        for (auto& entry : m_entries) {
+            bool idle = false;
+            if (entry->inUse.compare_exchange_strong(idle, true)) {
+                slot.entry = entry;
+                break;
+            }
+        }
+        if (!slot.entry) {
+            m_entries.push_back(std::make_shared<Entry>());
+            slot.entry = m_entries.back();
+        }
+        onClaim(slot.entry->shard);
+        slot.owner = m_instance;
+        return slot.entry->shard;
+    }
+
+    Shard& Local(std::mutex& registryMutex) {
+        return Local(registryMutex, [](Shard&) {});
+    }
+
+    // 遍历所有分片 (调用方持有注册锁)
+    template <typename Fn>
+    void ForEachLocked(Fn&& fn) const {
+        for (const auto& entry : m_entries) fn(static_cast<const Shard&>(entry->shard));
+    }
+
+private:
+    struct Entry {
+        Shard shard;
+        std::atomic<bool> inUse{ true };   // 所属线程退出后置为 false，由之后的新线程接手 (分片内容保留)
+    };
+
+    // 每个线程只缓存最近使用的一个实例的分片 (同一类型通常只有一个实例，换实例时归还旧分片)
+    struct Slot {
+        uint64_t owner = 0;
+        std::shared_ptr<Entry> entry;
+        ~Slot() { if (entry) entry->inUse.store(false); }
+    };
+
+    static uint64_t NextInstanceId() {
+        static std::atomic<uint64_t> next{ 1 };
+        return next.fetch_add(1);
+    }
+
+    static Slot& CurrentSlot() {
+        thread_local Slot slot;
+        return slot;
+    }
+
+    const uint64_t m_instance;
+    std::vector<std::shared_ptr<Entry>> m_entries;
+};
@@ -0,0 +1,301 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: TimingWheel.h
+// 对应需求: 分层时间轮 (Hierarchical Timing Wheel)，替代 std::priority_queue 定时堆
+// =================================================================================
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <limits>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// === 1. 侵入式定时节点 ===
+// 挂在时间轮上的对象需要继承 TimerNode
+// 节点自带前后指针，插入/删除不做任何内存分配，删除为 O(1)
+struct TimerNode {
+    TimerNode* timerPrev = nullptr;
+    TimerNode* timerNext = nullptr;
+    uint64_t expireTick = 0;   // 到期刻度 (绝对值)
+    int16_t wheelLevel = -1;   // 所在层 (-1 表示不在时间轮上)
+    uint16_t wheelSlot = 0;    // 所在槽
+
+    bool IsLinked() const { return wheelLevel >= 0; }
+};
+
+// === 2. 分层时间轮 ===
+// 结构 (与 Linux 内核经典 timer wheel 相同):
+// - 第 0 层 256 槽，每槽 1 tick
+// - 第 1~3 层各 64 槽，每层槽宽依次放大 64 倍
+// - 超出范围 (2^26 tick，1ms 刻度下约 18.6 小时) 的节点放入溢出链表 (Overflow)
+// 插入 O(1)；推进时每个节点最多被级联 (Cascade) 4 次，均摊 O(1)
+// 空槽用位图跳过：一次推进只访问非空的第 0 层槽，外加每转过一圈 (256 tick) 一次级联，
+// 成本取决于到期节点数与经过的圈数，而不是经过的 tick 数
+// 时间轮为空时调用方不必调用 Advance (调度器的定时线程此时在休眠)，m_current 停在最后处理的刻度，
+// 空闲期间没有任何开销；空闲之后的第一次 Advance 补走这段时间的圈数 (每圈一次位图检查与级联)
+// 注意: 本类不加锁，由调用方保证线程安全
+class TimingWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr uint64_t kNoTick = std::numeric_limits<uint64_t>::max();
+
+    explicit TimingWheel(Clock::duration tick = std::chrono::milliseconds(1))
+        : m_tick(tick.count() > 0 ? tick : Clock::duration(1)), m_epoch(Clock::now()) {
+        for (int i = 0; i < kLevel0Slots; ++i) InitSentinel(m_level0[i]);
+        for (int l = 0; l < kUpperLevels; ++l) {
+            for (int i = 0; i < kLevelNSlots; ++i) InitSentinel(m_levelN[l][i]);
+        }
+        InitSentinel(m_overflow);
+    }
+
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    // 刻度长度只能在时间轮为空时修改
+    bool SetTick(Clock::duration tick) {
+        if (m_size != 0 || tick.count() <= 0) return false;
+        m_epoch = Clock::now();
+        m_tick = tick;
+        m_current = 0;
+        return true;
+    }
+
+    Clock::duration GetTick() const { return m_tick; }
+    size_t Size() const { return m_size; }
+    bool Empty() const { return m_size == 0; }
+
+    // 时间点 -> 刻度。到期刻度向上取整，保证节点不会早于 runTime 触发
+    uint64_t TickOf(Clock::time_point tp, bool roundUp = false) const {
+        if (tp <= m_epoch) return 0;
+        auto elapsed = (tp - m_epoch).count();
+        auto tick = m_tick.count();
+        return static_cast<uint64_t>(roundUp ? (elapsed + tick - 1) / tick : elapsed / tick);
+    }
+
+    Clock::time_point TimeOfTick(uint64_t tick) const {
+        return m_epoch + m_tick * static_cast<Clock::rep>(tick);
+    }
+
+    // 插入节点，到期时间为 runTime (已过期的节点会在下一次 Advance 时立即到期)
+    void Add(TimerNode* node, Clock::time_point runTime) {
+        node->expireTick = TickOf(runTime, true);
+        Place(node);
+        ++m_size;
+    }
+
+    // O(1) 摘除 (Cancel / Reschedule 使用)
+    void Remove(TimerNode* node) {
+        if (!node->IsLinked()) return;
+        Unlink(node);
+        --m_size;
+    }
+
+    // 推进到 nowTick (含)，所有到期节点按到期刻度顺序交给 onExpire
+    // onExpire 被调用时节点已经从时间轮摘除；在 onExpire 中重新 Add 时，到期时间必须落在之后的刻度上：
+    // 已到期 (到期刻度不晚于正在处理的刻度) 的节点会被放回正在清空的槽，Advance 将一直循环不返回
+    // 需要立即再次到期的节点应先收集起来，在 Advance 返回后再 Add
+    template <typename Fn>
+    void Advance(uint64_t nowTick, Fn&& onExpire) {
+        while (m_current <= nowTick) {
+            const uint64_t index = m_current & kLevel0Mask;
+            if (index == 0) Cascade();
+
+            // 在本轮第 0 层中寻找下一个非空槽
+            int next = FindNextSet(m_level0Bits, kLevel0Words, static_cast<int>(index));
+            if (next < 0) {
+                uint64_t boundary = (m_current | kLevel0Mask) + 1;
+                if (boundary > nowTick) { m_current = nowTick + 1; break; }
+                m_current = boundary;
+                continue;
+            }
+            uint64_t slotTick = (m_current & ~kLevel0Mask) + static_cast<uint64_t>(next);
+            if (slotTick > nowTick) { m_current = nowTick + 1; break; }
+
+            m_current = slotTick;
+            TimerNode& head = m_level0[next];
+            while (head.timerNext != &head) {
+                TimerNode* node = head.timerNext;
+                Unlink(node);
+                --m_size;
+                onExpire(node);
+            }
+            ++m_current;
+        }
+    }
+
+    // 下一次需要推进的刻度 (定时线程据此休眠)
+    // 对高层槽返回其级联时刻，这是真实到期时间的下界，醒来后会重新计算
+    uint64_t NextWakeTick() const {
+        if (m_size == 0) return kNoTick;
+
+        const uint64_t index = m_current & kLevel0Mask;
+        if (index == 0) return m_current; // 停在一圈的起点，级联尚未执行
+        int next = FindNextSet(m_level0Bits, kLevel0Words, static_cast<int>(index));
+        if (next >= 0) return (m_current & ~kLevel0Mask) + static_cast<uint64_t>(next);
+
+        // 低于当前游标的第 0 层槽属于下一圈，先在本圈终点醒来
+        uint64_t best = kNoTick;
+        for (int w = 0; w < kLevel0Words; ++w) {
+            if (m_level0Bits[w]) { best = (m_current | kLevel0Mask) + 1; break; }
+        }
+        for (int l = 0; l < kUpperLevels; ++l) {
+            if (m_levelNBits[l] == 0) continue;
+            const int shift = kLevel0Bits + kLevelNBits * l;
+            const uint64_t block = m_current >> shift;
+            const int curIdx = static_cast<int>(block & kLevelNMask);
+            for (int d = 1; d <= kLevelNSlots; ++d) {
+                if (m_levelNBits[l] & (1ULL << ((curIdx + d) & kLevelNMask))) {
+                    uint64_t t = (block + static_cast<uint64_t>(d)) << shift;
+                    if (t < best) best = t;
+                    break;
+                }
+            }
+        }
+        if (m_overflow.timerNext != &m_overflow) {
+            const int shift = kLevel0Bits + kLevelNBits * kUpperLevels;
+            uint64_t t = ((m_current >> shift) + 1) << shift;
+            if (t < best) best = t;
+        }
+        return best;
+    }
+
+    // 清空时间轮，逐个回调节点 (用于 Stop 时释放)
+    template <typename Fn>
+    void Clear(Fn&& onNode) {
+        auto drain = [&](TimerNode& head) {
+            while (head.timerNext != &head) {
+                TimerNode* node = head.timerNext;
+                Unlink(node);
+                onNode(node);
+            }
+        };
+        for (auto& head : m_level0) drain(head);
+        for (auto& level : m_levelN) for (auto& head : level) drain(head);
+        drain(m_overflow);
+        m_size = 0;
+    }
+
+private:
+    static constexpr int kLevel0Bits = 8;
+    static constexpr int kLevelNBits = 6;
+    static constexpr int kUpperLevels = 3;
+    static constexpr int kLevel0Slots = 1 << kLevel0Bits;
+    static constexpr int kLevelNSlots = 1 << kLevelNBits;
+    static constexpr uint64_t kLevel0Mask = kLevel0Slots - 1;
+    static constexpr uint64_t kLevelNMask = kLevelNSlots - 1;
+    static constexpr int kLevel0Words = kLevel0Slots / 64;
+    static constexpr int16_t kOverflowLevel = kUpperLevels + 1;
+
+    static void InitSentinel(TimerNode& head) {
+        head.timerPrev = &head;
+        head.timerNext = &head;
+    }
+
+    static int CountTrailingZeros(uint64_t v) {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanForward64(&idx, v);
+        return static_cast<int>(idx);
+#else
+        return __builtin_ctzll(v);
+#endif
+    }
+
+    // 在位图中查找 >= from 的第一个置位
+    static int FindNextSet(const uint64_t* bits, int words, int from) {
+        int w = from >> 6;
+        if (w >= words) return -1;
+        uint64_t cur = bits[w] & (~0ULL << (from & 63));
+        while (true) {
+            if (cur) return (w << 6) + CountTrailingZeros(cur);
+            if (++w >= words) return -1;
+            cur = bits[w];
+        }
+    }
+
+    // 根据到期刻度与当前刻度的距离选择层与槽
+    void Place(TimerNode* node) {
+        if (node->expireTick < m_current) node->expireTick = m_current;
+        const uint64_t delta = node->expireTick - m_current;
+
+        if (delta < kLevel0Slots) {
+            int slot = static_cast<int>(node->expireTick & kLevel0Mask);
+            Append(m_level0[slot], node, 0, slot);
+            m_level0Bits[slot >> 6] |= 1ULL << (slot & 63);
+            return;
+        }
+        for (int l = 0; l < kUpperLevels; ++l) {
+            const int shift = kLevel0Bits + kLevelNBits * l;
+            if (delta < (1ULL << (shift + kLevelNBits))) {
+                int slot = static_cast<int>((node->expireTick >> shift) & kLevelNMask);
+                Append(m_levelN[l][slot], node, static_cast<int16_t>(l + 1), slot);
+                m_levelNBits[l] |= 1ULL << slot;
+                return;
+            }
+        }
+        Append(m_overflow, node, kOverflowLevel, 0);
+    }
+
+    static void Append(TimerNode& head, TimerNode* node, int16_t level, int slot) {
+        node->timerPrev = head.timerPrev;
+        node->timerNext = &head;
+        head.timerPrev->timerNext = node;
+        head.timerPrev = node;
+        node->wheelLevel = level;
+        node->wheelSlot = static_cast<uint16_t>(slot);
+    }
+
+    void Unlink(TimerNode* node) {
+        node->timerPrev->timerNext = node->timerNext;
+        node->timerNext->timerPrev = node->timerPrev;
+
+        // 槽变空时清除位图
+        const int level = node->wheelLevel;
+        const int slot = node->wheelSlot;
+        if (level == 0 && m_level0[slot].timerNext == &m_level0[slot]) {
+            m_level0Bits[slot >> 6] &= ~(1ULL << (slot & 63));
+        }
+        else if (level >= 1 && level <= kUpperLevels
+            && m_levelN[level - 1][slot].timerNext == &m_levelN[level - 1][slot]) {
+            m_levelNBits[level - 1] &= ~(1ULL << slot);
+        }
+        node->timerPrev = node->timerNext = nullptr;
+        node->wheelLevel = -1;
+    }
+
+    // 把 head 链表整体摘下并按当前刻度重新放置
+    void Redistribute(TimerNode& head, int level, int slot) {
+        TimerNode* node = head.timerNext;
+        InitSentinel(head);
+        if (level >= 1 && level <= kUpperLevels) m_levelNBits[level - 1] &= ~(1ULL << slot);
+        while (node != &head) {
+            TimerNode* next = node->timerNext;
+            Place(node);
+            node = next;
+        }
+    }
+
+    // 第 0 层转完一圈时，把上层对应槽的节点下放
+    void Cascade() {
+        for (int l = 0; l < kUpperLevels; ++l) {
+            const int shift = kLevel0Bits + kLevelNBits * l;
+            const int slot = static_cast<int>((m_current >> shift) & kLevelNMask);
+            Redistribute(m_levelN[l][slot], l + 1, slot);
+            if (slot != 0) return;
+        }
+        Redistribute(m_overflow, kOverflowLevel, 0);
+    }
+
+    Clock::duration m_tick;
+    Clock::time_point m_epoch;
+    uint64_t m_current = 0;   // 下一个待处理的刻度
+    size_t m_size = 0;
+
+    TimerNode m_level0[kLevel0Slots];
+    TimerNode m_levelN[kUpperLevels][kLevelNSlots];
+    TimerNode m_overflow;
+    uint64_t m_level0Bits[kLevel0Words] = {};
+    uint64_t m_levelNBits[kUpperLevels] = {};
+};
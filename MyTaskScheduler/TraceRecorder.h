@@ -0,0 +1,363 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: TraceRecorder.h
+// 对应需求: 调度时间线追踪：记录任务的提交、就绪、出队、开始与结束 (单调时钟 + 线程)，
+//           导出 Chrome trace-event JSON，可直接在 chrome://tracing 或 Perfetto 中打开
+// =================================================================================
+#pragma once
+#include "ThreadLocalShards.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 追踪参数 (可在运行中修改)
+struct TraceOptions {
+    bool enabled = false;
+    uint32_t sampleEvery = 1;        // 每 N 个任务追踪 1 个 (按任务编号取样，同一任务的事件全部保留或全部跳过)
+    size_t bufferEvents = 1 << 20;   // 事件缓冲上限 (约 40 字节 / 事件)，写满后覆盖最旧的事件 (飞行记录器)
+    std::string dumpOnStopPath;      // 非空时 Stop 会把追踪写入该文件
+};
+
+enum class TraceEventType : uint8_t {
+    Submit,     // 提交 (arg 为延迟毫秒)
+    Ready,      // 进入就绪队列 (提交即就绪、时间轮到期、依赖满足、协程恢复)
+    Dequeue,    // 被工作线程 / 弹性线程取出并领取
+    Start,      // 开始执行
+    End         // 执行结束 (flags 见 TraceEndFlags)
+};
+
+enum TraceEndFlags : uint8_t {
+    kTraceEndFailed = 1,   // 抛出异常
+    kTraceEndParked = 2    // 协程在 co_await 处挂起 (本次运行片段结束)
+};
+
+struct TraceEvent {
+    int64_t ns;             // 距记录器起点的纳秒数
+    uint64_t taskId;
+    const char* name;       // 驻留的任务名 (NameInterner，生命期与进程相同)
+    int32_t arg;
+    TraceEventType type;
+    uint8_t flags;
+};
+
+// 事件块：只有所属线程追加，count 以 release 发布，读线程以 acquire 读取后即可安全读取前 count 个事件
+// 写满的块在记录器的锁内移交给已满列表，只有在锁内才会被回收复用，所以导出时不会读到被覆盖的事件
+struct TraceChunk {
+    static constexpr uint32_t kEvents = 1024;
+    uint32_t thread = 0;                 // 写入线程的序号 (导出为 tid)
+    std::atomic<uint32_t> count{ 0 };
+    TraceEvent events[kEvents];
+};
+
+class TraceRecorder {
+public:
+    TraceRecorder() : m_epoch(std::chrono::steady_clock::now()) {}
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    void SetOptions(const TraceOptions& options) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_options = options;
+        m_maxChunks = (std::max)(options.bufferEvents / TraceChunk::kEvents, size_t(1));
+        m_sampleEvery.store((std::max)(options.sampleEvery, uint32_t(1)), std::memory_order_relaxed);
+        m_enabled.store(options.enabled, std::memory_order_relaxed);
+    }
+
+    TraceOptions GetOptions() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_options;
+    }
+
+    bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    // 该任务是否被取样 (乘法散列后取模，编号相邻的任务也能均匀取样)
+    bool Sampled(uint64_t taskId) const {
+        uint32_t every = m_sampleEvery.load(std::memory_order_relaxed);
+        return every <= 1 || ((taskId * 0x9E3779B97F4A7C15ull) >> 32) % every == 0;
+    }
+
+    // 记录一个事件 (调用方已检查 IsEnabled 与 Sampled)：热路径只写本线程的事件块，每 1024 个事件加一次记录器的锁
+    void Record(TraceEventType type, uint64_t taskId, const char* name, int32_t arg = 0, uint8_t flags = 0) {
+        const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - m_epoch).count();
+        ThreadBuffer& buffer = LocalBuffer();
+        TraceChunk* chunk = buffer.current;
+        uint32_t n = chunk->count.load(std::memory_order_relaxed);
+        if (n == TraceChunk::kEvents) {
+            chunk = NextChunk(buffer);
+            n = 0;
+        }
+        TraceEvent& ev = chunk->events[n];
+        ev.ns = ns;
+        ev.taskId = taskId;
+        ev.name = name;
+        ev.arg = arg;
+        ev.type = type;
+        ev.flags = flags;
+        chunk->count.store(n + 1, std::memory_order_release);
+    }
+
+    // 给当前线程起名 (导出为 thread_name，如 "Worker 3")，在线程第一次记录之前调用
+    static void SetThreadLabel(const char* label, int index = -1) {
+        ThreadLabel& t = CurrentLabel();
+        t.label = label;
+        t.index = index;
+    }
+
+    // 丢弃此前的事件 (写线程不停：只记下时刻，导出时跳过更早的事件)
+    void Clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_clearNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - m_epoch).count();
+        m_dropped = 0;
+    }
+
+    // 已写入缓冲的事件数与因缓冲写满被覆盖的事件数
+    size_t EventCount() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return CollectLocked().size();
+    }
+
+    uint64_t DroppedEvents() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_dropped;
+    }
+
+    // 导出 Chrome trace-event JSON (Object 格式)：
+    // - 每次执行是所在线程上的一个完整片段 (ph "X")，参数带任务编号与结果
+    // - 就绪 -> 出队的排队等待是按任务编号配对的异步片段 (ph "b"/"e"，cat "queue")
+    // - 提交与就绪是所在线程上的瞬时事件 (ph "i")
+    std::string ToJson() const {
+        std::vector<Collected> events;
+        std::vector<std::string> threads;
+        uint64_t dropped = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            events = CollectLocked();
+            threads = m_threadNames;
+            dropped = m_dropped;
+        }
+        std::stable_sort(events.begin(), events.end(),
+            [](const Collected& a, const Collected& b) { return a.ev.ns < b.ev.ns; });
+
+        std::string out;
+        out.reserve(events.size() * 128 + 1024);
+        out += "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"producer\":\"MyTaskScheduler\",\"droppedEvents\":";
+        out += std::to_string(dropped);
+        out += "},\"traceEvents\":[\n";
+        out += "{\"ph\":\"M\",\"pid\":1,\"tid\":0,\"name\":\"process_name\",\"args\":{\"name\":\"MyTaskScheduler\"}}";
+        for (size_t i = 0; i < threads.size(); ++i) {
+            out += ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(i + 1) +
+                ",\"name\":\"thread_name\",\"args\":{\"name\":\"" + Escape(threads[i].c_str()) + "\"}}";
+            out += ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(i + 1) +
+                ",\"name\":\"thread_sort_index\",\"args\":{\"sort_index\":" + std::to_string(i + 1) + "}}";
+        }
+
+        struct Pending { int64_t ns; uint32_t thread; };
+        std::unordered_map<uint64_t, Pending> ready;                // 任务编号 -> 就绪时刻
+        std::unordered_map<uint32_t, std::vector<const Collected*>> running; // 线程 -> 未结束的开始事件
+        char line[256];
+        for (const Collected& c : events) {
+            const TraceEvent& ev = c.ev;
+            const std::string name = Escape(ev.name);
+            switch (ev.type) {
+            case TraceEventType::Submit:
+                std::snprintf(line, sizeof(line),
+                    ",\n{\"ph\":\"i\",\"s\":\"t\",\"cat\":\"submit\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"name\":\"submit\","
+                    "\"args\":{\"id\":\"0x%llx\",\"delay_ms\":%d,\"task\":\"",
+                    c.thread, Micros(ev.ns), static_cast<unsigned long long>(ev.taskId), ev.arg);
+                out += line;
+                out += name + "\"}}";
+                break;
+            case TraceEventType::Ready:
+                ready[ev.taskId] = Pending{ ev.ns, c.thread };
+                break;
+            case TraceEventType::Dequeue: {
+                auto it = ready.find(ev.taskId);
+                if (it == ready.end()) break; // 就绪事件在缓冲回绕时丢失
+                std::snprintf(line, sizeof(line),
+                    ",\n{\"ph\":\"b\",\"cat\":\"queue\",\"id\":\"0x%llx\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"name\":\"",
+                    static_cast<unsigned long long>(ev.taskId), it->second.thread, Micros(it->second.ns));
+                out += line;
+                out += name + "\"}";
+                std::snprintf(line, sizeof(line),
+                    ",\n{\"ph\":\"e\",\"cat\":\"queue\",\"id\":\"0x%llx\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"name\":\"",
+                    static_cast<unsigned long long>(ev.taskId), c.thread, Micros(ev.ns));
+                out += line;
+                out += name + "\"}";
+                ready.erase(it);
+                break;
+            }
+            case TraceEventType::Start:
+                running[c.thread].push_back(&c);
+                break;
+            case TraceEventType::End: {
+                auto& stack = running[c.thread];
+                if (stack.empty() || stack.back()->ev.taskId != ev.taskId) break; // 开始事件已被覆盖
+                const TraceEvent& start = stack.back()->ev;
+                stack.pop_back();
+                const char* result = (ev.flags & kTraceEndFailed) ? "failed"
+                    : (ev.flags & kTraceEndParked) ? "parked" : "ok";
+                std::snprintf(line, sizeof(line),
+                    ",\n{\"ph\":\"X\",\"cat\":\"task\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                    "\"args\":{\"id\":\"0x%llx\",\"result\":\"%s\"},\"name\":\"",
+                    c.thread, Micros(start.ns), Micros(ev.ns - start.ns),
+                    static_cast<unsigned long long>(ev.taskId), result);
+                out += line;
+                out += name + "\"}";
+                break;
+            }
+            }
+        }
+        // 导出时仍在执行的任务：只有开始事件 (ph "B")，查看器中显示为未结束
+        for (const auto& item : running) {
+            for (const Collected* c : item.second) {
+                std::snprintf(line, sizeof(line),
+                    ",\n{\"ph\":\"B\",\"cat\":\"task\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"id\":\"0x%llx\"},\"name\":\"",
+                    c->thread, Micros(c->ev.ns), static_cast<unsigned long long>(c->ev.taskId));
+                out += line;
+                out += Escape(c->ev.name) + "\"}";
+            }
+        }
+        out += "\n]}\n";
+        return out;
+    }
+
+    bool DumpToFile(const std::string& path) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file << ToJson();
+        return static_cast<bool>(file);
+    }
+
+private:
+    struct ThreadLabel {
+        const char* label = nullptr;
+        int index = -1;
+    };
+
+    // 每个写线程一个缓冲：current 只在记录器的锁内替换，写线程自己读取时不需要加锁
+    struct ThreadBuffer {
+        TraceChunk* current = nullptr;
+    };
+
+    struct Collected {
+        TraceEvent ev;
+        uint32_t thread;
+    };
+
+    static ThreadLabel& CurrentLabel() {
+        thread_local ThreadLabel label;
+        return label;
+    }
+
+    static double Micros(int64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+    static std::string Escape(const char* text) {
+        std::string out;
+        for (const char* p = text; *p; ++p) {
+            unsigned char c = static_cast<unsigned char>(*p);
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += static_cast<char>(c);
+            }
+            else if (c < 0x20) {
+                char esc[8];
+                std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+                out += esc;
+            }
+            else {
+                out += static_cast<char>(c);
+            }
+        }
+        return out;
+    }
+
+    // 当前线程的缓冲：第一次记录时从注册表领取 (优先复用已退出线程留下的缓冲)
+    ThreadBuffer& LocalBuffer() {
+        return m_buffers.Local(m_mutex, [this](ThreadBuffer& buffer) {
+            // 新线程使用新的序号：接手的缓冲中剩余的事件移入已满列表，归属不变
+            if (buffer.current) RetireLocked(buffer.current);
+            const ThreadLabel& label = CurrentLabel();
+            std::string name = label.label ? label.label : "Thread";
+            if (label.index >= 0) name.append(" ").append(std::to_string(label.index));
+            m_threadNames.push_back(name);
+            buffer.current = TakeChunkLocked(static_cast<uint32_t>(m_threadNames.size()));
+        });
+    }
+
+    // 当前事件块写满：移交已满列表，换一个新块
+    TraceChunk* NextChunk(ThreadBuffer& buffer) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const uint32_t thread = buffer.current->thread;
+        RetireLocked(buffer.current);
+        buffer.current = TakeChunkLocked(thread);
+        return buffer.current;
+    }
+
+    void RetireLocked(TraceChunk* chunk) {
+        if (chunk->count.load(std::memory_order_relaxed) > 0) m_full.push_back(chunk);
+        else m_free.push_back(chunk);
+    }
+
+    // 依次取空闲块、新分配 (未到上限)、回收最旧的已满块
+    TraceChunk* TakeChunkLocked(uint32_t thread) {
+        TraceChunk* chunk = nullptr;
+        if (!m_free.empty()) {
+            chunk = m_free.back();
+            m_free.pop_back();
+        }
+        else if (m_chunks.size() < m_maxChunks || m_full.empty()) {
+            m_chunks.push_back(std::make_unique<TraceChunk>());
+            chunk = m_chunks.back().get();
+        }
+        else {
+            chunk = m_full.front();
+            m_full.pop_front();
+            m_dropped += chunk->count.load(std::memory_order_relaxed);
+        }
+        chunk->thread = thread;
+        chunk->count.store(0, std::memory_order_relaxed);
+        return chunk;
+    }
+
+    std::vector<Collected> CollectLocked() const {
+        std::vector<Collected> events;
+        auto collect = [&](const TraceChunk* chunk) {
+            const uint32_t n = chunk->count.load(std::memory_order_acquire);
+            for (uint32_t i = 0; i < n; ++i) {
+                if (chunk->events[i].ns >= m_clearNs) events.push_back(Collected{ chunk->events[i], chunk->thread });
+            }
+        };
+        for (const TraceChunk* chunk : m_full) collect(chunk);
+        m_buffers.ForEachLocked([&](const ThreadBuffer& buffer) {
+            if (buffer.current) collect(buffer.current);
+        });
+        return events;
+    }
+
+    const std::chrono::steady_clock::time_point m_epoch;
+    std::atomic<bool> m_enabled{ false };
+    std::atomic<uint32_t> m_sampleEvery{ 1 };
+
+    mutable std::mutex m_mutex;     // 保护缓冲注册表与事件块列表，与调度锁无关
+    TraceOptions m_options;
+    size_t m_maxChunks = (size_t(1) << 20) / TraceChunk::kEvents;
+    ThreadLocalShards<ThreadBuffer> m_buffers;
+    std::vector<std::unique_ptr<TraceChunk>> m_chunks;  // 所有事件块 (只增不减)
+    std::deque<TraceChunk*> m_full;                     // 已写满的块，最旧的在前
+    std::vector<TraceChunk*> m_free;
+    std::vector<std::string> m_threadNames;             // 线程序号 - 1 -> 名字
+    int64_t m_clearNs = 0;
+    uint64_t m_dropped = 0;
+};
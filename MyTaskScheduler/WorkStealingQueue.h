@@ -0,0 +1,149 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: WorkStealingQueue.h
+// 对应需求: 多工作线程 + 工作窃取 (Work-Stealing)，按优先级 + 截止时间 (EDF) 出队
+// =================================================================================
+#pragma once
+#include "TaskOptions.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <cstddef>
+#include <vector>
+
+// 每个工作线程私有的就绪队列
+// - 每个优先级一个小顶堆，堆内按截止时间排序 (Earliest Deadline First)，截止时间相同按就绪先后
+// - 出队时比较各优先级堆顶的“有效优先级”：在队列中每多等待一个老化步长 (Aging) 提升一级，
+//   低优先级任务等得足够久会越过高优先级任务，避免饿死
+// - 所有者 (Owner) 与窃取者 (Thief) 使用同一出队规则，偷走的永远是当前最该执行的任务
+// 每个队列独立加锁，锁粒度只覆盖一次 push/pop，工作线程之间互不阻塞
+// Node 需要有 priority (TaskPriority)、deadlineAt、readyTime (steady_clock::time_point) 成员
+// 堆的容量在预热后保持不变，入队出队不再分配内存
+template <typename Node>
+class WorkStealingQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // 老化步长 (0 表示关闭)，可在运行中修改
+    void SetAgingStep(Clock::duration step) {
+        m_agingStepNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(step).count(),
+            std::memory_order_relaxed);
+    }
+
+    void Push(Node* node) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        PushLocked(node);
+    }
+
+    // 批量入队：整批只加一次锁
+    template <typename It>
+    void PushBulk(It first, It last) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (; first != last; ++first) PushLocked(*first);
+    }
+
+    // 所有者取任务
+    // aged: 取到的任务是否因老化越过了更高优先级的任务
+    bool TryPop(Node*& out, Clock::time_point now, bool& aged) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return PopLocked(out, now, aged);
+    }
+
+    // 其他工作线程空闲时窃取
+    // 使用 try_lock：受害者正忙时直接换下一个，窃取者永不阻塞所有者
+    bool TrySteal(Node*& out, Clock::time_point now, bool& aged) {
+        std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+        return lock.owns_lock() && PopLocked(out, now, aged);
+    }
+
+    // 不考虑老化，按优先级 + EDF 取任务 (停止时清空队列用)
+    bool TryPop(Node*& out) {
+        bool aged = false;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return PopLocked(out, Clock::time_point::min(), aged);
+    }
+
+    // 队列中最高的优先级 (不含老化，无锁读取；为空时返回 kTaskPriorityCount)
+    // 工作线程据此判断其他队列是否有比自己队列更紧急的任务
+    size_t BestLevel() const {
+        return m_bestLevel.load(std::memory_order_relaxed);
+    }
+
+    size_t Size() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_size;
+    }
+
+    // 只摘除节点，不释放 (节点由调度器的对象池管理)
+    void Clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& heap : m_heaps) heap.clear();
+        m_size = 0;
+        UpdateBestLevelLocked();
+    }
+
+private:
+    // std::push_heap 默认是大顶堆，比较器取反得到“截止时间最早”在堆顶
+    static bool Later(const Node* a, const Node* b) {
+        if (a->deadlineAt != b->deadlineAt) return a->deadlineAt > b->deadlineAt;
+        return a->readyTime > b->readyTime;
+    }
+
+    void PushLocked(Node* node) {
+        auto& heap = m_heaps[static_cast<size_t>(node->priority)];
+        heap.push_back(node);
+        std::push_heap(heap.begin(), heap.end(), &Later);
+        ++m_size;
+        if (static_cast<size_t>(node->priority) < m_bestLevel.load(std::memory_order_relaxed)) {
+            m_bestLevel.store(static_cast<size_t>(node->priority), std::memory_order_relaxed);
+        }
+    }
+
+    void UpdateBestLevelLocked() {
+        size_t level = 0;
+        while (level < kTaskPriorityCount && m_heaps[level].empty()) ++level;
+        m_bestLevel.store(level, std::memory_order_relaxed);
+    }
+
+    bool PopLocked(Node*& out, Clock::time_point now, bool& aged) {
+        if (m_size == 0) return false;
+
+        const long long step = m_agingStepNs.load(std::memory_order_relaxed);
+        size_t best = kTaskPriorityCount;
+        size_t firstNonEmpty = kTaskPriorityCount;
+        long long bestLevel = 0;
+        for (size_t level = 0; level < kTaskPriorityCount; ++level) {
+            if (m_heaps[level].empty()) continue;
+            if (firstNonEmpty == kTaskPriorityCount) firstNonEmpty = level;
+
+            long long effective = static_cast<long long>(level);
+            if (step > 0 && now != Clock::time_point::min()) {
+                auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    now - m_heaps[level].front()->readyTime).count();
+                if (waited > 0) effective -= waited / step;
+                if (effective < 0) effective = 0;
+            }
+            // 有效优先级相同时保留原本更高的优先级 (按 level 递增遍历，只在严格更小时替换)
+            if (best == kTaskPriorityCount || effective < bestLevel) {
+                best = level;
+                bestLevel = effective;
+            }
+        }
+
+        auto& heap = m_heaps[best];
+        std::pop_heap(heap.begin(), heap.end(), &Later);
+        out = heap.back();
+        heap.pop_back();
+        --m_size;
+        if (heap.empty() && best == firstNonEmpty) UpdateBestLevelLocked();
+        aged = (best != firstNonEmpty);
+        return true;
+    }
+
+    std::vector<Node*> m_heaps[kTaskPriorityCount];
+    size_t m_size = 0;
+    std::atomic<size_t> m_bestLevel{ kTaskPriorityCount };
+    std::atomic<long long> m_agingStepNs{ 0 };
+    std::mutex m_mutex;
+};
@@ -0,0 +1,338 @@
+// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: LocalHttpServer.h
+// 对应需求: 本地替身 HTTP 服务器 (127.0.0.1)：只回答 GET，支持 keep-alive、ETag / Last-Modified 条件请求
+//           与人为延迟，基准程序用它代替外网源站测试 HttpClient 与结果缓存
+// =================================================================================
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+class LocalHttpServer {
+public:
+#if defined(_WIN32)
+    using NativeSocket = SOCKET;
+    static constexpr NativeSocket kInvalid = INVALID_SOCKET;
+#else
+    using NativeSocket = int;
+    static constexpr NativeSocket kInvalid = -1;
+#endif
+
+    struct Stats {
+        unsigned long long connections = 0;
+        unsigned long long requests = 0;
+        unsigned long long notModified = 0;   // 回答了 304
+        unsigned long long bytesSent = 0;     // 正文字节
+    };
+
+    LocalHttpServer() {
+#if defined(_WIN32)
+        WSADATA data;
+        ::WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+    }
+
+    ~LocalHttpServer() {
+        Stop();
+#if defined(_WIN32)
+        ::WSACleanup();
+#endif
+    }
+
+    // 监听 127.0.0.1:port (0 表示由系统分配)
+    bool Start(int port = 0) {
+        m_listen = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (m_listen == kInvalid) return false;
+        const int one = 1;
+        ::setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&one), sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(static_cast<unsigned short>(port));
+        socklen_t len = sizeof(addr);
+        if (::bind(m_listen, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+            || ::listen(m_listen, 1024) != 0
+            || ::getsockname(m_listen, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            CloseSocket(m_listen);
+            m_listen = kInvalid;
+            return false;
+        }
+        m_port = ntohs(addr.sin_port);
+        m_running = true;
+        m_acceptThread = std::thread([this] { AcceptLoop(); });
+        return true;
+    }
+
+    void Stop() {
+        if (!m_running.exchange(false)) return;
+        ::shutdown(m_listen, 2); // 唤醒阻塞在 accept 上的线程
+        if (m_acceptThread.joinable()) m_acceptThread.join();
+        CloseSocket(m_listen);
+        m_listen = kInvalid;
+        std::vector<Worker> workers;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (NativeSocket fd : m_clients) ::shutdown(fd, 2);
+            workers.swap(m_workers);
+        }
+        for (Worker& w : workers) w.thread.join();
+    }
+
+    int Port() const { return m_port; }
+
+    std::string Url(const std::string& path) const {
+        return "http://127.0.0.1:" + std::to_string(m_port) + path;
+    }
+
+    // 设置 path 的内容；每次设置版本号加一，ETag 与 Last-Modified 随之变化
+    void SetResource(const std::string& path, const std::string& body, const std::string& cacheControl = std::string()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Resource& res = m_resources[path];
+        res.body = body;
+        res.cacheControl = cacheControl;
+        ++res.version;
+        res.etag = "\"v" + std::to_string(res.version) + "\"";
+        res.lastModified = HttpDate(res.version);
+    }
+
+    // 没有登记的路径：返回 size 字节的固定内容 (0 表示回答 404)
+    void SetFallbackSize(size_t size) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_fallbackSize = size;
+    }
+
+    // 每个请求在回答之前等待多久 (模拟外网往返)
+    void SetLatency(std::chrono::milliseconds latency) {
+        m_latencyMs = static_cast<int>(latency.count());
+    }
+
+    Stats GetStats() const {
+        Stats stats;
+        stats.connections = m_connections.load();
+        stats.requests = m_requests.load();
+        stats.notModified = m_notModified.load();
+        stats.bytesSent = m_bytesSent.load();
+        return stats;
+    }
+
+    void ResetStats() {
+        m_connections = 0;
+        m_requests = 0;
+        m_notModified = 0;
+        m_bytesSent = 0;
+    }
+
+private:
+    struct Resource {
+        std::string body;
+        std::string etag;
+        std::string lastModified;
+        std::string cacheControl;
+        unsigned version = 0;
+    };
+
+    // 每个连接一个线程；结束的线程在下一次 accept 时回收
+    struct Worker {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> done;
+    };
+
+    static void CloseSocket(NativeSocket fd) {
+#if defined(_WIN32)
+        ::closesocket(fd);
+#else
+        ::close(fd);
+#endif
+    }
+
+    // 版本 n 对应的 HTTP 日期 (只需各版本不同)
+    static std::string HttpDate(unsigned version) {
+        char text[64];
+        std::snprintf(text, sizeof(text), "Mon, 01 Jan 2024 %02u:%02u:%02u GMT",
+            (version / 3600) % 24, (version / 60) % 60, version % 60);
+        return text;
+    }
+
+    static std::string HeaderValue(const std::string& head, const char* name) {
+        const std::string needle = std::string("\r\n") + name + ":";
+        size_t pos = 0;
+        for (;;) {
+            // 不区分大小写地查找
+            pos = head.find("\r\n", pos);
+            if (pos == std::string::npos) return std::string();
+            if (head.size() - pos >= needle.size()) {
+                bool match = true;
+                for (size_t i = 0; i < needle.size() && match; ++i) {
+                    match = std::tolower(static_cast<unsigned char>(head[pos + i])) == std::tolower(static_cast<unsigned char>(needle[i]));
+                }
+                if (match) {
+                    size_t start = pos + needle.size();
+                    while (start < head.size() && head[start] == ' ') ++start;
+                    const size_t end = head.find("\r\n", start);
+                    return head.substr(start, (end == std::string::npos) ? std::string::npos : end - start);
+                }
+            }
+            pos += 2;
+        }
+    }
+
+    void AcceptLoop() {
+        while (m_running) {
+            NativeSocket fd = ::accept(m_listen, nullptr, nullptr);
+            if (fd == kInvalid) {
+                if (!m_running) break;
+                continue;
+            }
+            const int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&one), sizeof(one));
+            m_connections.fetch_add(1);
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t i = 0; i < m_workers.size();) {
+                if (m_workers[i].done->load()) {
+                    m_workers[i].thread.join();
+                    m_workers[i] = std::move(m_workers.back());
+                    m_workers.pop_back();
+                }
+                else {
+                    ++i;
+                }
+            }
+            m_clients.push_back(fd);
+            auto done = std::make_shared<std::atomic<bool>>(false);
+            m_workers.push_back(Worker{ std::thread([this, fd, done] { Serve(fd); done->store(true); }), done });
+        }
+    }
+
+    // 一个连接：依次处理请求，直到对方关闭或要求 Connection: close
+    void Serve(NativeSocket fd) {
+        std::string buffer;
+        char chunk[8192];
+        bool open = true;
+        while (open && m_running) {
+            size_t end;
+            while ((end = buffer.find("\r\n\r\n")) == std::string::npos) {
+                const int n = static_cast<int>(::recv(fd, chunk, sizeof(chunk), 0));
+                if (n <= 0) { open = false; break; }
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+            if (!open) break;
+            const std::string head = buffer.substr(0, end + 2);
+            buffer.erase(0, end + 4);
+            m_requests.fetch_add(1);
+            if (m_latencyMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(m_latencyMs.load()));
+
+            const bool close = HeaderValue(head, "Connection").find("close") != std::string::npos;
+            const std::string response = Respond(head, close);
+            if (!SendAll(fd, response)) break;
+            if (close) break;
+        }
+        ::shutdown(fd, 2);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < m_clients.size(); ++i) {
+            if (m_clients[i] == fd) {
+                m_clients[i] = m_clients.back();
+                m_clients.pop_back();
+                break;
+            }
+        }
+        CloseSocket(fd);
+    }
+
+    std::string Respond(const std::string& head, bool close) {
+        const size_t pathStart = head.find(' ') + 1;
+        const std::string path = head.substr(pathStart, head.find(' ', pathStart) - pathStart);
+        Resource res;
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_resources.find(path);
+            if (it != m_resources.end()) {
+                res = it->second;
+                found = true;
+            }
+            else if (m_fallbackSize > 0) {
+                res.body.assign(m_fallbackSize, 'x');
+                res.body.replace(0, (std::min)(path.size(), m_fallbackSize), path, 0, m_fallbackSize);
+                res.etag = "\"fallback\"";
+                found = true;
+            }
+        }
+
+        std::string out;
+        const char* connection = close ? "close" : "keep-alive";
+        if (!found) {
+            out = std::string("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: ") + connection + "\r\n\r\n";
+            return out;
+        }
+        const std::string ifNoneMatch = HeaderValue(head, "If-None-Match");
+        const std::string ifModifiedSince = HeaderValue(head, "If-Modified-Since");
+        const bool notModified = (!ifNoneMatch.empty() && ifNoneMatch == res.etag)
+            || (ifNoneMatch.empty() && !ifModifiedSince.empty() && ifModifiedSince == res.lastModified);
+
+        out = notModified ? "HTTP/1.1 304 Not Modified\r\n" : "HTTP/1.1 200 OK\r\n";
+        out += "ETag: " + res.etag + "\r\n";
+        if (!res.lastModified.empty()) out += "Last-Modified: " + res.lastModified + "\r\n";
+        if (!res.cacheControl.empty()) out += "Cache-Control: " + res.cacheControl + "\r\n";
+        out += std::string("Connection: ") + connection + "\r\n";
+        if (notModified) {
+            m_notModified.fetch_add(1);
+            out += "\r\n";
+            return out;
+        }
+        out += "Content-Type: text/plain\r\nContent-Length: " + std::to_string(res.body.size()) + "\r\n\r\n";
+        out += res.body;
+        m_bytesSent.fetch_add(res.body.size());
+        return out;
+    }
+
+    static bool SendAll(NativeSocket fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+#if defined(_WIN32)
+            const int n = ::send(fd, data.data() + sent, static_cast<int>(data.size() - sent), 0);
+#else
+            const int n = static_cast<int>(::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL));
+#endif
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    NativeSocket m_listen = kInvalid;
+    int m_port = 0;
+    std::atomic<bool> m_running{ false };
+    std::atomic<int> m_latencyMs{ 0 };
+    std::thread m_acceptThread;
+    std::mutex m_mutex;
+    std::vector<NativeSocket> m_clients;
+    std::vector<Worker> m_workers;
+    std::map<std::string, Resource> m_resources;
+    size_t m_fallbackSize = 0;
+    std::atomic<unsigned long long> m_connections{ 0 };
+    std::atomic<unsigned long long> m_requests{ 0 };
+    std::atomic<unsigned long long> m_notModified{ 0 };
+    std::atomic<unsigned long long> m_bytesSent{ 0 };
+};
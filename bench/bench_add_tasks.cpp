@@ -0,0 +1,87 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_add_tasks.cpp
+// 对应需求: 批量提交 AddTasks vs 循环调用 AddTask 的单任务提交开销
+// 编译示例: cl /O2 /EHsc /std:c++17 /I..\MyTaskScheduler bench_add_tasks.cpp
+// =================================================================================
+#include "SchedulerEngine.h"
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+std::atomic<long> g_executed{ 0 };
+
+class CNoopTask : public ITask {
+public:
+    void Execute() override { g_executed.fetch_add(1, std::memory_order_relaxed); }
+    std::string GetName() const override { return "Noop Task"; }
+};
+
+constexpr int kRounds = 20;
+
+// 等待本轮提交的立即任务全部执行完，避免上一轮的积压影响下一轮计时
+void WaitExecuted(long target) {
+    while (g_executed.load() < target) std::this_thread::yield();
+}
+
+// 返回每个任务的平均提交耗时 (ns)，只统计提交调用本身
+double RunLoop(const std::vector<TaskSubmission>& batch) {
+    auto& scheduler = TaskScheduler::Instance();
+    long long totalNs = 0;
+    for (int round = 0; round < kRounds; ++round) {
+        long target = g_executed.load() + static_cast<long>(batch.size());
+        auto t0 = BenchClock::now();
+        for (const auto& sub : batch) scheduler.AddTask(sub.task, sub.delayMs, sub.intervalMs);
+        totalNs += std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - t0).count();
+        WaitExecuted(target);
+    }
+    return static_cast<double>(totalNs) / (static_cast<double>(kRounds) * batch.size());
+}
+
+double RunBatch(const std::vector<TaskSubmission>& batch) {
+    auto& scheduler = TaskScheduler::Instance();
+    long long totalNs = 0;
+    for (int round = 0; round < kRounds; ++round) {
+        long target = g_executed.load() + static_cast<long>(batch.size());
+        auto t0 = BenchClock::now();
+        scheduler.AddTasks(batch);
+        totalNs += std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - t0).count();
+        WaitExecuted(target);
+    }
+    return static_cast<double>(totalNs) / (static_cast<double>(kRounds) * batch.size());
+}
+
+} // namespace
+
+int main() {
+    auto& scheduler = TaskScheduler::Instance();
+    scheduler.Start();
+
+    // 模拟界面：挂一个只计数的订阅者，让事件通道的开销也计入
+    std::atomic<long> delivered{ 0 };
+    scheduler.SubscribeEvents(std::make_shared<CallbackEventSubscriber>(
+        [&](const SchedulerEvent*, size_t count) { delivered.fetch_add(static_cast<long>(count)); }));
+
+    std::printf("workers: %zu\n", scheduler.GetWorkerCount());
+    std::printf("%-8s %14s %14s %10s\n", "batch", "AddTask ns", "AddTasks ns", "speedup");
+
+    auto task = std::make_shared<CNoopTask>();
+    for (size_t n : { size_t(10), size_t(100), size_t(1000), size_t(10000) }) {
+        std::vector<TaskSubmission> batch(n);
+        for (auto& sub : batch) sub.task = task;
+
+        double loopNs = RunLoop(batch);
+        double batchNs = RunBatch(batch);
+        std::printf("%-8zu %14.1f %14.1f %9.2fx\n", n, loopNs, batchNs, batchNs > 0 ? loopNs / batchNs : 0.0);
+    }
+
+    scheduler.Stop();
+    return 0;
+}
@@ -0,0 +1,131 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_alloc_free.cpp
+// 对应需求: 验证对象池预热后，提交 + 执行一个任务 (可调用对象 / 复用的 ITask 实例) 的稳态循环零堆分配
+// 编译示例: cl /O2 /EHsc /std:c++17 /I..\MyTaskScheduler bench_alloc_free.cpp
+// 说明: 替换全局 operator new 统计所有线程的堆分配次数；有分配时返回非零退出码
+// =================================================================================
+#include "SchedulerEngine.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+namespace {
+
+std::atomic<unsigned long long> g_allocations{ 0 };
+
+void* CountedAlloc(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(size_t size) { return CountedAlloc(size); }
+void* operator new[](size_t size) { return CountedAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+std::atomic<long> g_executed{ 0 };
+
+// 名字超出 std::string 的短字符串优化长度：提交路径若每次都构造 GetName() 的返回值就会分配
+class AllocFreeTask : public ITask {
+public:
+    void Execute() override { g_executed.fetch_add(1, std::memory_order_relaxed); }
+    std::string GetName() const override { return "Alloc-Free ITask (long name)"; }
+};
+
+// 用 submit 提交一个任务并等它执行完，重复 cycles 次；返回期间所有线程的堆分配次数
+template <typename Submit>
+unsigned long long RunCycles(long cycles, Submit&& submit, double& nsPerCycle) {
+    unsigned long long before = g_allocations.load();
+    auto t0 = BenchClock::now();
+    for (long i = 0; i < cycles; ++i) {
+        long target = g_executed.load() + 1;
+        submit();
+        while (g_executed.load() < target) std::this_thread::yield();
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - t0).count();
+    nsPerCycle = static_cast<double>(ns) / static_cast<double>(cycles);
+    return g_allocations.load() - before;
+}
+
+// 可调用对象任务：捕获 16 字节，落在 SmallFunction 的内联存储中
+unsigned long long RunCallableCycles(long cycles, int delayMs, double& nsPerCycle) {
+    auto& scheduler = TaskScheduler::Instance();
+    long* counter = nullptr;
+    long payload = 42;
+    return RunCycles(cycles, [&] {
+        scheduler.AddTask("Alloc-Free Task", [counter, payload]() {
+            (void)counter;
+            (void)payload;
+            g_executed.fetch_add(1, std::memory_order_relaxed);
+        }, delayMs);
+    }, nsPerCycle);
+}
+
+// 反复提交同一个 ITask 实例 (与界面复用共享任务实例的方式相同)
+unsigned long long RunITaskCycles(long cycles, const std::shared_ptr<ITask>& task, double& nsPerCycle) {
+    auto& scheduler = TaskScheduler::Instance();
+    return RunCycles(cycles, [&] { scheduler.AddTask(task); }, nsPerCycle);
+}
+
+} // namespace
+
+int main() {
+    auto& scheduler = TaskScheduler::Instance();
+    scheduler.ReserveTasks(1024);
+    scheduler.Start(2);
+
+    // 挂一个订阅者，事件通道的发布与批量分发也计入
+    std::atomic<long> delivered{ 0 };
+    scheduler.SubscribeEvents(std::make_shared<CallbackEventSubscriber>(
+        [&](const SchedulerEvent*, size_t count) { delivered.fetch_add(static_cast<long>(count)); }));
+
+    // 预热：对象池、名字驻留表、各线程的首次初始化
+    std::shared_ptr<ITask> task = std::make_shared<AllocFreeTask>();
+    double ns = 0;
+    RunCallableCycles(1000, 0, ns);
+    RunCallableCycles(20, 1, ns);
+    RunITaskCycles(1000, task, ns);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // 让事件分发线程也跑过几轮
+
+    const long kImmediate = 100000;
+    const long kDelayed = 500;
+    double immediateNs = 0, delayedNs = 0, itaskNs = 0;
+    unsigned long long immediateAllocs = RunCallableCycles(kImmediate, 0, immediateNs);
+    unsigned long long delayedAllocs = RunCallableCycles(kDelayed, 1, delayedNs);
+    unsigned long long itaskAllocs = RunITaskCycles(kImmediate, task, itaskNs);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::printf("%-12s %10s %12s %14s %12s\n", "path", "cycles", "ns/cycle", "allocations", "allocs/cycle");
+    std::printf("%-12s %10ld %12.1f %14llu %12.4f\n", "immediate", kImmediate, immediateNs,
+        immediateAllocs, static_cast<double>(immediateAllocs) / kImmediate);
+    std::printf("%-12s %10ld %12.1f %14llu %12.4f\n", "delayed 1ms", kDelayed, delayedNs,
+        delayedAllocs, static_cast<double>(delayedAllocs) / kDelayed);
+    std::printf("%-12s %10ld %12.1f %14llu %12.4f\n", "ITask", kImmediate, itaskNs,
+        itaskAllocs, static_cast<double>(itaskAllocs) / kImmediate);
+
+    scheduler.Stop();
+    std::printf("events delivered: %ld\n", delivered.load());
+    return (immediateAllocs == 0 && delayedAllocs == 0 && itaskAllocs == 0) ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_backup.cpp
+// 对应需求: 备份开销：每次全量复制 vs 增量 (只复制新增尾部) vs 增量 + 分块去重
+// 编译示例: cl /O2 /EHsc /std:c++17 /I..\MyTaskScheduler bench_backup.cpp
+// 用法: bench_backup [初始大小 MB，默认 16] [备份轮数，默认 10]
+// 说明: 3 个日志文件，每轮各追加约 256KB 后备份一次；最后一轮把其中一个文件“轮转”
+//       (截断后写回几乎相同的内容)。每种方式结束后从备份还原并与源文件逐字节比对
+// =================================================================================
+#include "BackupEngine.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+uint64_t g_state = 0x2545F4914F6CDD1Dull;
+
+uint64_t NextRandom() {
+    g_state ^= g_state << 13;
+    g_state ^= g_state >> 7;
+    g_state ^= g_state << 17;
+    return g_state;
+}
+
+// 模拟调度器日志行
+void AppendLog(const fs::path& path, size_t bytes) {
+    static const char* kMessages[] = {
+        "Task A [Backup]: 开始执行文件备份...",
+        "Task B [Matrix]: 运算完成。耗时: 0.0123 秒 (AVX2, 41.2 GFLOP/s)",
+        "Task C [HTTP]: 下载成功! 内容: Keep it logically awesome.",
+        "Task E [Stats]: 均值(Mean) = 50.0123, 方差(Variance) = 850.4410",
+        "Scheduler: worker 3 stole 12 tasks",
+    };
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    std::string line;
+    for (size_t written = 0; written < bytes; written += line.size()) {
+        uint64_t r = NextRandom();
+        line = "[2026-10-17 12:" + std::to_string(r % 60) + ":" + std::to_string((r >> 8) % 60) + "] " +
+            kMessages[(r >> 16) % 5] + " #" + std::to_string(r >> 40) + "\n";
+        out << line;
+    }
+}
+
+uint64_t DirectoryBytes(const fs::path& dir) {
+    uint64_t total = 0;
+    for (const auto& entry : fs::recursive_directory_iterator(dir)) {
+        if (entry.is_regular_file()) total += entry.file_size();
+    }
+    return total;
+}
+
+bool SameContent(const fs::path& a, const fs::path& b) {
+    std::ifstream fa(a, std::ios::binary), fb(b, std::ios::binary);
+    std::string ca((std::istreambuf_iterator<char>(fa)), std::istreambuf_iterator<char>());
+    std::string cb((std::istreambuf_iterator<char>(fb)), std::istreambuf_iterator<char>());
+    return ca == cb;
+}
+
+struct Scenario {
+    const char* name;
+    BackupOptions options;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t initialMb = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 16;
+    const int rounds = (argc > 2) ? std::atoi(argv[2]) : 10;
+    const size_t appendBytes = 256 * 1024;
+
+    fs::path root = fs::temp_directory_path() / "bench_backup";
+    fs::remove_all(root);
+
+    Scenario scenarios[3];
+    scenarios[0].name = "full";
+    scenarios[0].options.mode = BackupMode::Full;
+    scenarios[1].name = "incremental";
+    scenarios[2].name = "incr+dedupe";
+    scenarios[2].options.dedupe = true;
+
+    std::printf("3 sources x %zu MB, %d rounds, +%zu KB per source per round, last round rotates one source\n",
+        initialMb, rounds, appendBytes / 1024);
+    std::printf("%-12s %14s %14s %12s %12s %16s %8s\n",
+        "mode", "bytes copied", "bytes deduped", "wall ms", "last ms", "backup dir MB", "restore");
+
+    bool ok = true;
+    for (const Scenario& scenario : scenarios) {
+        fs::path sourceDir = root / "src";
+        fs::path backupDir = root / scenario.name;
+        fs::remove_all(sourceDir);
+        fs::create_directories(sourceDir);
+        g_state = 0x2545F4914F6CDD1Dull;
+
+        std::vector<fs::path> sources;
+        for (const char* name : { "scheduler.log", "worker.log", "http.log" }) {
+            sources.push_back(sourceDir / name);
+            AppendLog(sources.back(), initialMb * 1024 * 1024);
+        }
+
+        BackupEngine engine(backupDir);
+        uint64_t copied = 0, deduped = 0;
+        double totalSeconds = 0.0, lastSeconds = 0.0;
+        CopyMethod method = CopyMethod::None;
+        for (int round = 0; round < rounds; ++round) {
+            for (const auto& source : sources) AppendLog(source, appendBytes);
+            if (round == rounds - 1) {
+                // 轮转：旧内容去掉开头一小段后写回，再追加新日志
+                std::ifstream in(sources[0], std::ios::binary);
+                std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                in.close();
+                std::ofstream(sources[0], std::ios::binary | std::ios::trunc) << content.substr(content.size() / 100);
+                AppendLog(sources[0], appendBytes);
+            }
+            BackupReport report = engine.Run(sources, scenario.options);
+            copied += report.bytesCopied;
+            deduped += report.bytesDeduped;
+            totalSeconds += report.seconds;
+            lastSeconds = report.seconds;
+            if (!report.files.empty() && report.files.back().method != CopyMethod::None) method = report.files.back().method;
+        }
+
+        // 全量模式的最新副本就是还原结果；增量模式从镜像 / 分块还原
+        bool restored = true;
+        if (scenario.options.mode == BackupMode::Incremental) {
+            for (const auto& source : sources) {
+                fs::path target = root / "restored.log";
+                restored &= engine.Restore(source, target) && SameContent(source, target);
+            }
+        }
+        ok &= restored;
+        std::printf("%-12s %14llu %14llu %12.1f %12.1f %16.1f %8s  (%s)\n", scenario.name,
+            static_cast<unsigned long long>(copied), static_cast<unsigned long long>(deduped),
+            totalSeconds * 1000.0, lastSeconds * 1000.0, DirectoryBytes(backupDir) / 1048576.0,
+            scenario.options.mode == BackupMode::Full ? "-" : (restored ? "OK" : "FAIL"), CopyMethodName(method));
+        std::fflush(stdout);
+        fs::remove_all(backupDir);
+    }
+
+    fs::remove_all(root);
+    std::printf("result check: %s\n", ok ? "OK" : "MISMATCH");
+    return ok ? 0 : 1;
+}
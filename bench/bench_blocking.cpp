@@ -0,0 +1,78 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_blocking.cpp
+// 对应需求: 阻塞任务对 CPU 任务排队等待的影响 (弹性线程池关闭 vs 开启)
+// 编译示例: cl /O2 /EHsc /std:c++17 /I..\MyTaskScheduler bench_blocking.cpp
+// 说明: 持续提交短小的 CPU 任务，同时穿插 sleep 模拟的阻塞任务 (类似 HTTP 下载、模态对话框)；
+//       关闭弹性池时阻塞任务占用 CPU 工作线程，开启后由弹性线程执行
+// =================================================================================
+#include "SchedulerEngine.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+namespace {
+
+constexpr int kWorkers = 2;
+constexpr int kRounds = 10;
+constexpr int kBlockingPerRound = 4;     // 每个阻塞 50ms
+constexpr int kCpuPerRound = 50;         // 每 1ms 一个
+
+std::atomic<long> g_cpu{ 0 };
+std::atomic<long> g_blocking{ 0 };
+
+// 模拟同步网络请求：线程睡眠等待，不消耗 CPU
+class CSleepyIoTask : public ITask {
+public:
+    void Execute() override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        g_blocking.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::string GetName() const override { return "Sleepy IO Task"; }
+    bool IsBlocking() const override { return true; }
+};
+
+void Run(const char* mode, unsigned elasticMaxThreads) {
+    auto& scheduler = TaskScheduler::Instance();
+    ElasticPoolOptions options;
+    options.maxThreads = elasticMaxThreads;
+    scheduler.SetBlockingPoolOptions(options);
+    scheduler.Start(kWorkers);
+    scheduler.ResetExecutorStats();
+    g_cpu = 0;
+    g_blocking = 0;
+
+    auto io = std::make_shared<CSleepyIoTask>();
+    for (int round = 0; round < kRounds; ++round) {
+        for (int i = 0; i < kBlockingPerRound; ++i) scheduler.AddTask(io);
+        for (int i = 0; i < kCpuPerRound; ++i) {
+            scheduler.AddTask("CPU Task", [] { g_cpu.fetch_add(1, std::memory_order_relaxed); });
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    while (g_cpu.load() < kRounds * kCpuPerRound || g_blocking.load() < kRounds * kBlockingPerRound) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ExecutorStats stats = scheduler.GetExecutorStats();
+    scheduler.Stop();
+    std::printf("%-9s %8llu %12.1f %12lld %9llu %12.1f %10llu %6zu\n", mode,
+        stats.cpuTasks, stats.cpuTasks ? static_cast<double>(stats.cpuWaitTotalUs) / stats.cpuTasks : 0.0,
+        stats.cpuWaitMaxUs, stats.blockingTasks,
+        stats.blockingTasks ? static_cast<double>(stats.blockingWaitTotalUs) / stats.blockingTasks : 0.0,
+        stats.blockingOnWorkers, stats.elasticPeak);
+}
+
+} // namespace
+
+int main() {
+    std::printf("workers: %d, rounds: %d x (%d blocking 50ms + %d cpu)\n",
+        kWorkers, kRounds, kBlockingPerRound, kCpuPerRound);
+    std::printf("%-9s %8s %12s %12s %9s %12s %10s %6s\n", "elastic", "cpu", "cpu avg us", "cpu max us",
+        "blocking", "blk avg us", "on workers", "peak");
+    Run("off", 0);
+    Run("on", 16);
+    return 0;
+}
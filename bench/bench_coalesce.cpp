@@ -0,0 +1,174 @@
+// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_coalesce.cpp
+// 对应需求: 合并键 (TaskOptions::coalesceKey)：四种策略在同键任务待执行 / 执行中时收到重复提交的行为
+//           (执行次数、执行的是哪一次提交、何时执行)、重复提交的开销、AddAsyncTask 的合并，
+//           以及动态键 (每个任务一个合并键 / 限流键) 在任务结束后从调度器的键表中释放 (每项打印 OK / FAIL)
+// 编译示例: cmake -S . -B build && cmake --build build --target bench_coalesce
+// 用法: bench_coalesce [每轮重复提交数，默认 10000]
+// =================================================================================
+#include "SchedulerEngine.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+double Millis(BenchClock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+const char* Verdict(bool ok) { return ok ? "OK" : "FAIL"; }
+
+const char* PolicyName(CoalescePolicy policy) {
+    switch (policy) {
+    case CoalescePolicy::Replace:      return "Replace";
+    case CoalescePolicy::KeepEarliest: return "KeepEarliest";
+    case CoalescePolicy::Merge:        return "Merge";
+    default:                           return "IgnoreWhileRunning";
+    }
+}
+
+// 一个合并键上的执行记录
+struct RunLog {
+    std::atomic<int> runs{ 0 };
+    std::atomic<long long> lastValue{ -1 };   // 最后执行的是第几次提交
+    std::atomic<long long> lastAtUs{ 0 };     // 相对第一次提交的时刻
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const long long duplicates = (argc > 1) ? std::atoll(argv[1]) : 10000;
+
+    TaskScheduler& scheduler = TaskScheduler::Instance();
+    scheduler.Start(2);
+    std::printf("%lld duplicate submissions per round\n\n", duplicates);
+    std::printf("%-20s %18s %14s %12s %10s %8s\n",
+        "policy", "pending: ran #", "at ms", "running: runs", "ns/dup", "result");
+
+    bool allOk = true;
+    const CoalescePolicy policies[] = {
+        CoalescePolicy::Replace, CoalescePolicy::KeepEarliest, CoalescePolicy::Merge, CoalescePolicy::IgnoreWhileRunning
+    };
+    int round = 0;
+    for (CoalescePolicy policy : policies) {
+        TaskOptions options;
+        options.coalesce = policy;
+
+        // 1. 待执行：第 0 次提交延迟 200ms，之后的重复提交延迟 20ms
+        //    Replace 执行最后一次提交 (约 20ms)；Merge 执行第 0 次但提前到约 20ms；KeepEarliest / Ignore 执行第 0 次 (约 200ms)
+        const std::string pendingKey = "pending-" + std::to_string(round);
+        options.coalesceKey = pendingKey.c_str();
+        RunLog pending;
+        const auto start = BenchClock::now();
+        for (long long i = 0; i <= duplicates; ++i) {
+            scheduler.AddTask("Coalesce Pending", [&pending, start, i] {
+                pending.lastValue = i;
+                pending.lastAtUs = std::chrono::duration_cast<std::chrono::microseconds>(BenchClock::now() - start).count();
+                pending.runs.fetch_add(1);
+            }, (i == 0) ? 200 : 20, 0, options);
+        }
+        const double nsPerDuplicate = Millis(BenchClock::now() - start) * 1e6 / static_cast<double>(duplicates + 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+        // 2. 执行中：第一个任务执行 50ms，执行期间再提交一次；只有 IgnoreWhileRunning 丢弃它
+        const std::string runningKey = "running-" + std::to_string(round);
+        options.coalesceKey = runningKey.c_str();
+        std::atomic<int> started{ 0 };
+        std::atomic<int> runningRuns{ 0 };
+        scheduler.AddTask("Coalesce Running", [&] {
+            started.fetch_add(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            runningRuns.fetch_add(1);
+        }, 0, 0, options);
+        while (started.load() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        scheduler.AddTask("Coalesce Running", [&runningRuns] { runningRuns.fetch_add(1); }, 0, 0, options);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        const bool replace = policy == CoalescePolicy::Replace;
+        const bool early = replace || policy == CoalescePolicy::Merge;
+        const double atMs = static_cast<double>(pending.lastAtUs.load()) / 1000.0;
+        const bool ok = pending.runs.load() == 1
+            && pending.lastValue.load() == (replace ? duplicates : 0)
+            && (early ? atMs < 150.0 : atMs >= 190.0)
+            && runningRuns.load() == (policy == CoalescePolicy::IgnoreWhileRunning ? 1 : 2);
+        allOk &= ok;
+        std::printf("%-20s %18lld %14.1f %12d %10.0f %8s\n", PolicyName(policy),
+            pending.lastValue.load(), atMs, runningRuns.load(), nsPerDuplicate, Verdict(ok));
+        ++round;
+    }
+
+    // 3. AddAsyncTask：KeepEarliest 只发起一次外部操作；Replace 取消还在等待的旧任务，只执行最后一次提交
+    {
+        std::vector<TaskScheduler::AsyncDone> dones;
+        std::atomic<int> starts{ 0 };
+        std::atomic<int> runs{ 0 };
+        for (int i = 0; i < 10; ++i) {
+            TaskBody body("Coalesce Async", [&runs] { runs.fetch_add(1); });
+            body.options.coalesceKey = "async-keep";
+            body.options.coalesce = CoalescePolicy::KeepEarliest;
+            scheduler.AddAsyncTask(std::move(body), [&](TaskScheduler::AsyncDone done) {
+                starts.fetch_add(1);
+                dones.push_back(std::move(done));
+            });
+        }
+        for (auto& done : dones) done();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const bool keepOk = starts.load() == 1 && runs.load() == 1;
+
+        dones.clear();
+        std::atomic<int> replaceStarts{ 0 };
+        std::atomic<long long> lastValue{ -1 };
+        std::atomic<int> replaceRuns{ 0 };
+        for (int i = 0; i < 10; ++i) {
+            TaskBody body("Coalesce Async", [&lastValue, &replaceRuns, i] { lastValue = i; replaceRuns.fetch_add(1); });
+            body.options.coalesceKey = "async-replace";
+            scheduler.AddAsyncTask(std::move(body), [&](TaskScheduler::AsyncDone done) {
+                replaceStarts.fetch_add(1);
+                dones.push_back(std::move(done));
+            });
+        }
+        for (auto& done : dones) done(); // 被取消的任务的 done() 被忽略
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const bool replaceOk = replaceStarts.load() == 10 && replaceRuns.load() == 1 && lastValue.load() == 9;
+        allOk &= keepOk && replaceOk;
+        std::printf("\nasync KeepEarliest : 10 submits, %d started, %d ran  %s\n", starts.load(), runs.load(), Verdict(keepOk));
+        std::printf("async Replace      : 10 submits, %d started, %d ran (#%lld)  %s\n",
+            replaceStarts.load(), replaceRuns.load(), lastValue.load(), Verdict(replaceOk));
+    }
+
+    // 4. 动态键：每个任务一个不同的合并键与限流键，全部结束后键表回到原来的大小
+    {
+        const size_t before = scheduler.GetCoalesceStats().internedKeys;
+        const int kKeys = 1000;
+        std::atomic<int> runs{ 0 };
+        std::vector<std::string> keys;
+        for (int i = 0; i < kKeys; ++i) keys.push_back("dynamic-" + std::to_string(i));
+        for (int i = 0; i < kKeys; ++i) {
+            TaskOptions options;
+            options.coalesceKey = keys[i].c_str();
+            options.limitKey = keys[i].c_str();
+            scheduler.AddTask("Coalesce Dynamic", [&runs] { runs.fetch_add(1); }, 0, 0, options);
+        }
+        const size_t peak = scheduler.GetCoalesceStats().internedKeys;
+        while (runs.load() < kKeys) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 节点在执行之后回收
+        const size_t after = scheduler.GetCoalesceStats().internedKeys;
+        const bool ok = after == before;
+        allOk &= ok;
+        std::printf("dynamic keys       : %d keys, table %zu -> %zu (peak %zu)  %s\n", kKeys, before, after, peak, Verdict(ok));
+    }
+
+    const CoalesceStats stats = scheduler.GetCoalesceStats();
+    std::printf("\nstats: submitted %llu, replaced %llu, kept %llu, merged %llu\n",
+        stats.submitted, stats.replaced, stats.kept, stats.merged);
+    scheduler.Stop();
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_coroutines.cpp
+// 对应需求: 大量“多数时间在等待”的任务：协程挂起 vs 在工作线程上 sleep
+// 编译示例: cl /O2 /EHsc /std:c++20 /I..\MyTaskScheduler bench_coroutines.cpp
+// 说明: 每个任务等待 kSteps 次、每次 kStepMs 毫秒；协程版本挂在时间轮上，
+//       sleep 版本占着工作线程等待 (任务数少很多，仍然慢得多)
+// =================================================================================
+#include "CoTask.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+constexpr unsigned kWorkers = 4;
+constexpr int kSteps = 5;
+constexpr int kStepMs = 10;
+
+std::atomic<long> g_finished{ 0 };
+
+CoTask WaitingCoroutine(TaskScheduler& scheduler) {
+    for (int i = 0; i < kSteps; ++i) {
+        co_await scheduler.Delay(kStepMs);
+    }
+    g_finished.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WaitFinished(long target) {
+    while (g_finished.load() < target) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+long long ElapsedMs(BenchClock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(BenchClock::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    auto& scheduler = TaskScheduler::Instance();
+    scheduler.Start(kWorkers);
+    std::printf("workers: %u, each task waits %d x %dms\n", kWorkers, kSteps, kStepMs);
+    std::printf("%-10s %8s %10s %16s\n", "mode", "tasks", "wall ms", "ideal wall ms");
+
+    for (long tasks : { 1000L, 10000L, 50000L }) {
+        g_finished = 0;
+        auto start = BenchClock::now();
+        for (long i = 0; i < tasks; ++i) scheduler.Spawn("Waiting Coroutine", WaitingCoroutine(scheduler));
+        WaitFinished(tasks);
+        std::printf("%-10s %8ld %10lld %16d\n", "coroutine", tasks, ElapsedMs(start), kSteps * kStepMs);
+    }
+
+    // 对照：同样的等待写成 sleep，每个任务独占一个工作线程
+    const long sleepTasks = 40;
+    g_finished = 0;
+    auto start = BenchClock::now();
+    for (long i = 0; i < sleepTasks; ++i) {
+        scheduler.AddTask("Sleeping Task", [] {
+            for (int step = 0; step < kSteps; ++step) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(kStepMs));
+            }
+            g_finished.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    WaitFinished(sleepTasks);
+    std::printf("%-10s %8ld %10lld %16ld\n", "sleep", sleepTasks, ElapsedMs(start),
+        static_cast<long>(kSteps * kStepMs) * sleepTasks / static_cast<long>(kWorkers));
+
+    scheduler.Stop();
+    return 0;
+}
+
+#else
+
+int main() {
+    std::printf("bench_coroutines requires C++20 coroutine support (/std:c++20)\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,163 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_gemm.cpp
+// 对应需求: 矩阵乘法 GFLOP/s：原 vector<vector<double>> 三重循环 vs 分块打包内核 (各指令集 / 并行)
+// 编译示例: cl /O2 /EHsc /std:c++17 /I..\MyTaskScheduler bench_gemm.cpp
+// 用法: bench_gemm [最大边长，默认 4096] [原始循环的最大边长，默认 1024]
+// 说明: 每个结果都与朴素 i-j-k 结果比对 (原始循环跑过的尺寸全量比对，其余随机抽样 256 个元素)
+// =================================================================================
+#include "MatrixKernel.h"
+#include "SchedulerEngine.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+// 原 CMatrixTask 的实现：每行单独分配，内层循环按列跨行访问 matB
+double RunLegacy(size_t size, const Matrix& a, const Matrix& b, Matrix& out) {
+    std::vector<std::vector<double>> matA(size, std::vector<double>(size));
+    std::vector<std::vector<double>> matB(size, std::vector<double>(size));
+    std::vector<std::vector<double>> matC(size, std::vector<double>(size, 0.0));
+    for (size_t i = 0; i < size; ++i) {
+        for (size_t j = 0; j < size; ++j) {
+            matA[i][j] = a(i, j);
+            matB[i][j] = b(i, j);
+        }
+    }
+
+    auto start = BenchClock::now();
+    for (size_t i = 0; i < size; ++i) {
+        for (size_t j = 0; j < size; ++j) {
+            for (size_t k = 0; k < size; ++k) {
+                matC[i][j] += matA[i][k] * matB[k][j];
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+    out = Matrix(size, size);
+    for (size_t i = 0; i < size; ++i) {
+        for (size_t j = 0; j < size; ++j) out(i, j) = matC[i][j];
+    }
+    return seconds;
+}
+
+// 小矩阵一次只有零点几毫秒，取多次中最快的一次
+double RunKernel(const Matrix& a, const Matrix& b, Matrix& c, const GemmOptions& options) {
+    const int repeats = (a.Rows() <= 512) ? 5 : 1;
+    double best = 0.0;
+    for (int r = 0; r < repeats; ++r) {
+        auto start = BenchClock::now();
+        MatrixMultiply(a, b, c, options);
+        double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+        if (r == 0 || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+// 与参照结果的最大相对误差；没有完整参照时按朴素点积随机抽样
+double MaxError(const Matrix& a, const Matrix& b, const Matrix& c, const Matrix* reference) {
+    double worst = 0.0;
+    auto check = [&](size_t i, size_t j, double expected) {
+        double err = std::fabs(c(i, j) - expected) / (std::fabs(expected) + 1.0);
+        if (err > worst) worst = err;
+    };
+    if (reference) {
+        for (size_t i = 0; i < c.Rows(); ++i) {
+            for (size_t j = 0; j < c.Cols(); ++j) check(i, j, (*reference)(i, j));
+        }
+        return worst;
+    }
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<size_t> row(0, c.Rows() - 1), col(0, c.Cols() - 1);
+    for (int s = 0; s < 256; ++s) {
+        size_t i = row(gen), j = col(gen);
+        double sum = 0.0;
+        for (size_t p = 0; p < a.Cols(); ++p) sum += a(i, p) * b(p, j);
+        check(i, j, sum);
+    }
+    return worst;
+}
+
+double GFlops(size_t size, double seconds) {
+    return 2.0 * size * size * size / seconds / 1e9;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t maxSize = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 4096;
+    const size_t maxLegacy = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 1024;
+
+    auto& scheduler = TaskScheduler::Instance();
+    scheduler.Start();
+    GemmOptions parallel;
+    parallel.parallelFor = [&](size_t count, const std::function<void(size_t)>& body) {
+        scheduler.ParallelFor(count, body);
+    };
+
+    std::vector<SimdLevel> levels{ SimdLevel::Scalar };
+    if (DetectSimdLevel() >= SimdLevel::Avx2) levels.push_back(SimdLevel::Avx2);
+    if (DetectSimdLevel() >= SimdLevel::Avx512) levels.push_back(SimdLevel::Avx512);
+
+    std::printf("cpu: %s, workers: %zu (GFLOP/s; max relative error vs naive in brackets)\n",
+        SimdLevelName(DetectSimdLevel()), scheduler.GetWorkerCount());
+    std::printf("%-6s %18s", "size", "legacy");
+    for (SimdLevel level : levels) std::printf(" %18s", SimdLevelName(level));
+    std::printf(" %18s\n", "parallel");
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    bool ok = true;
+    for (size_t size : { size_t(200), size_t(256), size_t(512), size_t(1024), size_t(2048), size_t(4096) }) {
+        if (size > maxSize) break;
+        Matrix a(size, size), b(size, size), c;
+        for (size_t i = 0; i < size; ++i) {
+            for (size_t j = 0; j < size; ++j) {
+                a(i, j) = dist(gen);
+                b(i, j) = dist(gen);
+            }
+        }
+
+        std::printf("%-6zu", size);
+        Matrix naive;
+        const Matrix* reference = nullptr;
+        if (size <= maxLegacy) {
+            Matrix legacy;
+            double seconds = RunLegacy(size, a, b, legacy);
+            MatrixMultiplyNaive(a, b, naive);
+            reference = &naive;
+            double err = MaxError(a, b, legacy, reference);
+            ok &= err < 1e-9;
+            std::printf(" %8.2f [%7.1e]", GFlops(size, seconds), err);
+        }
+        else {
+            std::printf(" %18s", "-");
+        }
+
+        auto report = [&](const GemmOptions& options) {
+            double seconds = RunKernel(a, b, c, options);
+            double err = MaxError(a, b, c, reference);
+            ok &= err < 1e-9;
+            std::printf(" %8.2f [%7.1e]", GFlops(size, seconds), err);
+        };
+        for (SimdLevel level : levels) {
+            GemmOptions options;
+            options.simd = level;
+            report(options);
+        }
+        report(parallel);
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    scheduler.Stop();
+    std::printf("result check: %s\n", ok ? "OK" : "MISMATCH");
+    return ok ? 0 : 1;
+}
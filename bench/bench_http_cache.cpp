@@ -0,0 +1,145 @@
+// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_http_cache.cpp
+// 对应需求: 结果缓存 + 条件请求：对本地替身服务器 (LocalHttpServer.h) 对比不缓存、TTL 命中、
+//           ETag 重新验证 (304)、并发相同请求合并 (Single-flight)、LRU 容量上限与源站故障时的过期兜底
+// 编译示例: cmake -S . -B build && cmake --build build --target bench_http_cache
+// 用法: bench_http_cache [顺序请求数，默认 200] [并发任务数，默认 64] [源站延迟毫秒，默认 5]
+// =================================================================================
+#include "SchedulerEngine.h"
+#include "HttpClient.h"
+#include "LocalHttpServer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+double Millis(BenchClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+}
+
+void PrintRow(const char* name, size_t fetches, const LocalHttpServer::Stats& origin, double ms) {
+    std::printf("%-26s %7zu %9llu %7llu %11.1f %10.2f\n", name, fetches,
+        origin.requests, origin.notModified, static_cast<double>(origin.bytesSent) / 1024.0, ms);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t sequential = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 200;
+    const size_t concurrent = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 64;
+    const int latencyMs = (argc > 3) ? std::atoi(argv[3]) : 5;
+
+    LocalHttpServer server;
+    if (!server.Start()) {
+        std::printf("cannot start the local server\n");
+        return 1;
+    }
+    server.SetLatency(std::chrono::milliseconds(latencyMs));
+    server.SetResource("/zen", "Design for failure.");
+    server.SetResource("/big", std::string(256 * 1024, 'z'));
+    server.SetFallbackSize(4 * 1024);
+    const std::string zen = server.Url("/zen");
+    const std::string big = server.Url("/big");
+
+    std::printf("origin %s, %d ms per request\n\n", server.Url("/").c_str(), latencyMs);
+    std::printf("%-26s %7s %9s %7s %11s %10s\n", "scenario", "fetches", "requests", "304s", "body KB", "ms");
+
+    // 1. 背靠背获取同一 URL：不缓存时每次都访问源站，TTL 内全部命中
+    {
+        server.ResetStats();
+        auto start = BenchClock::now();
+        for (size_t i = 0; i < sequential; ++i) HttpGet(zen);
+        PrintRow("no cache", sequential, server.GetStats(), Millis(start));
+
+        ResultCache cache;
+        CachedHttpClient client(cache, std::chrono::seconds(30));
+        server.ResetStats();
+        start = BenchClock::now();
+        for (size_t i = 0; i < sequential; ++i) client.Fetch(zen);
+        PrintRow("ttl 30 s", sequential, server.GetStats(), Millis(start));
+    }
+
+    // 2. 每次都过期 (TTL 0)：ETag 重新验证，源站只回答 304，内容变化后才重新下载
+    {
+        ResultCache cache;
+        CachedHttpClient client(cache, std::chrono::milliseconds(0));
+        server.ResetStats();
+        auto start = BenchClock::now();
+        for (size_t i = 0; i < sequential; ++i) HttpGet(big);
+        PrintRow("no cache, 256 KB", sequential, server.GetStats(), Millis(start));
+
+        server.ResetStats();
+        start = BenchClock::now();
+        size_t revalidated = 0;
+        for (size_t i = 0; i < sequential; ++i) {
+            if (i == sequential / 2) server.SetResource("/big", std::string(256 * 1024, 'Z')); // 中途内容变化
+            HttpFetchResult r = client.Fetch(big);
+            if (r.revalidated) ++revalidated;
+            if (!r.ok || r.Body()[0] != ((i < sequential / 2) ? 'z' : 'Z')) std::printf("  wrong content at %zu\n", i);
+        }
+        PrintRow("ttl 0, etag revalidate", sequential, server.GetStats(), Millis(start));
+    }
+
+    // 3. 调度器上的并发任务同时获取同一个未缓存的 URL：只有一个请求到达源站
+    {
+        ResultCache cache;
+        CachedHttpClient client(cache, std::chrono::seconds(30));
+        TaskScheduler& scheduler = TaskScheduler::Instance();
+        scheduler.Start(4);
+        server.ResetStats();
+        server.SetLatency(std::chrono::milliseconds(latencyMs * 10));
+        std::atomic<size_t> done{ 0 };
+        std::atomic<size_t> okCount{ 0 };
+        TaskOptions options;
+        options.blocking = true; // 等网络的任务交给弹性线程池，全部同时在途
+        const auto start = BenchClock::now();
+        for (size_t i = 0; i < concurrent; ++i) {
+            scheduler.AddTask("Fetch Task", [&] {
+                if (client.Fetch(zen).ok) okCount.fetch_add(1);
+                done.fetch_add(1);
+            }, 0, 0, options);
+        }
+        while (done.load() < concurrent) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        PrintRow("single-flight tasks", concurrent, server.GetStats(), Millis(start));
+        std::printf("  %zu/%zu ok, %llu joined an in-flight request\n",
+            okCount.load(), concurrent, cache.GetStats().joined);
+        scheduler.Stop();
+        server.SetLatency(std::chrono::milliseconds(latencyMs));
+    }
+
+    // 4. LRU：64 个条目的缓存，工作集 48 个 URL 时几乎全部命中，96 个时循环访问全部淘汰
+    for (size_t workingSet : { size_t(48), size_t(96) }) {
+        ResultCacheOptions options;
+        options.maxEntries = 64;
+        ResultCache cache(options);
+        CachedHttpClient client(cache, std::chrono::seconds(30));
+        server.ResetStats();
+        const auto start = BenchClock::now();
+        for (size_t i = 0; i < sequential * 2; ++i) client.Fetch(server.Url("/item/" + std::to_string(i % workingSet)));
+        char name[64];
+        std::snprintf(name, sizeof(name), "lru 64, working set %zu", workingSet);
+        PrintRow(name, sequential * 2, server.GetStats(), Millis(start));
+        const ResultCacheStats stats = cache.GetStats();
+        std::printf("  hits %llu, evictions %llu, %zu entries, %.1f KB\n",
+            stats.hits, stats.evictions, stats.entries, static_cast<double>(stats.bytes) / 1024.0);
+    }
+
+    // 5. 源站停止：过期内容兜底
+    {
+        ResultCache cache;
+        CachedHttpClient client(cache, std::chrono::milliseconds(0));
+        client.Fetch(zen);
+        server.Stop();
+        HttpFetchResult r = client.Fetch(zen);
+        std::printf("\norigin down: ok=%d stale=%d body=\"%s\" (%s)\n",
+            r.ok ? 1 : 0, r.stale ? 1 : 0, r.Body().c_str(), r.error.c_str());
+    }
+    return 0;
+}
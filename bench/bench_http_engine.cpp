@@ -0,0 +1,210 @@
+// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_http_engine.cpp
+// 对应需求: 非阻塞 HTTP 引擎：对本地替身服务器 (LocalHttpServer.h) 对比原来的阻塞路径
+//           (每个请求一个连接、等待网络的任务占着线程) 与 HttpEngine (keep-alive 连接池、一个 IO 线程、
+//           AddFetchTask 等待期间不占线程) 的每秒请求数与延迟分布
+// 编译示例: cmake -S . -B build && cmake --build build --target bench_http_engine
+// 用法: bench_http_engine [请求数，默认 4000] [在途请求数，默认 64] [源站延迟毫秒，默认 2]
+// =================================================================================
+#include "SchedulerEngine.h"
+#include "HttpEngine.h"
+#include "LocalHttpServer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+// 每个请求从发出到拿到响应的时延 (预分配，完成时按原子序号写入)
+struct LatencyLog {
+    std::vector<int64_t> us;
+    std::atomic<size_t> count{ 0 };
+    std::atomic<size_t> written{ 0 };   // 已写入 us 的条数 (等待它而不是 count，读取时写入都已完成)
+    std::atomic<size_t> failed{ 0 };
+
+    explicit LatencyLog(size_t capacity) : us(capacity) {}
+
+    void Record(BenchClock::time_point sent, bool ok) {
+        if (!ok) failed.fetch_add(1, std::memory_order_relaxed);
+        const size_t i = count.fetch_add(1, std::memory_order_relaxed);
+        if (i < us.size()) us[i] = std::chrono::duration_cast<std::chrono::microseconds>(BenchClock::now() - sent).count();
+        written.fetch_add(1);
+    }
+
+    void WaitFor(size_t total) const {
+        while (written.load() < total) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+};
+
+double Percentile(std::vector<int64_t>& values, double p) {
+    if (values.empty()) return 0;
+    const size_t k = static_cast<size_t>(p * static_cast<double>(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(k), values.end());
+    return static_cast<double>(values[k]) / 1000.0;
+}
+
+void PrintRow(const char* name, LatencyLog& log, size_t total, double seconds,
+    const LocalHttpServer::Stats& origin, size_t waitingThreads) {
+    std::vector<int64_t> values(log.us.begin(), log.us.begin() + static_cast<std::ptrdiff_t>((std::min)(total, log.us.size())));
+    const double p50 = Percentile(values, 0.50);
+    const double p99 = Percentile(values, 0.99);
+    std::printf("%-34s %8zu %6zu %10.0f %8.2f %8.2f %7llu %8zu\n", name, total, log.failed.load(),
+        static_cast<double>(total) / seconds, p50, p99, origin.connections, waitingThreads);
+}
+
+// 闭环：先发出 window 个请求，每完成一个再发下一个，直到发出 total 个
+// issue(i) 发出第 i 个请求，完成时必须调用 Complete
+struct ClosedLoop {
+    size_t total;
+    LatencyLog& log;
+    std::function<void(size_t)> issue;
+    std::atomic<size_t> next{ 0 };
+
+    ClosedLoop(size_t total, LatencyLog& log) : total(total), log(log) {}
+
+    void Start(size_t window) {
+        for (size_t i = 0; i < window; ++i) IssueNext();
+    }
+
+    void Complete(BenchClock::time_point sent, bool ok) {
+        log.Record(sent, ok);
+        IssueNext();
+    }
+
+    void IssueNext() {
+        const size_t i = next.fetch_add(1);
+        if (i < total) issue(i);
+    }
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t total = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 4000;
+    const size_t window = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 64;
+    const int latencyMs = (argc > 3) ? std::atoi(argv[3]) : 2;
+    const size_t sequential = (std::max)(total / 8, size_t(1));
+
+    LocalHttpServer server;
+    if (!server.Start()) {
+        std::printf("cannot start the local server\n");
+        return 1;
+    }
+    server.SetFallbackSize(2 * 1024); // 每个 URL 2 KB 正文
+    auto url = [&server](size_t i) { return server.Url("/item/" + std::to_string(i)); };
+
+    HttpEngineOptions engineOptions;
+    engineOptions.maxConnectionsPerHost = window; // 与阻塞路径的线程数相同，只比较等待方式
+    engineOptions.maxIdlePerHost = window;
+    HttpEngine engine(engineOptions);
+
+    std::printf("origin %s, %zu requests, %zu in flight, %d ms per request, 2 KB bodies\n\n",
+        server.Url("/").c_str(), total, window, latencyMs);
+    std::printf("%-34s %8s %6s %10s %8s %8s %7s %8s\n",
+        "scenario", "requests", "failed", "req/s", "p50 ms", "p99 ms", "conns", "threads");
+
+    // 1. 一次一个请求 (源站不加延迟)：每次新建连接 vs keep-alive 复用
+    {
+        server.SetLatency(std::chrono::milliseconds(0));
+        LatencyLog log(sequential);
+        server.ResetStats();
+        auto start = BenchClock::now();
+        for (size_t i = 0; i < sequential; ++i) {
+            const auto sent = BenchClock::now();
+            log.Record(sent, HttpGet(url(i)).status == 200);
+        }
+        PrintRow("sequential, blocking HttpGet", log, sequential,
+            std::chrono::duration<double>(BenchClock::now() - start).count(), server.GetStats(), 1);
+
+        LatencyLog pooled(sequential);
+        server.ResetStats();
+        start = BenchClock::now();
+        for (size_t i = 0; i < sequential; ++i) {
+            const auto sent = BenchClock::now();
+            pooled.Record(sent, engine.Get(url(i)).status == 200);
+        }
+        PrintRow("sequential, HttpEngine::Get", pooled, sequential,
+            std::chrono::duration<double>(BenchClock::now() - start).count(), server.GetStats(), 1);
+    }
+
+    server.SetLatency(std::chrono::milliseconds(latencyMs));
+    TaskScheduler& scheduler = TaskScheduler::Instance();
+    ElasticPoolOptions pool;
+    pool.maxThreads = static_cast<unsigned>(window); // 阻塞路径的在途请求数受线程数限制
+    scheduler.SetBlockingPoolOptions(pool);
+    scheduler.Start(4);
+
+    // 2. 原来的阻塞路径：阻塞任务在弹性线程池上执行 HttpGet，每个在途请求占一个线程、一个新连接
+    {
+        LatencyLog log(total);
+        ClosedLoop loop(total, log);
+        TaskOptions options;
+        options.blocking = true;
+        loop.issue = [&](size_t i) {
+            const auto sent = BenchClock::now();
+            scheduler.AddTask("Blocking Fetch", [&loop, &url, i, sent] {
+                loop.Complete(sent, HttpGet(url(i)).status == 200);
+            }, 0, 0, options);
+        };
+        server.ResetStats();
+        const auto start = BenchClock::now();
+        loop.Start(window);
+        log.WaitFor(total);
+        const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+        PrintRow("blocking tasks + HttpGet", log, total, seconds, server.GetStats(),
+            scheduler.GetExecutorStats().elasticPeak);
+    }
+
+    // 3. AddFetchTask：请求由 IO 线程推进，响应到达后处理函数才在工作线程上执行
+    {
+        LatencyLog log(total);
+        ClosedLoop loop(total, log);
+        loop.issue = [&](size_t i) {
+            const auto sent = BenchClock::now();
+            scheduler.AddFetchTask("Async Fetch", HttpRequest{ url(i), HttpHeaders() },
+                [&loop, sent](HttpResponse& response) { loop.Complete(sent, response.status == 200); });
+        };
+        HttpEngine::Instance().SetOptions(engineOptions);
+        server.ResetStats();
+        const auto start = BenchClock::now();
+        loop.Start(window);
+        log.WaitFor(total);
+        const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+        PrintRow("fetch tasks (AddFetchTask)", log, total, seconds, server.GetStats(), 1);
+        const HttpEngineStats stats = HttpEngine::Instance().GetStats();
+        std::printf("  engine: %llu connections opened, %llu requests on reused connections, peak %zu in flight\n",
+            stats.connectionsOpened, stats.connectionsReused, stats.peakInFlight);
+    }
+    scheduler.Stop();
+
+    // 4. 直接使用 HttpEngine (回调在 IO 线程上)：没有调度开销时的上限
+    {
+        LatencyLog log(total);
+        ClosedLoop loop(total, log);
+        loop.issue = [&](size_t i) {
+            const auto sent = BenchClock::now();
+            engine.Fetch(HttpRequest{ url(i), HttpHeaders() },
+                [&loop, sent](HttpResponse&& response) { loop.Complete(sent, response.status == 200); });
+        };
+        server.ResetStats();
+        const auto start = BenchClock::now();
+        loop.Start(window);
+        log.WaitFor(total);
+        const double seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+        PrintRow("HttpEngine::Fetch callbacks", log, total, seconds, server.GetStats(), 1);
+    }
+
+    std::printf("\nthreads: threads waiting on the network (blocking path: elastic pool peak; engine: its IO thread)\n");
+    engine.Stop();
+    HttpEngine::Instance().Stop();
+    return 0;
+}
@@ -0,0 +1,156 @@
+// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_overload.cpp
+// 对应需求: 准入控制：以 10 倍于处理能力的速率持续提交，对比不限容量与各满载策略下
+//           被接纳任务的排队时延 (提交 -> 开始执行) 分布、接纳 / 拒绝 / 丢弃数量与积压峰值
+//           (max 列是最慢的一个被接纳任务：满载策略下它应与 p99 同一量级，远大于 p99 说明有任务被饿住)
+// 编译示例: cmake -S . -B build && cmake --build build --target bench_overload
+// 用法: bench_overload [工作线程数，默认 2] [容量，默认 64 x 线程数] [过载倍数，默认 10] [持续毫秒，默认 500]
+// =================================================================================
+#include "SchedulerEngine.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+constexpr auto kTaskCost = std::chrono::microseconds(100);
+
+void Spin(std::chrono::microseconds duration) {
+    const auto end = BenchClock::now() + duration;
+    while (BenchClock::now() < end) {}
+}
+
+// 被接纳任务的排队时延 (预分配，执行时按原子序号写入)
+struct LatencyLog {
+    std::vector<int64_t> us;
+    std::vector<uint8_t> high;
+    std::atomic<size_t> count{ 0 };
+
+    explicit LatencyLog(size_t capacity) : us(capacity), high(capacity) {}
+
+    void Record(BenchClock::time_point submitted, bool isHigh) {
+        const size_t i = count.fetch_add(1, std::memory_order_relaxed);
+        if (i >= us.size()) return;
+        us[i] = std::chrono::duration_cast<std::chrono::microseconds>(BenchClock::now() - submitted).count();
+        high[i] = isHigh ? 1 : 0;
+    }
+};
+
+double Percentile(std::vector<int64_t>& values, double p) {
+    if (values.empty()) return 0;
+    const size_t k = static_cast<size_t>(p * static_cast<double>(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(k), values.end());
+    return static_cast<double>(values[k]) / 1000.0;
+}
+
+// 处理能力：不限容量时每秒完成的任务数
+double MeasureServiceRate(TaskScheduler& scheduler, unsigned workers) {
+    const size_t tasks = static_cast<size_t>(workers) * 2000;
+    std::atomic<size_t> done{ 0 };
+    const auto start = BenchClock::now();
+    for (size_t i = 0; i < tasks; ++i) {
+        scheduler.AddTask("Overload Task", [&done] { Spin(kTaskCost); done.fetch_add(1); });
+    }
+    while (done.load() < tasks) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return static_cast<double>(tasks) / std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+struct Scenario {
+    const char* name;
+    size_t capacity;   // 0 表示不限制
+    OverloadPolicy policy;
+};
+
+void RunScenario(TaskScheduler& scheduler, const Scenario& scenario, double offeredRate, int durationMs) {
+    AdmissionOptions admission;
+    admission.capacity = scenario.capacity;
+    admission.policy = scenario.policy;
+    scheduler.SetAdmissionOptions(admission);
+    scheduler.ResetAdmissionStats();
+
+    const size_t offered = static_cast<size_t>(offeredRate * durationMs / 1000.0);
+    LatencyLog log(offered);
+    std::atomic<size_t> finished{ 0 };
+    TaskOptions normal;
+    normal.priority = TaskPriority::Normal;
+    // 每 10 个中有 1 个高优先级，ShedByPriority 优先保留它们；过载 10 倍时高优先级任务恰好占满处理能力，
+    // 积压中的普通任务要等老化提升两级 (约 400ms) 才执行，所以 ShedByPriority 挤掉的是最早接纳的普通任务
+    TaskOptions high;
+    high.priority = TaskPriority::High;
+
+    // 生产者按 1ms 一批匀速提交 (Block 策略下会被拖慢，实际提交速率降到处理能力)
+    const auto start = BenchClock::now();
+    size_t submitted = 0;
+    for (int tick = 1; submitted < offered; ++tick) {
+        const size_t target = (std::min)(offered, static_cast<size_t>(offeredRate * tick / 1000.0));
+        for (; submitted < target; ++submitted) {
+            const bool isHigh = (submitted % 10 == 0);
+            const auto now = BenchClock::now();
+            scheduler.AddTask("Overload Task", [&log, &finished, now, isHigh] {
+                log.Record(now, isHigh);
+                Spin(kTaskCost);
+                finished.fetch_add(1, std::memory_order_relaxed);
+            }, 0, 0, isHigh ? high : normal);
+        }
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(tick));
+    }
+    const double submitMs = std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+
+    // 等待积压清空 (被丢弃的任务不会执行)
+    while (scheduler.GetAdmissionStats().held > 0 || finished.load() < log.count.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const double totalMs = std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+
+    const AdmissionStats stats = scheduler.GetAdmissionStats();
+    const size_t ran = (std::min)(log.count.load(), log.us.size());
+    std::vector<int64_t> all(log.us.begin(), log.us.begin() + static_cast<std::ptrdiff_t>(ran));
+    std::vector<int64_t> highOnly;
+    for (size_t i = 0; i < ran; ++i) {
+        if (log.high[i]) highOnly.push_back(log.us[i]);
+    }
+    const double maxMs = all.empty() ? 0 : static_cast<double>(*std::max_element(all.begin(), all.end())) / 1000.0;
+    std::printf("%-16s %7zu %7zu %7llu %7llu %6zu %9.2f %9.2f %9.2f %9.2f %8.0f %8.0f\n",
+        scenario.name, offered, ran,
+        static_cast<unsigned long long>(stats.rejected), static_cast<unsigned long long>(stats.dropped),
+        stats.peakHeld, Percentile(all, 0.50), Percentile(all, 0.99), maxMs, Percentile(highOnly, 0.99),
+        submitMs, totalMs);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const unsigned workers = (argc > 1) ? static_cast<unsigned>(std::atoi(argv[1])) : 2;
+    const size_t capacity = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : workers * 64;
+    const double overload = (argc > 3) ? std::atof(argv[3]) : 10.0;
+    const int durationMs = (argc > 4) ? std::atoi(argv[4]) : 500;
+
+    TaskScheduler& scheduler = TaskScheduler::Instance();
+    scheduler.Start(workers);
+    const double serviceRate = MeasureServiceRate(scheduler, workers);
+    const double offeredRate = serviceRate * overload;
+    std::printf("%u workers, %lld us per task: service rate %.0f tasks/s, offered %.0f tasks/s (%.0fx) for %d ms, capacity %zu\n\n",
+        workers, static_cast<long long>(kTaskCost.count()), serviceRate, offeredRate, overload, durationMs, capacity);
+    std::printf("%-16s %7s %7s %7s %7s %6s %9s %9s %9s %9s %8s %8s\n",
+        "policy", "offered", "ran", "reject", "dropped", "peak", "p50 ms", "p99 ms", "max ms", "p99 high", "submitMs", "totalMs");
+
+    const Scenario scenarios[] = {
+        { "Unbounded",      0,        OverloadPolicy::Reject },
+        { "Reject",         capacity, OverloadPolicy::Reject },
+        { "DropOldest",     capacity, OverloadPolicy::DropOldest },
+        { "ShedByPriority", capacity, OverloadPolicy::ShedByPriority },
+        { "Block",          capacity, OverloadPolicy::Block },
+    };
+    for (const Scenario& scenario : scenarios) RunScenario(scheduler, scenario, offeredRate, durationMs);
+
+    scheduler.SetAdmissionOptions(AdmissionOptions());
+    scheduler.Stop();
+    return 0;
+}
@@ -0,0 +1,103 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_priority.cpp
+// 对应需求: 工作线程饱和时，高优先级 + 截止时间任务的 SLO (截止时间命中率)
+// 编译示例: cl /O2 /EHsc /std:c++17 /I..\MyTaskScheduler bench_priority.cpp
+// 说明: 先灌入大量耗时的后台任务占满所有工作线程，再周期性地提交带 5ms 截止时间的探针任务；
+//       对比“按优先级分级”与“全部 Normal”两种提交方式下探针的截止时间命中情况
+// =================================================================================
+#include "SchedulerEngine.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+constexpr int kWorkers = 2;
+constexpr int kBackgroundTasks = 3000;   // 每个约 1ms，2 个工作线程约积压 1.5 秒
+constexpr int kProbes = 300;             // 每 5ms 一个，覆盖整个积压期
+constexpr int kProbeDeadlineMs = 5;
+
+std::atomic<long> g_background{ 0 };
+std::atomic<long> g_probes{ 0 };
+
+void Spin(std::chrono::microseconds duration) {
+    auto end = BenchClock::now() + duration;
+    while (BenchClock::now() < end) {}
+}
+
+// 后台批处理任务：每次占用工作线程约 1ms
+class CBackgroundTask : public ITask {
+public:
+    void Execute() override {
+        Spin(std::chrono::microseconds(1000));
+        g_background.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::string GetName() const override { return "Background Task"; }
+};
+
+void PrintStats(const char* mode) {
+    auto& scheduler = TaskScheduler::Instance();
+    for (size_t i = 0; i < kTaskPriorityCount; ++i) {
+        auto priority = static_cast<TaskPriority>(i);
+        PriorityClassStats stats = scheduler.GetPriorityStats(priority);
+        if (stats.executed == 0) continue;
+        std::printf("%-10s %-9s %9llu %9llu %9llu %8llu %14lld\n", mode, TaskPriorityName(priority),
+            stats.executed, stats.withDeadline, stats.deadlineMisses, stats.agedPromotions, stats.maxLatenessUs);
+    }
+}
+
+// prioritized 为 true 时后台任务为 Low、探针为 Critical；否则全部为 Normal
+// 两种方式下探针都带相同的截止时间，后台任务不带截止时间
+void Run(bool prioritized) {
+    auto& scheduler = TaskScheduler::Instance();
+    scheduler.ResetPriorityStats();
+    g_background = 0;
+    g_probes = 0;
+
+    TaskOptions background;
+    background.priority = prioritized ? TaskPriority::Low : TaskPriority::Normal;
+    auto task = std::make_shared<CBackgroundTask>();
+    std::vector<TaskSubmission> flood(kBackgroundTasks);
+    for (auto& sub : flood) {
+        sub.task = task;
+        sub.options = background;
+    }
+    scheduler.AddTasks(flood);
+
+    TaskOptions probe;
+    probe.priority = prioritized ? TaskPriority::Critical : TaskPriority::Normal;
+    probe.deadlineMs = kProbeDeadlineMs;
+    for (int i = 0; i < kProbes; ++i) {
+        scheduler.AddTask("Probe", [] { g_probes.fetch_add(1); }, 0, 0, probe);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    while (g_background.load() < kBackgroundTasks || g_probes.load() < kProbes) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    PrintStats(prioritized ? "priority" : "all-normal");
+}
+
+} // namespace
+
+int main() {
+    auto& scheduler = TaskScheduler::Instance();
+    scheduler.Start(kWorkers);
+
+    std::printf("workers: %d, background: %d x 1ms, probes: %d (deadline %dms)\n",
+        kWorkers, kBackgroundTasks, kProbes, kProbeDeadlineMs);
+    std::printf("%-10s %-9s %9s %9s %9s %8s %14s\n",
+        "mode", "class", "executed", "deadline", "misses", "aged", "max late us");
+
+    Run(false);
+    Run(true);
+
+    scheduler.Stop();
+    return 0;
+}
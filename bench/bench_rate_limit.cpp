@@ -0,0 +1,166 @@
+// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_rate_limit.cpp
+// 对应需求: 按任务类型限流：并发上限下的等待与放行、令牌桶的开始间隔、取消挂起中的任务、
+//           带限流键的 WhenAny 后继在等待名额期间不受其余前驱影响 (每项打印 OK / FAIL)
+// 编译示例: cmake -S . -B build && cmake --build build --target bench_rate_limit
+// 用法: bench_rate_limit [工作线程数，默认 4] [每项任务数，默认 40] [令牌速率 /s，默认 200]
+// =================================================================================
+#include "SchedulerEngine.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+double Millis(BenchClock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+void WaitUntil(const std::atomic<size_t>& counter, size_t target) {
+    while (counter.load() < target) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+const char* Verdict(bool ok) { return ok ? "OK" : "FAIL"; }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const unsigned workers = (argc > 1) ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 4;
+    const size_t tasks = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 40;
+    const double rate = (argc > 3) ? std::atof(argv[3]) : 200.0;
+
+    TaskScheduler& scheduler = TaskScheduler::Instance();
+    scheduler.Start(workers);
+    std::printf("%u workers, %zu tasks per scenario\n\n", workers, tasks);
+    bool allOk = true;
+
+    // 1. 并发上限 2：每个任务睡 5ms，同时执行的数量不超过上限，等待者在空位释放时依次放行
+    {
+        RateLimit limit;
+        limit.maxConcurrent = 2;
+        scheduler.SetRateLimit("Slot Task", limit);
+        std::atomic<int> running{ 0 };
+        std::atomic<int> peak{ 0 };
+        std::atomic<size_t> done{ 0 };
+        const auto start = BenchClock::now();
+        for (size_t i = 0; i < tasks; ++i) {
+            scheduler.AddTask("Slot Task", [&] {
+                const int now = running.fetch_add(1) + 1;
+                int prev = peak.load();
+                while (prev < now && !peak.compare_exchange_weak(prev, now)) {}
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                running.fetch_sub(1);
+                done.fetch_add(1);
+            });
+        }
+        WaitUntil(done, tasks);
+        const double ms = Millis(BenchClock::now() - start);
+        const RateLimitStats stats = scheduler.GetRateLimitStats("Slot Task");
+        const bool ok = peak.load() <= limit.maxConcurrent && stats.started == tasks;
+        allOk &= ok;
+        std::printf("slot wait   : limit %d, peak %d running, %.1f ms (ideal %.1f), %llu parked  %s\n",
+            limit.maxConcurrent, peak.load(), ms, 5.0 * static_cast<double>(tasks) / limit.maxConcurrent,
+            stats.deferredForSlot, Verdict(ok));
+    }
+
+    // 2. 令牌桶：rate 次/秒、突发 1，开始执行的平均间隔应接近 1000 / rate 毫秒
+    {
+        RateLimit limit;
+        limit.ratePerSecond = rate;
+        limit.burst = 1;
+        scheduler.SetRateLimit("Paced Task", limit);
+        std::vector<BenchClock::time_point> starts(tasks);
+        std::atomic<size_t> done{ 0 };
+        for (size_t i = 0; i < tasks; ++i) {
+            scheduler.AddTask("Paced Task", [&starts, &done] {
+                starts[done.fetch_add(1)] = BenchClock::now();
+            });
+        }
+        WaitUntil(done, tasks);
+        double minGap = 1e9;
+        for (size_t i = 1; i < tasks; ++i) minGap = (std::min)(minGap, Millis(starts[i] - starts[i - 1]));
+        const double span = Millis(starts[tasks - 1] - starts[0]);
+        const double achieved = (tasks > 1) ? 1000.0 * static_cast<double>(tasks - 1) / span : 0;
+        const RateLimitStats stats = scheduler.GetRateLimitStats("Paced Task");
+        // 定时器精度为一个时间轮刻度：允许 20% 的偏差，不能快于设定速率
+        const bool ok = achieved <= rate * 1.05 && achieved >= rate * 0.8;
+        allOk &= ok;
+        std::printf("pacing      : %.0f/s requested, %.1f/s achieved, min gap %.2f ms, %llu deferred  %s\n",
+            rate, achieved, minGap, stats.deferredForToken, Verdict(ok));
+    }
+
+    // 3. 取消挂起的任务：上限 1，占位任务执行期间提交的任务都在等待名额，取消其中一半
+    {
+        RateLimit limit;
+        limit.maxConcurrent = 1;
+        scheduler.SetRateLimit("Parked Task", limit);
+        std::atomic<size_t> started{ 0 };
+        std::atomic<size_t> done{ 0 };
+        scheduler.AddTask("Parked Task", [&] {
+            started.fetch_add(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            done.fetch_add(1);
+        });
+        WaitUntil(started, 1);
+        std::vector<TaskHandle> handles;
+        for (size_t i = 0; i < tasks; ++i) {
+            handles.push_back(scheduler.AddTask("Parked Task", [&done] { done.fetch_add(1); }));
+        }
+        while (scheduler.GetRateLimitStats("Parked Task").waitingForSlot < tasks) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        size_t cancelled = 0;
+        for (size_t i = 0; i < tasks; i += 2) cancelled += handles[i].Cancel() ? 1 : 0;
+        const size_t expected = 1 + tasks - cancelled;
+        WaitUntil(done, expected);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 被取消的任务不应再执行
+        const RateLimitStats stats = scheduler.GetRateLimitStats("Parked Task");
+        const bool ok = cancelled == (tasks + 1) / 2 && done.load() == expected && stats.running == 0;
+        allOk &= ok;
+        std::printf("cancel      : %zu parked, %zu cancelled, %zu executed (expected %zu), %d running  %s\n",
+            tasks, cancelled, done.load(), expected, stats.running, Verdict(ok));
+    }
+
+    // 4. WhenAny 后继与占位任务共用上限 1：快前驱放行后继，后继等待名额期间慢前驱失败结束，
+    //    后继不被取消、只执行一次，且在占位任务结束之后
+    {
+        RateLimit limit;
+        limit.maxConcurrent = 1;
+        scheduler.SetRateLimit("Limited Join", limit);
+        std::atomic<size_t> started{ 0 };
+        std::atomic<bool> holderDone{ false };
+        scheduler.AddTask("Limited Join", [&] {
+            started.fetch_add(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(60));
+            holderDone = true;
+        });
+        WaitUntil(started, 1);
+        std::atomic<size_t> runs{ 0 };
+        std::atomic<bool> afterHolder{ true };
+        TaskHandle fast = scheduler.AddTask("Pred Fast", [] {});
+        TaskHandle slow = scheduler.AddTask("Pred Slow", [] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            throw std::runtime_error("slow predecessor failed"); // WhenAny 已被快前驱满足，失败不应取消后继
+        });
+        scheduler.WhenAny({ fast, slow }, TaskBody("Limited Join", [&] {
+            if (!holderDone.load()) afterHolder = false;
+            runs.fetch_add(1);
+        }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        const bool ok = runs.load() == 1 && afterHolder.load();
+        allOk &= ok;
+        std::printf("when-any    : continuation ran %zu time(s), %s the holder  %s\n",
+            runs.load(), afterHolder.load() ? "after" : "during", Verdict(ok));
+    }
+
+    scheduler.Stop();
+    return allOk ? 0 : 1;
+}
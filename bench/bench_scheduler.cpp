@@ -0,0 +1,452 @@
+// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_scheduler.cpp
+// 对应需求: 调度引擎无界面基准：多生产者 AddTask 吞吐、到期 -> 开始执行的分发延迟分位数、
+//           周期任务抖动、空任务 / CPU 任务 / 睡眠任务的端到端吞吐、运行统计与时间线追踪开销；结果输出 JSON 便于版本间对比
+// 编译示例: cmake -S . -B build && cmake --build build --target bench_scheduler
+// 用法: bench_scheduler [--quick] [--workers N] [--json 文件名，"-" 表示标准输出]
+// =================================================================================
+#include "SchedulerEngine.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    bool quick = false;
+    unsigned workers = 0;
+    std::string jsonPath = "bench_scheduler.json";
+};
+
+double Seconds(BenchClock::time_point start, BenchClock::time_point end = BenchClock::now()) {
+    return std::chrono::duration<double>(end - start).count();
+}
+
+double Micros(BenchClock::duration d) {
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+void WaitFor(const std::atomic<long>& counter, long target) {
+    while (counter.load() < target) std::this_thread::sleep_for(std::chrono::microseconds(200));
+}
+
+// === 极简 JSON 输出 (只需要对象、数组、数字和字符串) ===
+class JsonWriter {
+public:
+    JsonWriter& BeginObject(const char* key = nullptr) { Open(key, '{'); return *this; }
+    JsonWriter& EndObject() { Close('}'); return *this; }
+    JsonWriter& BeginArray(const char* key = nullptr) { Open(key, '['); return *this; }
+    JsonWriter& EndArray() { Close(']'); return *this; }
+
+    JsonWriter& Value(const char* key, double value) {
+        Key(key);
+        if (std::isfinite(value)) {
+            char text[32];
+            std::snprintf(text, sizeof(text), "%.6g", value);
+            m_out << text;
+        }
+        else {
+            m_out << "null";
+        }
+        return *this;
+    }
+    JsonWriter& Value(const char* key, long long value) { Key(key); m_out << value; return *this; }
+    JsonWriter& Value(const char* key, const std::string& value) {
+        Key(key);
+        m_out << '"';
+        for (char c : value) {
+            if (c == '"' || c == '\\') m_out << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20) m_out << ' ';
+            else m_out << c;
+        }
+        m_out << '"';
+        return *this;
+    }
+
+    std::string Str() const { return m_out.str() + "\n"; }
+
+private:
+    void Key(const char* key) {
+        if (!m_first.empty()) {
+            if (!m_first.back()) m_out << ',';
+            m_first.back() = false;
+            m_out << '\n' << std::string(m_first.size() * 2, ' ');
+        }
+        if (key) m_out << '"' << key << "\": ";
+    }
+    void Open(const char* key, char bracket) {
+        Key(key);
+        m_out << bracket;
+        m_first.push_back(true);
+    }
+    void Close(char bracket) {
+        bool empty = m_first.back();
+        m_first.pop_back();
+        if (!empty) m_out << '\n' << std::string(m_first.size() * 2, ' ');
+        m_out << bracket;
+    }
+
+    std::ostringstream m_out;
+    std::vector<bool> m_first;
+};
+
+// 分位数汇总 (单位: 微秒)
+struct Percentiles {
+    size_t count = 0;
+    double mean = 0, p50 = 0, p90 = 0, p99 = 0, p999 = 0, max = 0;
+};
+
+Percentiles Summarize(std::vector<double> samples) {
+    Percentiles p;
+    p.count = samples.size();
+    if (samples.empty()) return p;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return samples[static_cast<size_t>(q * (samples.size() - 1))]; };
+    double sum = 0;
+    for (double s : samples) sum += s;
+    p.mean = sum / samples.size();
+    p.p50 = at(0.5);
+    p.p90 = at(0.9);
+    p.p99 = at(0.99);
+    p.p999 = at(0.999);
+    p.max = samples.back();
+    return p;
+}
+
+void WritePercentiles(JsonWriter& json, const char* key, const Percentiles& p) {
+    json.BeginObject(key)
+        .Value("count", static_cast<long long>(p.count))
+        .Value("mean", p.mean).Value("p50", p.p50).Value("p90", p.p90)
+        .Value("p99", p.p99).Value("p999", p.p999).Value("max", p.max)
+        .EndObject();
+}
+
+void PrintPercentiles(const char* name, const Percentiles& p) {
+    std::printf("  %-22s n=%-7zu mean %9.1f  p50 %9.1f  p90 %9.1f  p99 %9.1f  p99.9 %9.1f  max %9.1f us\n",
+        name, p.count, p.mean, p.p50, p.p90, p.p99, p.p999, p.max);
+}
+
+// === 1. 多生产者 AddTask 吞吐 ===
+// 每个生产者线程提交 total / producers 个空任务，只计提交阶段的墙钟时间
+struct AddTaskResult {
+    unsigned producers;
+    long tasks;
+    double seconds;
+};
+
+AddTaskResult BenchAddTask(TaskScheduler& scheduler, unsigned producers, long total) {
+    static std::atomic<long> executed{ 0 };
+    executed = 0;
+    const long perProducer = total / static_cast<long>(producers);
+    std::atomic<unsigned> ready{ 0 };
+    std::atomic<bool> go{ false };
+    std::vector<std::thread> threads;
+    for (unsigned p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            ready.fetch_add(1);
+            while (!go.load()) std::this_thread::yield();
+            for (long i = 0; i < perProducer; ++i) {
+                scheduler.AddTask("Bench Noop", [] { executed.fetch_add(1, std::memory_order_relaxed); });
+            }
+        });
+    }
+    while (ready.load() < producers) std::this_thread::yield();
+    auto start = BenchClock::now();
+    go = true;
+    for (auto& t : threads) t.join();
+    double seconds = Seconds(start);
+    WaitFor(executed, perProducer * static_cast<long>(producers));
+    return AddTaskResult{ producers, perProducer * static_cast<long>(producers), seconds };
+}
+
+// === 2. 分发延迟 ===
+// 立即任务: 提交 -> 开始执行；延时任务: 到期时刻 -> 开始执行
+// 任务以 pace 的间隔逐个提交，测的是空闲调度器的响应，而不是积压下的排队时间
+Percentiles BenchDispatchLatency(TaskScheduler& scheduler, int count, int delayMs, std::chrono::microseconds pace) {
+    std::vector<double> latencies(static_cast<size_t>(count));
+    std::atomic<long> done{ 0 };
+    for (int i = 0; i < count; ++i) {
+        const auto due = BenchClock::now() + std::chrono::milliseconds(delayMs);
+        double* slot = &latencies[static_cast<size_t>(i)];
+        scheduler.AddTask("Bench Latency", [slot, due, &done] {
+            *slot = Micros(BenchClock::now() - due);
+            done.fetch_add(1, std::memory_order_release);
+        }, delayMs);
+        if (pace.count() > 0) std::this_thread::sleep_for(pace);
+    }
+    WaitFor(done, count);
+    return Summarize(latencies);
+}
+
+// === 3. 周期任务抖动 ===
+// periodic 个周期任务 (间隔 intervalMs) 运行 durationMs，记录相邻两次执行间隔与标称间隔之差的绝对值
+Percentiles BenchPeriodicJitter(TaskScheduler& scheduler, int periodic, int intervalMs, int durationMs) {
+    struct Series {
+        std::mutex mutex;
+        std::vector<BenchClock::time_point> times;
+    };
+    std::vector<Series> series(static_cast<size_t>(periodic));
+    std::vector<TaskHandle> handles;
+    for (int i = 0; i < periodic; ++i) {
+        Series* s = &series[static_cast<size_t>(i)];
+        handles.push_back(scheduler.AddTask("Bench Periodic", [s] {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            s->times.push_back(BenchClock::now());
+        }, intervalMs, intervalMs));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(durationMs));
+    for (auto& handle : handles) handle.Cancel();
+    // 取消时正在执行的那一次可能还没结束，等它写完再读
+    std::this_thread::sleep_for(std::chrono::milliseconds(2 * intervalMs));
+
+    std::vector<double> jitter;
+    for (auto& s : series) {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (size_t i = 1; i < s.times.size(); ++i) {
+            jitter.push_back(std::fabs(Micros(s.times[i] - s.times[i - 1]) - intervalMs * 1000.0));
+        }
+    }
+    return Summarize(jitter);
+}
+
+// === 4. 端到端吞吐 ===
+// 一次性提交 tasks 个任务，计时到最后一个执行完
+struct ThroughputResult {
+    const char* workload;
+    long tasks;
+    double seconds;
+};
+
+volatile double g_sink = 0;
+
+template <typename Body>
+ThroughputResult BenchThroughput(TaskScheduler& scheduler, const char* workload, long tasks, Body body,
+                                 const TaskOptions& options = TaskOptions()) {
+    std::atomic<long> done{ 0 };
+    auto start = BenchClock::now();
+    for (long i = 0; i < tasks; ++i) {
+        scheduler.AddTask("Bench Throughput", [&done, body] {
+            body();
+            done.fetch_add(1, std::memory_order_relaxed);
+        }, 0, 0, options);
+    }
+    WaitFor(done, tasks);
+    return ThroughputResult{ workload, tasks, Seconds(start) };
+}
+
+// 约 20 微秒的纯计算
+void CpuWork() {
+    double x = 1.0;
+    for (int i = 0; i < 20000; ++i) x = x * 1.0000001 + 1e-9;
+    g_sink = x;
+}
+
+std::string NowIso() {
+    std::time_t t = std::time(nullptr);
+    std::tm tm;
+#if defined(_WIN32)
+    gmtime_s(&tm, &t);
+#else
+    gmtime_r(&t, &tm);
+#endif
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    return text;
+}
+
+std::string CompilerName() {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_VER);
+#else
+    return "unknown";
+#endif
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--quick") == 0) config.quick = true;
+        else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) config.workers = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) config.jsonPath = argv[++i];
+        else {
+            std::fprintf(stderr, "usage: %s [--quick] [--workers N] [--json file|-]\n", argv[0]);
+            return 2;
+        }
+    }
+    // JSON 写到标准输出时，人读的摘要改走标准错误
+    FILE* report = (config.jsonPath == "-") ? stderr : stdout;
+
+    auto& scheduler = TaskScheduler::Instance();
+    scheduler.ReserveTasks(4096);
+    scheduler.Start(config.workers);
+    const unsigned workers = static_cast<unsigned>(scheduler.GetWorkerCount());
+
+    JsonWriter json;
+    json.BeginObject()
+        .Value("schema", 1LL)
+        .Value("benchmark", std::string("bench_scheduler"))
+        .Value("timestamp", NowIso())
+        .Value("quick", static_cast<long long>(config.quick))
+        .BeginObject("host")
+        .Value("workers", static_cast<long long>(workers))
+        .Value("hardware_concurrency", static_cast<long long>(std::thread::hardware_concurrency()))
+        .Value("compiler", CompilerName())
+        .EndObject();
+
+    // 1. AddTask 吞吐
+    const long addTotal = config.quick ? 20000 : 200000;
+    std::fprintf(report, "workers: %u\nAddTask throughput (%ld no-op tasks):\n", workers, addTotal);
+    json.BeginArray("add_task");
+    for (unsigned producers : { 1u, 2u, 4u, 8u, 16u, 32u, 64u }) {
+        if (config.quick && producers > 16) break;
+        AddTaskResult r = BenchAddTask(scheduler, producers, addTotal);
+        double rate = r.tasks / r.seconds;
+        std::fprintf(report, "  producers %-3u %12.0f tasks/s %8.1f ns/task\n", producers, rate, 1e9 / rate);
+        json.BeginObject()
+            .Value("producers", static_cast<long long>(producers))
+            .Value("tasks", static_cast<long long>(r.tasks))
+            .Value("seconds", r.seconds)
+            .Value("tasks_per_sec", rate)
+            .EndObject();
+    }
+    json.EndArray();
+
+    // 2. 分发延迟
+    const int latencyCount = config.quick ? 500 : 5000;
+    std::fprintf(report, "dispatch latency (us):\n");
+    Percentiles immediate = BenchDispatchLatency(scheduler, latencyCount, 0, std::chrono::microseconds(100));
+    Percentiles delayed = BenchDispatchLatency(scheduler, latencyCount, 5, std::chrono::microseconds(100));
+    PrintPercentiles("immediate (submit)", immediate);
+    PrintPercentiles("delayed 5ms (due)", delayed);
+    json.BeginObject("dispatch_latency_us");
+    WritePercentiles(json, "immediate", immediate);
+    WritePercentiles(json, "delayed", delayed);
+    json.EndObject();
+
+    // 3. 周期抖动
+    const int periodic = 32, intervalMs = 10, durationMs = config.quick ? 300 : 2000;
+    Percentiles jitter = BenchPeriodicJitter(scheduler, periodic, intervalMs, durationMs);
+    std::fprintf(report, "periodic jitter (%d tasks x %dms for %dms, us):\n", periodic, intervalMs, durationMs);
+    PrintPercentiles("|interval - nominal|", jitter);
+    json.BeginObject("periodic_jitter_us")
+        .Value("tasks", static_cast<long long>(periodic))
+        .Value("interval_ms", static_cast<long long>(intervalMs))
+        .Value("duration_ms", static_cast<long long>(durationMs));
+    WritePercentiles(json, "jitter", jitter);
+    json.EndObject();
+
+    // 4. 端到端吞吐
+    TaskOptions blocking;
+    blocking.blocking = true;
+    std::vector<ThroughputResult> results;
+    results.push_back(BenchThroughput(scheduler, "noop", config.quick ? 50000 : 500000, [] {}));
+    results.push_back(BenchThroughput(scheduler, "cpu_20us", config.quick ? 2000 : 20000, CpuWork));
+    results.push_back(BenchThroughput(scheduler, "sleep_1ms", config.quick ? 64 : 256,
+        [] { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }));
+    results.push_back(BenchThroughput(scheduler, "sleep_1ms_blocking", config.quick ? 64 : 256,
+        [] { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }, blocking));
+    std::fprintf(report, "end-to-end throughput:\n");
+    json.BeginArray("throughput");
+    for (const auto& r : results) {
+        double rate = r.tasks / r.seconds;
+        std::fprintf(report, "  %-20s %8ld tasks %10.3f s %12.0f tasks/s\n", r.workload, r.tasks, r.seconds, rate);
+        json.BeginObject()
+            .Value("workload", std::string(r.workload))
+            .Value("tasks", static_cast<long long>(r.tasks))
+            .Value("seconds", r.seconds)
+            .Value("tasks_per_sec", rate)
+            .EndObject();
+    }
+    json.EndArray();
+
+    // 5. 运行统计 (EnableMetrics) 的开销：同样的空任务吞吐，取三次中最好的一次
+    const long metricTasks = config.quick ? 50000 : 500000;
+    double best[2] = { 0, 0 };
+    for (int round = 0; round < 3; ++round) {
+        for (int on = 0; on < 2; ++on) {
+            scheduler.EnableMetrics(on != 0);
+            ThroughputResult r = BenchThroughput(scheduler, "noop", metricTasks, [] {});
+            best[on] = (std::max)(best[on], r.tasks / r.seconds);
+        }
+    }
+    scheduler.EnableMetrics(false);
+    double overheadNs = 1e9 / best[1] - 1e9 / best[0];
+    std::fprintf(report, "metrics overhead: off %.0f tasks/s, on %.0f tasks/s (%+.1f ns/task)\n", best[0], best[1], overheadNs);
+    MetricsSnapshot metrics = scheduler.GetMetricsSnapshot();
+    const TaskMetrics* noop = metrics.Find("Bench Throughput");
+    json.BeginObject("metrics_overhead")
+        .Value("tasks", static_cast<long long>(metricTasks))
+        .Value("tasks_per_sec_off", best[0])
+        .Value("tasks_per_sec_on", best[1])
+        .Value("overhead_ns_per_task", overheadNs);
+    if (noop) {
+        json.Value("recorded_executions", static_cast<long long>(noop->executions))
+            .Value("queue_wait_p99_us", noop->queueWait.PercentileNs(0.99) / 1000.0)
+            .Value("execution_p99_us", noop->execution.PercentileNs(0.99) / 1000.0);
+    }
+    json.EndObject();
+
+    // 6. 时间线追踪 (SetTraceOptions) 的开销：关闭、每个任务都追踪、每 16 个任务追踪 1 个
+    const uint32_t sampling[3] = { 0, 1, 16 };
+    double traceBest[3] = { 0, 0, 0 };
+    for (int round = 0; round < 3; ++round) {
+        for (int mode = 0; mode < 3; ++mode) {
+            TraceOptions trace;
+            trace.enabled = (sampling[mode] != 0);
+            trace.sampleEvery = (std::max)(sampling[mode], uint32_t(1));
+            scheduler.SetTraceOptions(trace);
+            ThroughputResult r = BenchThroughput(scheduler, "noop", metricTasks, [] {});
+            traceBest[mode] = (std::max)(traceBest[mode], r.tasks / r.seconds);
+        }
+    }
+    scheduler.SetTraceOptions(TraceOptions());
+    const size_t traceBytes = scheduler.GetTraceJson().size();
+    scheduler.ClearTrace();
+    double traceAllNs = 1e9 / traceBest[1] - 1e9 / traceBest[0];
+    double traceSampledNs = 1e9 / traceBest[2] - 1e9 / traceBest[0];
+    std::fprintf(report, "trace overhead: off %.0f tasks/s, every task %.0f tasks/s (%+.1f ns/task), "
+        "1 in 16 %.0f tasks/s (%+.1f ns/task)\n", traceBest[0], traceBest[1], traceAllNs, traceBest[2], traceSampledNs);
+    json.BeginObject("trace_overhead")
+        .Value("tasks", static_cast<long long>(metricTasks))
+        .Value("tasks_per_sec_off", traceBest[0])
+        .Value("tasks_per_sec_all", traceBest[1])
+        .Value("tasks_per_sec_1_in_16", traceBest[2])
+        .Value("overhead_ns_per_task_all", traceAllNs)
+        .Value("overhead_ns_per_task_1_in_16", traceSampledNs)
+        .Value("json_bytes", static_cast<long long>(traceBytes))
+        .EndObject();
+    json.EndObject();
+
+    scheduler.Stop();
+
+    if (config.jsonPath == "-") {
+        std::cout << json.Str();
+    }
+    else {
+        std::ofstream out(config.jsonPath);
+        out << json.Str();
+        std::fprintf(report, "json: %s\n", config.jsonPath.c_str());
+    }
+    return 0;
+}
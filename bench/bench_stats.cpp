@@ -0,0 +1,223 @@
+// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_stats.cpp
+// 对应需求: 统计吞吐 (样本/秒)：原“先生成 vector 再两遍扫描” vs 流式分块统计 (标量 / SIMD / 分位数 / 并行)
+// 编译示例: cl /O2 /EHsc /std:c++17 /I..\MyTaskScheduler bench_stats.cpp
+// 用法: bench_stats [最大样本数，默认 1e9] [原始实现的最大样本数，默认 1e8]
+// 说明: 均值、方差与 long double 两遍结果比对；分位数与排序后的精确值比对，
+//       另外写一个临时文件验证文件数据源
+// =================================================================================
+#include "SchedulerEngine.h"
+#include "StatsEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+double Seconds(BenchClock::time_point start) {
+    return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+// 原 CStatsTask 的实现：先把全部样本放进 vector，再两遍求均值、方差
+double RunLegacy(uint64_t samples, double& mean, double& variance) {
+    auto start = BenchClock::now();
+    std::vector<int> numbers;
+    numbers.reserve(samples);
+    std::mt19937 gen(12345);
+    std::uniform_int_distribution<> dis(0, 100);
+    long long sum = 0;
+    for (uint64_t i = 0; i < samples; ++i) {
+        int num = dis(gen);
+        numbers.push_back(num);
+        sum += num;
+    }
+    mean = sum / static_cast<double>(samples);
+    double varianceSum = 0.0;
+    for (int num : numbers) varianceSum += (num - mean) * (num - mean);
+    variance = varianceSum / static_cast<double>(samples);
+    return Seconds(start);
+}
+
+// 只测生成开销：流式统计的时间里有多少花在数据源上
+double RunGenerateOnly(const ISampleSource& source) {
+    auto start = BenchClock::now();
+    std::vector<double> buffer(16384);
+    double sink = 0.0;
+    for (uint64_t offset = 0; offset < source.Size(); offset += buffer.size()) {
+        size_t got = source.Read(offset, buffer.data(), buffer.size());
+        sink += buffer[got - 1];
+    }
+    volatile double keep = sink;
+    (void)keep;
+    return Seconds(start);
+}
+
+uint64_t Mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// 带长尾的连续分布 (对数正态，每 8 个取一个负值)，用于检验分位数相对误差
+void FillLogNormal(uint64_t offset, double* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t index = offset + i;
+        double u1 = ((Mix(2 * index * 0x9E3779B97F4A7C15ull) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+        double u2 = ((Mix((2 * index + 1) * 0x9E3779B97F4A7C15ull) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+        double normal = std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+        out[i] = std::exp(1.5 * normal) * ((index & 7) == 0 ? -1.0 : 1.0);
+    }
+}
+
+struct Exact {
+    long double mean = 0, variance = 0;
+    std::vector<double> sorted;
+};
+
+Exact ComputeExact(const ISampleSource& source, bool quantiles) {
+    Exact e;
+    std::vector<double> all(source.Size());
+    for (uint64_t offset = 0; offset < all.size(); offset += 65536) {
+        source.Read(offset, all.data() + offset, static_cast<size_t>(std::min<uint64_t>(65536, all.size() - offset)));
+    }
+    long double sum = 0;
+    for (double x : all) sum += x;
+    e.mean = sum / all.size();
+    long double m2 = 0;
+    for (double x : all) m2 += (x - e.mean) * (x - e.mean);
+    e.variance = m2 / all.size();
+    if (quantiles) {
+        std::sort(all.begin(), all.end());
+        e.sorted.swap(all);
+    }
+    return e;
+}
+
+double RelError(double value, long double expected) {
+    return std::fabs(static_cast<double>((value - expected) / (std::fabs(expected) > 1e-300 ? std::fabs(expected) : 1.0L)));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const uint64_t maxSamples = (argc > 1) ? static_cast<uint64_t>(std::strtod(argv[1], nullptr)) : 1000000000ull;
+    const uint64_t maxLegacy = (argc > 2) ? static_cast<uint64_t>(std::strtod(argv[2], nullptr)) : 100000000ull;
+
+    auto& scheduler = TaskScheduler::Instance();
+    scheduler.Start();
+    ParallelForFn parallelFor = [&](size_t count, const std::function<void(size_t)>& body) {
+        scheduler.ParallelFor(count, body);
+    };
+
+    struct Variant {
+        const char* name;
+        SimdLevel simd;
+        bool quantiles;
+        bool parallel;
+    };
+    const Variant variants[] = {
+        { "scalar", SimdLevel::Scalar, false, false },
+        { "simd", DetectSimdLevel(), false, false },
+        { "simd+quantile", DetectSimdLevel(), true, false },
+        { "parallel", DetectSimdLevel(), true, true },
+    };
+
+    std::printf("cpu: %s, workers: %zu (million samples/s)\n", SimdLevelName(DetectSimdLevel()), scheduler.GetWorkerCount());
+    std::printf("%-12s %10s %10s", "samples", "legacy", "generate");
+    for (const Variant& v : variants) std::printf(" %14s", v.name);
+    std::printf("\n");
+
+    bool ok = true;
+    for (uint64_t samples : { 1000000ull, 10000000ull, 100000000ull, 1000000000ull }) {
+        if (samples > maxSamples) break;
+        UniformIntSource source(samples, 0, 100, 12345);
+        std::printf("%-12llu", static_cast<unsigned long long>(samples));
+
+        if (samples <= maxLegacy) {
+            double mean, variance;
+            double seconds = RunLegacy(samples, mean, variance);
+            std::printf(" %10.1f", samples / seconds / 1e6);
+        }
+        else {
+            std::printf(" %10s", "-");
+        }
+        std::printf(" %10.1f", samples / RunGenerateOnly(source) / 1e6);
+
+        Exact exact;
+        if (samples <= 10000000ull) exact = ComputeExact(source, false);
+        for (const Variant& v : variants) {
+            StatsOptions options;
+            options.simd = v.simd;
+            options.quantiles = v.quantiles;
+            if (v.parallel) options.parallelFor = parallelFor;
+            auto start = BenchClock::now();
+            StatsAccumulator stats = ComputeStats(source, options);
+            double seconds = Seconds(start);
+            std::printf(" %14.1f", samples / seconds / 1e6);
+
+            const RunningStats& m = stats.Moments();
+            ok &= m.count == samples && m.min == 0.0 && m.max == 100.0;
+            if (samples <= 10000000ull) {
+                ok &= RelError(m.mean, exact.mean) < 1e-12 && RelError(m.Variance(), exact.variance) < 1e-10;
+            }
+            else {
+                // 大样本没有精确参照：[0, 100] 均匀整数的理论值
+                ok &= std::fabs(m.mean - 50.0) < 0.05 && std::fabs(m.Variance() - 850.0) < 1.0;
+            }
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    // 分位数精度：对数正态 (含 1/8 负值)，与排序后的精确分位数比对
+    const uint64_t quantileSamples = std::min<uint64_t>(maxSamples, 10000000ull);
+    GeneratorSource logNormal(quantileSamples, FillLogNormal);
+    Exact exact = ComputeExact(logNormal, true);
+    StatsOptions options;
+    options.parallelFor = parallelFor;
+    StatsAccumulator stats = ComputeStats(logNormal, options);
+    double worstQuantile = 0.0;
+    for (double q : { 0.001, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999 }) {
+        double expected = exact.sorted[static_cast<size_t>(q * (exact.sorted.size() - 1))];
+        worstQuantile = std::max(worstQuantile, RelError(stats.Quantile(q), expected));
+    }
+    double meanError = RelError(stats.Moments().mean, exact.mean);
+    double varianceError = RelError(stats.Moments().Variance(), exact.variance);
+    ok &= worstQuantile <= options.quantileAccuracy + 1e-9 && meanError < 1e-10 && varianceError < 1e-10;
+    std::printf("lognormal %llu: quantile max rel error %.4f (bound %.2f), mean %.1e, variance %.1e\n",
+        static_cast<unsigned long long>(quantileSamples), worstQuantile, options.quantileAccuracy, meanError, varianceError);
+
+    // 文件数据源：把同一组样本写到临时文件再并行读回
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "bench_stats_samples.bin";
+    {
+        std::ofstream file(path, std::ios::binary);
+        std::vector<double> buffer(65536);
+        for (uint64_t offset = 0; offset < quantileSamples; offset += buffer.size()) {
+            size_t got = logNormal.Read(offset, buffer.data(), buffer.size());
+            file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(got * sizeof(double)));
+        }
+    }
+    BinaryFileSource fileSource(path.string());
+    auto start = BenchClock::now();
+    StatsAccumulator fromFile = ComputeStats(fileSource, options);
+    double seconds = Seconds(start);
+    bool fileOk = fromFile.Moments().count == quantileSamples
+        && RelError(fromFile.Moments().mean, exact.mean) < 1e-10
+        && fromFile.Quantile(0.5) == stats.Quantile(0.5);
+    ok &= fileOk;
+    std::printf("file source: %.1f million samples/s (%s)\n", quantileSamples / seconds / 1e6, fileOk ? "matches" : "MISMATCH");
+    std::filesystem::remove(path);
+
+    scheduler.Stop();
+    std::printf("result check: %s\n", ok ? "OK" : "MISMATCH");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: bench_timing_wheel.cpp
+// 对应需求: 分层时间轮 vs std::priority_queue 定时堆 (1k / 100k / 1M 挂起定时器)
+// 编译示例: g++ -O2 -std=c++17 -I../MyTaskScheduler bench_timing_wheel.cpp
+// =================================================================================
+#include "TimingWheel.h"
+#include <queue>
+#include <vector>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+// 与旧版 ScheduledTask 等价的“胖”堆元素：shared_ptr + 时间点 + 周期信息
+struct HeapTask {
+    std::shared_ptr<int> task;
+    uint64_t runTick;
+    bool isPeriodic;
+    int intervalMs;
+    bool operator>(const HeapTask& other) const { return runTick > other.runTick; }
+};
+using HeapQueue = std::priority_queue<HeapTask, std::vector<HeapTask>, std::greater<HeapTask>>;
+
+struct WheelTask : TimerNode {
+    std::shared_ptr<int> task;
+    bool isPeriodic = true;
+    int intervalMs = 0;
+};
+
+constexpr uint64_t kMaxDelayTicks = 60000;   // 1ms 刻度下最长 60s
+constexpr uint64_t kChurnTicks = 2000;       // 周期重挂阶段模拟的刻度数
+
+struct Result {
+    double insertNs;   // 每次插入
+    double churnNs;    // 每次 到期 + 重新挂入
+    double drainNs;    // 每次 到期
+    uint64_t churnOps;
+};
+
+double NsPerOp(BenchClock::time_point start, uint64_t ops) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(BenchClock::now() - start).count();
+    return ops ? static_cast<double>(ns) / static_cast<double>(ops) : 0.0;
+}
+
+Result RunHeap(size_t n, const std::vector<uint32_t>& delays) {
+    Result r{};
+    auto payload = std::make_shared<int>(0);
+    HeapQueue heap;
+
+    auto t0 = BenchClock::now();
+    for (size_t i = 0; i < n; ++i) {
+        heap.push(HeapTask{ payload, delays[i], true, static_cast<int>(delays[i]) });
+    }
+    r.insertNs = NsPerOp(t0, n);
+
+    // 逐刻度推进：弹出所有到期元素并按周期重新压入
+    uint64_t ops = 0;
+    t0 = BenchClock::now();
+    for (uint64_t now = 0; now < kChurnTicks; ++now) {
+        while (!heap.empty() && heap.top().runTick <= now) {
+            HeapTask t = heap.top();
+            heap.pop();
+            t.runTick = now + static_cast<uint64_t>(t.intervalMs) + 1;
+            heap.push(std::move(t));
+            ++ops;
+        }
+    }
+    r.churnNs = NsPerOp(t0, ops);
+    r.churnOps = ops;
+
+    t0 = BenchClock::now();
+    size_t drained = heap.size();
+    while (!heap.empty()) heap.pop();
+    r.drainNs = NsPerOp(t0, drained);
+    return r;
+}
+
+Result RunWheel(size_t n, const std::vector<uint32_t>& delays) {
+    Result r{};
+    auto payload = std::make_shared<int>(0);
+    std::vector<WheelTask> nodes(n);
+    TimingWheel wheel;
+
+    auto t0 = BenchClock::now();
+    for (size_t i = 0; i < n; ++i) {
+        nodes[i].task = payload;
+        nodes[i].intervalMs = static_cast<int>(delays[i]);
+        wheel.Add(&nodes[i], wheel.TimeOfTick(delays[i]));
+    }
+    r.insertNs = NsPerOp(t0, n);
+
+    uint64_t ops = 0;
+    t0 = BenchClock::now();
+    for (uint64_t now = 0; now < kChurnTicks; ++now) {
+        wheel.Advance(now, [&](TimerNode* node) {
+            auto* t = static_cast<WheelTask*>(node);
+            wheel.Add(t, wheel.TimeOfTick(now + static_cast<uint64_t>(t->intervalMs) + 1));
+            ++ops;
+        });
+    }
+    r.churnNs = NsPerOp(t0, ops);
+    r.churnOps = ops;
+
+    t0 = BenchClock::now();
+    size_t drained = wheel.Size();
+    wheel.Advance(kChurnTicks + 2 * kMaxDelayTicks + 2, [](TimerNode*) {});
+    r.drainNs = NsPerOp(t0, drained);
+    return r;
+}
+
+} // namespace
+
+int main() {
+    std::printf("%-10s %-6s %12s %12s %12s %12s\n",
+        "pending", "store", "insert ns", "rearm ns", "expire ns", "rearm ops");
+
+    for (size_t n : { size_t(1000), size_t(100000), size_t(1000000) }) {
+        std::mt19937 gen(12345);
+        std::uniform_int_distribution<uint32_t> dis(1, static_cast<uint32_t>(kMaxDelayTicks));
+        std::vector<uint32_t> delays(n);
+        for (auto& d : delays) d = dis(gen);
+
+        Result heap = RunHeap(n, delays);
+        Result wheel = RunWheel(n, delays);
+        std::printf("%-10zu %-6s %12.1f %12.1f %12.1f %12llu\n", n, "heap",
+            heap.insertNs, heap.churnNs, heap.drainNs, static_cast<unsigned long long>(heap.churnOps));
+        std::printf("%-10zu %-6s %12.1f %12.1f %12.1f %12llu\n", n, "wheel",
+            wheel.insertNs, wheel.churnNs, wheel.drainNs, static_cast<unsigned long long>(wheel.churnOps));
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+﻿// =================================================================================
+// 项目名称: MyTaskScheduler (Project 3)
+// 文件名称: blogdump.cpp
+// 对应需求: 二进制日志读取工具 (mmap + 时间索引)
+// 用法:
+//   blogdump <file.blog>                         全部转换为文本日志格式
+//   blogdump <file.blog> --from-ms A --to-ms B   只输出 [A, B] 毫秒 (相对日志打开时刻)
+//   blogdump <file.blog> --task ID               只输出某个任务的事件
+// 编译示例: g++ -O2 -std=c++17 -I../MyTaskScheduler blogdump.cpp -o blogdump
+// =================================================================================
+#include "BinaryLog.h"
+#include <iostream>
+#include <cstdlib>
+#include <limits>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: blogdump <file.blog> [--from-ms N] [--to-ms N] [--task ID]\n";
+        return 2;
+    }
+
+    int64_t fromMs = 0;
+    int64_t toMs = -1;
+    uint64_t taskId = 0;
+    bool byTask = false;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string opt = argv[i];
+        if (opt == "--from-ms") fromMs = std::atoll(argv[i + 1]);
+        else if (opt == "--to-ms") toMs = std::atoll(argv[i + 1]);
+        else if (opt == "--task") { taskId = std::strtoull(argv[i + 1], nullptr, 10); byTask = true; }
+        else { std::cerr << "unknown option: " << opt << "\n"; return 2; }
+    }
+
+    BinaryLogReader reader;
+    if (!reader.Open(argv[1])) {
+        std::cerr << "cannot open binary log: " << argv[1] << "\n";
+        return 1;
+    }
+
+    if (byTask) {
+        reader.ForEachForTask(taskId, [&](const BinaryLogRecordView& rec) {
+            std::cout << reader.FormatText(rec) << '\n';
+            return true;
+        });
+        return 0;
+    }
+
+    uint64_t from = reader.FromOffsetMs(fromMs);
+    uint64_t to = (toMs < 0) ? std::numeric_limits<uint64_t>::max() : reader.FromOffsetMs(toMs);
+    reader.WriteText(from, to, std::cout);
+    return 0;
+}